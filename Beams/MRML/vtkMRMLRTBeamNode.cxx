@@ -37,6 +37,7 @@
 
 // VTK includes
 #include <vtkCommand.h>
+#include <vtkDoubleArray.h>
 #include <vtkObjectFactory.h>
 #include <vtkSmartPointer.h>
 #include <vtkIntArray.h>
@@ -46,6 +47,10 @@
 #include <vtkCellArray.h>
 #include <vtkAppendPolyData.h>
 
+// STD includes
+#include <algorithm>
+#include <sstream>
+
 //------------------------------------------------------------------------------
 const char* vtkMRMLRTBeamNode::NEW_BEAM_NODE_NAME_PREFIX = "NewBeam_";
 const char* vtkMRMLRTBeamNode::BEAM_TRANSFORM_NODE_NAME_POSTFIX = "_BeamTransform";
@@ -55,6 +60,37 @@ static const char* MLC_BOUNDARY_POSITION_REFERENCE_ROLE = "MLCBoundaryAndPositio
 static const char* DRR_REFERENCE_ROLE = "DRRRef";
 static const char* CONTOUR_BEV_REFERENCE_ROLE = "contourBEVRef";
 
+//------------------------------------------------------------------------------
+namespace
+{
+  /// Write values as a space separated XML attribute. Nothing is written for empty arrays
+  void WriteXMLDoubleVector(ostream& of, const char* attributeName, const std::vector<double>& values)
+  {
+    if (values.empty())
+    {
+      return;
+    }
+    of << " " << attributeName << "=\"";
+    for (std::vector<double>::const_iterator valueIt = values.begin(); valueIt != values.end(); ++valueIt)
+    {
+      of << (valueIt == values.begin() ? "" : " ") << (*valueIt);
+    }
+    of << "\"";
+  }
+
+  /// Read space separated values of an XML attribute
+  void ReadXMLDoubleVector(const char* attributeValue, std::vector<double>& values)
+  {
+    values.clear();
+    std::stringstream ss(attributeValue);
+    double value = 0.0;
+    while (ss >> value)
+    {
+      values.push_back(value);
+    }
+  }
+}
+
 //------------------------------------------------------------------------------
 vtkMRMLNodeNewMacro(vtkMRMLRTBeamNode);
 
@@ -79,6 +115,8 @@ vtkMRMLRTBeamNode::vtkMRMLRTBeamNode()
   this->SourceToJawsDistanceX = 500.;
   this->SourceToJawsDistanceY = 500.;
   this->SourceToMultiLeafCollimatorDistance = 400.;
+
+  this->CurrentControlPointIndex = -1;
 }
 
 //----------------------------------------------------------------------------
@@ -108,7 +146,17 @@ void vtkMRMLRTBeamNode::WriteXML(ostream& of, int nIndent)
   vtkMRMLWriteXMLFloatMacro( GantryAngle, GantryAngle);
   vtkMRMLWriteXMLFloatMacro( CollimatorAngle, CollimatorAngle);
   vtkMRMLWriteXMLFloatMacro( CouchAngle, CouchAngle);
+  vtkMRMLWriteXMLIntMacro( CurrentControlPointIndex, CurrentControlPointIndex);
   vtkMRMLWriteXMLEndMacro();
+
+  // Control points of dynamic beams
+  WriteXMLDoubleVector(of, "ControlPointGantryAngles", this->ControlPoints.GantryAngles);
+  WriteXMLDoubleVector(of, "ControlPointCollimatorAngles", this->ControlPoints.CollimatorAngles);
+  WriteXMLDoubleVector(of, "ControlPointCouchAngles", this->ControlPoints.CouchAngles);
+  WriteXMLDoubleVector(of, "ControlPointJawPositions", this->ControlPoints.JawPositions);
+  WriteXMLDoubleVector(of, "ControlPointCumulativeMetersetWeights", this->ControlPoints.CumulativeMetersetWeights);
+  WriteXMLDoubleVector(of, "ControlPointMLCBoundaries", this->ControlPoints.MultiLeafCollimatorBoundaries);
+  WriteXMLDoubleVector(of, "ControlPointMLCPositions", this->ControlPoints.MultiLeafCollimatorPositions);
 }
 
 //----------------------------------------------------------------------------
@@ -132,7 +180,43 @@ void vtkMRMLRTBeamNode::ReadXMLAttributes(const char** atts)
   vtkMRMLReadXMLFloatMacro( GantryAngle, GantryAngle);
   vtkMRMLReadXMLFloatMacro( CollimatorAngle, CollimatorAngle);
   vtkMRMLReadXMLFloatMacro( CouchAngle, CouchAngle);
+  vtkMRMLReadXMLIntMacro( CurrentControlPointIndex, CurrentControlPointIndex);
   vtkMRMLReadXMLEndMacro();
+
+  // Control points of dynamic beams
+  for (const char** attribute = atts; attribute && *attribute != nullptr; attribute += 2)
+  {
+    std::string attributeName(attribute[0]);
+    const char* attributeValue = attribute[1];
+    if (attributeName == "ControlPointGantryAngles")
+    {
+      ReadXMLDoubleVector(attributeValue, this->ControlPoints.GantryAngles);
+    }
+    else if (attributeName == "ControlPointCollimatorAngles")
+    {
+      ReadXMLDoubleVector(attributeValue, this->ControlPoints.CollimatorAngles);
+    }
+    else if (attributeName == "ControlPointCouchAngles")
+    {
+      ReadXMLDoubleVector(attributeValue, this->ControlPoints.CouchAngles);
+    }
+    else if (attributeName == "ControlPointJawPositions")
+    {
+      ReadXMLDoubleVector(attributeValue, this->ControlPoints.JawPositions);
+    }
+    else if (attributeName == "ControlPointCumulativeMetersetWeights")
+    {
+      ReadXMLDoubleVector(attributeValue, this->ControlPoints.CumulativeMetersetWeights);
+    }
+    else if (attributeName == "ControlPointMLCBoundaries")
+    {
+      ReadXMLDoubleVector(attributeValue, this->ControlPoints.MultiLeafCollimatorBoundaries);
+    }
+    else if (attributeName == "ControlPointMLCPositions")
+    {
+      ReadXMLDoubleVector(attributeValue, this->ControlPoints.MultiLeafCollimatorPositions);
+    }
+  }
 }
 
 //----------------------------------------------------------------------------
@@ -178,7 +262,9 @@ void vtkMRMLRTBeamNode::Copy(vtkMRMLNode *anode)
   vtkMRMLCopyFloatMacro(GantryAngle);
   vtkMRMLCopyFloatMacro(CollimatorAngle);
   vtkMRMLCopyFloatMacro(CouchAngle);
+  vtkMRMLCopyIntMacro(CurrentControlPointIndex);
   vtkMRMLCopyEndMacro();
+  this->ControlPoints = node->ControlPoints;
 
   this->EndModify(disabledModify);
 
@@ -211,7 +297,9 @@ void vtkMRMLRTBeamNode::CopyContent(vtkMRMLNode *anode, bool deepCopy/*=true*/)
   vtkMRMLCopyFloatMacro(GantryAngle);
   vtkMRMLCopyFloatMacro(CollimatorAngle);
   vtkMRMLCopyFloatMacro(CouchAngle);
+  vtkMRMLCopyIntMacro(CurrentControlPointIndex);
   vtkMRMLCopyEndMacro();
+  this->ControlPoints = node->ControlPoints;
 }
 
 //----------------------------------------------------------------------------
@@ -254,7 +342,9 @@ void vtkMRMLRTBeamNode::PrintSelf(ostream& os, vtkIndent indent)
   vtkMRMLPrintFloatMacro(GantryAngle);
   vtkMRMLPrintFloatMacro(CollimatorAngle);
   vtkMRMLPrintFloatMacro(CouchAngle);
+  vtkMRMLPrintIntMacro(CurrentControlPointIndex);
   vtkMRMLPrintEndMacro();
+  os << indent << "NumberOfControlPoints: " << this->GetNumberOfControlPoints() << "\n";
 }
 
 //----------------------------------------------------------------------------
@@ -505,6 +595,180 @@ void vtkMRMLRTBeamNode::SetSAD(double sad)
   this->InvokeCustomModifiedEvent(vtkMRMLRTBeamNode::BeamGeometryModified);
 }
 
+//---------------------------------------------------------------------------
+int vtkMRMLRTBeamNode::GetNumberOfControlPoints()
+{
+  return static_cast<int>(this->ControlPoints.GantryAngles.size());
+}
+
+//---------------------------------------------------------------------------
+void vtkMRMLRTBeamNode::SetNumberOfControlPoints(int numberOfControlPoints)
+{
+  if (numberOfControlPoints < 0)
+  {
+    vtkErrorMacro("SetNumberOfControlPoints: Invalid number of control points " << numberOfControlPoints);
+    return;
+  }
+
+  this->ControlPoints = ControlPointArrays();
+  this->ControlPoints.GantryAngles.resize(numberOfControlPoints, 0.0);
+  this->ControlPoints.CollimatorAngles.resize(numberOfControlPoints, 0.0);
+  this->ControlPoints.CouchAngles.resize(numberOfControlPoints, 0.0);
+  this->ControlPoints.JawPositions.resize(4 * numberOfControlPoints, 0.0);
+  this->ControlPoints.CumulativeMetersetWeights.resize(numberOfControlPoints, 0.0);
+  this->CurrentControlPointIndex = -1;
+  this->Modified();
+}
+
+//---------------------------------------------------------------------------
+void vtkMRMLRTBeamNode::SetControlPoint(int index, double gantryAngle, double collimatorAngle, double couchAngle,
+  const double jawPositions[4], double cumulativeMetersetWeight)
+{
+  if (index < 0 || index >= this->GetNumberOfControlPoints())
+  {
+    vtkErrorMacro("SetControlPoint: Invalid control point index " << index);
+    return;
+  }
+
+  this->ControlPoints.GantryAngles[index] = gantryAngle;
+  this->ControlPoints.CollimatorAngles[index] = collimatorAngle;
+  this->ControlPoints.CouchAngles[index] = couchAngle;
+  std::copy(jawPositions, jawPositions + 4, this->ControlPoints.JawPositions.begin() + 4 * index);
+  this->ControlPoints.CumulativeMetersetWeights[index] = cumulativeMetersetWeight;
+}
+
+//---------------------------------------------------------------------------
+bool vtkMRMLRTBeamNode::GetControlPoint(int index, double& gantryAngle, double& collimatorAngle, double& couchAngle,
+  double jawPositions[4], double& cumulativeMetersetWeight)
+{
+  if (index < 0 || index >= this->GetNumberOfControlPoints())
+  {
+    vtkErrorMacro("GetControlPoint: Invalid control point index " << index);
+    return false;
+  }
+
+  gantryAngle = this->ControlPoints.GantryAngles[index];
+  collimatorAngle = this->ControlPoints.CollimatorAngles[index];
+  couchAngle = this->ControlPoints.CouchAngles[index];
+  std::copy_n(this->ControlPoints.JawPositions.begin() + 4 * index, 4, jawPositions);
+  cumulativeMetersetWeight = this->ControlPoints.CumulativeMetersetWeights[index];
+  return true;
+}
+
+//---------------------------------------------------------------------------
+void vtkMRMLRTBeamNode::SetControlPointMultiLeafCollimatorBoundaries(const std::vector<double>& boundaries)
+{
+  this->ControlPoints.MultiLeafCollimatorBoundaries = boundaries;
+
+  // Positions are stored for all control points with the same number of leaf pairs
+  size_t numberOfLeafPairs = (boundaries.empty() ? 0 : boundaries.size() - 1);
+  this->ControlPoints.MultiLeafCollimatorPositions.assign(2 * numberOfLeafPairs * this->GetNumberOfControlPoints(), 0.0);
+}
+
+//---------------------------------------------------------------------------
+void vtkMRMLRTBeamNode::SetControlPointMultiLeafCollimatorPositions(int index, const std::vector<double>& positions)
+{
+  if (index < 0 || index >= this->GetNumberOfControlPoints())
+  {
+    vtkErrorMacro("SetControlPointMultiLeafCollimatorPositions: Invalid control point index " << index);
+    return;
+  }
+  size_t numberOfPositions = (this->ControlPoints.MultiLeafCollimatorBoundaries.empty() ? 0 :
+    2 * (this->ControlPoints.MultiLeafCollimatorBoundaries.size() - 1) );
+  if (positions.size() != numberOfPositions)
+  {
+    vtkErrorMacro("SetControlPointMultiLeafCollimatorPositions: Number of leaf positions (" << positions.size()
+      << ") does not match the MLC boundaries of the beam (" << numberOfPositions << " positions)");
+    return;
+  }
+
+  std::copy(positions.begin(), positions.end(), this->ControlPoints.MultiLeafCollimatorPositions.begin() + index * numberOfPositions);
+}
+
+//---------------------------------------------------------------------------
+void vtkMRMLRTBeamNode::SetControlPointMultiLeafCollimatorPositions(const std::vector<double>& positions)
+{
+  if (positions.size() != this->ControlPoints.MultiLeafCollimatorPositions.size())
+  {
+    vtkErrorMacro("SetControlPointMultiLeafCollimatorPositions: Number of leaf positions (" << positions.size()
+      << ") does not match the control points and MLC boundaries of the beam ("
+      << this->ControlPoints.MultiLeafCollimatorPositions.size() << " positions)");
+    return;
+  }
+
+  this->ControlPoints.MultiLeafCollimatorPositions = positions;
+}
+
+//---------------------------------------------------------------------------
+bool vtkMRMLRTBeamNode::GetControlPointMultiLeafCollimatorPositions(int index, std::vector<double>& positions)
+{
+  positions.clear();
+  if (index < 0 || index >= this->GetNumberOfControlPoints())
+  {
+    vtkErrorMacro("GetControlPointMultiLeafCollimatorPositions: Invalid control point index " << index);
+    return false;
+  }
+  if (this->ControlPoints.MultiLeafCollimatorBoundaries.empty())
+  {
+    return false;
+  }
+
+  size_t numberOfPositions = 2 * (this->ControlPoints.MultiLeafCollimatorBoundaries.size() - 1);
+  std::vector<double>::const_iterator positionsBegin = this->ControlPoints.MultiLeafCollimatorPositions.begin() + index * numberOfPositions;
+  positions.assign(positionsBegin, positionsBegin + numberOfPositions);
+  return true;
+}
+
+//---------------------------------------------------------------------------
+void vtkMRMLRTBeamNode::SetCurrentControlPointIndex(int index)
+{
+  if (index < 0 || index >= this->GetNumberOfControlPoints())
+  {
+    vtkErrorMacro("SetCurrentControlPointIndex: Invalid control point index " << index);
+    return;
+  }
+
+  int disabledModify = this->StartModify();
+
+  this->CurrentControlPointIndex = index;
+
+  // Set parameters directly, so that beam model and transform are updated only once
+  this->GantryAngle = this->ControlPoints.GantryAngles[index];
+  this->CollimatorAngle = this->ControlPoints.CollimatorAngles[index];
+  this->CouchAngle = this->ControlPoints.CouchAngles[index];
+  this->X1Jaw = this->ControlPoints.JawPositions[4 * index];
+  this->X2Jaw = this->ControlPoints.JawPositions[4 * index + 1];
+  this->Y1Jaw = this->ControlPoints.JawPositions[4 * index + 2];
+  this->Y2Jaw = this->ControlPoints.JawPositions[4 * index + 3];
+
+  // Copy leaf positions into the MLC table
+  vtkMRMLTableNode* mlcTableNode = this->GetMultiLeafCollimatorTableNode();
+  vtkIdType numberOfLeafPairs = static_cast<vtkIdType>(this->ControlPoints.MultiLeafCollimatorBoundaries.size()) - 1;
+  if (mlcTableNode && numberOfLeafPairs > 0 && mlcTableNode->GetNumberOfRows() == numberOfLeafPairs + 1)
+  {
+    vtkDoubleArray* side1Positions = vtkDoubleArray::SafeDownCast(mlcTableNode->GetTable()->GetColumn(1));
+    vtkDoubleArray* side2Positions = vtkDoubleArray::SafeDownCast(mlcTableNode->GetTable()->GetColumn(2));
+    if (side1Positions && side2Positions)
+    {
+      const double* positions = this->ControlPoints.MultiLeafCollimatorPositions.data() + 2 * numberOfLeafPairs * index;
+      for (vtkIdType leafPair = 0; leafPair < numberOfLeafPairs; ++leafPair)
+      {
+        side1Positions->SetValue(leafPair, positions[leafPair]);
+        side2Positions->SetValue(leafPair, positions[numberOfLeafPairs + leafPair]);
+      }
+      side1Positions->Modified();
+      side2Positions->Modified();
+      mlcTableNode->Modified();
+    }
+  }
+
+  this->Modified();
+  this->InvokeCustomModifiedEvent(vtkMRMLRTBeamNode::BeamGeometryModified);
+  this->InvokeCustomModifiedEvent(vtkMRMLRTBeamNode::BeamTransformModified);
+
+  this->EndModify(disabledModify);
+}
+
 //---------------------------------------------------------------------------
 void vtkMRMLRTBeamNode::UpdateGeometry()
 {
@@ -28,6 +28,9 @@
 // MRML includes
 #include <vtkMRMLModelNode.h>
 
+// STD includes
+#include <vector>
+
 class vtkPolyData;
 class vtkMRMLScene;
 class vtkMRMLTableNode;
@@ -203,6 +206,41 @@ public:
   /// Set source to multi-leaf collimator distance. Triggers \sa BeamTransformModified event and re-generation of beam model
   void SetSourceToMultiLeafCollimatorDistance(double distance);
 
+// Control points of dynamic beams
+public:
+  /// Get number of control points stored in the beam. Zero if the beam has no control points (static beam)
+  int GetNumberOfControlPoints();
+  /// Allocate storage for the control points. Previously stored control points are discarded
+  void SetNumberOfControlPoints(int numberOfControlPoints);
+
+  /// Store geometry of a control point. It is applied to the beam parameters only when the control point
+  /// is made current (\sa SetCurrentControlPointIndex)
+  /// \param jawPositions X1, X2, Y1, Y2 jaw positions
+  void SetControlPoint(int index, double gantryAngle, double collimatorAngle, double couchAngle,
+    const double jawPositions[4], double cumulativeMetersetWeight);
+  /// Get geometry of a stored control point
+  /// \return Success flag
+  bool GetControlPoint(int index, double& gantryAngle, double& collimatorAngle, double& couchAngle,
+    double jawPositions[4], double& cumulativeMetersetWeight);
+
+  /// Set MLC leaf pair boundaries shared by all control points
+  void SetControlPointMultiLeafCollimatorBoundaries(const std::vector<double>& boundaries);
+  /// Store MLC leaf positions of a control point: positions on side "1" followed by positions on side "2".
+  /// The number of leaf pairs is given by the boundaries (\sa SetControlPointMultiLeafCollimatorBoundaries)
+  void SetControlPointMultiLeafCollimatorPositions(int index, const std::vector<double>& positions);
+  /// Store MLC leaf positions of all control points at once: number of control points x (2 x number of leaf pairs) values,
+  /// contiguous for each control point in the same layout as for a single control point
+  void SetControlPointMultiLeafCollimatorPositions(const std::vector<double>& positions);
+  /// Get MLC leaf positions of a stored control point (in the same layout as they were set)
+  /// \return Success flag
+  bool GetControlPointMultiLeafCollimatorPositions(int index, std::vector<double>& positions);
+
+  /// Get index of the control point applied to the beam parameters. -1 if none
+  vtkGetMacro(CurrentControlPointIndex, int);
+  /// Apply a stored control point to the beam parameters (angles, jaws) and to the MLC table node.
+  /// Triggers a single \sa BeamGeometryModified and \sa BeamTransformModified event
+  void SetCurrentControlPointIndex(int index);
+
 protected:
   /// Create beam model from beam parameters, supporting MLC leaves
   /// \param beamModelPolyData Output polydata. If none given then the beam node's own polydata is used
@@ -248,6 +286,27 @@ protected:
   /// Couch angle
   double CouchAngle;
 
+protected:
+  /// Compact storage of the control points of a dynamic beam. Each array holds one value per control point
+  /// so that no MRML nodes need to be created for the individual control points
+  struct ControlPointArrays
+  {
+    std::vector<double> GantryAngles;
+    std::vector<double> CollimatorAngles;
+    std::vector<double> CouchAngles;
+    /// Jaw positions, 4 values (X1, X2, Y1, Y2) per control point
+    std::vector<double> JawPositions;
+    std::vector<double> CumulativeMetersetWeights;
+    /// MLC leaf pair boundaries (number of leaf pairs + 1 values), shared by all control points
+    std::vector<double> MultiLeafCollimatorBoundaries;
+    /// MLC leaf positions, 2 x number of leaf pairs values per control point
+    std::vector<double> MultiLeafCollimatorPositions;
+  };
+  ControlPointArrays ControlPoints;
+
+  /// Index of the control point applied to the beam parameters
+  int CurrentControlPointIndex;
+
 protected:
   /// Visible multi-leaf collimator points
   typedef std::vector< std::pair< double, double > > MLCVisiblePointVector;
@@ -20,6 +20,9 @@
 
 #include "vtkPlanarContourToClosedSurfaceConversionRule.h"
 
+// SlicerRT includes
+#include "vtkSlicerRtCommon.h"
+
 // VTK includes
 #include <vtkExtractCells.h>
 #include <vtkImageAccumulate.h>
@@ -160,6 +163,18 @@ bool vtkPlanarContourToClosedSurfaceConversionRule::Convert(vtkDataObject* sourc
     return false;
   }
 
+#if Slicer_VERSION_MAJOR >= 5 || (Slicer_VERSION_MAJOR >= 4 && Slicer_VERSION_MINOR >= 11)
+  // Contours of segments loaded on demand are empty until requested, their surface is empty as well.
+  // Empty contours of any other segment are converted as before.
+  std::string contoursDeferred;
+  if ( planarContoursPolyData->GetNumberOfPoints() == 0
+    && segment->GetTag(vtkSlicerRtCommon::DICOMRTIMPORT_ROI_CONTOURS_DEFERRED_SEGMENT_TAG_NAME, contoursDeferred) )
+  {
+    closedSurfacePolyData->Initialize();
+    return true;
+  }
+#endif
+
   // Copy the contours so that we can make modifications without affecting the original
   vtkSmartPointer<vtkPolyData> inputContoursCopy = vtkSmartPointer<vtkPolyData>::New();
 
@@ -22,6 +22,11 @@ class DicomRtImportExportPluginClass(DICOMPlugin):
     self.tags['RTPlanLabel'] = "300a,0002"
     self.tags['ReferencedSOPInstanceUID'] = "0008,1155"
 
+    # Loadables of the last examination that have not been loaded yet
+    self.pendingLoadables = []
+    # Results of the loadables that were loaded together with an earlier loadable, by file list
+    self.studyLoadResults = {}
+
   def examineForImport(self,fileLists):
     """ Returns a list of qSlicerDICOMLoadable
     instances corresponding to ways of interpreting the
@@ -29,6 +34,8 @@ class DicomRtImportExportPluginClass(DICOMPlugin):
     """
     # Create loadables for each file list
     loadables = []
+    self.pendingLoadables = loadables
+    self.studyLoadResults = {}
     for fileList in fileLists: # Each file list corresponds to one series, so do loadables
       # Convert file list to VTK object to be able to pass it for examining
       # (VTK class cannot have Qt object as argument, otherwise it is not python wrapped)
@@ -55,13 +62,33 @@ class DicomRtImportExportPluginClass(DICOMPlugin):
 
   def load(self,loadable):
     """Load the selection as an RT object
-    using the DicomRtImportExport module
+    using the DicomRtImportExport module.
+    The DICOM module loads the selected loadables one by one, so when the first
+    one is loaded, all selected loadables of the last examination are loaded
+    together as a study, in which referenced objects are loaded first
     """
-    if len(loadable.files) > 1:
-      logging.error('RT objects must be contained by a single file')
-    vtkLoadable = slicer.vtkSlicerDICOMLoadable()
-    loadable.copyToVtkLoadable(vtkLoadable)
-    success = slicer.modules.dicomrtimportexport.logic().LoadDicomRT(vtkLoadable)
+    filesKey = tuple(loadable.files)
+    if filesKey in self.studyLoadResults:
+      return self.studyLoadResults.pop(filesKey)
+
+    studyLoadables = [loadable]
+    studyLoadables += [pendingLoadable for pendingLoadable in self.pendingLoadables
+      if pendingLoadable.selected and tuple(pendingLoadable.files) != filesKey]
+    loadablesCollection = vtk.vtkCollection()
+    for studyLoadable in studyLoadables:
+      if len(studyLoadable.files) > 1:
+        logging.error('RT objects must be contained by a single file')
+      vtkLoadable = slicer.vtkSlicerDICOMLoadable()
+      studyLoadable.copyToVtkLoadable(vtkLoadable)
+      loadablesCollection.AddItem(vtkLoadable)
+    success = slicer.modules.dicomrtimportexport.logic().LoadDicomRTStudy(loadablesCollection)
+
+    # The other loadables are not loaded again when the DICOM module asks for them
+    loadedFileKeys = [tuple(studyLoadable.files) for studyLoadable in studyLoadables]
+    self.pendingLoadables = [pendingLoadable for pendingLoadable in self.pendingLoadables
+      if tuple(pendingLoadable.files) not in loadedFileKeys]
+    for otherFilesKey in loadedFileKeys[1:]:
+      self.studyLoadResults[otherFilesKey] = success
     return success
 
   def examineForExport(self,subjectHierarchyItemID):
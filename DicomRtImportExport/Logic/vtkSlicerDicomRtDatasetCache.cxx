@@ -0,0 +1,237 @@
+/*==============================================================================
+
+  Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+  Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// DicomRtImportExportModuleLogic includes
+#include "vtkSlicerDicomRtDatasetCache.h"
+
+// VTK includes
+#include <vtkObjectFactory.h>
+
+// VTKSYS includes
+#include <vtksys/SystemTools.hxx>
+
+// DCMTK includes
+#include <dcmtk/config/osconfig.h>    /* make sure OS specific configuration is included first */
+#include <dcmtk/dcmdata/dcfilefo.h>
+
+// STD includes
+#include <list>
+#include <map>
+#include <mutex>
+
+vtkStandardNewMacro(vtkSlicerDicomRtDatasetCache);
+
+namespace
+{
+  /// Default memory budget of the cache
+  const double DEFAULT_MEMORY_BUDGET_MB = 512.0;
+
+  const double BYTES_PER_MB = 1024.0 * 1024.0;
+}
+
+//----------------------------------------------------------------------------
+class vtkSlicerDicomRtDatasetCache::vtkInternal
+{
+public:
+  struct CacheEntry
+  {
+    std::shared_ptr<DcmFileFormat> FileFormat;
+    /// Modification time of the file when it was cached
+    long ModifiedTime{0};
+    /// Size of the file when it was cached. Also used as the memory estimate of the entry
+    unsigned long FileLength{0};
+    /// Position of the entry in the recently used list
+    std::list<std::string>::iterator RecentlyUsedIterator;
+  };
+
+  /// Remove entry from the cache. Mutex must be locked by the caller
+  void RemoveEntry(std::map<std::string, CacheEntry>::iterator entryIt);
+
+  /// Remove least recently used entries until the cache fits in the budget. Mutex must be locked by the caller
+  void EnforceMemoryBudget();
+
+public:
+  std::mutex Mutex;
+
+  std::map<std::string, CacheEntry> Entries;
+
+  /// File names of the entries, most recently used first
+  std::list<std::string> RecentlyUsedFileNames;
+
+  unsigned long CachedSize{0};
+
+  double MemoryBudgetMB{DEFAULT_MEMORY_BUDGET_MB};
+};
+
+//----------------------------------------------------------------------------
+void vtkSlicerDicomRtDatasetCache::vtkInternal::RemoveEntry(std::map<std::string, CacheEntry>::iterator entryIt)
+{
+  this->CachedSize -= entryIt->second.FileLength;
+  this->RecentlyUsedFileNames.erase(entryIt->second.RecentlyUsedIterator);
+  this->Entries.erase(entryIt);
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerDicomRtDatasetCache::vtkInternal::EnforceMemoryBudget()
+{
+  while (!this->RecentlyUsedFileNames.empty() && this->CachedSize > this->MemoryBudgetMB * BYTES_PER_MB)
+  {
+    this->RemoveEntry(this->Entries.find(this->RecentlyUsedFileNames.back()));
+  }
+}
+
+//----------------------------------------------------------------------------
+// vtkSlicerDicomRtDatasetCache methods
+
+//----------------------------------------------------------------------------
+vtkSlicerDicomRtDatasetCache::vtkSlicerDicomRtDatasetCache()
+{
+  this->Internal = new vtkInternal();
+}
+
+//----------------------------------------------------------------------------
+vtkSlicerDicomRtDatasetCache::~vtkSlicerDicomRtDatasetCache()
+{
+  if (this->Internal)
+  {
+    delete this->Internal;
+    this->Internal = nullptr;
+  }
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerDicomRtDatasetCache::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+
+  os << indent << "NumberOfCachedFiles: " << this->GetNumberOfCachedFiles() << "\n";
+  os << indent << "CachedSizeMB: " << this->GetCachedSizeMB() << "\n";
+  os << indent << "MemoryBudgetMB: " << this->GetMemoryBudgetMB() << "\n";
+}
+
+//----------------------------------------------------------------------------
+std::shared_ptr<DcmFileFormat> vtkSlicerDicomRtDatasetCache::GetFileFormat(const std::string& fileName)
+{
+  // Query file outside the lock, as it accesses the file system
+  long modifiedTime = vtksys::SystemTools::ModifiedTime(fileName);
+  unsigned long fileLength = vtksys::SystemTools::FileLength(fileName);
+
+  std::lock_guard<std::mutex> lock(this->Internal->Mutex);
+  auto entryIt = this->Internal->Entries.find(fileName);
+  if (entryIt == this->Internal->Entries.end())
+  {
+    return nullptr;
+  }
+  if (entryIt->second.ModifiedTime != modifiedTime || entryIt->second.FileLength != fileLength)
+  {
+    // File changed since it was cached
+    this->Internal->RemoveEntry(entryIt);
+    return nullptr;
+  }
+
+  // Move to the front of the recently used list
+  this->Internal->RecentlyUsedFileNames.splice(this->Internal->RecentlyUsedFileNames.begin(),
+    this->Internal->RecentlyUsedFileNames, entryIt->second.RecentlyUsedIterator);
+  return entryIt->second.FileFormat;
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerDicomRtDatasetCache::AddFileFormat(const std::string& fileName, std::shared_ptr<DcmFileFormat> fileFormat)
+{
+  if (fileName.empty() || !fileFormat)
+  {
+    return;
+  }
+
+  long modifiedTime = vtksys::SystemTools::ModifiedTime(fileName);
+  unsigned long fileLength = vtksys::SystemTools::FileLength(fileName);
+
+  std::lock_guard<std::mutex> lock(this->Internal->Mutex);
+  auto entryIt = this->Internal->Entries.find(fileName);
+  if (entryIt != this->Internal->Entries.end())
+  {
+    this->Internal->RemoveEntry(entryIt);
+  }
+  if (fileLength > this->Internal->MemoryBudgetMB * BYTES_PER_MB)
+  {
+    return;
+  }
+
+  vtkInternal::CacheEntry& entry = this->Internal->Entries[fileName];
+  entry.FileFormat = fileFormat;
+  entry.ModifiedTime = modifiedTime;
+  entry.FileLength = fileLength;
+  entry.RecentlyUsedIterator = this->Internal->RecentlyUsedFileNames.insert(this->Internal->RecentlyUsedFileNames.begin(), fileName);
+  this->Internal->CachedSize += fileLength;
+
+  this->Internal->EnforceMemoryBudget();
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerDicomRtDatasetCache::RemoveFileFormat(const std::string& fileName)
+{
+  std::lock_guard<std::mutex> lock(this->Internal->Mutex);
+  auto entryIt = this->Internal->Entries.find(fileName);
+  if (entryIt != this->Internal->Entries.end())
+  {
+    this->Internal->RemoveEntry(entryIt);
+  }
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerDicomRtDatasetCache::Clear()
+{
+  std::lock_guard<std::mutex> lock(this->Internal->Mutex);
+  this->Internal->Entries.clear();
+  this->Internal->RecentlyUsedFileNames.clear();
+  this->Internal->CachedSize = 0;
+}
+
+//----------------------------------------------------------------------------
+int vtkSlicerDicomRtDatasetCache::GetNumberOfCachedFiles()
+{
+  std::lock_guard<std::mutex> lock(this->Internal->Mutex);
+  return static_cast<int>(this->Internal->Entries.size());
+}
+
+//----------------------------------------------------------------------------
+double vtkSlicerDicomRtDatasetCache::GetCachedSizeMB()
+{
+  std::lock_guard<std::mutex> lock(this->Internal->Mutex);
+  return this->Internal->CachedSize / BYTES_PER_MB;
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerDicomRtDatasetCache::SetMemoryBudgetMB(double budget)
+{
+  {
+    std::lock_guard<std::mutex> lock(this->Internal->Mutex);
+    if (this->Internal->MemoryBudgetMB == budget)
+    {
+      return;
+    }
+    this->Internal->MemoryBudgetMB = budget;
+    this->Internal->EnforceMemoryBudget();
+  }
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+double vtkSlicerDicomRtDatasetCache::GetMemoryBudgetMB()
+{
+  std::lock_guard<std::mutex> lock(this->Internal->Mutex);
+  return this->Internal->MemoryBudgetMB;
+}
@@ -0,0 +1,84 @@
+/*==============================================================================
+
+  Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+  Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+#ifndef __vtkSlicerDicomRtDatasetCache_h
+#define __vtkSlicerDicomRtDatasetCache_h
+
+#include "vtkSlicerDicomRtImportExportModuleLogicExport.h"
+
+// VTK includes
+#include <vtkObject.h>
+
+// STD includes
+#include <memory>
+#include <string>
+
+class DcmFileFormat;
+
+/// \ingroup SlicerRt_QtModules_DicomRtImport
+/// \brief Cache of parsed DICOM-RT files shared between examination and loading.
+///
+/// Files are parsed once when examined for loading, and the loader reuses the parsed
+/// dataset instead of reading the file again. Entries are keyed by file path and are
+/// invalidated if the modification time or size of the file changes. The total size of the
+/// cached files is kept under a memory budget by evicting the least recently used entries.
+/// All methods are thread-safe, but a cached dataset must not be accessed from multiple
+/// threads while one of them loads values into memory.
+class VTK_SLICER_DICOMRTIMPORTEXPORT_LOGIC_EXPORT vtkSlicerDicomRtDatasetCache : public vtkObject
+{
+public:
+  static vtkSlicerDicomRtDatasetCache *New();
+  vtkTypeMacro(vtkSlicerDicomRtDatasetCache, vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent) override;
+
+  /// Get parsed file from the cache
+  /// \return Parsed file, nullptr if the file is not cached or it changed since it was cached
+  std::shared_ptr<DcmFileFormat> GetFileFormat(const std::string& fileName);
+
+  /// Add parsed file to the cache. Replaces the entry of the same file if any.
+  /// The file is not cached if it is larger than the memory budget.
+  void AddFileFormat(const std::string& fileName, std::shared_ptr<DcmFileFormat> fileFormat);
+
+  /// Remove parsed file from the cache
+  void RemoveFileFormat(const std::string& fileName);
+
+  /// Remove all entries from the cache
+  void Clear();
+
+  /// Get number of cached files
+  int GetNumberOfCachedFiles();
+
+  /// Get estimated memory used by the cached files in megabytes
+  double GetCachedSizeMB();
+
+  /// Set memory budget in megabytes. Least recently used entries are evicted if the budget is exceeded
+  void SetMemoryBudgetMB(double budget);
+  /// Get memory budget in megabytes
+  double GetMemoryBudgetMB();
+
+protected:
+  vtkSlicerDicomRtDatasetCache();
+  ~vtkSlicerDicomRtDatasetCache() override;
+
+private:
+  vtkSlicerDicomRtDatasetCache(const vtkSlicerDicomRtDatasetCache&) = delete;
+  void operator=(const vtkSlicerDicomRtDatasetCache&) = delete;
+
+  class vtkInternal;
+  vtkInternal* Internal;
+};
+
+#endif
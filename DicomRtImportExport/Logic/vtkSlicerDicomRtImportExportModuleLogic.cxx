@@ -25,6 +25,7 @@
 
 // DicomRtImportExport includes
 #include "vtkSlicerDicomRtImportExportModuleLogic.h"
+#include "vtkSlicerDicomRtDatasetCache.h"
 #include "vtkSlicerDicomRtReader.h"
 #include "vtkSlicerDicomRtWriter.h"
 #include "vtkRibbonModelToBinaryLabelmapConversionRule.h"
@@ -38,6 +39,7 @@
 
 // Qt includes
 #include <QSettings>
+#include <QSqlDatabase>
 #include "qSlicerApplication.h"
 
 // SubjectHierarchy includes
@@ -66,20 +68,20 @@
 
 // vtkSegmentationCore includes
 #include "vtkOrientedImageDataResample.h"
+#include "vtkSegment.h"
+#include "vtkSegmentation.h"
 #include "vtkSegmentationConverterFactory.h"
 
 // DCMTK includes
 #include <dcmtk/dcmdata/dcfilefo.h>
 #include <dcmtk/dcmdata/dcdeftag.h>
 #include <dcmtk/dcmdata/dcdatset.h>
+#include <dcmtk/dcmdata/dcitem.h>
+#include <dcmtk/dcmdata/dcsequen.h>
 #include <dcmtk/dcmdata/dcuid.h>
 #include <dcmtk/ofstd/ofcond.h>
 #include <dcmtk/ofstd/ofstring.h>
 #include <dcmtk/ofstd/ofstd.h> // for class OFStandard
-#include <dcmtk/dcmrt/drtdose.h>
-#include <dcmtk/dcmrt/drtimage.h>
-#include <dcmtk/dcmrt/drtplan.h>
-#include <dcmtk/dcmrt/drtstrct.h>
 
 // MRML includes
 #include <vtkMRMLColorTableNode.h>
@@ -92,10 +94,12 @@
 #include <vtkMRMLLabelMapVolumeNode.h>
 #include <vtkMRMLLabelMapVolumeDisplayNode.h>
 #include <vtkMRMLSelectionNode.h>
+#include <vtkMRMLSliceCompositeNode.h>
 #include <vtkMRMLVolumeArchetypeStorageNode.h>
 #include <vtkMRMLTableNode.h>
 #include <vtkMRMLSequenceNode.h>
 #include <vtkMRMLLinearTransformNode.h>
+#include <vtkMRMLScriptedModuleNode.h>
 
 // Sequences inludes
 #include <vtkMRMLSequenceBrowserNode.h>
@@ -105,20 +109,32 @@
 #include <vtkMRMLMarkupsDisplayNode.h>
 
 // VTK includes
+#include <vtkCallbackCommand.h>
+#include <vtkCellArray.h>
+#include <vtkCommand.h>
 #include <vtkCutter.h>
+#include <vtkDataArray.h>
+#include <vtkDataObject.h>
 #include <vtkGeneralTransform.h>
 #include <vtkImageCast.h>
 #include <vtkImageData.h>
+#include <vtkIntArray.h>
 #include <vtkLookupTable.h>
+#include <vtkMath.h>
+#include <vtkMatrix4x4.h>
 #include <vtkObjectFactory.h>
 #include <vtkPlane.h>
+#include <vtkPointData.h>
 #include <vtkPolyData.h>
+#include <vtkSMPTools.h>
 #include <vtkSmartPointer.h>
 #include <vtkStringArray.h>
 #include <vtkStripper.h>
 #include <vtkTransformPolyDataFilter.h>
+#include <vtkVersion.h>
 #include <vtkTable.h>
 #include <vtkDoubleArray.h>
+#include <vtkWeakPointer.h>
 
 // ITK includes
 #include <itkImage.h>
@@ -126,6 +142,19 @@
 // GDCM includes
 #include <gdcmIPPSorter.h>
 
+// VTKSYS includes
+#include <vtksys/SystemTools.hxx>
+
+// STD includes
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <set>
+#include <thread>
+
 // DICOMLib includes
 #include "vtkSlicerDICOMLoadable.h"
 #include "vtkSlicerDICOMExportable.h"
@@ -142,6 +171,373 @@ namespace
   {
     return ptr ? ptr : "";
   }
+
+  /// Values longer than this (contour data, pixel data, control point sequences, etc.) are not read into memory
+  /// when examining files. They are only loaded from the file if accessed, which never happens during examination
+  const Uint32 EXAMINE_MAX_READ_LENGTH = 1024;
+
+  /// Reference role from a control point sequence browser node to the dynamic beam node that stores the control points
+  const char* CONTROL_POINT_BEAM_REFERENCE_ROLE = "controlPointBeamRef";
+
+  /// Reference role from a multi-frame RT image volume node to the volume node that stores all its frames
+  const char* RTIMAGE_FRAMES_VOLUME_REFERENCE_ROLE = "rtImageFramesVolumeRef";
+  /// Reference role from a frame sequence browser node to the multi-frame RT image volume node showing the selected frame
+  const char* FRAME_SEQUENCE_RTIMAGE_REFERENCE_ROLE = "frameSequenceRtImageRef";
+  /// Attribute of a multi-frame RT image volume node storing the index of the frame it shows
+  const char* RTIMAGE_FRAME_INDEX_ATTRIBUTE_NAME = "DicomRtImport.RtImageFrameIndex";
+
+  /// Maximum deviation of the distances between consecutive slices for the slice spacing to be considered regular (mm).
+  /// Same as the default Z spacing tolerance of gdcm::IPPSorter, which is used if the tags are not in the database
+  const double SLICE_SPACING_TOLERANCE = 1e-6;
+
+  /// Connection to the application DICOM database shared by the database operations of an import session,
+  /// so that loading the objects of a study does not open and close the database for each object
+  struct DicomDatabaseConnectionPool
+  {
+    /// Open database, nullptr if not open
+    ctkDICOMDatabase* Database{nullptr};
+    /// File of the open database
+    QString DatabaseFile;
+    /// Number of references acquired and not yet released
+    int ReferenceCount{0};
+    /// Close the connection when the last reference is released
+    bool CloseRequested{false};
+  };
+
+  DicomDatabaseConnectionPool& GetDicomDatabaseConnectionPool()
+  {
+    static DicomDatabaseConnectionPool pool;
+    return pool;
+  }
+
+  void CloseDicomDatabase(DicomDatabaseConnectionPool& pool)
+  {
+    if (!pool.Database)
+    {
+      return;
+    }
+    pool.Database->closeDatabase();
+    delete pool.Database;
+    pool.Database = nullptr;
+    pool.DatabaseFile.clear();
+    QSqlDatabase::removeDatabase(vtkSlicerDicomRtReader::DICOMREADER_DICOM_CONNECTION_NAME.c_str());
+    QSqlDatabase::removeDatabase(QString(vtkSlicerDicomRtReader::DICOMREADER_DICOM_CONNECTION_NAME.c_str()) + "TagCache");
+  }
+
+  /// Get the shared connection to the application DICOM database. The database file is read from the application
+  /// settings on each call, and if it has changed, then the connection is reopened when it is not in use.
+  /// Each successful call must be paired with a call to \sa ReleaseDicomDatabase. Must be called from the main thread.
+  /// \return Open database, nullptr if the database could not be opened
+  ctkDICOMDatabase* AcquireDicomDatabase()
+  {
+    DicomDatabaseConnectionPool& pool = GetDicomDatabaseConnectionPool();
+    QSettings settings;
+    QString databaseFile = settings.value("DatabaseDirectory").toString() + vtkSlicerDicomRtReader::DICOMREADER_DICOM_DATABASE_FILENAME.c_str();
+    if (pool.Database && pool.ReferenceCount == 0 && (pool.CloseRequested || pool.DatabaseFile != databaseFile))
+    {
+      CloseDicomDatabase(pool);
+    }
+    if (!pool.Database)
+    {
+      pool.Database = new ctkDICOMDatabase();
+      pool.Database->openDatabase(databaseFile, vtkSlicerDicomRtReader::DICOMREADER_DICOM_CONNECTION_NAME.c_str());
+      if (!pool.Database->isOpen())
+      {
+        vtkGenericWarningMacro("AcquireDicomDatabase: Failed to open DICOM database " << databaseFile.toUtf8().constData());
+        CloseDicomDatabase(pool);
+        return nullptr;
+      }
+      pool.DatabaseFile = databaseFile;
+      pool.CloseRequested = false;
+    }
+
+    ++pool.ReferenceCount;
+    return pool.Database;
+  }
+
+  /// Release a reference acquired by \sa AcquireDicomDatabase
+  void ReleaseDicomDatabase()
+  {
+    DicomDatabaseConnectionPool& pool = GetDicomDatabaseConnectionPool();
+    if (pool.ReferenceCount <= 0)
+    {
+      vtkGenericWarningMacro("ReleaseDicomDatabase: DICOM database is not acquired");
+      return;
+    }
+
+    --pool.ReferenceCount;
+    if (pool.ReferenceCount == 0 && pool.CloseRequested)
+    {
+      CloseDicomDatabase(pool);
+      pool.CloseRequested = false;
+    }
+  }
+
+  /// Close the shared DICOM database connection when an import session ends.
+  /// If the connection is still in use, then it is closed when the last reference is released.
+  void ResetDicomDatabaseConnection()
+  {
+    DicomDatabaseConnectionPool& pool = GetDicomDatabaseConnectionPool();
+    if (pool.ReferenceCount > 0)
+    {
+      pool.CloseRequested = true;
+      return;
+    }
+    CloseDicomDatabase(pool);
+  }
+
+  /// Errors and warnings reported by an object processed in a worker thread. VTK logging is not thread-safe,
+  /// so the messages are collected by observing the object, and logged after the parallel section
+  struct CollectedMessages
+  {
+    std::vector<std::string> Errors;
+    std::vector<std::string> Warnings;
+  };
+
+  /// Callback of the error and warning events, client data is the \sa CollectedMessages to add the message to
+  void CollectMessageCallback(vtkObject* vtkNotUsed(caller), unsigned long eventId, void* clientData, void* callData)
+  {
+    CollectedMessages* messages = static_cast<CollectedMessages*>(clientData);
+    std::string message = SafeStr(static_cast<const char*>(callData));
+    if (eventId == vtkCommand::ErrorEvent)
+    {
+      messages->Errors.push_back(message);
+    }
+    else
+    {
+      messages->Warnings.push_back(message);
+    }
+  }
+
+  /// Copy a frame of a multi-frame image data (frame index being the third axis) into a single-frame image data
+  /// of the same size and scalar type
+  bool CopyImageFrame(vtkImageData* framesImageData, int frameIndex, vtkImageData* frameImageData)
+  {
+    int* framesDimensions = framesImageData->GetDimensions();
+    int* frameDimensions = frameImageData->GetDimensions();
+    if ( frameIndex < 0 || frameIndex >= framesDimensions[2]
+      || framesDimensions[0] != frameDimensions[0] || framesDimensions[1] != frameDimensions[1] || frameDimensions[2] != 1
+      || framesImageData->GetScalarType() != frameImageData->GetScalarType()
+      || framesImageData->GetNumberOfScalarComponents() != frameImageData->GetNumberOfScalarComponents() )
+    {
+      return false;
+    }
+    size_t bytesPerFrame = static_cast<size_t>(frameImageData->GetNumberOfPoints())
+      * frameImageData->GetScalarSize() * frameImageData->GetNumberOfScalarComponents();
+    memcpy(frameImageData->GetScalarPointer(), static_cast<char*>(framesImageData->GetScalarPointer()) + frameIndex * bytesPerFrame, bytesPerFrame);
+    frameImageData->GetPointData()->GetScalars()->Modified();
+    frameImageData->Modified();
+    return true;
+  }
+
+  /// Parse backslash separated DICOM multi-value string (e.g. Image Position (Patient)) into numbers
+  bool ParseDicomMultiValue(const QString& valueString, int numberOfValues, double* values)
+  {
+    QStringList valueStrings = valueString.split('\\');
+    if (valueStrings.size() != numberOfValues)
+    {
+      return false;
+    }
+    for (int index = 0; index < numberOfValues; ++index)
+    {
+      bool ok = false;
+      values[index] = valueStrings[index].trimmed().toDouble(&ok);
+      if (!ok)
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  /// Get image data of a volume for export.
+  /// The voxels are shared with the volume node if it is not transformed, otherwise the transformed copy is returned.
+  /// The returned image data must not be modified in place
+  bool GetVolumeOrientedImageDataForExport(vtkMRMLScalarVolumeNode* volumeNode, vtkOrientedImageData* outImageData)
+  {
+    if (!volumeNode || !volumeNode->GetImageData())
+    {
+      return false;
+    }
+    if (volumeNode->GetParentTransformNode())
+    {
+      return vtkSlicerRtCommon::ConvertVolumeNodeToVtkOrientedImageData(volumeNode, outImageData);
+    }
+    outImageData->vtkImageData::ShallowCopy(volumeNode->GetImageData());
+    vtkSmartPointer<vtkMatrix4x4> ijkToRasMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+    volumeNode->GetIJKToRASMatrix(ijkToRasMatrix);
+    outImageData->SetGeometryFromImageToWorldMatrix(ijkToRasMatrix);
+    return true;
+  }
+
+  /// Set the voxels of a mask to 1 where a labelmap layer contains the given label value, and to 0 elsewhere.
+  /// The layer and the mask must have the same geometry, but they may have different extents
+  template<typename LayerScalarType>
+  void ExtractSegmentMask(vtkOrientedImageData* labelmapLayer, LayerScalarType* vtkNotUsed(scalarTypeTag), int labelValue, vtkOrientedImageData* mask)
+  {
+    memset(mask->GetScalarPointer(), 0, mask->GetNumberOfPoints() * mask->GetScalarSize());
+
+    int maskExtent[6] = { 0, -1, 0, -1, 0, -1 };
+    mask->GetExtent(maskExtent);
+    int layerExtent[6] = { 0, -1, 0, -1, 0, -1 };
+    labelmapLayer->GetExtent(layerExtent);
+    int commonExtent[6] = { 0, -1, 0, -1, 0, -1 };
+    for (int axis = 0; axis < 3; ++axis)
+    {
+      commonExtent[2 * axis] = std::max(maskExtent[2 * axis], layerExtent[2 * axis]);
+      commonExtent[2 * axis + 1] = std::min(maskExtent[2 * axis + 1], layerExtent[2 * axis + 1]);
+      if (commonExtent[2 * axis] > commonExtent[2 * axis + 1])
+      {
+        // Segment is outside the mask
+        return;
+      }
+    }
+
+    const LayerScalarType label = static_cast<LayerScalarType>(labelValue);
+    int rowLength = commonExtent[1] - commonExtent[0] + 1;
+    for (int k = commonExtent[4]; k <= commonExtent[5]; ++k)
+    {
+      for (int j = commonExtent[2]; j <= commonExtent[3]; ++j)
+      {
+        const LayerScalarType* layerRow = static_cast<LayerScalarType*>(labelmapLayer->GetScalarPointer(commonExtent[0], j, k));
+        unsigned char* maskRow = static_cast<unsigned char*>(mask->GetScalarPointer(commonExtent[0], j, k));
+        for (int i = 0; i < rowLength; ++i)
+        {
+          maskRow[i] = (layerRow[i] == label ? 1 : 0);
+        }
+      }
+    }
+  }
+
+  /// Cut closed surface with the slice planes of an image. All planes are cut in one pass over the surface.
+  /// \param closedSurface Closed surface in the world coordinate system
+  /// \param imageToWorldMatrix Geometry of the image. Slices are perpendicular to its third axis
+  /// \param imageExtent Extent of the image
+  /// \param sliceContours Output closed polylines for each slice (third IJK coordinate) intersecting the surface
+  void CutClosedSurfaceWithImageSlices(vtkPolyData* closedSurface, vtkMatrix4x4* imageToWorldMatrix, const int imageExtent[6],
+    std::map<int, vtkSmartPointer<vtkPolyData> >& sliceContours)
+  {
+    sliceContours.clear();
+    if (!closedSurface || !closedSurface->GetPoints() || closedSurface->GetNumberOfPoints() == 0)
+    {
+      return;
+    }
+
+    double origin[3] = { imageToWorldMatrix->GetElement(0,3), imageToWorldMatrix->GetElement(1,3), imageToWorldMatrix->GetElement(2,3) };
+    double normal[3] = { imageToWorldMatrix->GetElement(0,2), imageToWorldMatrix->GetElement(1,2), imageToWorldMatrix->GetElement(2,2) };
+    double sliceSpacing = vtkMath::Normalize(normal);
+    if (sliceSpacing <= 0.0)
+    {
+      return;
+    }
+
+    // Determine the slices intersecting the surface
+    double distanceRange[2] = { VTK_DOUBLE_MAX, -VTK_DOUBLE_MAX };
+    vtkPoints* surfacePoints = closedSurface->GetPoints();
+    for (vtkIdType pointId = 0; pointId < surfacePoints->GetNumberOfPoints(); ++pointId)
+    {
+      double distance = vtkPlane::Evaluate(normal, origin, surfacePoints->GetPoint(pointId));
+      distanceRange[0] = std::min(distanceRange[0], distance);
+      distanceRange[1] = std::max(distanceRange[1], distance);
+    }
+    int firstSlice = std::max(imageExtent[4], static_cast<int>(std::ceil(distanceRange[0] / sliceSpacing)));
+    int lastSlice = std::min(imageExtent[5], static_cast<int>(std::floor(distanceRange[1] / sliceSpacing)));
+    if (firstSlice > lastSlice)
+    {
+      return;
+    }
+
+    // Cut with all slice planes at once, using the distance from the first slice as cut function
+    vtkSmartPointer<vtkPlane> slicePlane = vtkSmartPointer<vtkPlane>::New();
+    slicePlane->SetOrigin(origin);
+    slicePlane->SetNormal(normal);
+    vtkSmartPointer<vtkCutter> cutter = vtkSmartPointer<vtkCutter>::New();
+    cutter->SetInputData(closedSurface);
+    cutter->SetCutFunction(slicePlane);
+    cutter->SetGenerateCutScalars(0);
+    for (int slice = firstSlice; slice <= lastSlice; ++slice)
+    {
+      cutter->SetValue(slice - firstSlice, slice * sliceSpacing);
+    }
+    vtkSmartPointer<vtkStripper> stripper = vtkSmartPointer<vtkStripper>::New();
+    stripper->SetInputConnection(cutter->GetOutputPort());
+    stripper->Update();
+    vtkPolyData* cutPolyData = stripper->GetOutput();
+    vtkPoints* cutPoints = cutPolyData->GetPoints();
+    if (!cutPoints || !cutPolyData->GetLines())
+    {
+      return;
+    }
+
+    // Assign each polyline to the slice of its first point. The slice contours share the points of the cut
+    std::vector<vtkIdType> contourPointIds;
+    vtkIdType numberOfLinePoints = 0;
+#if VTK_MAJOR_VERSION >= 9
+    const vtkIdType* linePointIds = nullptr;
+#else
+    vtkIdType* linePointIds = nullptr;
+#endif
+    vtkCellArray* lines = cutPolyData->GetLines();
+    lines->InitTraversal();
+    while (lines->GetNextCell(numberOfLinePoints, linePointIds))
+    {
+      // Closed contours are implicitly closed in DICOM, so the repeated first point is not stored
+      if (numberOfLinePoints > 1 && linePointIds[0] == linePointIds[numberOfLinePoints - 1])
+      {
+        --numberOfLinePoints;
+      }
+      if (numberOfLinePoints < 2)
+      {
+        continue;
+      }
+
+      int slice = vtkMath::Round(vtkPlane::Evaluate(normal, origin, cutPoints->GetPoint(linePointIds[0])) / sliceSpacing);
+      vtkSmartPointer<vtkPolyData>& sliceContour = sliceContours[slice];
+      if (!sliceContour)
+      {
+        sliceContour = vtkSmartPointer<vtkPolyData>::New();
+        sliceContour->SetPoints(cutPoints);
+        sliceContour->SetLines(vtkSmartPointer<vtkCellArray>::New());
+      }
+      contourPointIds.assign(linePointIds, linePointIds + numberOfLinePoints);
+      sliceContour->GetLines()->InsertNextCell(numberOfLinePoints, contourPointIds.data());
+    }
+  }
+
+  /// Maximum number of threads used for examining files if not specified explicitly.
+  /// Examination is mostly I/O bound, so more threads than cores are used, but not so many that the disk is thrashed
+  const unsigned int EXAMINE_MAX_AUTO_NUMBER_OF_THREADS = 16;
+
+  /// Collect referenced SOP instance UIDs from the items at the end of a path of nested sequences.
+  /// All items of each sequence on the path are visited, and each UID is added only once
+  void CollectReferencedSOPInstanceUIDs(DcmItem* item, const std::vector<DcmTagKey>& sequencePath, size_t pathIndex,
+    std::vector<OFString>& referencedSOPInstanceUIDs, std::set<OFString>& foundUIDs)
+  {
+    if (!item)
+    {
+      return;
+    }
+    if (pathIndex >= sequencePath.size())
+    {
+      OFString referencedSOPInstanceUID("");
+      if ( item->findAndGetOFString(DCM_ReferencedSOPInstanceUID, referencedSOPInstanceUID).good()
+        && !referencedSOPInstanceUID.empty() && foundUIDs.insert(referencedSOPInstanceUID).second )
+      {
+        referencedSOPInstanceUIDs.push_back(referencedSOPInstanceUID);
+      }
+      return;
+    }
+
+    DcmSequenceOfItems* sequence = nullptr;
+    if (!item->findAndGetSequence(sequencePath[pathIndex], sequence).good() || !sequence)
+    {
+      return;
+    }
+    for (unsigned long itemIndex = 0; itemIndex < sequence->card(); ++itemIndex)
+    {
+      CollectReferencedSOPInstanceUIDs(sequence->getItem(itemIndex), sequencePath, pathIndex + 1, referencedSOPInstanceUIDs, foundUIDs);
+    }
+  }
 }
 
 //----------------------------------------------------------------------------
@@ -151,20 +547,55 @@ public:
   vtkInternal(vtkSlicerDicomRtImportExportModuleLogic* external);
   ~vtkInternal() = default;
 
+  /// Result of examining a single file
+  struct ExamineResult
+  {
+    /// Flag indicating whether the file is a loadable RT object
+    bool Loadable{false};
+    /// Assembled loadable name
+    OFString Name;
+    /// SOP instance UIDs referenced by the RT object
+    std::vector<OFString> ReferencedSOPInstanceUIDs;
+    /// Referenced RT plan SOP instance UID for RT dose. The plan label is appended to the name from the DICOM database
+    OFString ReferencedRtPlanSOPInstanceUID;
+  };
+
+  /// Parse a file and examine whether it is a loadable RT object.
+  /// Only uses DCMTK and the thread-safe dataset cache, so it can be called from multiple threads concurrently
+  /// \param datasetCache Cache of parsed files. The file is taken from it if cached, otherwise the parsed
+  ///   file is added to it if it can be used for loading. Optional
+  static void ExamineFile(const std::string& fileName, vtkSlicerDicomRtDatasetCache* datasetCache, ExamineResult& result);
+
+  /// Append the labels of the referenced RT plans to the names of examined RT dose objects.
+  /// Opens the DICOM database once, and only if there is an RT dose that references a plan.
+  /// Must be called from the main thread, as the DICOM database is not thread-safe
+  static void AppendReferencedRtPlanLabels(std::vector<ExamineResult>& results);
+
   /// Examine RT Dose dataset and assemble name and referenced SOP instances
-  void ExamineRtDoseDataset(DcmDataset* dataset, OFString &name, std::vector<OFString> &referencedSOPInstanceUIDs);
+  static void ExamineRtDoseDataset(DcmDataset* dataset, OFString &name, std::vector<OFString> &referencedSOPInstanceUIDs);
 
   /// Examine RT Plan dataset and assemble name and referenced SOP instances
-  void ExamineRtPlanDataset(DcmDataset* dataset, OFString &name, std::vector<OFString> &referencedSOPInstanceUIDs);
+  static void ExamineRtPlanDataset(DcmDataset* dataset, OFString &name, std::vector<OFString> &referencedSOPInstanceUIDs);
 
   /// Examine RT Ion Plan dataset and assemble name and referenced SOP instances
-  void ExamineRtIonPlanDataset(DcmDataset* dataset, OFString &name, std::vector<OFString> &referencedSOPInstanceUIDs);
+  static void ExamineRtIonPlanDataset(DcmDataset* dataset, OFString &name, std::vector<OFString> &referencedSOPInstanceUIDs);
 
   /// Examine RT Structure Set dataset and assemble name and referenced SOP instances
-  void ExamineRtStructureSetDataset(DcmDataset* dataset, OFString &name, std::vector<OFString> &referencedSOPInstanceUIDs);
+  static void ExamineRtStructureSetDataset(DcmDataset* dataset, OFString &name, std::vector<OFString> &referencedSOPInstanceUIDs);
 
   /// Examine RT Image dataset and assemble name and referenced SOP instances
-  void ExamineRtImageDataset(DcmDataset* dataset, OFString &name, std::vector<OFString> &referencedSOPInstanceUIDs);
+  static void ExamineRtImageDataset(DcmDataset* dataset, OFString &name, std::vector<OFString> &referencedSOPInstanceUIDs);
+
+  /// Create reader for a loadable and read the DICOM object
+  vtkSmartPointer<vtkSlicerDicomRtReader> ReadLoadable(vtkSlicerDICOMLoadable* loadable);
+
+  /// Load objects read by the reader of a loadable into the MRML scene
+  /// \return Success flag
+  bool LoadFromReader(vtkSlicerDicomRtReader* rtReader, vtkSlicerDICOMLoadable* loadable);
+
+  /// Get loading order of the object in a file within a study. Objects are loaded after the ones they reference.
+  /// Only the SOP class of the file is needed, so it is taken from the dataset cache or from the file header
+  static int GetStudyLoadOrder(const char* fileName, vtkSlicerDicomRtDatasetCache* datasetCache);
 
   /// Load RT Dose and related objects into the MRML scene
   /// \return Success flag
@@ -189,6 +620,16 @@ public:
     vtkMRMLLinearTransformNode* proxyTransformNode, 
     vtkMRMLTableNode* mlcTableNode, vtkMRMLTableNode* scanSpotTableNode);
 
+  /// Load dynamic photon beam into a single beam node storing all its control points (called from \sa LoadExternalBeamPlan).
+  /// A sequence browser is created for the control points, and the geometry of a control point is applied
+  /// to the beam only when the browser selects it
+  bool LoadDynamicBeamControlPoints(vtkSlicerDicomRtReader* rtReader, const char* seriesName, vtkMRMLRTPlanNode* planNode, int beamIndex);
+
+  /// Observe control point or RT image frame sequence browser node to apply the selected item to its beam or RT image
+  void ObserveSequenceBrowser(vtkMRMLSequenceBrowserNode* browserNode);
+  /// Apply the control point selected in a sequence browser node to the referenced beam
+  void UpdateBeamFromControlPointSequenceBrowser(vtkMRMLSequenceBrowserNode* browserNode);
+
   /// Load brachytherapy plan (called from \sa LoadRtPlan)
   bool LoadBrachyPlan(vtkSlicerDicomRtReader* rtReader, const char* seriesName, vtkMRMLRTPlanNode* planNode);
 
@@ -196,10 +637,59 @@ public:
   /// \return Success flag
   bool LoadRtStructureSet(vtkSlicerDicomRtReader* rtReader, vtkSlicerDICOMLoadable* loadable);
 
+  /// Create segments for the contour ROIs of a loaded structure set and add them to the segmentation node.
+  /// Segments are created and their closed surface representation is computed in parallel, then the segments are
+  /// added to the segmentation in ROI order in one batch
+  /// \param contourRoiInternalIndices Internal indices of the contour ROIs in the reader
+  /// \param createClosedSurface Flag determining whether the closed surface representation is created
+  /// \param replacedSegmentIDs Segment to replace for each contour ROI, keeping its ID and position. Empty ID if
+  ///   the segment is added. All segments are added if nullptr
+  void CreateStructureSetSegments(vtkSlicerDicomRtReader* rtReader, const std::vector<int>& contourRoiInternalIndices,
+    vtkMRMLSegmentationNode* segmentationNode, bool createClosedSurface, const std::vector<std::string>* replacedSegmentIDs=nullptr);
+
+  /// Get segmentation loaded from an earlier revision of the structure set in the reader, referencing the given image series.
+  /// The structure set is merged into this segmentation (see \sa MergeStructureSetSegments)
+  /// \return Segmentation loaded last from a structure set referencing the series, nullptr if there is none
+  vtkMRMLSegmentationNode* GetSegmentationToMergeStructureSet(vtkSlicerDicomRtReader* rtReader, const char* referencedSeriesUid);
+
+  /// Merge the contour ROIs of a loaded structure set into an existing segmentation (see \sa MergeStructureSetSegments).
+  /// Segments whose contour hash changed are rebuilt by \sa CreateStructureSetSegments, the others are kept
+  void MergeStructureSetIntoSegmentation(vtkSlicerDicomRtReader* rtReader, const std::vector<int>& contourRoiInternalIndices,
+    vtkMRMLSegmentationNode* segmentationNode, bool createClosedSurface);
+
+  /// Load the deferred contours of the segments that are visible in the given display node
+  void LoadVisibleDeferredSegmentContours(vtkMRMLSegmentationDisplayNode* displayNode);
+
   /// Load RT Image and related objects into the MRML scene
   /// \return Success flag
   bool LoadRtImage(vtkSlicerDicomRtReader* rtReader, vtkSlicerDICOMLoadable* loadable);
 
+  /// Read image and geometry of an RT image file into a volume node
+  static bool ReadRtImageFile(const char* fileName, vtkMRMLScalarVolumeNode* volumeNode);
+
+  /// Set empty image to an RT image volume node, with the dimensions and geometry read from the header tags
+  /// by the reader. The geometry is the same as if the image was read by \sa ReadRtImageFile
+  static bool SetRtImageGeometryFromHeader(vtkSlicerDicomRtReader* rtReader, vtkMRMLScalarVolumeNode* volumeNode, int scalarType=VTK_UNSIGNED_CHAR);
+
+  /// Store the frames of a multi-frame RT image decoded by the reader in a hidden volume node, and create a sequence browser
+  /// for the frames. The RT image volume node shows one frame at a time, the one selected by the browser.
+  /// Must be called before the RT image geometry is set up, as the frames share the initial geometry of the RT image
+  void LoadRtImageFrames(vtkSlicerDicomRtReader* rtReader, vtkMRMLScalarVolumeNode* volumeNode);
+  /// Copy the frame selected in a sequence browser node into the referenced multi-frame RT image
+  void UpdateRtImageFromFrameSequenceBrowser(vtkMRMLSequenceBrowserNode* browserNode);
+
+  /// Observe the display nodes of an RT image with deferred pixel loading and of its planar image model
+  void ObserveDeferredRtImageDisplayNodes(vtkMRMLScalarVolumeNode* volumeNode);
+
+  /// Stop observing an RT image with deferred pixel loading and forget its deferred pixels
+  void RemoveDeferredRtImage(vtkMRMLScalarVolumeNode* volumeNode);
+
+  /// Load the deferred pixels of the RT image that the given display node belongs to, if the display node is visible
+  void LoadVisibleDeferredRtImage(vtkMRMLDisplayNode* displayNode);
+  /// Load the deferred pixels of the RT images shown as background or foreground in the slice view of the given composite node.
+  /// Showing a volume in a slice view does not change the visibility of its display node
+  void LoadDeferredRtImagesInSliceView(vtkMRMLSliceCompositeNode* sliceCompositeNode);
+
   /// Add an ROI point to the scene
   vtkMRMLMarkupsFiducialNode* AddRoiPoint(double* roiPosition, std::string baseName, double* roiColor);
 
@@ -226,9 +716,53 @@ public:
   /// IPPSorter uses Image Position (Patient) and Image Orientation (Patient) to calculate slice spacing
   /// \param roiReferencedSeriesUid Uid of the input series for which slice spacing is to be calculated.
   double CalculateSliceSpacing(vtkSlicerDicomRtReader* rtReader, const char* roiReferencedSeriesUid);
+  /// Calculate slice spacing from the Image Position (Patient) and Image Orientation (Patient) tags of the files.
+  /// Tag values are taken from the tag cache of the DICOM database if available. Follows the rules of gdcm::IPPSorter
+  /// with its default tolerances: all slices need to have the same orientation, and the spacing needs to be regular.
+  /// \return True if the tags are found in all files. Spacing is 0 if the slices are not regularly spaced or not parallel
+  bool CalculateSliceSpacingFromImagePositions(ctkDICOMDatabase* dicomDatabase, const QStringList& fileNames, double& sliceSpacing);
 
 public:
   vtkSlicerDicomRtImportExportModuleLogic* External;
+
+  /// Structure set segments with deferred contour loading (see \sa LazyStructureSetLoading)
+  struct DeferredSegmentContours
+  {
+    /// Reader retaining the structure set that the contours are loaded from
+    vtkSmartPointer<vtkSlicerDicomRtReader> Reader;
+    /// Internal ROI index in the reader for each segment with contours not loaded yet
+    std::map<std::string, int> SegmentIDToRoiInternalIndexMap;
+    /// Observed segmentation display node
+    vtkWeakPointer<vtkMRMLSegmentationDisplayNode> DisplayNode;
+  };
+  /// Deferred segment contours for each segmentation node ID
+  std::map<std::string, DeferredSegmentContours> DeferredSegmentContoursMap;
+
+  /// Flag indicating that deferred contours are being loaded. Prevents re-entrant loading on display node modified events
+  bool LoadingDeferredSegmentContours;
+
+  /// RT image with deferred pixel loading (see \sa LazyRtImageLoading)
+  struct DeferredRtImage
+  {
+    /// File that the pixels are read from
+    std::string FileName;
+    /// Visibility of the volume display node before it was hidden, restored when the pixels are loaded
+    bool VolumeVisibility{true};
+    /// Observed display nodes of the RT image volume and of its planar image model
+    std::vector<vtkWeakPointer<vtkMRMLDisplayNode> > DisplayNodes;
+  };
+  /// Deferred RT images for each volume node ID
+  std::map<std::string, DeferredRtImage> DeferredRtImageMap;
+
+  /// Slice spacing calculated for a series, valid as long as the files of the series do not change
+  struct SliceSpacingCacheEntry
+  {
+    std::vector<std::string> FileNames;
+    std::vector<long> ModifiedTimes;
+    double SliceSpacing;
+  };
+  /// Calculated slice spacings for each series instance UID (see \sa CalculateSliceSpacing)
+  std::map<std::string, SliceSpacingCacheEntry> SliceSpacingCache;
 };
 
 //----------------------------------------------------------------------------
@@ -237,7 +771,142 @@ public:
 //----------------------------------------------------------------------------
 vtkSlicerDicomRtImportExportModuleLogic::vtkInternal::vtkInternal(vtkSlicerDicomRtImportExportModuleLogic* external)
   : External(external)
+  , LoadingDeferredSegmentContours(false)
+{
+}
+
+//-----------------------------------------------------------------------------
+void vtkSlicerDicomRtImportExportModuleLogic::vtkInternal::ExamineFile(
+  const std::string& fileName, vtkSlicerDicomRtDatasetCache* datasetCache, ExamineResult& result)
+{
+  result.Loadable = false;
+
+  // Use already parsed file if available
+  std::shared_ptr<DcmFileFormat> fileformat;
+  if (datasetCache)
+  {
+    fileformat = datasetCache->GetFileFormat(fileName);
+  }
+  bool parsed = false;
+  if (!fileformat)
+  {
+    // Load file header in DCMTK. Parsing stops at the pixel data, and long values (such as contour data)
+    // are not read, as only short identifying tags and references are needed for examination
+    fileformat = std::make_shared<DcmFileFormat>();
+    OFCondition condition = fileformat->loadFileUntilTag( fileName.c_str(), EXS_Unknown, EGL_noChange,
+      EXAMINE_MAX_READ_LENGTH, ERM_autoDetect, DCM_PixelData );
+    if (!condition.good())
+    {
+      return; // Failed to parse this file, skip it
+    }
+    parsed = true;
+  }
+
+  // Check SOP Class UID for one of the supported RT objects
+  DcmDataset *dataset = fileformat->getDataset();
+  OFString sopClass;
+  if (!dataset->findAndGetOFString(DCM_SOPClassUID, sopClass).good() || sopClass.empty())
+  {
+    return; // Failed to parse this file, skip it
+  }
+
+  // DICOM parsing is successful, now check if the object is loadable
+  OFString seriesNumber("");
+  dataset->findAndGetOFString(DCM_SeriesNumber, seriesNumber);
+  if (!seriesNumber.empty())
+  {
+    result.Name += seriesNumber + ": ";
+  }
+
+  // RTDose
+  if (sopClass == UID_RTDoseStorage)
+  {
+    ExamineRtDoseDataset(dataset, result.Name, result.ReferencedSOPInstanceUIDs);
+    if (!result.ReferencedSOPInstanceUIDs.empty())
+    {
+      result.ReferencedRtPlanSOPInstanceUID = result.ReferencedSOPInstanceUIDs[0];
+    }
+  }
+  // RTPlan
+  else if (sopClass == UID_RTPlanStorage)
+  {
+    ExamineRtPlanDataset(dataset, result.Name, result.ReferencedSOPInstanceUIDs);
+  }
+  // RTIonPlan
+  else if (sopClass == UID_RTIonPlanStorage)
+  {
+    ExamineRtPlanDataset(dataset, result.Name, result.ReferencedSOPInstanceUIDs);
+  }
+  // RTStructureSet
+  else if (sopClass == UID_RTStructureSetStorage)
+  {
+    ExamineRtStructureSetDataset(dataset, result.Name, result.ReferencedSOPInstanceUIDs);
+  }
+  // RTImage
+  else if (sopClass == UID_RTImageStorage)
+  {
+    ExamineRtImageDataset(dataset, result.Name, result.ReferencedSOPInstanceUIDs);
+  }
+  /* Not yet supported
+  else if (sopClass == UID_RTTreatmentSummaryRecordStorage)
+  else if (sopClass == UID_RTIonBeamsTreatmentRecordStorage)
+  */
+  else
+  {
+    return; // Not an RT file
+  }
+
+  result.Loadable = true;
+
+  // Cache the parsed file for loading. Objects without pixel data are completely parsed (long values are read from
+  // the file on demand), but parsing of objects containing pixel data stopped before the pixel data, so they are not cached
+  if ( parsed && datasetCache
+    && (sopClass == UID_RTPlanStorage || sopClass == UID_RTIonPlanStorage || sopClass == UID_RTStructureSetStorage) )
+  {
+    datasetCache->AddFileFormat(fileName, fileformat);
+  }
+}
+
+//-----------------------------------------------------------------------------
+void vtkSlicerDicomRtImportExportModuleLogic::vtkInternal::AppendReferencedRtPlanLabels(std::vector<ExamineResult>& results)
 {
+  bool planLabelNeeded = false;
+  for (const ExamineResult& result : results)
+  {
+    if (result.Loadable && !result.ReferencedRtPlanSOPInstanceUID.empty())
+    {
+      planLabelNeeded = true;
+      break;
+    }
+  }
+  if (!planLabelNeeded)
+  {
+    return;
+  }
+
+  // Get shared DICOM database connection to perform database operations for getting RTPlan name
+  ctkDICOMDatabase* dicomDatabase = AcquireDicomDatabase();
+  if (!dicomDatabase)
+  {
+    return;
+  }
+
+  // Get RTPlan name to show it with the dose
+  QString rtPlanLabelTag("300a,0002");
+  for (ExamineResult& result : results)
+  {
+    if (!result.Loadable || result.ReferencedRtPlanSOPInstanceUID.empty())
+    {
+      continue;
+    }
+    QString rtPlanFileName = dicomDatabase->fileForInstance(result.ReferencedRtPlanSOPInstanceUID.c_str());
+    if (!rtPlanFileName.isEmpty())
+    {
+      result.Name += OFString(": ") + OFString(dicomDatabase->fileValue(rtPlanFileName,rtPlanLabelTag).toUtf8().constData());
+    }
+  }
+
+  ReleaseDicomDatabase();
 }
 
 //-----------------------------------------------------------------------------
@@ -263,46 +932,15 @@ void vtkSlicerDicomRtImportExportModuleLogic::vtkInternal::ExamineRtDoseDataset(
     name += " [" + instanceNumber + "]";
   }
 
-  // Find RTPlan name for RTDose series
+  // Find referenced RTPlan for RTDose series (its name is added in \sa AppendReferencedRtPlanLabels)
   OFString referencedSOPInstanceUID("");
-  DRTDoseIOD rtDoseObject;
-  if (rtDoseObject.read(*dataset).good())
-  {
-    DRTReferencedRTPlanSequence &referencedRTPlanSequence = rtDoseObject.getReferencedRTPlanSequence();
-    if (referencedRTPlanSequence.gotoFirstItem().good())
-    {
-      DRTReferencedRTPlanSequence::Item &referencedRTPlanSequenceItem = referencedRTPlanSequence.getCurrentItem();
-      if (referencedRTPlanSequenceItem.isValid())
-      {
-        if (referencedRTPlanSequenceItem.getReferencedSOPInstanceUID(referencedSOPInstanceUID).good())
-        {
-          referencedSOPInstanceUIDs.push_back(referencedSOPInstanceUID);
-        }
-      }
-    }
-  }
-
-  // Create and open DICOM database to perform database operations for getting RTPlan name
-  QSettings settings;
-  QString databaseDirectory = settings.value("DatabaseDirectory").toString();
-  QString databaseFile = databaseDirectory + vtkSlicerDicomRtReader::DICOMREADER_DICOM_DATABASE_FILENAME.c_str();
-  ctkDICOMDatabase* dicomDatabase = new ctkDICOMDatabase();
-  dicomDatabase->openDatabase(databaseFile, vtkSlicerDicomRtReader::DICOMREADER_DICOM_CONNECTION_NAME.c_str());
-
-  // Get RTPlan name to show it with the dose
-  //TODO: Uncomment this line when figured out the reason for the crash, see https://github.com/SlicerRt/SlicerRT/issues/135
-  QString rtPlanLabelTag("300a,0002");
-  QString rtPlanFileName = dicomDatabase->fileForInstance(referencedSOPInstanceUID.c_str());
-  if (!rtPlanFileName.isEmpty())
+  DcmItem* referencedRTPlanItem = nullptr;
+  if ( dataset->findAndGetSequenceItem(DCM_ReferencedRTPlanSequence, referencedRTPlanItem, 0).good()
+    && referencedRTPlanItem->findAndGetOFString(DCM_ReferencedSOPInstanceUID, referencedSOPInstanceUID).good()
+    && !referencedSOPInstanceUID.empty() )
   {
-   name += OFString(": ") + OFString(dicomDatabase->fileValue(rtPlanFileName,rtPlanLabelTag).toUtf8().constData());
+    referencedSOPInstanceUIDs.push_back(referencedSOPInstanceUID);
   }
-
-  // Close and delete DICOM database
-  dicomDatabase->closeDatabase();
-  delete dicomDatabase;
-  QSqlDatabase::removeDatabase(vtkSlicerDicomRtReader::DICOMREADER_DICOM_CONNECTION_NAME.c_str());
-  QSqlDatabase::removeDatabase(QString(vtkSlicerDicomRtReader::DICOMREADER_DICOM_CONNECTION_NAME.c_str()) + "TagCache");
 }
 
 //-----------------------------------------------------------------------------
@@ -358,98 +996,25 @@ void vtkSlicerDicomRtImportExportModuleLogic::vtkInternal::ExamineRtStructureSet
     name += ": " + structLabel;
   }
 
-  // Get referenced image instance UIDs
-  OFString referencedSOPInstanceUID("");
-  DRTStructureSetIOD rtStructureSetObject;
-  if (rtStructureSetObject.read(*dataset).good())
-  {
-    DRTROIContourSequence &rtROIContourSequenceObject = rtStructureSetObject.getROIContourSequence();
-    if (rtROIContourSequenceObject.gotoFirstItem().good())
-    {
-      do // For all ROIs
-      {
-        DRTROIContourSequence::Item &currentRoiObject = rtROIContourSequenceObject.getCurrentItem();
-        if (currentRoiObject.isValid())
-        {
-          DRTContourSequence &rtContourSequenceObject = currentRoiObject.getContourSequence();
-          if (rtContourSequenceObject.gotoFirstItem().good())
-          {
-            do // For all contours
-            {
-              DRTContourSequence::Item &contourItem = rtContourSequenceObject.getCurrentItem();
-              if (!contourItem.isValid())
-              {
-                DRTContourImageSequence &rtContourImageSequenceObject = contourItem.getContourImageSequence();
-                if (rtContourImageSequenceObject.gotoFirstItem().good())
-                {
-                  DRTContourImageSequence::Item &rtContourImageSequenceItem = rtContourImageSequenceObject.getCurrentItem();
-                  if (rtContourImageSequenceItem.isValid())
-                  {
-                    OFString referencedSOPInstanceUID("");
-                    if (rtContourImageSequenceItem.getReferencedSOPInstanceUID(referencedSOPInstanceUID).good())
-                    {
-                      referencedSOPInstanceUIDs.push_back(referencedSOPInstanceUID);
-                    }
-                  }
-                }
-              }
-            } // For all contours
-            while (rtContourSequenceObject.gotoNextItem().good());
-          }
-        }
-      } // For all ROIs
-      while (rtROIContourSequenceObject.gotoNextItem().good());
-    } // End ROIContourSequence
+  // Get referenced image instance UIDs by walking only the sequences leading to the contour image references.
+  // The structure set IOD is not parsed, so the (potentially huge) contour data is never decoded.
+  std::set<OFString> foundUIDs;
+  std::vector<DcmTagKey> contourImagePath;
+  contourImagePath.push_back(DCM_ROIContourSequence);
+  contourImagePath.push_back(DCM_ContourSequence);
+  contourImagePath.push_back(DCM_ContourImageSequence);
+  CollectReferencedSOPInstanceUIDs(dataset, contourImagePath, 0, referencedSOPInstanceUIDs, foundUIDs);
 
-    // If the above tags do not store the referenced instance UIDs, then look at the other possible place
-    if (referencedSOPInstanceUIDs.empty())
-    {
-      DRTReferencedFrameOfReferenceSequence &rtReferencedFrameOfReferenceSequenceObject = rtStructureSetObject.getReferencedFrameOfReferenceSequence();
-      if (rtReferencedFrameOfReferenceSequenceObject.gotoFirstItem().good())
-      {
-        DRTReferencedFrameOfReferenceSequence::Item &currentReferencedFrameOfReferenceSequenceItem = rtReferencedFrameOfReferenceSequenceObject.getCurrentItem();
-        if (currentReferencedFrameOfReferenceSequenceItem.isValid())
-        {
-          DRTRTReferencedStudySequence &rtReferencedStudySequenceObject = currentReferencedFrameOfReferenceSequenceItem.getRTReferencedStudySequence();
-          if (rtReferencedStudySequenceObject.gotoFirstItem().good())
-          {
-            DRTRTReferencedStudySequence::Item &rtReferencedStudySequenceItem = rtReferencedStudySequenceObject.getCurrentItem();
-            if (rtReferencedStudySequenceItem.isValid())
-            {
-              DRTRTReferencedSeriesSequence &rtReferencedSeriesSequenceObject = rtReferencedStudySequenceItem.getRTReferencedSeriesSequence();
-              if (rtReferencedSeriesSequenceObject.gotoFirstItem().good())
-              {
-                if (rtReferencedSeriesSequenceObject.gotoFirstItem().good())
-                {
-                  DRTRTReferencedSeriesSequence::Item &rtReferencedSeriesSequenceItem = rtReferencedSeriesSequenceObject.getCurrentItem();
-                  if (rtReferencedSeriesSequenceItem.isValid())
-                  {
-                    DRTContourImageSequence &rtContourImageSequenceObject = rtReferencedSeriesSequenceItem.getContourImageSequence();
-                    if (rtContourImageSequenceObject.gotoFirstItem().good())
-                    {
-                      do
-                      {
-                        DRTContourImageSequence::Item &rtContourImageSequenceItem = rtContourImageSequenceObject.getCurrentItem();
-                        if (rtContourImageSequenceItem.isValid())
-                        {
-                          OFString referencedSOPInstanceUID("");
-                          if (rtContourImageSequenceItem.getReferencedSOPInstanceUID(referencedSOPInstanceUID).good())
-                          {
-                            referencedSOPInstanceUIDs.push_back(referencedSOPInstanceUID);
-                          }
-                        }
-                      } // For all contours
-                      while (rtContourImageSequenceObject.gotoNextItem().good());
-                    }
-                  }
-                }
-              }
-            }
-          }
-        }
-      }
-    } // End DRTReferencedFrameOfReferenceSequence
-  } // End finding referenced instance UIDs
+  // If the above tags do not store the referenced instance UIDs, then look at the other possible place
+  if (referencedSOPInstanceUIDs.empty())
+  {
+    std::vector<DcmTagKey> referencedSeriesPath;
+    referencedSeriesPath.push_back(DCM_ReferencedFrameOfReferenceSequence);
+    referencedSeriesPath.push_back(DCM_RTReferencedStudySequence);
+    referencedSeriesPath.push_back(DCM_RTReferencedSeriesSequence);
+    referencedSeriesPath.push_back(DCM_ContourImageSequence);
+    CollectReferencedSOPInstanceUIDs(dataset, referencedSeriesPath, 0, referencedSOPInstanceUIDs, foundUIDs);
+  }
 }
 
 //-----------------------------------------------------------------------------
@@ -471,18 +1036,11 @@ void vtkSlicerDicomRtImportExportModuleLogic::vtkInternal::ExamineRtImageDataset
 
   // Get referenced RTPlan
   OFString referencedSOPInstanceUID("");
-  DRTImageIOD rtImageObject;
-  if (rtImageObject.read(*dataset).good())
+  DcmItem* referencedRTPlanItem = nullptr;
+  if ( dataset->findAndGetSequenceItem(DCM_ReferencedRTPlanSequence, referencedRTPlanItem, 0).good()
+    && referencedRTPlanItem->findAndGetOFString(DCM_ReferencedSOPInstanceUID, referencedSOPInstanceUID).good() )
   {
-    DRTReferencedRTPlanSequenceInRTImageModule &rtReferencedRtPlanSequenceObject = rtImageObject.getReferencedRTPlanSequence();
-    if (rtReferencedRtPlanSequenceObject.gotoFirstItem().good())
-    {
-      DRTReferencedRTPlanSequenceInRTImageModule::Item &currentReferencedRtPlanSequenceObject = rtReferencedRtPlanSequenceObject.getCurrentItem();
-      if (currentReferencedRtPlanSequenceObject.getReferencedSOPInstanceUID(referencedSOPInstanceUID).good())
-      {
-        referencedSOPInstanceUIDs.push_back(referencedSOPInstanceUID);
-      }
-    }
+    referencedSOPInstanceUIDs.push_back(referencedSOPInstanceUID);
   }
 }
 
@@ -499,56 +1057,63 @@ bool vtkSlicerDicomRtImportExportModuleLogic::vtkInternal::LoadRtDose(vtkSlicerD
   const char* fileName = loadable->GetFiles()->GetValue(0);
   const char* seriesName = loadable->GetName();
 
-  // Load Volume
-  vtkSmartPointer<vtkMRMLVolumeArchetypeStorageNode> volumeStorageNode = vtkSmartPointer<vtkMRMLVolumeArchetypeStorageNode>::New();
   vtkSmartPointer<vtkMRMLScalarVolumeNode> volumeNode = vtkSmartPointer<vtkMRMLScalarVolumeNode>::New();
-  volumeStorageNode->SetFileName(fileName);
-  volumeStorageNode->ResetFileNameList();
-  volumeStorageNode->SetSingleFile(1);
-
-  // Read volume from disk
-  if (!volumeStorageNode->ReadData(volumeNode))
+  if (!rtReader->GetDoseGridScaling())
   {
-    vtkErrorWithObjectMacro(this->External, "LoadRtDose: Failed to load dose volume file '" << fileName << "' (series name '" << seriesName << "')");
-    return false;
+    vtkErrorWithObjectMacro(this->External, "LoadRtDose: Empty dose unit value found for dose series '" << seriesName << "'");
   }
+  double doseGridScaling = vtkVariant(rtReader->GetDoseGridScaling()).ToDouble();
 
-  volumeNode->SetScene(this->External->GetMRMLScene());
-  std::string volumeNodeName = scene->GenerateUniqueName(seriesName);
-  volumeNode->SetName(volumeNodeName.c_str());
-
-  // Set new spacing
-  double* initialSpacing = volumeNode->GetSpacing();
-  double* correctSpacing = rtReader->GetPixelSpacing();
-  volumeNode->SetSpacing(correctSpacing[0], correctSpacing[1], initialSpacing[2]);
-  volumeNode->SetAttribute(vtkSlicerRtCommon::DICOMRTIMPORT_DOSE_VOLUME_IDENTIFIER_ATTRIBUTE_NAME.c_str(), "1");
-  scene->AddNode(volumeNode);
-
-  // Apply dose grid scaling
-  if (!rtReader->GetDoseGridScaling())
+  if (rtReader->GetDoseImageData() && rtReader->GetDoseIJKToRASMatrix())
   {
-    vtkErrorWithObjectMacro(this->External, "LoadRtDose: Empty dose unit value found for dose volume " << volumeNode->GetName());
+    // Dose voxels have been decoded and scaled by the reader
+    volumeNode->SetIJKToRASMatrix(rtReader->GetDoseIJKToRASMatrix());
+    volumeNode->SetAndObserveImageData(rtReader->GetDoseImageData());
   }
-  double doseGridScaling = vtkVariant(rtReader->GetDoseGridScaling()).ToDouble();
+  else
+  {
+    // Read volume from disk using the generic reader (e.g. for compressed pixel data)
+    vtkSmartPointer<vtkMRMLVolumeArchetypeStorageNode> volumeStorageNode = vtkSmartPointer<vtkMRMLVolumeArchetypeStorageNode>::New();
+    volumeStorageNode->SetFileName(fileName);
+    volumeStorageNode->ResetFileNameList();
+    volumeStorageNode->SetSingleFile(1);
+    if (!volumeStorageNode->ReadData(volumeNode))
+    {
+      vtkErrorWithObjectMacro(this->External, "LoadRtDose: Failed to load dose volume file '" << fileName << "' (series name '" << seriesName << "')");
+      return false;
+    }
 
-  vtkSmartPointer<vtkImageData> floatVolumeData = vtkSmartPointer<vtkImageData>::New();
+    // Set new spacing
+    double* initialSpacing = volumeNode->GetSpacing();
+    double* correctSpacing = rtReader->GetPixelSpacing();
+    volumeNode->SetSpacing(correctSpacing[0], correctSpacing[1], initialSpacing[2]);
 
-  vtkSmartPointer<vtkImageCast> imageCast = vtkSmartPointer<vtkImageCast>::New();
-  imageCast->SetInputData(volumeNode->GetImageData());
-  imageCast->SetOutputScalarTypeToFloat();
-  imageCast->Update();
-  floatVolumeData->DeepCopy(imageCast->GetOutput());
+    // Apply dose grid scaling
+    vtkSmartPointer<vtkImageData> floatVolumeData = vtkSmartPointer<vtkImageData>::New();
 
-  float value = 0.0;
-  float* floatPtr = (float*)floatVolumeData->GetScalarPointer();
-  for (long i=0; i<floatVolumeData->GetNumberOfPoints(); ++i)
-  {
-    value = (*floatPtr) * doseGridScaling;
-    (*floatPtr) = value;
-    ++floatPtr;
+    vtkSmartPointer<vtkImageCast> imageCast = vtkSmartPointer<vtkImageCast>::New();
+    imageCast->SetInputData(volumeNode->GetImageData());
+    imageCast->SetOutputScalarTypeToFloat();
+    imageCast->Update();
+    floatVolumeData->DeepCopy(imageCast->GetOutput());
+
+    float value = 0.0;
+    float* floatPtr = (float*)floatVolumeData->GetScalarPointer();
+    for (long i=0; i<floatVolumeData->GetNumberOfPoints(); ++i)
+    {
+      value = (*floatPtr) * doseGridScaling;
+      (*floatPtr) = value;
+      ++floatPtr;
+    }
+
+    volumeNode->SetAndObserveImageData(floatVolumeData);
   }
 
-  volumeNode->SetAndObserveImageData(floatVolumeData);
+  volumeNode->SetScene(this->External->GetMRMLScene());
+  std::string volumeNodeName = scene->GenerateUniqueName(seriesName);
+  volumeNode->SetName(volumeNodeName.c_str());
+  volumeNode->SetAttribute(vtkSlicerRtCommon::DICOMRTIMPORT_DOSE_VOLUME_IDENTIFIER_ATTRIBUTE_NAME.c_str(), "1");
+  scene->AddNode(volumeNode);
 
   // Get default isodose color table and default dose color table
   vtkMRMLColorTableNode* defaultIsodoseColorTable = vtkSlicerIsodoseModuleLogic::GetDefaultIsodoseColorTable(scene);
@@ -822,6 +1387,15 @@ bool vtkSlicerDicomRtImportExportModuleLogic::vtkInternal::LoadExternalBeamPlan(
     {
       ionBeamNode = vtkMRMLRTIonBeamNode::SafeDownCast(beamNode);
     }
+    else if (!singleBeam && rtReader->GetLoadRTPlanSuccessful())
+    {
+      // Control points of all dynamic photon beams are stored in the beam node, so for photon plans
+      // the per control point sequences below are not created. Those are only used for ion beams
+      if (!this->LoadDynamicBeamControlPoints(rtReader, seriesName, planNode, beamIndex))
+      {
+        return false;
+      }
+    }
     else if (!singleBeam && this->LoadDynamicBeamSequence( rtReader, seriesName, 
       planNode, beamIndex, beamNode, beamTransformNode, mlcTableNode, scanSpotTableNode))
     {
@@ -1366,6 +1940,121 @@ bool vtkSlicerDicomRtImportExportModuleLogic::vtkInternal::LoadDynamicBeamSequen
   return true;
 }
 
+//---------------------------------------------------------------------------
+bool vtkSlicerDicomRtImportExportModuleLogic::vtkInternal::LoadDynamicBeamControlPoints(
+  vtkSlicerDicomRtReader* rtReader, const char* seriesName, vtkMRMLRTPlanNode* planNode, int beamIndex)
+{
+  vtkMRMLScene* scene = planNode->GetScene();
+
+  unsigned int dicomBeamNumber = rtReader->GetBeamNumberForIndex(beamIndex);
+  const char* beamName = rtReader->GetBeamName(dicomBeamNumber);
+  unsigned int numberOfControlPoints = rtReader->GetBeamNumberOfControlPoints(dicomBeamNumber);
+  const char* treatmentDeliveryType = rtReader->GetBeamTreatmentDeliveryType(dicomBeamNumber);
+
+  // Create beam with the geometry of the first control point the same way as static beams
+  vtkMRMLRTBeamNode* beamNode = this->LoadStaticBeam(rtReader, seriesName, planNode, beamIndex, nullptr, nullptr);
+  if (!beamNode)
+  {
+    vtkErrorWithObjectMacro(this->External, "LoadDynamicBeamControlPoints: Failed to load beam " << (beamName ? beamName : ""));
+    return false;
+  }
+  std::ostringstream nameStream;
+  nameStream << beamName;
+  if (treatmentDeliveryType)
+  {
+    nameStream << " [" << treatmentDeliveryType << "]";
+  }
+  beamNode->SetName(nameStream.str().c_str());
+
+  // Store control points in the beam node. Values that are not present in a control point are
+  // unchanged from the previous control point
+  beamNode->SetNumberOfControlPoints(numberOfControlPoints);
+  std::vector<double> mlcBoundaries, mlcPositions;
+  if (rtReader->GetBeamMultiLeafCollimatorPositions(dicomBeamNumber, mlcBoundaries, mlcPositions))
+  {
+    beamNode->SetControlPointMultiLeafCollimatorBoundaries(mlcBoundaries);
+    beamNode->SetControlPointMultiLeafCollimatorPositions(mlcPositions);
+  }
+  double jawPositions[4] = { beamNode->GetX1Jaw(), beamNode->GetX2Jaw(), beamNode->GetY1Jaw(), beamNode->GetY2Jaw() };
+  for (unsigned int controlPointIndex = 0; controlPointIndex < numberOfControlPoints; ++controlPointIndex)
+  {
+    double controlPointJawPositions[2][2] = {{0.0, 0.0},{0.0, 0.0}};
+    if (rtReader->GetBeamControlPointJawPositions( dicomBeamNumber, controlPointIndex, controlPointJawPositions))
+    {
+      jawPositions[0] = controlPointJawPositions[0][0];
+      jawPositions[1] = controlPointJawPositions[0][1];
+      jawPositions[2] = controlPointJawPositions[1][0];
+      jawPositions[3] = controlPointJawPositions[1][1];
+    }
+    beamNode->SetControlPoint( controlPointIndex,
+      rtReader->GetBeamControlPointGantryAngle( dicomBeamNumber, controlPointIndex),
+      rtReader->GetBeamControlPointBeamLimitingDeviceAngle( dicomBeamNumber, controlPointIndex),
+      rtReader->GetBeamControlPointPatientSupportAngle( dicomBeamNumber, controlPointIndex),
+      jawPositions, rtReader->GetBeamControlPointCumulativeMetersetWeight( dicomBeamNumber, controlPointIndex) );
+  }
+
+  // Create sequence of lightweight nodes that only identify the control points, so that they can be browsed
+  vtkNew<vtkMRMLSequenceNode> controlPointSequenceNode;
+  std::string name = std::string(beamNode->GetName()) + "_ControlPoints";
+  controlPointSequenceNode->SetName(name.c_str());
+  controlPointSequenceNode->SetIndexName("Control point");
+  controlPointSequenceNode->SetIndexUnit("index");
+  controlPointSequenceNode->SetIndexType(vtkMRMLSequenceNode::NumericIndex);
+  scene->AddNode(controlPointSequenceNode);
+
+  vtkNew<vtkMRMLScriptedModuleNode> controlPointNode;
+  for (unsigned int controlPointIndex = 0; controlPointIndex < numberOfControlPoints; ++controlPointIndex)
+  {
+    std::string controlPointIndexStr = std::to_string(controlPointIndex);
+    controlPointNode->SetName((std::string("CP") + controlPointIndexStr).c_str());
+    controlPointNode->SetParameter("ControlPointIndex", controlPointIndexStr);
+    controlPointNode->SetParameter("CumulativeMetersetWeight",
+      vtkVariant(rtReader->GetBeamControlPointCumulativeMetersetWeight(dicomBeamNumber, controlPointIndex)).ToString() );
+    controlPointSequenceNode->SetDataNodeAtValue(controlPointNode, controlPointIndexStr);
+  }
+
+  vtkNew<vtkMRMLSequenceBrowserNode> beamSequenceBrowserNode;
+  name = std::string(beamName) + "_SequenceBrowser";
+  beamSequenceBrowserNode->SetName(name.c_str());
+  scene->AddNode(beamSequenceBrowserNode);
+  beamSequenceBrowserNode->SetAndObserveMasterSequenceNodeID(controlPointSequenceNode->GetID());
+  beamSequenceBrowserNode->SetNodeReferenceID(CONTROL_POINT_BEAM_REFERENCE_ROLE, beamNode->GetID());
+
+  // Apply the first control point, then the others when the browser selects them
+  beamNode->SetCurrentControlPointIndex(0);
+  this->ObserveSequenceBrowser(beamSequenceBrowserNode);
+
+  return true;
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerDicomRtImportExportModuleLogic::vtkInternal::ObserveSequenceBrowser(vtkMRMLSequenceBrowserNode* browserNode)
+{
+  if (!browserNode)
+  {
+    return;
+  }
+  vtkSmartPointer<vtkIntArray> events = vtkSmartPointer<vtkIntArray>::New();
+  events->InsertNextValue(vtkCommand::ModifiedEvent);
+  this->External->GetMRMLNodesObserverManager()->AddObjectEvents(browserNode, events);
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerDicomRtImportExportModuleLogic::vtkInternal::UpdateBeamFromControlPointSequenceBrowser(vtkMRMLSequenceBrowserNode* browserNode)
+{
+  vtkMRMLRTBeamNode* beamNode = vtkMRMLRTBeamNode::SafeDownCast(browserNode->GetNodeReference(CONTROL_POINT_BEAM_REFERENCE_ROLE));
+  if (!beamNode)
+  {
+    return;
+  }
+  int selectedControlPointIndex = browserNode->GetSelectedItemNumber();
+  if ( selectedControlPointIndex >= 0 && selectedControlPointIndex < beamNode->GetNumberOfControlPoints()
+    && selectedControlPointIndex != beamNode->GetCurrentControlPointIndex() )
+  {
+    beamNode->SetCurrentControlPointIndex(selectedControlPointIndex);
+  }
+}
+
 //---------------------------------------------------------------------------
 bool vtkSlicerDicomRtImportExportModuleLogic::vtkInternal::LoadBrachyPlan(
   vtkSlicerDicomRtReader* rtReader, const char* seriesName, vtkMRMLRTPlanNode* planNode)
@@ -1452,6 +2141,7 @@ bool vtkSlicerDicomRtImportExportModuleLogic::vtkInternal::LoadRtStructureSet(vt
   vtkIdType segmentationShItemID = vtkMRMLSubjectHierarchyNode::INVALID_ITEM_ID;
   vtkSmartPointer<vtkMRMLSegmentationNode> segmentationNode;
   vtkSmartPointer<vtkMRMLSegmentationDisplayNode> segmentationDisplayNode;
+  bool mergeIntoSegmentation = false;
 
   const char* fileName = loadable->GetFiles()->GetValue(0);
   const char* seriesName = loadable->GetName();
@@ -1463,6 +2153,9 @@ bool vtkSlicerDicomRtImportExportModuleLogic::vtkInternal::LoadRtStructureSet(vt
   long maximumNumberOfPoints = -1;
   long totalNumberOfPoints = 0;
 
+  // Internal indices of contour ROIs, for which segments are created after all ROIs are processed
+  std::vector<int> contourRoiInternalIndices;
+
   // Add ROIs
   int numberOfRois = rtReader->GetNumberOfRois();
   for (int internalROIIndex=0; internalROIIndex<numberOfRois; internalROIIndex++)
@@ -1471,27 +2164,28 @@ bool vtkSlicerDicomRtImportExportModuleLogic::vtkInternal::LoadRtStructureSet(vt
     const char* roiLabel = rtReader->GetRoiName(internalROIIndex);
     double *roiColor = rtReader->GetRoiDisplayColor(internalROIIndex);
 
-    // Get structure
+    // Get structure. If contour loading is deferred, then only the number of points is known
     vtkPolyData* roiPolyData = rtReader->GetRoiPolyData(internalROIIndex);
-    if (roiPolyData == nullptr)
+    if (roiPolyData == nullptr && rtReader->GetRoiContoursLoaded(internalROIIndex))
     {
       vtkWarningWithObjectMacro(this->External, "LoadRtStructureSet: Invalid structure ROI data for ROI named '"
         << (roiLabel?roiLabel:"Unnamed") << "' in file '" << fileName
         << "' (internal ROI index: " << internalROIIndex << ")");
       continue;
     }
-    if (roiPolyData->GetNumberOfPoints() == 0)
+    long roiNumberOfPoints = rtReader->GetRoiNumberOfPoints(internalROIIndex);
+    if (roiNumberOfPoints == 0)
     {
       vtkWarningWithObjectMacro(this->External, "LoadRtStructureSet: Structure ROI data does not contain any points for ROI named '"
         << (roiLabel?roiLabel:"Unnamed") << "' in file '" << fileName
         << "' (internal ROI index: " << internalROIIndex << ")");
       continue;
     }
-    if (maximumNumberOfPoints < roiPolyData->GetNumberOfPoints())
+    if (maximumNumberOfPoints < roiNumberOfPoints)
     {
-      maximumNumberOfPoints = roiPolyData->GetNumberOfPoints();
+      maximumNumberOfPoints = roiNumberOfPoints;
     }
-    totalNumberOfPoints += roiPolyData->GetNumberOfPoints();
+    totalNumberOfPoints += roiNumberOfPoints;
 
     // Get referenced series UID
     const char* roiReferencedSeriesUid = rtReader->GetRoiReferencedSeriesUid(internalROIIndex);
@@ -1505,9 +2199,9 @@ bool vtkSlicerDicomRtImportExportModuleLogic::vtkInternal::LoadRtStructureSet(vt
     }
 
     //
-    // Point ROI (fiducial)
+    // Point ROI (fiducial). Contours of point ROIs are never deferred
     //
-    if (roiPolyData->GetNumberOfPoints() == 1)
+    if (roiNumberOfPoints == 1 && roiPolyData)
     {
       // Set up subject hierarchy item for the series, if it has not been done yet.
       // Only create it for fiducials, as all structures are stored in a single segmentation node
@@ -1533,6 +2227,23 @@ bool vtkSlicerDicomRtImportExportModuleLogic::vtkInternal::LoadRtStructureSet(vt
     //
     else
     {
+      // Use the segmentation loaded earlier from a structure set of the same image series if merging
+      if (segmentationNode.GetPointer() == nullptr && this->External->MergeStructureSetSegments)
+      {
+        segmentationNode = this->GetSegmentationToMergeStructureSet(rtReader, roiReferencedSeriesUid);
+        if (segmentationNode.GetPointer())
+        {
+          mergeIntoSegmentation = true;
+          segmentationDisplayNode = vtkMRMLSegmentationDisplayNode::SafeDownCast(segmentationNode->GetDisplayNode());
+
+          // Subject hierarchy item now represents the new structure set series
+          segmentationShItemID = shNode->GetItemByDataNode(segmentationNode);
+          shNode->SetItemUID(segmentationShItemID, vtkMRMLSubjectHierarchyConstants::GetDICOMUIDName(), rtReader->GetSeriesInstanceUid());
+          shNode->SetItemAttribute(segmentationShItemID,
+            vtkMRMLSubjectHierarchyConstants::GetDICOMReferencedInstanceUIDsAttributeName(), referencedSopInstanceUids );
+        }
+      }
+
       // Create segmentation node for the structure set series, if not created yet
       if (segmentationNode.GetPointer() == nullptr)
       {
@@ -1569,6 +2280,8 @@ bool vtkSlicerDicomRtImportExportModuleLogic::vtkInternal::LoadRtStructureSet(vt
         segmentationShItemID = shNode->CreateItem(shNode->GetSceneItemID(), segmentationNode);
         shNode->SetItemUID(segmentationShItemID, vtkMRMLSubjectHierarchyConstants::GetDICOMUIDName(), rtReader->GetSeriesInstanceUid());
         shNode->SetItemAttribute(segmentationShItemID, vtkSlicerRtCommon::DICOMRTIMPORT_ROI_REFERENCED_SERIES_UID_ATTRIBUTE_NAME, structureSetReferencedSeriesUid);
+        shNode->SetItemAttribute(segmentationShItemID, vtkSlicerRtCommon::DICOMRTIMPORT_STRUCTURE_SET_LABEL_ATTRIBUTE_NAME,
+          SafeStr(rtReader->GetRTStructureSetLabel()) );
         shNode->SetItemAttribute(segmentationShItemID,
           vtkMRMLSubjectHierarchyConstants::GetDICOMReferencedInstanceUIDsAttributeName(), referencedSopInstanceUids );
 
@@ -1593,33 +2306,37 @@ bool vtkSlicerDicomRtImportExportModuleLogic::vtkInternal::LoadRtStructureSet(vt
         segmentationNode->GetSegmentation()->SetConversionParameter(vtkPlanarContourToClosedSurfaceConversionRule::GetDefaultSliceThicknessParameterName(), defaultSliceThicknessStream.str());
       }
 
-      // Add segment for current structure
-      vtkSmartPointer<vtkSegment> segment = vtkSmartPointer<vtkSegment>::New();
-      segment->SetName(roiLabel);
-      segment->SetColor(roiColor[0], roiColor[1], roiColor[2]);
-      segment->AddRepresentation(vtkSegmentationConverter::GetSegmentationPlanarContourRepresentationName(), roiPolyData);
-      segmentationNode->GetSegmentation()->AddSegment(segment);
-
-      // Add DICOM ROI number as tag to the segment
-      std::stringstream roiNumberStream;
-      roiNumberStream << rtReader->GetRoiNumber(internalROIIndex);
-      segment->SetTag(vtkSlicerRtCommon::DICOMRTIMPORT_ROI_NUMBER_SEGMENT_TAG_NAME, roiNumberStream.str());
+      // Segment for current structure is created after all ROIs are processed
+      contourRoiInternalIndices.push_back(internalROIIndex);
     }
   } // for all ROIs
 
-  // Force showing closed surface model instead of contour points and calculate auto opacity values for segments
-  // Do not set closed surface display in case of extremely large structures, to prevent unreasonably long load times
+  // Closed surface model is shown instead of contour points, except in case of extremely large structures,
+  // to prevent unreasonably long load times. Arbitrary thresholds, can revisit
+  vtkDebugWithObjectMacro(this->External, "LoadRtStructureSet: Maximum number of points in a segment = " << maximumNumberOfPoints << ", Total number of points in segmentation = " << totalNumberOfPoints);
+  bool showClosedSurface = (maximumNumberOfPoints < 800000 && totalNumberOfPoints < 3000000);
+
+  // Create segments for the contour ROIs
+  if (mergeIntoSegmentation)
+  {
+    this->MergeStructureSetIntoSegmentation(rtReader, contourRoiInternalIndices, segmentationNode, showClosedSurface);
+  }
+  else if (segmentationNode.GetPointer() && !contourRoiInternalIndices.empty())
+  {
+    this->CreateStructureSetSegments(rtReader, contourRoiInternalIndices, segmentationNode, showClosedSurface);
+  }
+
+  // Force showing closed surface model instead of contour points and calculate auto opacity values for segments.
+  // Display settings of a segmentation that the structure set is merged into are kept
   if (segmentationDisplayNode.GetPointer())
   {
-    // Arbitrary thresholds, can revisit
-    vtkDebugWithObjectMacro(this->External, "LoadRtStructureSet: Maximum number of points in a segment = " << maximumNumberOfPoints << ", Total number of points in segmentation = " << totalNumberOfPoints);
-    if (maximumNumberOfPoints < 800000 && totalNumberOfPoints < 3000000)
+    if (showClosedSurface && !mergeIntoSegmentation)
     {
       segmentationDisplayNode->SetPreferredDisplayRepresentationName3D(vtkSegmentationConverter::GetSegmentationClosedSurfaceRepresentationName());
       segmentationDisplayNode->SetPreferredDisplayRepresentationName2D(vtkSegmentationConverter::GetSegmentationClosedSurfaceRepresentationName());
       segmentationDisplayNode->CalculateAutoOpacitiesForSegments();
     }
-    else
+    else if (!showClosedSurface)
     {
       vtkWarningWithObjectMacro(this->External, "LoadRtStructureSet: Structure set contains extremely large contours that will most likely take an unreasonably long time to load. No closed surface representation is thus created for nicer display, but the raw RICOM-RT planar contours are shown. It is possible to create nicer models in Segmentations module by converting to the lighter Ribbon model or the nicest Closed surface.");
     }
@@ -1635,6 +2352,362 @@ bool vtkSlicerDicomRtImportExportModuleLogic::vtkInternal::LoadRtStructureSet(vt
   return true;
 }
 
+//---------------------------------------------------------------------------
+void vtkSlicerDicomRtImportExportModuleLogic::vtkInternal::CreateStructureSetSegments(vtkSlicerDicomRtReader* rtReader,
+  const std::vector<int>& contourRoiInternalIndices, vtkMRMLSegmentationNode* segmentationNode, bool createClosedSurface,
+  const std::vector<std::string>* replacedSegmentIDs/*=nullptr*/)
+{
+  if (!rtReader || !segmentationNode || !segmentationNode->GetSegmentation())
+  {
+    vtkErrorWithObjectMacro(this->External, "CreateStructureSetSegments: Invalid inputs");
+    return;
+  }
+  vtkSegmentation* segmentation = segmentationNode->GetSegmentation();
+  vtkIdType numberOfSegments = static_cast<vtkIdType>(contourRoiInternalIndices.size());
+
+  // Get ROI properties from the reader on the calling thread
+  std::vector<std::string> roiLabels(numberOfSegments);
+  std::vector<std::array<double,3> > roiColors(numberOfSegments);
+  std::vector<vtkPolyData*> roiPolyDatas(numberOfSegments);
+  std::vector<char> roiContoursDeferred(numberOfSegments, 0);
+  std::vector<std::string> roiNumbers(numberOfSegments);
+  std::vector<std::string> roiContourHashes(numberOfSegments);
+  for (vtkIdType segmentIndex = 0; segmentIndex < numberOfSegments; ++segmentIndex)
+  {
+    int internalROIIndex = contourRoiInternalIndices[segmentIndex];
+    roiLabels[segmentIndex] = SafeStr(rtReader->GetRoiName(internalROIIndex));
+    double* roiColor = rtReader->GetRoiDisplayColor(internalROIIndex);
+    roiColors[segmentIndex] = { roiColor[0], roiColor[1], roiColor[2] };
+    roiPolyDatas[segmentIndex] = rtReader->GetRoiPolyData(internalROIIndex);
+    roiContoursDeferred[segmentIndex] = !rtReader->GetRoiContoursLoaded(internalROIIndex);
+    std::stringstream roiNumberStream;
+    roiNumberStream << rtReader->GetRoiNumber(internalROIIndex);
+    roiNumbers[segmentIndex] = roiNumberStream.str();
+    roiContourHashes[segmentIndex] = SafeStr(rtReader->GetRoiContourHash(internalROIIndex));
+  }
+
+  // Use the conversion parameters of the segmentation for the closed surface conversion
+  std::string defaultSliceThickness = segmentation->GetConversionParameter(
+    vtkPlanarContourToClosedSurfaceConversionRule::GetDefaultSliceThicknessParameterName() );
+  std::string endCapping = segmentation->GetConversionParameter(
+    vtkPlanarContourToClosedSurfaceConversionRule::GetEndCappingParameterName() );
+
+  // Create segments and their closed surface representation in parallel. The segments are independent
+  // until they are added to the segmentation, and each conversion uses its own conversion rule instance
+  std::vector<vtkSmartPointer<vtkSegment> > segments(numberOfSegments);
+  std::vector<CollectedMessages> conversionMessages(numberOfSegments);
+  vtkSMPTools::For(0, numberOfSegments, 1, [&](vtkIdType beginSegmentIndex, vtkIdType endSegmentIndex)
+  {
+    for (vtkIdType segmentIndex = beginSegmentIndex; segmentIndex < endSegmentIndex; ++segmentIndex)
+    {
+      vtkSmartPointer<vtkSegment> segment = vtkSmartPointer<vtkSegment>::New();
+      segment->SetName(roiLabels[segmentIndex].c_str());
+      segment->SetColor(roiColors[segmentIndex][0], roiColors[segmentIndex][1], roiColors[segmentIndex][2]);
+
+      // Add DICOM ROI number as tag to the segment
+      segment->SetTag(vtkSlicerRtCommon::DICOMRTIMPORT_ROI_NUMBER_SEGMENT_TAG_NAME, roiNumbers[segmentIndex]);
+      // Add contour hash to find out if the contours changed when merging a structure set into the segmentation
+      if (!roiContourHashes[segmentIndex].empty())
+      {
+        segment->SetTag(vtkSlicerRtCommon::DICOMRTIMPORT_ROI_CONTOUR_HASH_SEGMENT_TAG_NAME, roiContourHashes[segmentIndex]);
+      }
+
+      // If contour loading is deferred, then an empty planar contour is added, which is filled when loading the contours
+      if (roiContoursDeferred[segmentIndex])
+      {
+        // The tag lets the conversion rules tell not yet loaded contours from contours that are really empty
+        segment->SetTag(vtkSlicerRtCommon::DICOMRTIMPORT_ROI_CONTOURS_DEFERRED_SEGMENT_TAG_NAME, "1");
+        vtkSmartPointer<vtkPolyData> emptyPolyData = vtkSmartPointer<vtkPolyData>::New();
+        segment->AddRepresentation(vtkSegmentationConverter::GetSegmentationPlanarContourRepresentationName(), emptyPolyData);
+        segments[segmentIndex] = segment;
+        continue;
+      }
+      segment->AddRepresentation(vtkSegmentationConverter::GetSegmentationPlanarContourRepresentationName(), roiPolyDatas[segmentIndex]);
+
+      if (createClosedSurface)
+      {
+        vtkSmartPointer<vtkPlanarContourToClosedSurfaceConversionRule> conversionRule =
+          vtkSmartPointer<vtkPlanarContourToClosedSurfaceConversionRule>::New();
+        conversionRule->SetConversionParameter(
+          vtkPlanarContourToClosedSurfaceConversionRule::GetDefaultSliceThicknessParameterName(), defaultSliceThickness);
+        conversionRule->SetConversionParameter(
+          vtkPlanarContourToClosedSurfaceConversionRule::GetEndCappingParameterName(), endCapping);
+        // Errors and warnings of the conversion are collected instead of being logged from the worker thread
+        vtkSmartPointer<vtkCallbackCommand> messageCallback = vtkSmartPointer<vtkCallbackCommand>::New();
+        messageCallback->SetCallback(CollectMessageCallback);
+        messageCallback->SetClientData(&conversionMessages[segmentIndex]);
+        conversionRule->AddObserver(vtkCommand::ErrorEvent, messageCallback);
+        conversionRule->AddObserver(vtkCommand::WarningEvent, messageCallback);
+#if Slicer_VERSION_MAJOR >= 5 || (Slicer_VERSION_MAJOR >= 4 && Slicer_VERSION_MINOR >= 11)
+        conversionRule->Convert(segment);
+#else
+        vtkSmartPointer<vtkDataObject> closedSurface = vtkSmartPointer<vtkDataObject>::Take(
+          conversionRule->ConstructRepresentationObjectByRepresentation(vtkSegmentationConverter::GetSegmentationClosedSurfaceRepresentationName()) );
+        if (conversionRule->Convert(roiPolyDatas[segmentIndex], closedSurface))
+        {
+          segment->AddRepresentation(vtkSegmentationConverter::GetSegmentationClosedSurfaceRepresentationName(), closedSurface);
+        }
+#endif
+      }
+
+      segments[segmentIndex] = segment;
+    }
+  });
+  for (vtkIdType segmentIndex = 0; segmentIndex < numberOfSegments; ++segmentIndex)
+  {
+    for (const std::string& error : conversionMessages[segmentIndex].Errors)
+    {
+      vtkErrorWithObjectMacro(this->External, "CreateStructureSetSegments: Closed surface conversion of segment '"
+        << roiLabels[segmentIndex] << "' failed: " << error);
+    }
+    for (const std::string& warning : conversionMessages[segmentIndex].Warnings)
+    {
+      vtkWarningWithObjectMacro(this->External, "CreateStructureSetSegments: Closed surface conversion of segment '"
+        << roiLabels[segmentIndex] << "': " << warning);
+    }
+  }
+
+  // Add segments to the segmentation in ROI order
+  DeferredSegmentContours deferredSegmentContours;
+  int wasModified = segmentationNode->StartModify();
+  for (vtkIdType segmentIndex = 0; segmentIndex < numberOfSegments; ++segmentIndex)
+  {
+    std::string replacedSegmentID = (replacedSegmentIDs ? (*replacedSegmentIDs)[segmentIndex] : std::string());
+    if (!replacedSegmentID.empty() && segmentation->GetSegment(replacedSegmentID))
+    {
+      // Replace segment in place, so that it stays in the same position with the same ID
+      int replacedSegmentIndex = segmentation->GetSegmentIndex(replacedSegmentID);
+      std::string nextSegmentID;
+      if (replacedSegmentIndex + 1 < segmentation->GetNumberOfSegments())
+      {
+        nextSegmentID = segmentation->GetNthSegmentID(replacedSegmentIndex + 1);
+      }
+      segmentation->RemoveSegment(replacedSegmentID);
+      segmentation->AddSegment(segments[segmentIndex], replacedSegmentID, nextSegmentID);
+    }
+    else
+    {
+      segmentation->AddSegment(segments[segmentIndex]);
+    }
+    if (roiContoursDeferred[segmentIndex])
+    {
+      std::string segmentID = segmentation->GetSegmentIdBySegment(segments[segmentIndex]);
+      deferredSegmentContours.SegmentIDToRoiInternalIndexMap[segmentID] = contourRoiInternalIndices[segmentIndex];
+    }
+  }
+  segmentationNode->EndModify(wasModified);
+  if (deferredSegmentContours.SegmentIDToRoiInternalIndexMap.empty())
+  {
+    return;
+  }
+
+  // Hide segments with deferred contours, so that the contours are loaded only when the user shows them
+  vtkMRMLSegmentationDisplayNode* displayNode = vtkMRMLSegmentationDisplayNode::SafeDownCast(segmentationNode->GetDisplayNode());
+  if (displayNode)
+  {
+    for (std::map<std::string, int>::iterator segmentIt = deferredSegmentContours.SegmentIDToRoiInternalIndexMap.begin();
+      segmentIt != deferredSegmentContours.SegmentIDToRoiInternalIndexMap.end(); ++segmentIt)
+    {
+      displayNode->SetSegmentVisibility(segmentIt->first, false);
+    }
+  }
+
+  // Keep reader for loading the contours later, and observe the nodes to load the contours when needed
+  deferredSegmentContours.Reader = rtReader;
+  deferredSegmentContours.DisplayNode = displayNode;
+  this->DeferredSegmentContoursMap[segmentationNode->GetID()] = deferredSegmentContours;
+
+  vtkSmartPointer<vtkIntArray> segmentationEvents = vtkSmartPointer<vtkIntArray>::New();
+  segmentationEvents->InsertNextValue(vtkSlicerRtCommon::SegmentDataRequested);
+  this->External->GetMRMLNodesObserverManager()->AddObjectEvents(segmentationNode, segmentationEvents);
+  if (displayNode)
+  {
+    vtkSmartPointer<vtkIntArray> displayEvents = vtkSmartPointer<vtkIntArray>::New();
+    displayEvents->InsertNextValue(vtkCommand::ModifiedEvent);
+    this->External->GetMRMLNodesObserverManager()->AddObjectEvents(displayNode, displayEvents);
+  }
+}
+
+//---------------------------------------------------------------------------
+vtkMRMLSegmentationNode* vtkSlicerDicomRtImportExportModuleLogic::vtkInternal::GetSegmentationToMergeStructureSet(
+  vtkSlicerDicomRtReader* rtReader, const char* referencedSeriesUid)
+{
+  vtkMRMLScene* scene = this->External->GetMRMLScene();
+  vtkMRMLSubjectHierarchyNode* shNode = vtkMRMLSubjectHierarchyNode::GetSubjectHierarchyNode(scene);
+  if (!scene || !shNode || !rtReader || !referencedSeriesUid || !referencedSeriesUid[0])
+  {
+    return nullptr;
+  }
+  std::string studyInstanceUid = SafeStr(rtReader->GetStudyInstanceUid());
+  std::string structureSetLabel = SafeStr(rtReader->GetRTStructureSetLabel());
+
+  vtkMRMLSegmentationNode* mergedSegmentationNode = nullptr;
+  std::vector<vtkMRMLNode*> segmentationNodes;
+  scene->GetNodesByClass("vtkMRMLSegmentationNode", segmentationNodes);
+  for (vtkMRMLNode* node : segmentationNodes)
+  {
+    vtkIdType segmentationShItemID = shNode->GetItemByDataNode(node);
+    if (segmentationShItemID == vtkMRMLSubjectHierarchyNode::INVALID_ITEM_ID)
+    {
+      continue;
+    }
+    std::string segmentationReferencedSeriesUid = shNode->GetItemAttribute(segmentationShItemID,
+      vtkSlicerRtCommon::DICOMRTIMPORT_ROI_REFERENCED_SERIES_UID_ATTRIBUTE_NAME);
+    if (STRCASECMP(segmentationReferencedSeriesUid.c_str(), referencedSeriesUid))
+    {
+      continue;
+    }
+
+    // Structure sets referencing the same image series are revisions of each other only if they are
+    // in the same study and have the same label
+    if ( !shNode->HasItemAttribute(segmentationShItemID, vtkSlicerRtCommon::DICOMRTIMPORT_STRUCTURE_SET_LABEL_ATTRIBUTE_NAME)
+      || shNode->GetItemAttribute(segmentationShItemID, vtkSlicerRtCommon::DICOMRTIMPORT_STRUCTURE_SET_LABEL_ATTRIBUTE_NAME) != structureSetLabel )
+    {
+      continue;
+    }
+    std::string segmentationStudyInstanceUid = shNode->GetItemUID(
+      shNode->GetItemParent(segmentationShItemID), vtkMRMLSubjectHierarchyConstants::GetDICOMUIDName() );
+    if (STRCASECMP(segmentationStudyInstanceUid.c_str(), studyInstanceUid.c_str()))
+    {
+      continue;
+    }
+
+    mergedSegmentationNode = vtkMRMLSegmentationNode::SafeDownCast(node);
+  }
+  return mergedSegmentationNode;
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerDicomRtImportExportModuleLogic::vtkInternal::MergeStructureSetIntoSegmentation(vtkSlicerDicomRtReader* rtReader,
+  const std::vector<int>& contourRoiInternalIndices, vtkMRMLSegmentationNode* segmentationNode, bool createClosedSurface)
+{
+  if (!rtReader || !segmentationNode || !segmentationNode->GetSegmentation())
+  {
+    vtkErrorWithObjectMacro(this->External, "MergeStructureSetIntoSegmentation: Invalid inputs");
+    return;
+  }
+  vtkSegmentation* segmentation = segmentationNode->GetSegmentation();
+
+  // Segments with deferred contours have no contour hash, so they are all rebuilt or removed. Release their deferred contours
+  std::map<std::string, DeferredSegmentContours>::iterator deferredIt = this->DeferredSegmentContoursMap.find(segmentationNode->GetID());
+  if (deferredIt != this->DeferredSegmentContoursMap.end())
+  {
+    this->External->GetMRMLNodesObserverManager()->RemoveObjectEvents(segmentationNode);
+    if (deferredIt->second.DisplayNode)
+    {
+      this->External->GetMRMLNodesObserverManager()->RemoveObjectEvents(deferredIt->second.DisplayNode);
+    }
+    this->DeferredSegmentContoursMap.erase(deferredIt);
+  }
+
+  // Only segments loaded from ROIs are merged, other segments added to the segmentation are kept as they are
+  std::vector<std::string> existingSegmentIDs;
+  std::vector<std::string> allSegmentIDs;
+  segmentation->GetSegmentIDs(allSegmentIDs);
+  for (const std::string& segmentID : allSegmentIDs)
+  {
+    std::string roiNumber;
+    if (segmentation->GetSegment(segmentID)->GetTag(vtkSlicerRtCommon::DICOMRTIMPORT_ROI_NUMBER_SEGMENT_TAG_NAME, roiNumber))
+    {
+      existingSegmentIDs.push_back(segmentID);
+    }
+  }
+  std::set<std::string> matchedSegmentIDs;
+  std::vector<int> changedRoiInternalIndices;
+  std::vector<std::string> replacedSegmentIDs;
+
+  int wasModified = segmentationNode->StartModify();
+  for (int internalROIIndex : contourRoiInternalIndices)
+  {
+    // Find segment of the ROI by name. Segments matched by a previous ROI are skipped in case of duplicate names
+    std::string roiLabel = SafeStr(rtReader->GetRoiName(internalROIIndex));
+    std::string matchedSegmentID;
+    for (const std::string& segmentID : existingSegmentIDs)
+    {
+      vtkSegment* segment = segmentation->GetSegment(segmentID);
+      if (segment && matchedSegmentIDs.find(segmentID) == matchedSegmentIDs.end() && roiLabel == SafeStr(segment->GetName()))
+      {
+        matchedSegmentID = segmentID;
+        break;
+      }
+    }
+
+    // Keep segment with all its representations if the contours did not change. Only update the ROI properties
+    std::string roiContourHash = SafeStr(rtReader->GetRoiContourHash(internalROIIndex));
+    std::string segmentContourHash;
+    vtkSegment* matchedSegment = (matchedSegmentID.empty() ? nullptr : segmentation->GetSegment(matchedSegmentID));
+    if ( matchedSegment && !roiContourHash.empty()
+      && matchedSegment->GetTag(vtkSlicerRtCommon::DICOMRTIMPORT_ROI_CONTOUR_HASH_SEGMENT_TAG_NAME, segmentContourHash)
+      && segmentContourHash == roiContourHash )
+    {
+      matchedSegment->SetColor(rtReader->GetRoiDisplayColor(internalROIIndex));
+      matchedSegment->SetTag(vtkSlicerRtCommon::DICOMRTIMPORT_ROI_NUMBER_SEGMENT_TAG_NAME, std::to_string(rtReader->GetRoiNumber(internalROIIndex)));
+    }
+    else
+    {
+      changedRoiInternalIndices.push_back(internalROIIndex);
+      replacedSegmentIDs.push_back(matchedSegmentID);
+    }
+    if (!matchedSegmentID.empty())
+    {
+      matchedSegmentIDs.insert(matchedSegmentID);
+    }
+  }
+
+  // Remove segments of ROIs that are not in the structure set anymore
+  for (const std::string& segmentID : existingSegmentIDs)
+  {
+    if (matchedSegmentIDs.find(segmentID) == matchedSegmentIDs.end())
+    {
+      segmentation->RemoveSegment(segmentID);
+    }
+  }
+  segmentationNode->EndModify(wasModified);
+
+  vtkDebugWithObjectMacro(this->External, "MergeStructureSetIntoSegmentation: Kept " << contourRoiInternalIndices.size() - changedRoiInternalIndices.size()
+    << " segments, rebuilt " << changedRoiInternalIndices.size() << " segments, removed " << existingSegmentIDs.size() - matchedSegmentIDs.size()
+    << " segments in segmentation " << segmentationNode->GetName());
+
+  // Rebuild changed segments in place, and add new ones
+  if (!changedRoiInternalIndices.empty())
+  {
+    this->CreateStructureSetSegments(rtReader, changedRoiInternalIndices, segmentationNode, createClosedSurface, &replacedSegmentIDs);
+  }
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerDicomRtImportExportModuleLogic::vtkInternal::LoadVisibleDeferredSegmentContours(vtkMRMLSegmentationDisplayNode* displayNode)
+{
+  if (this->LoadingDeferredSegmentContours || !displayNode || !displayNode->GetVisibility())
+  {
+    return;
+  }
+  vtkMRMLSegmentationNode* segmentationNode = vtkMRMLSegmentationNode::SafeDownCast(displayNode->GetDisplayableNode());
+  if (!segmentationNode || !segmentationNode->GetID())
+  {
+    return;
+  }
+  std::map<std::string, DeferredSegmentContours>::iterator deferredIt = this->DeferredSegmentContoursMap.find(segmentationNode->GetID());
+  if (deferredIt == this->DeferredSegmentContoursMap.end())
+  {
+    return;
+  }
+
+  std::vector<std::string> visibleSegmentIDs;
+  for (std::map<std::string, int>::iterator segmentIt = deferredIt->second.SegmentIDToRoiInternalIndexMap.begin();
+    segmentIt != deferredIt->second.SegmentIDToRoiInternalIndexMap.end(); ++segmentIt)
+  {
+    if (displayNode->GetSegmentVisibility(segmentIt->first))
+    {
+      visibleSegmentIDs.push_back(segmentIt->first);
+    }
+  }
+  for (std::vector<std::string>::iterator segmentIDIt = visibleSegmentIDs.begin(); segmentIDIt != visibleSegmentIDs.end(); ++segmentIDIt)
+  {
+    this->External->LoadDeferredSegmentContours(segmentationNode, segmentIDIt->c_str());
+  }
+}
+
 //---------------------------------------------------------------------------
 bool vtkSlicerDicomRtImportExportModuleLogic::vtkInternal::LoadRtImage(vtkSlicerDicomRtReader* rtReader, vtkSlicerDICOMLoadable* loadable)
 {
@@ -1655,15 +2728,31 @@ bool vtkSlicerDicomRtImportExportModuleLogic::vtkInternal::LoadRtImage(vtkSlicer
   const char* seriesName = loadable->GetName();
 
   // Load Volume
-  vtkSmartPointer<vtkMRMLVolumeArchetypeStorageNode> volumeStorageNode = vtkSmartPointer<vtkMRMLVolumeArchetypeStorageNode>::New();
   vtkSmartPointer<vtkMRMLScalarVolumeNode> volumeNode = vtkSmartPointer<vtkMRMLScalarVolumeNode>::New();
-  volumeStorageNode->SetFileName(fileName);
-  volumeStorageNode->ResetFileNameList();
-  volumeStorageNode->SetSingleFile(1);
-
-  // Read image from disk
-  if (!volumeStorageNode->ReadData(volumeNode))
+  vtkImageData* framesImageData = rtReader->GetRTImageFramesImageData();
+  bool deferPixelLoading = this->External->LazyRtImageLoading && !framesImageData;
+  if (framesImageData)
+  {
+    // Multi-frame image is already decoded by the reader. The volume shows one frame, so that it can be displayed as a planar image
+    if ( !SetRtImageGeometryFromHeader(rtReader, volumeNode, framesImageData->GetScalarType())
+      || !CopyImageFrame(framesImageData, 0, volumeNode->GetImageData()) )
+    {
+      vtkErrorWithObjectMacro(this->External, "LoadRtImage: Failed to set up frames of multi-frame RT image file '" << fileName << "' (series name '" << seriesName << "')");
+      return false;
+    }
+  }
+  else if (deferPixelLoading)
+  {
+    // Only set up the geometry, the pixels are read from disk when the image is first shown
+    if (!SetRtImageGeometryFromHeader(rtReader, volumeNode))
+    {
+      vtkErrorWithObjectMacro(this->External, "LoadRtImage: Failed to get image geometry from RT image file '" << fileName << "' (series name '" << seriesName << "')");
+      return false;
+    }
+  }
+  else if (!ReadRtImageFile(fileName, volumeNode))
   {
+    // Read image from disk
     vtkErrorWithObjectMacro(this->External, "LoadRtImage: Failed to load RT image file '" << fileName << "' (series name '" << seriesName << "')");
     return false;
   }
@@ -1681,60 +2770,298 @@ bool vtkSlicerDicomRtImportExportModuleLogic::vtkInternal::LoadRtImage(vtkSlicer
   {
     volumeDisplayNode->AutoWindowLevelOn();
   }
-  else
+  else
+  {
+    // Apply given window level if available
+    volumeDisplayNode->AutoWindowLevelOff();
+    volumeDisplayNode->SetWindowLevel(rtReader->GetWindowWidth(), rtReader->GetWindowCenter());
+  }
+  volumeNode->SetAndObserveDisplayNodeID(volumeDisplayNode->GetID());
+
+  // Set up subject hierarchy item
+  vtkIdType seriesShItemID = shNode->CreateItem(shNode->GetSceneItemID(), volumeNode);
+  shNode->SetItemUID(seriesShItemID, vtkMRMLSubjectHierarchyConstants::GetDICOMUIDName(), rtReader->GetSeriesInstanceUid());
+
+  // Set RT image specific attributes
+  shNode->SetItemAttribute(seriesShItemID, vtkSlicerRtCommon::DICOMRTIMPORT_RTIMAGE_IDENTIFIER_ATTRIBUTE_NAME, "1");
+  shNode->SetItemAttribute(seriesShItemID, vtkMRMLSubjectHierarchyConstants::GetDICOMReferencedInstanceUIDsAttributeName(),
+    SafeStr(rtReader->GetRTImageReferencedRTPlanSOPInstanceUID()) );
+
+  std::stringstream radiationMachineSadStream;
+  radiationMachineSadStream << rtReader->GetRadiationMachineSAD();
+  shNode->SetItemAttribute(seriesShItemID, vtkSlicerRtCommon::DICOMRTIMPORT_SOURCE_AXIS_DISTANCE_ATTRIBUTE_NAME, radiationMachineSadStream.str());
+
+  std::stringstream gantryAngleStream;
+  gantryAngleStream << rtReader->GetGantryAngle();
+  shNode->SetItemAttribute(seriesShItemID, vtkSlicerRtCommon::DICOMRTIMPORT_GANTRY_ANGLE_ATTRIBUTE_NAME, gantryAngleStream.str());
+
+  std::stringstream couchAngleStream;
+  couchAngleStream << rtReader->GetPatientSupportAngle();
+  shNode->SetItemAttribute(seriesShItemID, vtkSlicerRtCommon::DICOMRTIMPORT_COUCH_ANGLE_ATTRIBUTE_NAME, couchAngleStream.str());
+
+  std::stringstream collimatorAngleStream;
+  collimatorAngleStream << rtReader->GetBeamLimitingDeviceAngle();
+  shNode->SetItemAttribute(seriesShItemID, vtkSlicerRtCommon::DICOMRTIMPORT_COLLIMATOR_ANGLE_ATTRIBUTE_NAME, collimatorAngleStream.str());
+
+  std::stringstream referencedBeamNumberStream;
+  referencedBeamNumberStream << rtReader->GetReferencedBeamNumber();
+  shNode->SetItemAttribute(seriesShItemID, vtkSlicerRtCommon::DICOMRTIMPORT_BEAM_NUMBER_ATTRIBUTE_NAME, referencedBeamNumberStream.str());
+
+  std::stringstream rtImageSidStream;
+  rtImageSidStream << rtReader->GetRTImageSID();
+  shNode->SetItemAttribute(seriesShItemID, vtkSlicerRtCommon::DICOMRTIMPORT_RTIMAGE_SID_ATTRIBUTE_NAME, rtImageSidStream.str());
+
+  std::stringstream rtImagePositionStream;
+  double rtImagePosition[2] = {0.0, 0.0};
+  rtReader->GetRTImagePosition(rtImagePosition);
+  rtImagePositionStream << rtImagePosition[0] << " " << rtImagePosition[1];
+  shNode->SetItemAttribute(seriesShItemID,  vtkSlicerRtCommon::DICOMRTIMPORT_RTIMAGE_POSITION_ATTRIBUTE_NAME, rtImagePositionStream.str());
+
+  // Insert series in subject hierarchy
+  vtkSlicerDicomRtImportExportModuleLogic::InsertSeriesInSubjectHierarchy(rtReader, scene);
+
+  // Make frames of multi-frame image browsable
+  if (framesImageData)
+  {
+    this->LoadRtImageFrames(rtReader, volumeNode);
+  }
+
+  // Keep file for reading the pixels later, and hide the image until then
+  if (deferPixelLoading)
+  {
+    DeferredRtImage& deferredRtImage = this->DeferredRtImageMap[volumeNode->GetID()];
+    deferredRtImage.FileName = fileName;
+    deferredRtImage.VolumeVisibility = volumeDisplayNode->GetVisibility();
+    volumeDisplayNode->SetVisibility(0);
+
+    vtkSmartPointer<vtkIntArray> volumeEvents = vtkSmartPointer<vtkIntArray>::New();
+    volumeEvents->InsertNextValue(vtkSlicerRtCommon::RtImageDataRequested);
+    this->External->GetMRMLNodesObserverManager()->AddObjectEvents(volumeNode, volumeEvents);
+  }
+
+  // Compute and set RT image geometry. Uses the referenced beam if available, otherwise the geometry will be set up when loading the referenced beam
+  this->SetupRtImageGeometry(volumeNode);
+
+  // Observe display nodes to load the pixels when the image is shown
+  this->ObserveDeferredRtImageDisplayNodes(volumeNode);
+
+  return true;
+}
+
+//---------------------------------------------------------------------------
+bool vtkSlicerDicomRtImportExportModuleLogic::vtkInternal::ReadRtImageFile(const char* fileName, vtkMRMLScalarVolumeNode* volumeNode)
+{
+  vtkSmartPointer<vtkMRMLVolumeArchetypeStorageNode> volumeStorageNode = vtkSmartPointer<vtkMRMLVolumeArchetypeStorageNode>::New();
+  volumeStorageNode->SetFileName(fileName);
+  volumeStorageNode->ResetFileNameList();
+  volumeStorageNode->SetSingleFile(1);
+  return volumeStorageNode->ReadData(volumeNode);
+}
+
+//---------------------------------------------------------------------------
+bool vtkSlicerDicomRtImportExportModuleLogic::vtkInternal::SetRtImageGeometryFromHeader(vtkSlicerDicomRtReader* rtReader, vtkMRMLScalarVolumeNode* volumeNode, int scalarType)
+{
+  int dimensions[2] = {0, 0};
+  rtReader->GetRTImageDimensions(dimensions);
+  if (dimensions[0] <= 0 || dimensions[1] <= 0)
+  {
+    return false;
+  }
+
+  // Single byte voxels are enough by default, as the image is replaced when the pixels are read
+  vtkSmartPointer<vtkImageData> imageData = vtkSmartPointer<vtkImageData>::New();
+  imageData->SetDimensions(dimensions[0], dimensions[1], 1);
+  imageData->AllocateScalars(scalarType, 1);
+  memset(imageData->GetScalarPointer(), 0, imageData->GetNumberOfPoints() * imageData->GetScalarSize());
+  volumeNode->SetAndObserveImageData(imageData);
+
+  // RT images have no Image Position (Patient) and Image Orientation (Patient), so the image is read
+  // in the LPS coordinate system with the image plane pixel spacing and no origin
+  double spacing[2] = {1.0, 1.0};
+  rtReader->GetImagePlanePixelSpacing(spacing);
+  volumeNode->SetIJKToRASDirections(-1.0, 0.0, 0.0, 0.0, -1.0, 0.0, 0.0, 0.0, 1.0);
+  volumeNode->SetSpacing(spacing[0], spacing[1], 1.0);
+  volumeNode->SetOrigin(0.0, 0.0, 0.0);
+  return true;
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerDicomRtImportExportModuleLogic::vtkInternal::LoadRtImageFrames(vtkSlicerDicomRtReader* rtReader, vtkMRMLScalarVolumeNode* volumeNode)
+{
+  vtkMRMLScene* scene = volumeNode->GetScene();
+  vtkImageData* framesImageData = rtReader->GetRTImageFramesImageData();
+  int numberOfFrames = framesImageData->GetDimensions()[2];
+
+  // All frames are kept in one buffer with the geometry of the RT image. The volume is only used for storing the frames.
+  // The geometry is copied again when the RT image geometry is set up using the referenced beam
+  vtkNew<vtkMRMLScalarVolumeNode> framesVolumeNode;
+  std::string name = scene->GenerateUniqueName(std::string(volumeNode->GetName()) + "_Frames");
+  framesVolumeNode->SetName(name.c_str());
+  framesVolumeNode->CopyOrientation(volumeNode);
+  framesVolumeNode->SetAndObserveImageData(framesImageData);
+  framesVolumeNode->SetAttribute(vtkMRMLSubjectHierarchyConstants::GetSubjectHierarchyExcludeFromTreeAttributeName().c_str(), "1");
+  scene->AddNode(framesVolumeNode);
+  volumeNode->SetNodeReferenceID(RTIMAGE_FRAMES_VOLUME_REFERENCE_ROLE, framesVolumeNode->GetID());
+  volumeNode->SetAttribute(RTIMAGE_FRAME_INDEX_ATTRIBUTE_NAME, "0");
+
+  // Create sequence of lightweight nodes that only identify the frames, so that they can be browsed
+  vtkNew<vtkMRMLSequenceNode> frameSequenceNode;
+  name = std::string(volumeNode->GetName()) + "_FrameSequence";
+  frameSequenceNode->SetName(name.c_str());
+  frameSequenceNode->SetIndexName("Frame");
+  frameSequenceNode->SetIndexUnit("index");
+  frameSequenceNode->SetIndexType(vtkMRMLSequenceNode::NumericIndex);
+  scene->AddNode(frameSequenceNode);
+
+  vtkNew<vtkMRMLScriptedModuleNode> frameNode;
+  for (int frameIndex = 0; frameIndex < numberOfFrames; ++frameIndex)
+  {
+    std::string frameIndexStr = std::to_string(frameIndex);
+    frameNode->SetName((std::string("Frame") + frameIndexStr).c_str());
+    frameNode->SetParameter("FrameIndex", frameIndexStr);
+    frameSequenceNode->SetDataNodeAtValue(frameNode, frameIndexStr);
+  }
+
+  vtkNew<vtkMRMLSequenceBrowserNode> frameSequenceBrowserNode;
+  name = std::string(volumeNode->GetName()) + "_SequenceBrowser";
+  frameSequenceBrowserNode->SetName(name.c_str());
+  scene->AddNode(frameSequenceBrowserNode);
+  frameSequenceBrowserNode->SetAndObserveMasterSequenceNodeID(frameSequenceNode->GetID());
+  frameSequenceBrowserNode->SetNodeReferenceID(FRAME_SEQUENCE_RTIMAGE_REFERENCE_ROLE, volumeNode->GetID());
+
+  // The first frame is shown, the others are copied into the RT image when the browser selects them
+  this->ObserveSequenceBrowser(frameSequenceBrowserNode);
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerDicomRtImportExportModuleLogic::vtkInternal::UpdateRtImageFromFrameSequenceBrowser(vtkMRMLSequenceBrowserNode* browserNode)
+{
+  vtkMRMLScalarVolumeNode* volumeNode = vtkMRMLScalarVolumeNode::SafeDownCast(browserNode->GetNodeReference(FRAME_SEQUENCE_RTIMAGE_REFERENCE_ROLE));
+  if (!volumeNode || !volumeNode->GetImageData())
+  {
+    return;
+  }
+  vtkMRMLScalarVolumeNode* framesVolumeNode = vtkMRMLScalarVolumeNode::SafeDownCast(volumeNode->GetNodeReference(RTIMAGE_FRAMES_VOLUME_REFERENCE_ROLE));
+  if (!framesVolumeNode || !framesVolumeNode->GetImageData())
+  {
+    return;
+  }
+  int selectedFrameIndex = browserNode->GetSelectedItemNumber();
+  std::string selectedFrameIndexStr = std::to_string(selectedFrameIndex);
+  if (selectedFrameIndex < 0 || selectedFrameIndexStr == SafeStr(volumeNode->GetAttribute(RTIMAGE_FRAME_INDEX_ATTRIBUTE_NAME)))
+  {
+    return;
+  }
+
+  // Pixels are copied into the image data of the RT image, so that the planar image texture is updated as well
+  if (!CopyImageFrame(framesVolumeNode->GetImageData(), selectedFrameIndex, volumeNode->GetImageData()))
+  {
+    vtkErrorWithObjectMacro(this->External, "UpdateRtImageFromFrameSequenceBrowser: Failed to show frame " << selectedFrameIndex
+      << " of RT image " << volumeNode->GetName());
+    return;
+  }
+  volumeNode->SetAttribute(RTIMAGE_FRAME_INDEX_ATTRIBUTE_NAME, selectedFrameIndexStr.c_str());
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerDicomRtImportExportModuleLogic::vtkInternal::ObserveDeferredRtImageDisplayNodes(vtkMRMLScalarVolumeNode* volumeNode)
+{
+  if (!volumeNode || !volumeNode->GetID())
+  {
+    return;
+  }
+  std::map<std::string, DeferredRtImage>::iterator deferredIt = this->DeferredRtImageMap.find(volumeNode->GetID());
+  if (deferredIt == this->DeferredRtImageMap.end())
   {
-    // Apply given window level if available
-    volumeDisplayNode->AutoWindowLevelOff();
-    volumeDisplayNode->SetWindowLevel(rtReader->GetWindowWidth(), rtReader->GetWindowCenter());
+    return;
   }
-  volumeNode->SetAndObserveDisplayNodeID(volumeDisplayNode->GetID());
-
-  // Set up subject hierarchy item
-  vtkIdType seriesShItemID = shNode->CreateItem(shNode->GetSceneItemID(), volumeNode);
-  shNode->SetItemUID(seriesShItemID, vtkMRMLSubjectHierarchyConstants::GetDICOMUIDName(), rtReader->GetSeriesInstanceUid());
-
-  // Set RT image specific attributes
-  shNode->SetItemAttribute(seriesShItemID, vtkSlicerRtCommon::DICOMRTIMPORT_RTIMAGE_IDENTIFIER_ATTRIBUTE_NAME, "1");
-  shNode->SetItemAttribute(seriesShItemID, vtkMRMLSubjectHierarchyConstants::GetDICOMReferencedInstanceUIDsAttributeName(),
-    SafeStr(rtReader->GetRTImageReferencedRTPlanSOPInstanceUID()) );
 
-  std::stringstream radiationMachineSadStream;
-  radiationMachineSadStream << rtReader->GetRadiationMachineSAD();
-  shNode->SetItemAttribute(seriesShItemID, vtkSlicerRtCommon::DICOMRTIMPORT_SOURCE_AXIS_DISTANCE_ATTRIBUTE_NAME, radiationMachineSadStream.str());
-
-  std::stringstream gantryAngleStream;
-  gantryAngleStream << rtReader->GetGantryAngle();
-  shNode->SetItemAttribute(seriesShItemID, vtkSlicerRtCommon::DICOMRTIMPORT_GANTRY_ANGLE_ATTRIBUTE_NAME, gantryAngleStream.str());
-
-  std::stringstream couchAngleStream;
-  couchAngleStream << rtReader->GetPatientSupportAngle();
-  shNode->SetItemAttribute(seriesShItemID, vtkSlicerRtCommon::DICOMRTIMPORT_COUCH_ANGLE_ATTRIBUTE_NAME, couchAngleStream.str());
+  // The planar image model only exists if the geometry has been set up using the referenced beam
+  std::vector<vtkMRMLDisplayNode*> displayNodes;
+  displayNodes.push_back(volumeNode->GetDisplayNode());
+  vtkMRMLModelNode* modelNode = vtkMRMLModelNode::SafeDownCast(
+    volumeNode->GetNodeReference(vtkMRMLPlanarImageNode::PLANARIMAGE_DISPLAYED_MODEL_REFERENCE_ROLE.c_str()) );
+  if (modelNode)
+  {
+    displayNodes.push_back(modelNode->GetDisplayNode());
+  }
 
-  std::stringstream collimatorAngleStream;
-  collimatorAngleStream << rtReader->GetBeamLimitingDeviceAngle();
-  shNode->SetItemAttribute(seriesShItemID, vtkSlicerRtCommon::DICOMRTIMPORT_COLLIMATOR_ANGLE_ATTRIBUTE_NAME, collimatorAngleStream.str());
+  std::vector<vtkWeakPointer<vtkMRMLDisplayNode> >& observedDisplayNodes = deferredIt->second.DisplayNodes;
+  for (vtkMRMLDisplayNode* displayNode : displayNodes)
+  {
+    if (!displayNode || std::find(observedDisplayNodes.begin(), observedDisplayNodes.end(), displayNode) != observedDisplayNodes.end())
+    {
+      continue;
+    }
+    vtkSmartPointer<vtkIntArray> displayEvents = vtkSmartPointer<vtkIntArray>::New();
+    displayEvents->InsertNextValue(vtkCommand::ModifiedEvent);
+    this->External->GetMRMLNodesObserverManager()->AddObjectEvents(displayNode, displayEvents);
+    observedDisplayNodes.push_back(displayNode);
+  }
+}
 
-  std::stringstream referencedBeamNumberStream;
-  referencedBeamNumberStream << rtReader->GetReferencedBeamNumber();
-  shNode->SetItemAttribute(seriesShItemID, vtkSlicerRtCommon::DICOMRTIMPORT_BEAM_NUMBER_ATTRIBUTE_NAME, referencedBeamNumberStream.str());
+//---------------------------------------------------------------------------
+void vtkSlicerDicomRtImportExportModuleLogic::vtkInternal::RemoveDeferredRtImage(vtkMRMLScalarVolumeNode* volumeNode)
+{
+  if (!volumeNode || !volumeNode->GetID())
+  {
+    return;
+  }
+  std::map<std::string, DeferredRtImage>::iterator deferredIt = this->DeferredRtImageMap.find(volumeNode->GetID());
+  if (deferredIt == this->DeferredRtImageMap.end())
+  {
+    return;
+  }
 
-  std::stringstream rtImageSidStream;
-  rtImageSidStream << rtReader->GetRTImageSID();
-  shNode->SetItemAttribute(seriesShItemID, vtkSlicerRtCommon::DICOMRTIMPORT_RTIMAGE_SID_ATTRIBUTE_NAME, rtImageSidStream.str());
+  this->External->GetMRMLNodesObserverManager()->RemoveObjectEvents(volumeNode);
+  for (vtkMRMLDisplayNode* displayNode : deferredIt->second.DisplayNodes)
+  {
+    if (displayNode)
+    {
+      this->External->GetMRMLNodesObserverManager()->RemoveObjectEvents(displayNode);
+    }
+  }
+  this->DeferredRtImageMap.erase(deferredIt);
+}
 
-  std::stringstream rtImagePositionStream;
-  double rtImagePosition[2] = {0.0, 0.0};
-  rtReader->GetRTImagePosition(rtImagePosition);
-  rtImagePositionStream << rtImagePosition[0] << " " << rtImagePosition[1];
-  shNode->SetItemAttribute(seriesShItemID,  vtkSlicerRtCommon::DICOMRTIMPORT_RTIMAGE_POSITION_ATTRIBUTE_NAME, rtImagePositionStream.str());
+//---------------------------------------------------------------------------
+void vtkSlicerDicomRtImportExportModuleLogic::vtkInternal::LoadVisibleDeferredRtImage(vtkMRMLDisplayNode* displayNode)
+{
+  if (!displayNode || !displayNode->GetVisibility() || !this->External->GetMRMLScene())
+  {
+    return;
+  }
 
-  // Insert series in subject hierarchy
-  vtkSlicerDicomRtImportExportModuleLogic::InsertSeriesInSubjectHierarchy(rtReader, scene);
+  for (std::map<std::string, DeferredRtImage>::iterator deferredIt = this->DeferredRtImageMap.begin();
+    deferredIt != this->DeferredRtImageMap.end(); ++deferredIt)
+  {
+    const std::vector<vtkWeakPointer<vtkMRMLDisplayNode> >& displayNodes = deferredIt->second.DisplayNodes;
+    if (std::find(displayNodes.begin(), displayNodes.end(), displayNode) != displayNodes.end())
+    {
+      this->External->LoadDeferredRtImage(vtkMRMLScalarVolumeNode::SafeDownCast(
+        this->External->GetMRMLScene()->GetNodeByID(deferredIt->first)) );
+      return;
+    }
+  }
+}
 
-  // Compute and set RT image geometry. Uses the referenced beam if available, otherwise the geometry will be set up when loading the referenced beam
-  this->SetupRtImageGeometry(volumeNode);
+//---------------------------------------------------------------------------
+void vtkSlicerDicomRtImportExportModuleLogic::vtkInternal::LoadDeferredRtImagesInSliceView(vtkMRMLSliceCompositeNode* sliceCompositeNode)
+{
+  if (!sliceCompositeNode || this->DeferredRtImageMap.empty() || !this->External->GetMRMLScene())
+  {
+    return;
+  }
 
-  return true;
+  const char* shownVolumeIDs[2] = { sliceCompositeNode->GetBackgroundVolumeID(), sliceCompositeNode->GetForegroundVolumeID() };
+  for (const char* volumeID : shownVolumeIDs)
+  {
+    if (volumeID && this->DeferredRtImageMap.find(volumeID) != this->DeferredRtImageMap.end())
+    {
+      this->External->LoadDeferredRtImage(vtkMRMLScalarVolumeNode::SafeDownCast(
+        this->External->GetMRMLScene()->GetNodeByID(volumeID)) );
+    }
+  }
 }
 
 //---------------------------------------------------------------------------
@@ -2123,6 +3450,14 @@ void vtkSlicerDicomRtImportExportModuleLogic::vtkInternal::SetupRtImageGeometry(
   // Transform RT image to proper position and orientation
   rtImageVolumeNode->SetIJKToRASMatrix(isocenterToRtImageRas->GetMatrix());
 
+  // Keep frames of multi-frame RT image in the same geometry. The geometry may be set up after the frames have been loaded
+  vtkMRMLScalarVolumeNode* framesVolumeNode = vtkMRMLScalarVolumeNode::SafeDownCast(
+    rtImageVolumeNode->GetNodeReference(RTIMAGE_FRAMES_VOLUME_REFERENCE_ROLE) );
+  if (framesVolumeNode)
+  {
+    framesVolumeNode->CopyOrientation(rtImageVolumeNode);
+  }
+
   // Set up outputs for the planar image display
   vtkSmartPointer<vtkMRMLModelNode> displayedModelNode = vtkSmartPointer<vtkMRMLModelNode>::New();
   this->External->GetMRMLScene()->AddNode(displayedModelNode);
@@ -2140,100 +3475,512 @@ void vtkSlicerDicomRtImportExportModuleLogic::vtkInternal::SetupRtImageGeometry(
   planarImageParameterSetNode->SetAndObserveRtImageVolumeNode(rtImageVolumeNode);
   planarImageParameterSetNode->SetAndObserveDisplayedModelNode(displayedModelNode);
 
-  // Create planar image model for the RT image
+  // Create planar image model for the RT image. The texture is a pipeline on the RT image data that only executes
+  // when the model is rendered, and showing the model loads deferred pixels into the same image data first
   this->External->PlanarImageLogic->CreateModelForPlanarImage(planarImageParameterSetNode);
 
   // Hide the displayed planar image model by default
   displayedModelNode->SetDisplayVisibility(0);
+
+  // Load deferred pixels when the planar image model is shown
+  this->ObserveDeferredRtImageDisplayNodes(rtImageVolumeNode);
 }
 
 //---------------------------------------------------------------------------
-double vtkSlicerDicomRtImportExportModuleLogic::vtkInternal::CalculateSliceSpacing(vtkSlicerDicomRtReader* rtReader, const char* roiReferencedSeriesUid)
+double vtkSlicerDicomRtImportExportModuleLogic::vtkInternal::CalculateSliceSpacing(vtkSlicerDicomRtReader* vtkNotUsed(rtReader), const char* roiReferencedSeriesUid)
 {
   double sliceSpacing = 0.0;
 
-  ctkDICOMDatabase* dicomDatabase = new ctkDICOMDatabase();
-  dicomDatabase->openDatabase(rtReader->GetDatabaseFile(), vtkSlicerDicomRtReader::DICOMREADER_DICOM_CONNECTION_NAME.c_str());
+  ctkDICOMDatabase* dicomDatabase = AcquireDicomDatabase();
+  if (!dicomDatabase)
+  {
+    return sliceSpacing;
+  }
 
   // IPPSorter takes a std::vector<std::string>. Need to convert from QStringList.
   QStringList filesForSeriesQString = dicomDatabase->filesForSeries(roiReferencedSeriesUid);
   std::vector<std::string> filesForSeries;
+  std::vector<long> modifiedTimes;
   for (QStringList::iterator fileNameQStringIt = filesForSeriesQString.begin(); fileNameQStringIt != filesForSeriesQString.end(); fileNameQStringIt++)
   {
     filesForSeries.push_back((*fileNameQStringIt).toStdString());
+    modifiedTimes.push_back(vtksys::SystemTools::ModifiedTime(filesForSeries.back()));
+  }
+
+  // Use cached spacing if the files of the series have not changed since it was calculated
+  std::map<std::string, SliceSpacingCacheEntry>::iterator cacheIt = this->SliceSpacingCache.find(roiReferencedSeriesUid);
+  if ( cacheIt != this->SliceSpacingCache.end()
+    && cacheIt->second.FileNames == filesForSeries && cacheIt->second.ModifiedTimes == modifiedTimes )
+  {
+    sliceSpacing = cacheIt->second.SliceSpacing;
+  }
+  else
+  {
+    // Use the image positions from the tag cache of the database if possible, which avoids parsing the files
+    if (!this->CalculateSliceSpacingFromImagePositions(dicomDatabase, filesForSeriesQString, sliceSpacing))
+    {
+      // From gdcmIPPSorter.h:
+      // "ALL slices are taken into account, if one slice is
+      /// missing then ZSpacing will be set to 0 since the spacing
+      /// will not be found to be regular along the Series"
+      gdcm::IPPSorter imageSorter = gdcm::IPPSorter();
+      imageSorter.SetComputeZSpacing(true);
+      //imageSorter.SetZSpacingTolerance(0.000001); // 1e-6 is the default value for Z-spacing tolerance 
+      //imageSorter.SetDirectionCosinesTolerance(0); // 0 is the default value for direction cosine tolerance
+      imageSorter.Sort(filesForSeries);
+      sliceSpacing = imageSorter.GetZSpacing();
+    }
+
+    SliceSpacingCacheEntry& cacheEntry = this->SliceSpacingCache[roiReferencedSeriesUid];
+    cacheEntry.FileNames = filesForSeries;
+    cacheEntry.ModifiedTimes = modifiedTimes;
+    cacheEntry.SliceSpacing = sliceSpacing;
+  }
+
+  ReleaseDicomDatabase();
+
+  return sliceSpacing;
+}
+
+//---------------------------------------------------------------------------
+bool vtkSlicerDicomRtImportExportModuleLogic::vtkInternal::CalculateSliceSpacingFromImagePositions(
+  ctkDICOMDatabase* dicomDatabase, const QStringList& fileNames, double& sliceSpacing)
+{
+  sliceSpacing = 0.0;
+  if (!dicomDatabase || fileNames.size() < 2)
+  {
+    return false;
+  }
+
+  // Slice normal from the orientation of the first slice
+  double imageOrientation[6] = { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+  if (!ParseDicomMultiValue(dicomDatabase->fileValue(fileNames[0], "0020,0037"), 6, imageOrientation))
+  {
+    return false;
+  }
+  double sliceNormal[3] = { 0.0, 0.0, 0.0 };
+  vtkMath::Cross(imageOrientation, imageOrientation + 3, sliceNormal);
+
+  // Distance of each slice along the normal
+  std::vector<double> sliceDistances;
+  sliceDistances.reserve(fileNames.size());
+  bool sameOrientation = true;
+  for (QStringList::const_iterator fileNameIt = fileNames.begin(); fileNameIt != fileNames.end(); ++fileNameIt)
+  {
+    // All slices need to have the same orientation (gdcm::IPPSorter has zero direction cosines tolerance by default)
+    double sliceImageOrientation[6] = { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+    if (!ParseDicomMultiValue(dicomDatabase->fileValue(*fileNameIt, "0020,0037"), 6, sliceImageOrientation))
+    {
+      return false;
+    }
+    if (!std::equal(imageOrientation, imageOrientation + 6, sliceImageOrientation))
+    {
+      sameOrientation = false;
+    }
+
+    double imagePosition[3] = { 0.0, 0.0, 0.0 };
+    if (!ParseDicomMultiValue(dicomDatabase->fileValue(*fileNameIt, "0020,0032"), 3, imagePosition))
+    {
+      return false;
+    }
+    sliceDistances.push_back(vtkMath::Dot(imagePosition, sliceNormal));
+  }
+  if (!sameOrientation)
+  {
+    return true;
+  }
+  std::sort(sliceDistances.begin(), sliceDistances.end());
+
+  // Spacing is only valid if it is regular along the series (same as in gdcm::IPPSorter)
+  double firstSpacing = sliceDistances[1] - sliceDistances[0];
+  for (size_t sliceIndex = 2; sliceIndex < sliceDistances.size(); ++sliceIndex)
+  {
+    if (fabs(sliceDistances[sliceIndex] - sliceDistances[sliceIndex-1] - firstSpacing) > SLICE_SPACING_TOLERANCE)
+    {
+      return true;
+    }
+  }
+  if (firstSpacing > SLICE_SPACING_TOLERANCE)
+  {
+    sliceSpacing = firstSpacing;
+  }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+// vtkSlicerDicomRtImportExportModuleLogic methods
+
+//----------------------------------------------------------------------------
+vtkSlicerDicomRtImportExportModuleLogic::vtkSlicerDicomRtImportExportModuleLogic()
+{
+  this->Internal = new vtkInternal(this);
+
+  this->IsodoseLogic = nullptr;
+  this->PlanarImageLogic = nullptr;
+  this->BeamsLogic = nullptr;
+
+  this->BeamModelsInSeparateBranch = true;
+  this->ExamineNumberOfThreads = 0;
+  this->ExportDoseConcurrently = false;
+  this->ExportClosedSurfaceContours = false;
+
+  this->DatasetCache = vtkSlicerDicomRtDatasetCache::New();
+
+  this->LazyStructureSetLoading = false;
+  this->LazyRtImageLoading = false;
+  this->MergeStructureSetSegments = false;
+}
+
+//----------------------------------------------------------------------------
+vtkSlicerDicomRtImportExportModuleLogic::~vtkSlicerDicomRtImportExportModuleLogic()
+{
+  this->SetIsodoseLogic(nullptr);
+  this->SetPlanarImageLogic(nullptr);
+  this->SetBeamsLogic(nullptr);
+
+  if (this->DatasetCache)
+  {
+    this->DatasetCache->Delete();
+    this->DatasetCache = nullptr;
+  }
+
+  // Close the shared DICOM database connection while Qt is still available
+  ResetDicomDatabaseConnection();
+
+  if (this->Internal)
+  {
+    delete this->Internal;
+    this->Internal = nullptr;
+  }
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerDicomRtImportExportModuleLogic::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+
+  os << indent << "BeamModelsInSeparateBranch: " << (this->BeamModelsInSeparateBranch ? "true" : "false") << "\n";
+  os << indent << "ExamineNumberOfThreads: " << this->ExamineNumberOfThreads << "\n";
+  os << indent << "ExportDoseConcurrently: " << (this->ExportDoseConcurrently ? "true" : "false") << "\n";
+  os << indent << "ExportClosedSurfaceContours: " << (this->ExportClosedSurfaceContours ? "true" : "false") << "\n";
+  os << indent << "LazyStructureSetLoading: " << (this->LazyStructureSetLoading ? "true" : "false") << "\n";
+  os << indent << "LazyRtImageLoading: " << (this->LazyRtImageLoading ? "true" : "false") << "\n";
+  os << indent << "MergeStructureSetSegments: " << (this->MergeStructureSetSegments ? "true" : "false") << "\n";
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerDicomRtImportExportModuleLogic::SetMRMLSceneInternal(vtkMRMLScene * newScene)
+{
+  vtkSmartPointer<vtkIntArray> events = vtkSmartPointer<vtkIntArray>::New();
+  events->InsertNextValue(vtkMRMLScene::EndCloseEvent);
+  events->InsertNextValue(vtkMRMLScene::NodeAddedEvent);
+  events->InsertNextValue(vtkMRMLScene::NodeRemovedEvent);
+  events->InsertNextValue(vtkMRMLScene::StartSaveEvent);
+  this->SetAndObserveMRMLSceneEvents(newScene, events.GetPointer());
+
+  // Observe the slice composite nodes already in the scene, the others are observed when added
+  if (newScene)
+  {
+    std::vector<vtkMRMLNode*> sliceCompositeNodes;
+    newScene->GetNodesByClass("vtkMRMLSliceCompositeNode", sliceCompositeNodes);
+    for (vtkMRMLNode* sliceCompositeNode : sliceCompositeNodes)
+    {
+      this->OnMRMLSceneNodeAdded(sliceCompositeNode);
+    }
+  }
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerDicomRtImportExportModuleLogic::OnMRMLSceneEndClose()
+{
+  if (!this->GetMRMLScene())
+  {
+    vtkErrorMacro("OnMRMLSceneEndClose: Invalid MRML scene");
+    return;
+  }
+
+  // Release memory of the parsed files
+  this->DatasetCache->Clear();
+
+  // Release structure sets retained for loading deferred contours
+  this->Internal->DeferredSegmentContoursMap.clear();
+
+  // Forget RT images with deferred pixels
+  this->Internal->DeferredRtImageMap.clear();
+
+  // Close the shared DICOM database connection
+  ResetDicomDatabaseConnection();
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerDicomRtImportExportModuleLogic::OnMRMLSceneNodeAdded(vtkMRMLNode* node)
+{
+  // Observe control point sequence browsers of dynamic beams and frame sequence browsers of multi-frame RT images loaded with the scene
+  vtkMRMLSequenceBrowserNode* browserNode = vtkMRMLSequenceBrowserNode::SafeDownCast(node);
+  if ( browserNode && ( browserNode->GetNodeReferenceID(CONTROL_POINT_BEAM_REFERENCE_ROLE)
+    || browserNode->GetNodeReferenceID(FRAME_SEQUENCE_RTIMAGE_REFERENCE_ROLE) ) )
+  {
+    this->Internal->ObserveSequenceBrowser(browserNode);
+    return;
+  }
+
+  // Observe slice composite nodes to load the deferred pixels of RT images when shown in a slice view
+  if (vtkMRMLSliceCompositeNode::SafeDownCast(node))
+  {
+    vtkSmartPointer<vtkIntArray> sliceCompositeEvents = vtkSmartPointer<vtkIntArray>::New();
+    sliceCompositeEvents->InsertNextValue(vtkCommand::ModifiedEvent);
+    this->GetMRMLNodesObserverManager()->AddObjectEvents(node, sliceCompositeEvents);
+  }
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerDicomRtImportExportModuleLogic::OnMRMLSceneNodeRemoved(vtkMRMLNode* node)
+{
+  vtkMRMLSequenceBrowserNode* browserNode = vtkMRMLSequenceBrowserNode::SafeDownCast(node);
+  if ( browserNode && ( browserNode->GetNodeReferenceID(CONTROL_POINT_BEAM_REFERENCE_ROLE)
+    || browserNode->GetNodeReferenceID(FRAME_SEQUENCE_RTIMAGE_REFERENCE_ROLE) ) )
+  {
+    this->GetMRMLNodesObserverManager()->RemoveObjectEvents(browserNode);
+    return;
+  }
+
+  if (vtkMRMLSliceCompositeNode::SafeDownCast(node))
+  {
+    this->GetMRMLNodesObserverManager()->RemoveObjectEvents(node);
+    return;
+  }
+
+  vtkMRMLScalarVolumeNode* volumeNode = vtkMRMLScalarVolumeNode::SafeDownCast(node);
+  if (volumeNode)
+  {
+    // Forget deferred pixels of RT image
+    this->Internal->RemoveDeferredRtImage(volumeNode);
+    return;
+  }
+
+  vtkMRMLSegmentationNode* segmentationNode = vtkMRMLSegmentationNode::SafeDownCast(node);
+  if (!segmentationNode || !segmentationNode->GetID())
+  {
+    return;
+  }
+
+  // Release structure set retained for loading deferred contours
+  std::map<std::string, vtkInternal::DeferredSegmentContours>::iterator deferredIt =
+    this->Internal->DeferredSegmentContoursMap.find(segmentationNode->GetID());
+  if (deferredIt != this->Internal->DeferredSegmentContoursMap.end())
+  {
+    this->GetMRMLNodesObserverManager()->RemoveObjectEvents(segmentationNode);
+    if (deferredIt->second.DisplayNode)
+    {
+      this->GetMRMLNodesObserverManager()->RemoveObjectEvents(deferredIt->second.DisplayNode);
+    }
+    this->Internal->DeferredSegmentContoursMap.erase(deferredIt);
+  }
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerDicomRtImportExportModuleLogic::ProcessMRMLSceneEvents(vtkObject* caller, unsigned long event, void* callData)
+{
+  // Load all deferred contours before saving, so that the saved segmentations contain them
+  if (event == vtkMRMLScene::StartSaveEvent)
+  {
+    std::vector<std::string> segmentationNodeIDs;
+    for (std::map<std::string, vtkInternal::DeferredSegmentContours>::iterator deferredIt = this->Internal->DeferredSegmentContoursMap.begin();
+      deferredIt != this->Internal->DeferredSegmentContoursMap.end(); ++deferredIt)
+    {
+      segmentationNodeIDs.push_back(deferredIt->first);
+    }
+    for (std::vector<std::string>::iterator nodeIDIt = segmentationNodeIDs.begin(); nodeIDIt != segmentationNodeIDs.end(); ++nodeIDIt)
+    {
+      vtkMRMLSegmentationNode* segmentationNode = vtkMRMLSegmentationNode::SafeDownCast(
+        this->GetMRMLScene() ? this->GetMRMLScene()->GetNodeByID(*nodeIDIt) : nullptr );
+      if (segmentationNode)
+      {
+        this->LoadDeferredSegmentContours(segmentationNode);
+      }
+    }
+
+    // Load pixels of RT images too, so that they are not saved empty
+    std::vector<std::string> volumeNodeIDs;
+    for (std::map<std::string, vtkInternal::DeferredRtImage>::iterator deferredIt = this->Internal->DeferredRtImageMap.begin();
+      deferredIt != this->Internal->DeferredRtImageMap.end(); ++deferredIt)
+    {
+      volumeNodeIDs.push_back(deferredIt->first);
+    }
+    for (std::vector<std::string>::iterator nodeIDIt = volumeNodeIDs.begin(); nodeIDIt != volumeNodeIDs.end(); ++nodeIDIt)
+    {
+      vtkMRMLScalarVolumeNode* volumeNode = vtkMRMLScalarVolumeNode::SafeDownCast(
+        this->GetMRMLScene() ? this->GetMRMLScene()->GetNodeByID(*nodeIDIt) : nullptr );
+      if (volumeNode)
+      {
+        this->LoadDeferredRtImage(volumeNode);
+      }
+    }
+    return;
   }
 
-  // From gdcmIPPSorter.h:
-  // "ALL slices are taken into account, if one slice is
-  /// missing then ZSpacing will be set to 0 since the spacing
-  /// will not be found to be regular along the Series"
-  gdcm::IPPSorter imageSorter = gdcm::IPPSorter();
-  imageSorter.SetComputeZSpacing(true);
-  //imageSorter.SetZSpacingTolerance(0.000001); // 1e-6 is the default value for Z-spacing tolerance 
-  //imageSorter.SetDirectionCosinesTolerance(0); // 0 is the default value for direction cosine tolerance
-  imageSorter.Sort(filesForSeries);
-  sliceSpacing = imageSorter.GetZSpacing();
-
-  dicomDatabase->closeDatabase();
-  delete dicomDatabase;
-  QSqlDatabase::removeDatabase(vtkSlicerDicomRtReader::DICOMREADER_DICOM_CONNECTION_NAME.c_str());
-  QSqlDatabase::removeDatabase(QString(vtkSlicerDicomRtReader::DICOMREADER_DICOM_CONNECTION_NAME.c_str()) + "TagCache");
-
-  return sliceSpacing;
+  this->Superclass::ProcessMRMLSceneEvents(caller, event, callData);
 }
 
-
-//----------------------------------------------------------------------------
-// vtkSlicerDicomRtImportExportModuleLogic methods
-
-//----------------------------------------------------------------------------
-vtkSlicerDicomRtImportExportModuleLogic::vtkSlicerDicomRtImportExportModuleLogic()
+//---------------------------------------------------------------------------
+void vtkSlicerDicomRtImportExportModuleLogic::ProcessMRMLNodesEvents(vtkObject* caller, unsigned long event, void* callData)
 {
-  this->Internal = new vtkInternal(this);
+  this->Superclass::ProcessMRMLNodesEvents(caller, event, callData);
 
-  this->IsodoseLogic = nullptr;
-  this->PlanarImageLogic = nullptr;
-  this->BeamsLogic = nullptr;
-
-  this->BeamModelsInSeparateBranch = true;
+  if (event == vtkSlicerRtCommon::SegmentDataRequested)
+  {
+    vtkMRMLSegmentationNode* segmentationNode = vtkMRMLSegmentationNode::SafeDownCast(caller);
+    if (segmentationNode)
+    {
+      this->LoadDeferredSegmentContours(segmentationNode, reinterpret_cast<const char*>(callData));
+    }
+  }
+  else if (event == vtkSlicerRtCommon::RtImageDataRequested)
+  {
+    vtkMRMLScalarVolumeNode* volumeNode = vtkMRMLScalarVolumeNode::SafeDownCast(caller);
+    if (volumeNode)
+    {
+      this->LoadDeferredRtImage(volumeNode);
+    }
+  }
+  else if (event == vtkCommand::ModifiedEvent && vtkMRMLSequenceBrowserNode::SafeDownCast(caller))
+  {
+    // Control point or RT image frame may have been selected
+    this->Internal->UpdateBeamFromControlPointSequenceBrowser(vtkMRMLSequenceBrowserNode::SafeDownCast(caller));
+    this->Internal->UpdateRtImageFromFrameSequenceBrowser(vtkMRMLSequenceBrowserNode::SafeDownCast(caller));
+  }
+  else if (event == vtkCommand::ModifiedEvent && vtkMRMLSliceCompositeNode::SafeDownCast(caller))
+  {
+    // RT image may have been shown in a slice view
+    this->Internal->LoadDeferredRtImagesInSliceView(vtkMRMLSliceCompositeNode::SafeDownCast(caller));
+  }
+  else if (event == vtkCommand::ModifiedEvent)
+  {
+    // Segment or RT image may have been shown
+    this->Internal->LoadVisibleDeferredSegmentContours(vtkMRMLSegmentationDisplayNode::SafeDownCast(caller));
+    this->Internal->LoadVisibleDeferredRtImage(vtkMRMLDisplayNode::SafeDownCast(caller));
+  }
 }
 
-//----------------------------------------------------------------------------
-vtkSlicerDicomRtImportExportModuleLogic::~vtkSlicerDicomRtImportExportModuleLogic()
+//---------------------------------------------------------------------------
+bool vtkSlicerDicomRtImportExportModuleLogic::LoadDeferredRtImage(vtkMRMLScalarVolumeNode* volumeNode)
 {
-  this->SetIsodoseLogic(nullptr);
-  this->SetPlanarImageLogic(nullptr);
-  this->SetBeamsLogic(nullptr);
+  if (!volumeNode || !volumeNode->GetID() || !volumeNode->GetImageData())
+  {
+    vtkErrorMacro("LoadDeferredRtImage: Invalid RT image volume node");
+    return false;
+  }
+  std::map<std::string, vtkInternal::DeferredRtImage>::iterator deferredIt =
+    this->Internal->DeferredRtImageMap.find(volumeNode->GetID());
+  if (deferredIt == this->Internal->DeferredRtImageMap.end())
+  {
+    return true; // Pixels are not deferred
+  }
+  std::string fileName = deferredIt->second.FileName;
+  bool volumeVisibility = deferredIt->second.VolumeVisibility;
+  this->Internal->RemoveDeferredRtImage(volumeNode);
 
-  if (this->Internal)
+  // Read pixels from disk
+  vtkSmartPointer<vtkMRMLScalarVolumeNode> loadedVolumeNode = vtkSmartPointer<vtkMRMLScalarVolumeNode>::New();
+  if (!vtkInternal::ReadRtImageFile(fileName.c_str(), loadedVolumeNode) || !loadedVolumeNode->GetImageData())
   {
-    delete this->Internal;
-    this->Internal = nullptr;
+    vtkErrorMacro("LoadDeferredRtImage: Failed to load RT image file '" << fileName << "'");
+    return false;
   }
-}
 
-//----------------------------------------------------------------------------
-void vtkSlicerDicomRtImportExportModuleLogic::PrintSelf(ostream& os, vtkIndent indent)
-{
-  this->Superclass::PrintSelf(os, indent);
+  // Only replace the voxels, as the geometry is already set up from the header and the referenced beam.
+  // The image data object is kept, so that the texture of the planar image model is updated too
+  volumeNode->GetImageData()->DeepCopy(loadedVolumeNode->GetImageData());
+  if (volumeNode->GetDisplayNode())
+  {
+    volumeNode->GetDisplayNode()->SetVisibility(volumeVisibility);
+  }
+  return true;
 }
 
 //---------------------------------------------------------------------------
-void vtkSlicerDicomRtImportExportModuleLogic::SetMRMLSceneInternal(vtkMRMLScene * newScene)
+bool vtkSlicerDicomRtImportExportModuleLogic::LoadDeferredSegmentContours(vtkMRMLSegmentationNode* segmentationNode, const char* segmentID/*=nullptr*/)
 {
-  vtkSmartPointer<vtkIntArray> events = vtkSmartPointer<vtkIntArray>::New();
-  events->InsertNextValue(vtkMRMLScene::EndCloseEvent);
-  this->SetAndObserveMRMLSceneEvents(newScene, events.GetPointer());
-}
+  if (!segmentationNode || !segmentationNode->GetID() || !segmentationNode->GetSegmentation())
+  {
+    vtkErrorMacro("LoadDeferredSegmentContours: Invalid segmentation node");
+    return false;
+  }
+  std::map<std::string, vtkInternal::DeferredSegmentContours>::iterator deferredIt =
+    this->Internal->DeferredSegmentContoursMap.find(segmentationNode->GetID());
+  if (deferredIt == this->Internal->DeferredSegmentContoursMap.end())
+  {
+    return true; // No deferred contours in this segmentation
+  }
+  vtkInternal::DeferredSegmentContours& deferredSegmentContours = deferredIt->second;
 
-//---------------------------------------------------------------------------
-void vtkSlicerDicomRtImportExportModuleLogic::OnMRMLSceneEndClose()
-{
-  if (!this->GetMRMLScene())
+  // Collect segments to load
+  std::map<std::string, int> segmentIDToRoiInternalIndexMap;
+  if (segmentID)
   {
-    vtkErrorMacro("OnMRMLSceneEndClose: Invalid MRML scene");
-    return;
+    std::map<std::string, int>::iterator segmentIt = deferredSegmentContours.SegmentIDToRoiInternalIndexMap.find(segmentID);
+    if (segmentIt == deferredSegmentContours.SegmentIDToRoiInternalIndexMap.end())
+    {
+      return true; // Already loaded
+    }
+    segmentIDToRoiInternalIndexMap[segmentIt->first] = segmentIt->second;
+    deferredSegmentContours.SegmentIDToRoiInternalIndexMap.erase(segmentIt);
+  }
+  else
+  {
+    segmentIDToRoiInternalIndexMap.swap(deferredSegmentContours.SegmentIDToRoiInternalIndexMap);
+  }
+  vtkSmartPointer<vtkSlicerDicomRtReader> rtReader = deferredSegmentContours.Reader;
+
+  // Release reader and stop observing the nodes if all contours are loaded
+  if (deferredSegmentContours.SegmentIDToRoiInternalIndexMap.empty())
+  {
+    this->GetMRMLNodesObserverManager()->RemoveObjectEvents(segmentationNode);
+    if (deferredSegmentContours.DisplayNode)
+    {
+      this->GetMRMLNodesObserverManager()->RemoveObjectEvents(deferredSegmentContours.DisplayNode);
+    }
+    this->Internal->DeferredSegmentContoursMap.erase(deferredIt);
+  }
+
+  // Decode contours and set them as the planar contour representation of the segments.
+  // Modifying the master representation triggers update of the other representations
+  bool success = true;
+  bool wasLoadingDeferredSegmentContours = this->Internal->LoadingDeferredSegmentContours;
+  this->Internal->LoadingDeferredSegmentContours = true;
+  int wasModified = segmentationNode->StartModify();
+  for (std::map<std::string, int>::iterator segmentIt = segmentIDToRoiInternalIndexMap.begin();
+    segmentIt != segmentIDToRoiInternalIndexMap.end(); ++segmentIt)
+  {
+    vtkSegment* segment = segmentationNode->GetSegmentation()->GetSegment(segmentIt->first);
+    if (!segment)
+    {
+      continue; // Segment has been removed
+    }
+    if (!rtReader->LoadRoiContours(segmentIt->second) || !rtReader->GetRoiPolyData(segmentIt->second))
+    {
+      vtkErrorMacro("LoadDeferredSegmentContours: Failed to load contours for segment " << segmentIt->first);
+      success = false;
+      continue;
+    }
+    vtkPolyData* roiPolyData = rtReader->GetRoiPolyData(segmentIt->second);
+    segment->RemoveTag(vtkSlicerRtCommon::DICOMRTIMPORT_ROI_CONTOURS_DEFERRED_SEGMENT_TAG_NAME);
+    vtkPolyData* planarContourPolyData = vtkPolyData::SafeDownCast(
+      segment->GetRepresentation(vtkSegmentationConverter::GetSegmentationPlanarContourRepresentationName()) );
+    if (planarContourPolyData)
+    {
+      planarContourPolyData->DeepCopy(roiPolyData);
+    }
+    else
+    {
+      segment->AddRepresentation(vtkSegmentationConverter::GetSegmentationPlanarContourRepresentationName(), roiPolyData);
+    }
+    segment->SetTag(vtkSlicerRtCommon::DICOMRTIMPORT_ROI_CONTOUR_HASH_SEGMENT_TAG_NAME, SafeStr(rtReader->GetRoiContourHash(segmentIt->second)));
   }
+  segmentationNode->EndModify(wasModified);
+  this->Internal->LoadingDeferredSegmentContours = wasLoadingDeferredSegmentContours;
+
+  return success;
 }
 
 //-----------------------------------------------------------------------------
@@ -2264,79 +4011,78 @@ void vtkSlicerDicomRtImportExportModuleLogic::ExamineForLoad(vtkStringArray* fil
   }
   loadables->RemoveAllItems();
 
-  for (int fileIndex=0; fileIndex<fileList->GetNumberOfValues(); ++fileIndex)
+  // Examination starts a new import session, so the connection of the previous session is closed.
+  // The connection opened during examination is then shared by loading of the examined objects
+  ResetDicomDatabaseConnection();
+
+  int numberOfFiles = fileList->GetNumberOfValues();
+  if (numberOfFiles <= 0)
   {
-    // Load file in DCMTK
-    DcmFileFormat fileformat;
-    vtkStdString fileName = fileList->GetValue(fileIndex);
-    OFCondition result = fileformat.loadFile(fileName.c_str(), EXS_Unknown);
-    if (!result.good())
-    {
-      continue; // Failed to parse this file, skip it
-    }
+    return;
+  }
+  std::vector<std::string> fileNames(numberOfFiles);
+  for (int fileIndex=0; fileIndex<numberOfFiles; ++fileIndex)
+  {
+    fileNames[fileIndex] = fileList->GetValue(fileIndex);
+  }
 
-    // Check SOP Class UID for one of the supported RT objects
-    DcmDataset *dataset = fileformat.getDataset();
-    OFString sopClass;
-    if (!dataset->findAndGetOFString(DCM_SOPClassUID, sopClass).good() || sopClass.empty())
-    {
-      continue; // Failed to parse this file, skip it
-    }
+  // Determine number of threads. The main thread also takes part in examination
+  unsigned int numberOfThreads = 1;
+  if (this->ExamineNumberOfThreads > 0)
+  {
+    numberOfThreads = static_cast<unsigned int>(this->ExamineNumberOfThreads);
+  }
+  else
+  {
+    unsigned int hardwareConcurrency = std::max(std::thread::hardware_concurrency(), 1u);
+    numberOfThreads = std::min(2 * hardwareConcurrency, EXAMINE_MAX_AUTO_NUMBER_OF_THREADS);
+  }
+  numberOfThreads = std::min(numberOfThreads, static_cast<unsigned int>(numberOfFiles));
 
-    // DICOM parsing is successful, now check if the object is loadable
-    OFString name("");
-    OFString seriesNumber("");
-    std::vector<OFString> referencedSOPInstanceUIDs;
-    dataset->findAndGetOFString(DCM_SeriesNumber, seriesNumber);
-    if (!seriesNumber.empty())
+  // Examine files in parallel. The work queue is the list of file indices, from which each thread takes the
+  // next unprocessed index. Results are stored by file index so that the output does not depend on scheduling
+  std::vector<vtkInternal::ExamineResult> results(numberOfFiles);
+  std::atomic<int> nextFileIndex(0);
+  vtkSlicerDicomRtDatasetCache* datasetCache = this->DatasetCache;
+  auto examineWorker = [&fileNames, &results, &nextFileIndex, numberOfFiles, datasetCache]()
+  {
+    for (int fileIndex = nextFileIndex++; fileIndex < numberOfFiles; fileIndex = nextFileIndex++)
     {
-      name += seriesNumber + ": ";
+      vtkInternal::ExamineFile(fileNames[fileIndex], datasetCache, results[fileIndex]);
     }
+  };
+  std::vector<std::thread> workerThreads;
+  workerThreads.reserve(numberOfThreads - 1);
+  for (unsigned int threadIndex = 1; threadIndex < numberOfThreads; ++threadIndex)
+  {
+    workerThreads.emplace_back(examineWorker);
+  }
+  examineWorker();
+  for (std::thread& workerThread : workerThreads)
+  {
+    workerThread.join();
+  }
 
-    // RTDose
-    if (sopClass == UID_RTDoseStorage)
-    {
-      this->Internal->ExamineRtDoseDataset(dataset, name, referencedSOPInstanceUIDs);
-    }
-    // RTPlan
-    else if (sopClass == UID_RTPlanStorage)
-    {
-      this->Internal->ExamineRtPlanDataset(dataset, name, referencedSOPInstanceUIDs);
-    }
-    // RTIonPlan
-    else if (sopClass == UID_RTIonPlanStorage)
-    {
-      this->Internal->ExamineRtPlanDataset(dataset, name, referencedSOPInstanceUIDs);
-    }
-    // RTStructureSet
-    else if (sopClass == UID_RTStructureSetStorage)
-    {
-      this->Internal->ExamineRtStructureSetDataset(dataset, name, referencedSOPInstanceUIDs);
-    }
-    // RTImage
-    else if (sopClass == UID_RTImageStorage)
-    {
-      this->Internal->ExamineRtImageDataset(dataset, name, referencedSOPInstanceUIDs);
-    }
-    /* Not yet supported
-    else if (sopClass == UID_RTTreatmentSummaryRecordStorage)
-    else if (sopClass == UID_RTIonBeamsTreatmentRecordStorage)
-    */
-    else
+  // Get referenced plan labels for doses from the DICOM database (not thread-safe, so done on the main thread)
+  vtkInternal::AppendReferencedRtPlanLabels(results);
+
+  // Create and set up loadables in the order of the files
+  for (int fileIndex=0; fileIndex<numberOfFiles; ++fileIndex)
+  {
+    const vtkInternal::ExamineResult& result = results[fileIndex];
+    if (!result.Loadable)
     {
-      continue; // Not an RT file
+      continue;
     }
 
-    // The file is a loadable RT object, create and set up loadable
     vtkNew<vtkSlicerDICOMLoadable> loadable;
-    loadable->SetName(name.c_str());
-    loadable->AddFile(fileName.c_str());
+    loadable->SetName(result.Name.c_str());
+    loadable->AddFile(fileNames[fileIndex].c_str());
     loadable->SetConfidence(1.0);
     loadable->SetSelected(true);
-    std::vector<OFString>::iterator uidIt;
-    for (uidIt = referencedSOPInstanceUIDs.begin(); uidIt != referencedSOPInstanceUIDs.end(); ++uidIt)
+    for (const OFString& referencedSOPInstanceUID : result.ReferencedSOPInstanceUIDs)
     {
-      loadable->AddReferencedInstanceUID(uidIt->c_str());
+      loadable->AddReferencedInstanceUID(referencedSOPInstanceUID.c_str());
     }
     loadables->AddItem(loadable);
   }
@@ -2353,50 +4099,187 @@ bool vtkSlicerDicomRtImportExportModuleLogic::LoadDicomRT(vtkSlicerDICOMLoadable
     return loadSuccessful;
   }
 
+  vtkSmartPointer<vtkSlicerDicomRtReader> rtReader = this->Internal->ReadLoadable(loadable);
+  loadSuccessful = this->Internal->LoadFromReader(rtReader, loadable);
+
+  return loadSuccessful;
+}
+
+//---------------------------------------------------------------------------
+bool vtkSlicerDicomRtImportExportModuleLogic::LoadDicomRTStudy(vtkCollection* loadables)
+{
+  vtkMRMLScene* scene = this->GetMRMLScene();
+  if (!scene)
+  {
+    vtkErrorMacro("LoadDicomRTStudy: Invalid MRML scene");
+    return false;
+  }
+  if (!loadables)
+  {
+    vtkErrorMacro("LoadDicomRTStudy: Invalid loadables");
+    return false;
+  }
+
+  bool loadSuccessful = true;
+
+  // Keep the DICOM database connection open while loading the study
+  bool dicomDatabaseAcquired = (AcquireDicomDatabase() != nullptr);
+
+  // Determine the loading order from the file headers, so that only one object needs to be read at a time
+  struct StudyObject
+  {
+    vtkSlicerDICOMLoadable* Loadable;
+    int LoadOrder;
+  };
+  std::vector<StudyObject> studyObjects;
+  for (int loadableIndex = 0; loadableIndex < loadables->GetNumberOfItems(); ++loadableIndex)
+  {
+    vtkSlicerDICOMLoadable* loadable = vtkSlicerDICOMLoadable::SafeDownCast(loadables->GetItemAsObject(loadableIndex));
+    if (!loadable || loadable->GetFiles()->GetNumberOfValues() < 1 || loadable->GetConfidence() == 0.0)
+    {
+      vtkErrorMacro("LoadDicomRTStudy: Unable to load DICOM-RT data due to invalid loadable information at index " << loadableIndex);
+      loadSuccessful = false;
+      continue;
+    }
+    StudyObject studyObject;
+    studyObject.Loadable = loadable;
+    studyObject.LoadOrder = vtkInternal::GetStudyLoadOrder(loadable->GetFiles()->GetValue(0), this->DatasetCache);
+    studyObjects.push_back(studyObject);
+  }
+
+  // Referenced objects are loaded first, so that references are resolved when the referencing object is loaded,
+  // and not afterwards by searching the scene for the objects referencing the newly loaded one
+  std::stable_sort(studyObjects.begin(), studyObjects.end(),
+    [](const StudyObject& a, const StudyObject& b) { return a.LoadOrder < b.LoadOrder; });
+
+  scene->StartState(vtkMRMLScene::BatchProcessState);
+  for (StudyObject& studyObject : studyObjects)
+  {
+    // The reader is released after its series is loaded, so that the data of only one object is kept in memory
+    vtkSmartPointer<vtkSlicerDicomRtReader> rtReader = this->Internal->ReadLoadable(studyObject.Loadable);
+    if (!this->Internal->LoadFromReader(rtReader, studyObject.Loadable))
+    {
+      vtkErrorMacro("LoadDicomRTStudy: Failed to load series '" << studyObject.Loadable->GetName() << "'");
+      loadSuccessful = false;
+    }
+  }
+  scene->EndState(vtkMRMLScene::BatchProcessState);
+
+  if (dicomDatabaseAcquired)
+  {
+    ReleaseDicomDatabase();
+  }
+
+  return loadSuccessful;
+}
+
+//---------------------------------------------------------------------------
+vtkSmartPointer<vtkSlicerDicomRtReader> vtkSlicerDicomRtImportExportModuleLogic::vtkInternal::ReadLoadable(vtkSlicerDICOMLoadable* loadable)
+{
   const char* firstFileName = loadable->GetFiles()->GetValue(0);
 
-  vtkDebugMacro("Loading series '" << loadable->GetName() << "' from file '" << firstFileName << "'");
+  vtkDebugWithObjectMacro(this->External, "Loading series '" << loadable->GetName() << "' from file '" << firstFileName << "'");
 
   vtkSmartPointer<vtkSlicerDicomRtReader> rtReader = vtkSmartPointer<vtkSlicerDicomRtReader>::New();
   rtReader->SetFileName(firstFileName);
+  rtReader->SetDatasetCache(this->External->DatasetCache);
+  // Contours are needed for merging, as the unchanged segments are found by the hash of their contours
+  rtReader->SetDeferRoiContourLoading(this->External->LazyStructureSetLoading && !this->External->MergeStructureSetSegments);
+  rtReader->SetDeferRtImagePixelLoading(this->External->LazyRtImageLoading);
   rtReader->Update();
 
+  return rtReader;
+}
+
+//---------------------------------------------------------------------------
+bool vtkSlicerDicomRtImportExportModuleLogic::vtkInternal::LoadFromReader(vtkSlicerDicomRtReader* rtReader, vtkSlicerDICOMLoadable* loadable)
+{
+  bool loadSuccessful = false;
+
   // One series can contain composite information, e.g, an RTPLAN series can contain structure sets and plans as well
   // TODO: vtkSlicerDicomRtReader class does not support this yet
 
   // RTSTRUCT
   if (rtReader->GetLoadRTStructureSetSuccessful())
   {
-    loadSuccessful = this->Internal->LoadRtStructureSet(rtReader, loadable);
+    loadSuccessful = this->LoadRtStructureSet(rtReader, loadable);
   }
 
   // RTDOSE
   if (rtReader->GetLoadRTDoseSuccessful())
   {
-    loadSuccessful = this->Internal->LoadRtDose(rtReader, loadable);
+    loadSuccessful = this->LoadRtDose(rtReader, loadable);
   }
 
   // RTPLAN
   if (rtReader->GetLoadRTPlanSuccessful())
   {
-    loadSuccessful = this->Internal->LoadRtPlan(rtReader, loadable);
+    loadSuccessful = this->LoadRtPlan(rtReader, loadable);
   }
 
   // RTIONPLAN
   if (rtReader->GetLoadRTIonPlanSuccessful())
   {
-    loadSuccessful = this->Internal->LoadRtPlan(rtReader, loadable);
+    loadSuccessful = this->LoadRtPlan(rtReader, loadable);
   }
 
   // RTIMAGE
   if (rtReader->GetLoadRTImageSuccessful())
   {
-    loadSuccessful = this->Internal->LoadRtImage(rtReader, loadable);
+    loadSuccessful = this->LoadRtImage(rtReader, loadable);
   }
 
   return loadSuccessful;
 }
 
+//---------------------------------------------------------------------------
+int vtkSlicerDicomRtImportExportModuleLogic::vtkInternal::GetStudyLoadOrder(
+  const char* fileName, vtkSlicerDicomRtDatasetCache* datasetCache)
+{
+  const int unknownLoadOrder = 4;
+
+  // Use already parsed file if available, otherwise parse the header until the SOP class
+  std::shared_ptr<DcmFileFormat> fileformat;
+  if (datasetCache)
+  {
+    fileformat = datasetCache->GetFileFormat(fileName);
+  }
+  if (!fileformat)
+  {
+    fileformat = std::make_shared<DcmFileFormat>();
+    OFCondition condition = fileformat->loadFileUntilTag( fileName, EXS_Unknown, EGL_noChange,
+      EXAMINE_MAX_READ_LENGTH, ERM_autoDetect, DCM_SOPInstanceUID );
+    if (!condition.good())
+    {
+      return unknownLoadOrder;
+    }
+  }
+  OFString sopClass;
+  if (!fileformat->getDataset()->findAndGetOFString(DCM_SOPClassUID, sopClass).good())
+  {
+    return unknownLoadOrder;
+  }
+
+  // Plans reference structure sets, doses and RT images reference plans
+  if (sopClass == UID_RTStructureSetStorage)
+  {
+    return 0;
+  }
+  if (sopClass == UID_RTPlanStorage || sopClass == UID_RTIonPlanStorage)
+  {
+    return 1;
+  }
+  if (sopClass == UID_RTDoseStorage)
+  {
+    return 2;
+  }
+  if (sopClass == UID_RTImageStorage)
+  {
+    return 3;
+  }
+  return unknownLoadOrder;
+}
+
 //----------------------------------------------------------------------------
 std::string vtkSlicerDicomRtImportExportModuleLogic::ExportDicomRTStudy(vtkCollection* exportables)
 {
@@ -2575,7 +4458,7 @@ std::string vtkSlicerDicomRtImportExportModuleLogic::ExportDicomRTStudy(vtkColle
 
   // Convert input image (CT/MR/etc) to the format Plastimatch can use
   vtkSmartPointer<vtkOrientedImageData> imageOrientedImageData = vtkSmartPointer<vtkOrientedImageData>::New();
-  if (!vtkSlicerRtCommon::ConvertVolumeNodeToVtkOrientedImageData(imageNode, imageOrientedImageData))
+  if (!GetVolumeOrientedImageDataForExport(imageNode, imageOrientedImageData))
   {
     error = "Failed to convert anatomical image " + std::string(imageNode->GetName()) + " to oriented image data";
     vtkErrorMacro("ExportDicomRTStudy: " + error);
@@ -2608,7 +4491,7 @@ std::string vtkSlicerDicomRtImportExportModuleLogic::ExportDicomRTStudy(vtkColle
   if (doseNode)
   {
     vtkSmartPointer<vtkOrientedImageData> doseOrientedImageData = vtkSmartPointer<vtkOrientedImageData>::New();
-    if (!vtkSlicerRtCommon::ConvertVolumeNodeToVtkOrientedImageData(doseNode, doseOrientedImageData))
+    if (!GetVolumeOrientedImageDataForExport(doseNode, doseOrientedImageData))
     {
       error = "Failed to convert dose volume " + std::string(doseNode->GetName()) + " to oriented image data";
       vtkErrorMacro("ExportDicomRTStudy: " + error);
@@ -2643,7 +4526,7 @@ std::string vtkSlicerDicomRtImportExportModuleLogic::ExportDicomRTStudy(vtkColle
   {
     // If master representation is labelmap type, then export binary labelmap
     vtkSegmentation* segmentation = segmentationNode->GetSegmentation();
-    if (segmentation->IsMasterRepresentationImageData())
+    if (segmentation->IsMasterRepresentationImageData() && !this->ExportClosedSurfaceContours)
     {
       // Make sure segmentation contains binary labelmap
       if ( !segmentationNode->GetSegmentation()->CreateRepresentation(
@@ -2654,6 +4537,9 @@ std::string vtkSlicerDicomRtImportExportModuleLogic::ExportDicomRTStudy(vtkColle
         return error;
       }
 
+      // Mask of the anatomical image geometry, reused by all segments that can be extracted directly from their layer
+      vtkSmartPointer<vtkOrientedImageData> segmentMask;
+
       // Export each segment in segmentation
       std::vector< std::string > segmentIDs;
       segmentationNode->GetSegmentation()->GetSegmentIDs(segmentIDs);
@@ -2662,48 +4548,87 @@ std::string vtkSlicerDicomRtImportExportModuleLogic::ExportDicomRTStudy(vtkColle
         std::string segmentID = *segmentIdIt;
         vtkSegment* segment = segmentationNode->GetSegmentation()->GetSegment(*segmentIdIt);
 
-        // Get binary labelmap representation
+        Plm_image::Pointer plmStructure;
+
 #if Slicer_VERSION_MAJOR >= 5 || (Slicer_VERSION_MAJOR >= 4 && Slicer_VERSION_MINOR >= 11)
-        vtkNew<vtkOrientedImageData> binaryLabelmap;
-        segmentationNode->GetBinaryLabelmapRepresentation(segmentID, binaryLabelmap);
-#else
-        vtkOrientedImageData* binaryLabelmap = vtkOrientedImageData::SafeDownCast(
+        // If the labelmap layer of the segment has the geometry of the anatomical image, then extract the segment
+        // from the (possibly shared) layer directly into the mask, without copying, transforming or resampling it
+        vtkOrientedImageData* labelmapLayer = vtkOrientedImageData::SafeDownCast(
           segment->GetRepresentation(vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName()) );
-#endif
-        if (!binaryLabelmap)
-        {
-          error = "Failed to get binary labelmap representation from segment " + segmentID;
-          vtkErrorMacro("ExportDicomRTStudy: " + error);
-          return error;
-        }
-        // Temporarily copy labelmap image data as it will be probably resampled
-        vtkSmartPointer<vtkOrientedImageData> binaryLabelmapCopy = vtkSmartPointer<vtkOrientedImageData>::New();
-        binaryLabelmapCopy->DeepCopy(binaryLabelmap);
-
-        // Apply parent transformation nodes if necessary
-        if (segmentationNode->GetParentTransformNode())
+        if ( labelmapLayer && !segmentationNode->GetParentTransformNode()
+          && labelmapLayer->GetPointData()->GetScalars() && labelmapLayer->GetNumberOfScalarComponents() == 1
+          && vtkOrientedImageDataResample::DoGeometriesMatch(imageOrientedImageData, labelmapLayer) )
         {
-          if (!vtkSlicerSegmentationsModuleLogic::ApplyParentTransformToOrientedImageData(segmentationNode, binaryLabelmapCopy))
+          if (!segmentMask)
+          {
+            segmentMask = vtkSmartPointer<vtkOrientedImageData>::New();
+            vtkSmartPointer<vtkMatrix4x4> imageToWorldMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+            imageOrientedImageData->GetImageToWorldMatrix(imageToWorldMatrix);
+            segmentMask->SetGeometryFromImageToWorldMatrix(imageToWorldMatrix);
+            segmentMask->SetExtent(imageOrientedImageData->GetExtent());
+            segmentMask->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+          }
+          bool extracted = true;
+          switch (labelmapLayer->GetScalarType())
           {
-            std::string errorMessage("Failed to apply parent transformation to exported segment");
-            vtkErrorMacro("ExportDicomRTStudy: " << errorMessage);
-            return errorMessage;
+            vtkTemplateMacro(ExtractSegmentMask(labelmapLayer, static_cast<VTK_TT*>(nullptr), segment->GetLabelValue(), segmentMask));
+            default:
+              extracted = false;
+              break;
+          }
+          if (extracted)
+          {
+            plmStructure = PlmCommon::ConvertVtkOrientedImageDataToPlmImage(segmentMask);
           }
         }
-        // Make sure the labelmap dimensions match the reference dimensions
-        if ( !vtkOrientedImageDataResample::DoGeometriesMatch(imageOrientedImageData, binaryLabelmapCopy)
-          || !vtkOrientedImageDataResample::DoExtentsMatch(imageOrientedImageData, binaryLabelmapCopy) )
+#endif
+
+        if (!plmStructure)
         {
-          if (!vtkOrientedImageDataResample::ResampleOrientedImageToReferenceOrientedImage(binaryLabelmapCopy, imageOrientedImageData, binaryLabelmapCopy))
+          // Get binary labelmap representation
+#if Slicer_VERSION_MAJOR >= 5 || (Slicer_VERSION_MAJOR >= 4 && Slicer_VERSION_MINOR >= 11)
+          // The segment is extracted from its layer into a new image, which can be transformed and resampled in place
+          vtkSmartPointer<vtkOrientedImageData> binaryLabelmapCopy = vtkSmartPointer<vtkOrientedImageData>::New();
+          segmentationNode->GetBinaryLabelmapRepresentation(segmentID, binaryLabelmapCopy);
+#else
+          vtkOrientedImageData* binaryLabelmap = vtkOrientedImageData::SafeDownCast(
+            segment->GetRepresentation(vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName()) );
+          if (!binaryLabelmap)
           {
-            error = "Failed to resample segment " + segmentID + " to match anatomical image geometry";
+            error = "Failed to get binary labelmap representation from segment " + segmentID;
             vtkErrorMacro("ExportDicomRTStudy: " + error);
             return error;
           }
-        }
+          // Temporarily copy labelmap image data as it will be probably resampled
+          vtkSmartPointer<vtkOrientedImageData> binaryLabelmapCopy = vtkSmartPointer<vtkOrientedImageData>::New();
+          binaryLabelmapCopy->DeepCopy(binaryLabelmap);
+#endif
+
+          // Apply parent transformation nodes if necessary
+          if (segmentationNode->GetParentTransformNode())
+          {
+            if (!vtkSlicerSegmentationsModuleLogic::ApplyParentTransformToOrientedImageData(segmentationNode, binaryLabelmapCopy))
+            {
+              std::string errorMessage("Failed to apply parent transformation to exported segment");
+              vtkErrorMacro("ExportDicomRTStudy: " << errorMessage);
+              return errorMessage;
+            }
+          }
+          // Make sure the labelmap dimensions match the reference dimensions
+          if ( !vtkOrientedImageDataResample::DoGeometriesMatch(imageOrientedImageData, binaryLabelmapCopy)
+            || !vtkOrientedImageDataResample::DoExtentsMatch(imageOrientedImageData, binaryLabelmapCopy) )
+          {
+            if (!vtkOrientedImageDataResample::ResampleOrientedImageToReferenceOrientedImage(binaryLabelmapCopy, imageOrientedImageData, binaryLabelmapCopy))
+            {
+              error = "Failed to resample segment " + segmentID + " to match anatomical image geometry";
+              vtkErrorMacro("ExportDicomRTStudy: " + error);
+              return error;
+            }
+          }
 
-        // Convert mask to Plm image
-        Plm_image::Pointer plmStructure = PlmCommon::ConvertVtkOrientedImageDataToPlmImage(binaryLabelmapCopy);
+          // Convert mask to Plm image
+          plmStructure = PlmCommon::ConvertVtkOrientedImageDataToPlmImage(binaryLabelmapCopy);
+        }
         if (!plmStructure)
         {
           error = "Failed to convert segment labelmap " + segmentID + " to Plastimatch image";
@@ -2718,8 +4643,8 @@ std::string vtkSlicerDicomRtImportExportModuleLogic::ExportDicomRTStudy(vtkColle
         rtWriter->AddStructure(plmStructure->itk_uchar(), segmentName.c_str(), segmentColor);
       } // For each segment
     }
-    // If master representation is poly data type, then export from closed surface
-    else if (segmentation->IsMasterRepresentationPolyData())
+    // If master representation is poly data type (or requested), then export from closed surface
+    else if (segmentation->IsMasterRepresentationPolyData() || this->ExportClosedSurfaceContours)
     {
       // Make sure segmentation contains closed surface
       if ( !segmentationNode->GetSegmentation()->CreateRepresentation(
@@ -2731,91 +4656,74 @@ std::string vtkSlicerDicomRtImportExportModuleLogic::ExportDicomRTStudy(vtkColle
       }
 
       // Get transform  from segmentation to world (RAS)
-      vtkSmartPointer<vtkGeneralTransform> nodeToWorldTransform = vtkSmartPointer<vtkGeneralTransform>::New();
-      nodeToWorldTransform->Identity();
+      vtkSmartPointer<vtkGeneralTransform> nodeToWorldTransform;
       if (segmentationNode->GetParentTransformNode())
       {
+        nodeToWorldTransform = vtkSmartPointer<vtkGeneralTransform>::New();
         segmentationNode->GetParentTransformNode()->GetTransformToWorld(nodeToWorldTransform);
       }
-      // Initialize poly data transformer
-      vtkSmartPointer<vtkTransformPolyDataFilter> transformPolyData = vtkSmartPointer<vtkTransformPolyDataFilter>::New();
-      transformPolyData->SetTransform(nodeToWorldTransform);
-
-      // Initialize cutting plane with normal of the Z axis of the anatomical image
-      vtkSmartPointer<vtkMatrix4x4> imageToWorldMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
-      imageOrientedImageData->GetImageToWorldMatrix(imageToWorldMatrix);
-      double normal[3] = { imageToWorldMatrix->GetElement(0,2), imageToWorldMatrix->GetElement(1,2), imageToWorldMatrix->GetElement(2,2) };
-      vtkSmartPointer<vtkPlane> slicePlane = vtkSmartPointer<vtkPlane>::New();
-      slicePlane->SetNormal(normal);
 
-      // Export each segment in segmentation
+      // Get closed surfaces in world coordinate system. Transforms are applied on the main thread,
+      // as the transform is shared by the segments
       std::vector< std::string > segmentIDs;
       segmentationNode->GetSegmentation()->GetSegmentIDs(segmentIDs);
+      std::vector<vtkSmartPointer<vtkPolyData> > closedSurfaces;
       for (std::vector< std::string >::const_iterator segmentIdIt = segmentIDs.begin(); segmentIdIt != segmentIDs.end(); ++segmentIdIt)
       {
-        std::string segmentID = *segmentIdIt;
         vtkSegment* segment = segmentationNode->GetSegmentation()->GetSegment(*segmentIdIt);
-
-        // Get closed surface representation
         vtkPolyData* closedSurfacePolyData = vtkPolyData::SafeDownCast(
           segment->GetRepresentation(vtkSegmentationConverter::GetSegmentationClosedSurfaceRepresentationName()) );
         if (!closedSurfacePolyData)
         {
-          error = "Failed to get closed surface representation from segment " + segmentID;
+          error = "Failed to get closed surface representation from segment " + *segmentIdIt;
           vtkErrorMacro("ExportDicomRTStudy: " + error);
           return error;
         }
-
-        // Initialize cutter pipeline for segment
+        if (!nodeToWorldTransform)
+        {
+          closedSurfaces.push_back(closedSurfacePolyData);
+          continue;
+        }
+        vtkSmartPointer<vtkTransformPolyDataFilter> transformPolyData = vtkSmartPointer<vtkTransformPolyDataFilter>::New();
+        transformPolyData->SetTransform(nodeToWorldTransform);
         transformPolyData->SetInputData(closedSurfacePolyData);
-        vtkSmartPointer<vtkCutter> cutter = vtkSmartPointer<vtkCutter>::New();
-        cutter->SetInputConnection(transformPolyData->GetOutputPort());
-        cutter->SetGenerateCutScalars(0);
-        vtkSmartPointer<vtkStripper> stripper = vtkSmartPointer<vtkStripper>::New();
-        stripper->SetInputConnection(cutter->GetOutputPort());
-
-        // Get segment bounding box
-        double bounds[6] = {0.0,0.0,0.0,0.0,0.0,0.0};
         transformPolyData->Update();
-        transformPolyData->GetOutput()->GetBounds(bounds);
+        closedSurfaces.push_back(transformPolyData->GetOutput());
+      }
+
+      // Create planar contours from the closed surfaces based on the anatomical image slices.
+      // Segments are cut in parallel, each with its own cutter pipeline
+      vtkSmartPointer<vtkMatrix4x4> imageToWorldMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+      imageOrientedImageData->GetImageToWorldMatrix(imageToWorldMatrix);
+      int imageExtent[6] = {0,-1,0,-1,0,-1};
+      imageOrientedImageData->GetExtent(imageExtent);
+      std::vector<std::map<int, vtkSmartPointer<vtkPolyData> > > segmentSliceContours(segmentIDs.size());
+      vtkSMPTools::For(0, static_cast<vtkIdType>(segmentIDs.size()), 1, [&](vtkIdType beginSegmentIndex, vtkIdType endSegmentIndex)
+      {
+        for (vtkIdType segmentIndex = beginSegmentIndex; segmentIndex < endSegmentIndex; ++segmentIndex)
+        {
+          CutClosedSurfaceWithImageSlices(closedSurfaces[segmentIndex], imageToWorldMatrix, imageExtent, segmentSliceContours[segmentIndex]);
+        }
+      });
+
+      // Export each segment in segmentation
+      for (size_t segmentIndex = 0; segmentIndex < segmentIDs.size(); ++segmentIndex)
+      {
+        vtkSegment* segment = segmentationNode->GetSegmentation()->GetSegment(segmentIDs[segmentIndex]);
 
         // Containers to be passed to the writer
         std::vector<int> sliceNumbers;
         std::vector<std::string> sliceUIDs;
         std::vector<vtkPolyData*> sliceContours;
-
-        // Create planar contours from closed surface based on each of the anatomical image slices
-        int imageExtent[6] = {0,-1,0,-1,0,-1};
-        imageOrientedImageData->GetExtent(imageExtent);
-        for (int slice=imageExtent[4]; slice<imageExtent[5]; ++slice)
+        for (const auto& sliceContour : segmentSliceContours[segmentIndex])
         {
-          // Calculate slice origin
-          double origin[3] = { imageToWorldMatrix->GetElement(0,3) + slice*normal[0],
-                               imageToWorldMatrix->GetElement(1,3) + slice*normal[1],
-                               imageToWorldMatrix->GetElement(2,3) + slice*normal[2] };
-          slicePlane->SetOrigin(origin);
-          if (origin[2] < bounds[4] || origin[2] > bounds[5])
-          {
-            // No contours outside surface bounds
-            continue;
-          }
-
-          // Cut closed surface at slice
-          cutter->SetCutFunction(slicePlane);
-
           // Get instance UID of corresponding slice
-          int sliceNumber = slice-imageExtent[0];
+          int sliceNumber = sliceContour.first - imageExtent[4];
           sliceNumbers.push_back(sliceNumber);
           std::string sliceInstanceUID = (imageSliceUIDs.size() > static_cast<size_t>(sliceNumber) ? imageSliceUIDs[sliceNumber] : "");
           sliceUIDs.push_back(sliceInstanceUID);
-
-          // Save slice contour
-          stripper->Update();
-          vtkPolyData* sliceContour = vtkPolyData::New();
-          sliceContour->SetPoints(stripper->GetOutput()->GetPoints());
-          sliceContour->SetPolys(stripper->GetOutput()->GetLines());
-          sliceContours.push_back(sliceContour);
-        } // For each anatomical image slice
+          sliceContours.push_back(sliceContour.second);
+        }
 
         // Get segment properties
         std::string segmentName = segment->GetName();
@@ -2823,12 +4731,6 @@ std::string vtkSlicerDicomRtImportExportModuleLogic::ExportDicomRTStudy(vtkColle
 
         // Add contours to writer
         rtWriter->AddStructure(segmentName.c_str(), segmentColor, sliceNumbers, sliceUIDs, sliceContours);
-
-        // Clean up slice contours
-        for (std::vector<vtkPolyData*>::iterator contourIt=sliceContours.begin(); contourIt!=sliceContours.end(); ++contourIt)
-        {
-          (*contourIt)->Delete();
-        }
       } // For each segment
     }
     else
@@ -2840,6 +4742,7 @@ std::string vtkSlicerDicomRtImportExportModuleLogic::ExportDicomRTStudy(vtkColle
   }
 
   // Write files to disk
+  rtWriter->SetWriteDoseConcurrently(this->ExportDoseConcurrently);
   rtWriter->SetFileName(outputPath);
   rtWriter->Write();
 
@@ -38,12 +38,14 @@
 #include "vtkSlicerDicomRtImportExportModuleLogicExport.h"
 
 class vtkCollection;
+class vtkMRMLNode;
 class vtkMRMLScalarVolumeNode;
 class vtkMRMLScene;
 class vtkMRMLSegmentationNode;
 class vtkSlicerBeamsModuleLogic;
 class vtkSlicerDICOMLoadable;
 class vtkSlicerDicomReaderBase;
+class vtkSlicerDicomRtDatasetCache;
 class vtkSlicerIsodoseModuleLogic;
 class vtkSlicerPlanarImageModuleLogic;
 class vtkStringArray;
@@ -57,7 +59,9 @@ public:
   vtkTypeMacro(vtkSlicerDicomRtImportExportModuleLogic, vtkSlicerModuleLogic);
   void PrintSelf(ostream& os, vtkIndent indent) override;
 
-  /// Examine a list of file lists and determine what objects can be loaded from them
+  /// Examine a list of file lists and determine what objects can be loaded from them.
+  /// Files are parsed in parallel (see \sa ExamineNumberOfThreads), the loadables are created in the order of the files.
+  /// Parsed RT plans and structure sets are stored in \sa DatasetCache so that loading does not need to parse them again
   /// \param fileList List of files to examine and generate loadables from
   /// \param loadables Collection to store generated (output) loadables
   void ExamineForLoad(vtkStringArray* fileList, vtkCollection* loadables);
@@ -66,6 +70,29 @@ public:
   /// /return True if loading successful
   bool LoadDicomRT(vtkSlicerDICOMLoadable* loadable);
 
+  /// Load the DICOM RT series of a study in one pass.
+  /// The objects are loaded in reference order (structure sets and plans before the doses and RT images referencing
+  /// them) in a single scene batch process. The order is determined from the file headers, and each object is read
+  /// right before it is loaded and released afterwards. The parsed files (\sa DatasetCache) and the DICOM database
+  /// connection are shared by all objects. Used by the DICOM plugin to load the selected RT series together
+  /// \param loadables Collection of vtkSlicerDICOMLoadable objects
+  /// \return True if all loadables were loaded successfully
+  bool LoadDicomRTStudy(vtkCollection* loadables);
+
+  /// Load the contours of structure set segments that were not loaded when importing the structure set
+  /// (see \sa LazyStructureSetLoading). It is also called when the segment is shown, or when its data is
+  /// requested by invoking vtkSlicerRtCommon::SegmentDataRequested on the segmentation node
+  /// \param segmentID Segment to load the contours of. If nullptr, then the contours of all segments are loaded
+  /// \return True if the contours are loaded or were loaded already
+  bool LoadDeferredSegmentContours(vtkMRMLSegmentationNode* segmentationNode, const char* segmentID=nullptr);
+
+  /// Load the pixels of an RT image that were not loaded when importing the RT image (see \sa LazyRtImageLoading).
+  /// It is also called when the RT image or its planar image model is shown, when the RT image is shown as background
+  /// or foreground in a slice view, or when its data is requested by invoking vtkSlicerRtCommon::RtImageDataRequested
+  /// on the volume node
+  /// \return True if the pixels are loaded or were loaded already
+  bool LoadDeferredRtImage(vtkMRMLScalarVolumeNode* volumeNode);
+
   /// Export RT study (list of RT exportables) to DICOM files
   /// \return Error message, empty string if success
   std::string ExportDicomRTStudy(vtkCollection* exportables);
@@ -90,9 +117,43 @@ public:
   vtkGetMacro(BeamModelsInSeparateBranch, bool);
   vtkBooleanMacro(BeamModelsInSeparateBranch, bool);
 
+  vtkSetMacro(ExamineNumberOfThreads, int);
+  vtkGetMacro(ExamineNumberOfThreads, int);
+
+  vtkSetMacro(ExportDoseConcurrently, bool);
+  vtkGetMacro(ExportDoseConcurrently, bool);
+  vtkBooleanMacro(ExportDoseConcurrently, bool);
+
+  vtkSetMacro(ExportClosedSurfaceContours, bool);
+  vtkGetMacro(ExportClosedSurfaceContours, bool);
+  vtkBooleanMacro(ExportClosedSurfaceContours, bool);
+
+  vtkSetMacro(LazyStructureSetLoading, bool);
+  vtkGetMacro(LazyStructureSetLoading, bool);
+  vtkBooleanMacro(LazyStructureSetLoading, bool);
+
+  vtkSetMacro(LazyRtImageLoading, bool);
+  vtkGetMacro(LazyRtImageLoading, bool);
+  vtkBooleanMacro(LazyRtImageLoading, bool);
+
+  vtkSetMacro(MergeStructureSetSegments, bool);
+  vtkGetMacro(MergeStructureSetSegments, bool);
+  vtkBooleanMacro(MergeStructureSetSegments, bool);
+
+  /// Get cache of parsed files shared by examination and loading
+  vtkGetObjectMacro(DatasetCache, vtkSlicerDicomRtDatasetCache);
+
 protected:
   void SetMRMLSceneInternal(vtkMRMLScene* newScene) override;
   void OnMRMLSceneEndClose() override;
+  void OnMRMLSceneNodeAdded(vtkMRMLNode* node) override;
+  void OnMRMLSceneNodeRemoved(vtkMRMLNode* node) override;
+
+  /// Load deferred segment contours before saving the scene
+  void ProcessMRMLSceneEvents(vtkObject* caller, unsigned long event, void* callData) override;
+
+  /// Load deferred segment contours and RT image pixels when they are shown or their data is requested
+  void ProcessMRMLNodesEvents(vtkObject* caller, unsigned long event, void* callData) override;
 
   /// Register MRML Node classes to Scene. Gets called automatically when the MRMLScene is attached to this logic class.
   void RegisterNodes() override;
@@ -121,6 +182,41 @@ private:
   /// Flag determining whether the generated beam models are arranged in a separate subject hierarchy
   /// branch, or each beam model is added under its corresponding isocenter fiducial
   bool BeamModelsInSeparateBranch;
+
+  /// Number of threads parsing files in \sa ExamineForLoad. If 0 (default), then it is determined
+  /// automatically from the number of available cores and the number of files
+  int ExamineNumberOfThreads;
+
+  /// Flag determining whether the RT dose is written on a separate thread in \sa ExportDicomRTStudy, concurrently
+  /// with the image series and the structure set (see vtkSlicerDicomRtWriter::WriteDoseConcurrently). Off by default
+  bool ExportDoseConcurrently;
+
+  /// Flag determining whether structure set contours are exported by cutting the closed surface representation
+  /// of the segments with the anatomical image slices even if the master representation is binary labelmap.
+  /// Segmentations with closed surface master representation are always exported this way. Off by default
+  bool ExportClosedSurfaceContours;
+
+  /// Cache of parsed files shared by \sa ExamineForLoad and \sa LoadDicomRT
+  vtkSlicerDicomRtDatasetCache* DatasetCache;
+
+  /// Flag determining whether structure set segments are created without contours, which are loaded
+  /// only when the segment is first shown or its data is requested (see \sa LoadDeferredSegmentContours).
+  /// The segments are hidden initially, and are tagged with \sa vtkSlicerRtCommon::DICOMRTIMPORT_ROI_CONTOURS_DEFERRED_SEGMENT_TAG_NAME
+  /// until their contours are loaded. Off by default
+  bool LazyStructureSetLoading;
+
+  /// Flag determining whether RT images are created with geometry from the header tags only, and their pixels
+  /// are read only when the image is first shown or its data is requested (see \sa LoadDeferredRtImage).
+  /// The RT image volumes are hidden initially. Off by default
+  bool LazyRtImageLoading;
+
+  /// Flag determining whether a structure set is merged into the segmentation loaded earlier from a revision of the
+  /// same structure set, if any. That is a structure set in the same study with the same label, referencing the same
+  /// image series. Segments loaded from ROIs are matched by name, and only the ones whose contour hash changed are
+  /// rebuilt. The others are kept with all their representations. Segments of ROIs that are not in the structure set
+  /// anymore are removed, while segments not loaded from ROIs are kept. Point ROIs are not merged, but loaded as new
+  /// markups nodes. Contour loading is not deferred in this mode (\sa LazyStructureSetLoading). Off by default
+  bool MergeStructureSetSegments;
 };
 
 #endif
@@ -23,28 +23,46 @@
 
 // DicomRtImportExportModuleLogic includes
 #include "vtkSlicerDicomRtReader.h"
+#include "vtkSlicerDicomRtDatasetCache.h"
 
 // SlicerRt includes
 #include "vtkSlicerRtCommon.h"
 
 // VTK includes
 #include <vtkCellArray.h>
+#include <vtkFloatArray.h>
+#include <vtkIdTypeArray.h>
+#include <vtkImageData.h>
 #include <vtkMath.h>
+#include <vtkMatrix4x4.h>
 #include <vtkObjectFactory.h>
 #include <vtkPoints.h>
 #include <vtkPolyData.h>
+#include <vtkSMPTools.h>
 #include <vtkSmartPointer.h>
+#include <vtkVariant.h>
+#include <vtkVersion.h>
 
 // STD includes
+#include <algorithm>
 #include <array>
+#include <cstdint>
+#include <iomanip>
 #include <vector>
 #include <map>
+#include <memory>
+#include <set>
+#include <sstream>
+#include <unordered_map>
 
 // DCMTK includes
 #include <dcmtk/config/osconfig.h>    /* make sure OS specific configuration is included first */
 
 #include <dcmtk/ofstd/ofconapp.h>
 
+#include <dcmtk/dcmdata/dcfcache.h>
+#include <dcmtk/dcmdata/dcxfer.h>
+
 #include <dcmtk/dcmrt/drtdose.h>
 #include <dcmtk/dcmrt/drtimage.h>
 #include <dcmtk/dcmrt/drtplan.h>
@@ -57,6 +75,68 @@
 #include <QSettings>
 
 vtkStandardNewMacro(vtkSlicerDicomRtReader);
+vtkCxxSetObjectMacro(vtkSlicerDicomRtReader, DatasetCache, vtkSlicerDicomRtDatasetCache);
+
+namespace
+{
+  /// Values longer than this (pixel data) are not read into memory if RT image pixel loading is deferred.
+  /// They are only loaded from the file if accessed
+  const Uint32 DEFERRED_PIXEL_MAX_READ_LENGTH = 1024;
+
+  /// Determine whether a parsed DICOM file is an RT image. Only the pixel data of RT images is deferred
+  bool IsRtImageFile(DcmFileFormat* fileformat)
+  {
+    OFString sopClass("");
+    return fileformat->getDataset()->findAndGetOFString(DCM_SOPClassUID, sopClass).good() && sopClass == UID_RTImageStorage;
+  }
+
+  /// Determine whether a DICOM file is an RT image by parsing its header only until the SOP class
+  bool IsRtImageFile(const char* fileName)
+  {
+    DcmFileFormat fileformat;
+    return fileformat.loadFileUntilTag(fileName, EXS_Unknown, EGL_noChange,
+      DEFERRED_PIXEL_MAX_READ_LENGTH, ERM_autoDetect, DCM_SOPInstanceUID).good() && IsRtImageFile(&fileformat);
+  }
+
+  /// Offset basis and prime of the 64-bit FNV-1a hash used for ROI contour hashes
+  const uint64_t CONTOUR_HASH_OFFSET_BASIS = 14695981039346656037ULL;
+  const uint64_t CONTOUR_HASH_PRIME = 1099511628211ULL;
+
+  /// Add bytes to a 64-bit FNV-1a hash
+  void AddToContourHash(uint64_t& hash, const void* data, size_t length)
+  {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    for (size_t byteIndex = 0; byteIndex < length; ++byteIndex)
+    {
+      hash ^= bytes[byteIndex];
+      hash *= CONTOUR_HASH_PRIME;
+    }
+  }
+
+  /// Convert stored dose values of a frame to dose using the dose grid scaling
+  template<typename StoredType>
+  void ScaleDoseFrame(const void* frameBuffer, vtkIdType numberOfVoxels, double doseGridScaling, float* doseVoxels)
+  {
+    const StoredType* storedValues = static_cast<const StoredType*>(frameBuffer);
+    for (vtkIdType voxelIndex = 0; voxelIndex < numberOfVoxels; ++voxelIndex)
+    {
+      doseVoxels[voxelIndex] = static_cast<float>(storedValues[voxelIndex] * doseGridScaling);
+    }
+  }
+
+  /// Convert stored pixel values of an image frame in place using the rescale slope and intercept.
+  /// The frame is stored at the beginning of the float buffer of the same number of pixels
+  template<typename StoredType>
+  void RescaleImageFrame(float* pixels, vtkIdType numberOfPixels, double rescaleSlope, double rescaleIntercept)
+  {
+    // Convert from the last pixel, as the stored values are not larger than the floats
+    const StoredType* storedValues = reinterpret_cast<const StoredType*>(pixels);
+    for (vtkIdType pixelIndex = numberOfPixels - 1; pixelIndex >= 0; --pixelIndex)
+    {
+      pixels[pixelIndex] = static_cast<float>(storedValues[pixelIndex] * rescaleSlope + rescaleIntercept);
+    }
+  }
+}
 
 //----------------------------------------------------------------------------
 class vtkSlicerDicomRtReader::vtkInternal
@@ -146,10 +226,26 @@ public:
     std::string ReferencedSeriesUID;
     std::string ReferencedFrameOfReferenceUID;
     std::map<int,std::string> ContourIndexToSOPInstanceUIDMap;
+    /// Number of contour points. Set also if loading the contours is deferred
+    vtkIdType NumberOfPoints;
+    /// ROI contour item in the retained structure set if loading the contours is deferred, nullptr otherwise
+    DRTROIContourSequence::Item* DeferredContourItem;
+    /// Hash of the contour sequence. Empty until the contours are loaded
+    std::string ContourHash;
+  };
+
+  /// Errors and warnings of loading the contours of a ROI. VTK logging is not thread-safe, so when ROIs are
+  /// loaded concurrently the messages are collected and logged after all ROIs are loaded
+  struct RoiLoadMessages
+  {
+    std::vector<std::string> Errors;
+    std::vector<std::string> Warnings;
   };
 
   /// List of loaded contour ROIs from structure set
   std::vector<RoiEntry> RoiSequenceVector;
+  /// Index in \sa RoiSequenceVector for each ROI number (the first ROI if the number is not unique)
+  std::unordered_map<unsigned int, size_t> RoiNumberToIndexMap;
 
   //TODO: Use referenced beams to load beams in correct order
   class ReferencedBeamEntry
@@ -320,6 +416,8 @@ public:
 
   /// List of loaded beams from external beam plan
   std::vector<BeamEntry> BeamSequenceVector;
+  /// Index in \sa BeamSequenceVector for each beam number (the first beam if the number is not unique)
+  std::unordered_map<unsigned int, size_t> BeamNumberToIndexMap;
 
   /// Structure storing a channel in an RT application setup (for brachytherapy plan)
   class ChannelEntry
@@ -346,6 +444,10 @@ public:
 public:
   /// Load RT Dose
   void LoadRTDose(DcmDataset* dataset);
+  /// Decode dose voxels into a float image data frame by frame, applying the dose grid scaling.
+  /// Uncompressed pixel data is read from the file one frame at a time, so the stored values are never held in full.
+  /// \return Success flag. If failed, then the dose volume needs to be read by a generic volume reader
+  bool LoadRTDoseVoxels(DRTDoseIOD& rtDose, DcmDataset* dataset, double doseGridScaling);
 
   /// Load RT Plan 
   void LoadRTPlan(DcmDataset* dataset);
@@ -356,11 +458,26 @@ public:
   void LoadRTStructureSet(DcmDataset* dataset);
   /// Load contours from a structure sequence
   void LoadContoursFromRoiSequence(DRTStructureSetROISequence* roiSequence);
-  /// Load individual contour from RT Structure Set
-  vtkSlicerDicomRtReader::vtkInternal::RoiEntry* LoadContour(DRTROIContourSequence::Item &roiObject, DRTStructureSetIOD* rtStructureSet);
+  /// Get the number of contour points in a ROI without decoding the contour data
+  static vtkIdType GetNumberOfContourPoints(DRTROIContourSequence::Item &roiObject, vtkIdType* numberOfContours=nullptr);
+  /// Read the display color of a ROI into its ROI entry
+  static void LoadRoiDisplayColor(DRTROIContourSequence::Item &roiObject, RoiEntry* roiEntry);
+  /// Load individual contour from RT Structure Set into its ROI entry.
+  /// Only accesses the given ROI item and entry, so it can be called for different ROIs concurrently
+  /// \param referencedSopInstanceUids Output set of slice instance UIDs referenced by the contours
+  /// \param messages Output errors and warnings, to be logged by the caller (see \sa LogRoiLoadMessages)
+  /// \return True if the ROI contains contours
+  bool LoadContour(DRTROIContourSequence::Item &roiObject, RoiEntry* roiEntry, std::set<std::string>& referencedSopInstanceUids,
+    RoiLoadMessages& messages);
+  /// Log errors and warnings collected while loading a ROI. Must be called on the main thread
+  void LogRoiLoadMessages(const RoiLoadMessages& messages);
 
   /// Load RT Image
   void LoadRTImage(DcmDataset* dataset);
+  /// Decode all frames of a multi-frame RT image into one preallocated image data.
+  /// Uncompressed pixel data is read from the file directly into the buffer of each frame.
+  /// \return Success flag. If failed, then the RT image needs to be read by a generic volume reader
+  bool LoadRTImageFrames(DRTImageIOD& rtImage, DcmDataset* dataset, Sint32 numberOfFrames);
 
 public:
   /// Find and return a beam entry according to its beam number
@@ -381,8 +498,23 @@ public:
   /// Get contour image sequence object in the referenced frame of reference sequence for a structure set
   DRTContourImageSequence* GetReferencedFrameOfReferenceContourImageSequence(DRTStructureSetIOD* rtStructureSet);
 
+  /// Get slice instance UIDs from the referenced frame of reference sequence for ROIs that do not reference the slices for each contour.
+  /// Keys of the map are negative to indicate that the slice instances cannot be directly mapped to the ROI planar contours
+  void GetReferencedFrameOfReferenceContourToSliceInstanceUIDMap(DRTStructureSetIOD* rtStructureSet, std::map<int, std::string>& contourToSliceInstanceUIDMap);
+
 public:
   vtkSlicerDicomRtReader* External;
+
+  /// Structure set kept in memory to load the deferred ROI contours from (see \sa DeferRoiContourLoading)
+  DRTStructureSetIOD* DeferredStructureSet;
+
+  /// Dose voxels with dose grid scaling applied (see \sa LoadRTDoseVoxels)
+  vtkSmartPointer<vtkImageData> DoseImageData;
+  /// IJK to RAS matrix of the dose volume
+  vtkSmartPointer<vtkMatrix4x4> DoseIJKToRASMatrix;
+
+  /// Frames of a multi-frame RT image (see \sa LoadRTImageFrames)
+  vtkSmartPointer<vtkImageData> RTImageFramesImageData;
 };
 
 //----------------------------------------------------------------------------
@@ -391,9 +523,12 @@ public:
 //----------------------------------------------------------------------------
 vtkSlicerDicomRtReader::vtkInternal::vtkInternal(vtkSlicerDicomRtReader* external)
   : External(external)
+  , DeferredStructureSet(nullptr)
 {
   this->RoiSequenceVector.clear();
+  this->RoiNumberToIndexMap.clear();
   this->BeamSequenceVector.clear();
+  this->BeamNumberToIndexMap.clear();
   this->ChannelSequenceVector.clear();
 }
 
@@ -403,6 +538,12 @@ vtkSlicerDicomRtReader::vtkInternal::~vtkInternal()
   this->RoiSequenceVector.clear();
   this->BeamSequenceVector.clear();
   this->ChannelSequenceVector.clear();
+
+  if (this->DeferredStructureSet)
+  {
+    delete this->DeferredStructureSet;
+    this->DeferredStructureSet = nullptr;
+  }
 }
 
 //----------------------------------------------------------------------------
@@ -411,6 +552,8 @@ vtkSlicerDicomRtReader::vtkInternal::RoiEntry::RoiEntry()
   this->Number = 0;
   this->DisplayColor = { 1.0, 0.0, 0.0 };
   this->PolyData = nullptr;
+  this->NumberOfPoints = 0;
+  this->DeferredContourItem = nullptr;
 }
 
 //----------------------------------------------------------------------------
@@ -431,6 +574,9 @@ vtkSlicerDicomRtReader::vtkInternal::RoiEntry::RoiEntry(const RoiEntry& src)
   this->ReferencedSeriesUID = src.ReferencedSeriesUID;
   this->ReferencedFrameOfReferenceUID = src.ReferencedFrameOfReferenceUID;
   this->ContourIndexToSOPInstanceUIDMap = src.ContourIndexToSOPInstanceUIDMap;
+  this->NumberOfPoints = src.NumberOfPoints;
+  this->DeferredContourItem = src.DeferredContourItem;
+  this->ContourHash = src.ContourHash;
 }
 
 //----------------------------------------------------------------------------
@@ -444,6 +590,9 @@ vtkSlicerDicomRtReader::vtkInternal::RoiEntry& vtkSlicerDicomRtReader::vtkIntern
   this->ReferencedSeriesUID = src.ReferencedSeriesUID;
   this->ReferencedFrameOfReferenceUID = src.ReferencedFrameOfReferenceUID;
   this->ContourIndexToSOPInstanceUIDMap = src.ContourIndexToSOPInstanceUIDMap;
+  this->NumberOfPoints = src.NumberOfPoints;
+  this->DeferredContourItem = src.DeferredContourItem;
+  this->ContourHash = src.ContourHash;
 
   return (*this);
 }
@@ -574,12 +723,10 @@ vtkSlicerDicomRtReader::vtkInternal::ControlPointEntry::operator=(const ControlP
 //----------------------------------------------------------------------------
 vtkSlicerDicomRtReader::vtkInternal::BeamEntry* vtkSlicerDicomRtReader::vtkInternal::FindBeamByNumber(unsigned int beamNumber)
 {
-  for (unsigned int i=0; i<this->BeamSequenceVector.size(); i++)
+  std::unordered_map<unsigned int, size_t>::const_iterator beamIndexIt = this->BeamNumberToIndexMap.find(beamNumber);
+  if (beamIndexIt != this->BeamNumberToIndexMap.end())
   {
-    if (this->BeamSequenceVector[i].Number == beamNumber)
-    {
-      return &this->BeamSequenceVector[i];
-    }
+    return &this->BeamSequenceVector[beamIndexIt->second];
   }
 
   // Not found
@@ -590,12 +737,10 @@ vtkSlicerDicomRtReader::vtkInternal::BeamEntry* vtkSlicerDicomRtReader::vtkInter
 //----------------------------------------------------------------------------
 vtkSlicerDicomRtReader::vtkInternal::RoiEntry* vtkSlicerDicomRtReader::vtkInternal::FindRoiByNumber(unsigned int roiNumber)
 {
-  for (unsigned int i=0; i<this->RoiSequenceVector.size(); i++)
+  std::unordered_map<unsigned int, size_t>::const_iterator roiIndexIt = this->RoiNumberToIndexMap.find(roiNumber);
+  if (roiIndexIt != this->RoiNumberToIndexMap.end())
   {
-    if (this->RoiSequenceVector[i].Number == roiNumber)
-    {
-      return &this->RoiSequenceVector[i];
-    }
+    return &this->RoiSequenceVector[roiIndexIt->second];
   }
 
   // Not found
@@ -710,6 +855,38 @@ DRTContourImageSequence* vtkSlicerDicomRtReader::vtkInternal::GetReferencedFrame
   return &rtContourImageSequence;
 }
 
+//----------------------------------------------------------------------------
+void vtkSlicerDicomRtReader::vtkInternal::GetReferencedFrameOfReferenceContourToSliceInstanceUIDMap(
+  DRTStructureSetIOD* rtStructureSet, std::map<int, std::string>& contourToSliceInstanceUIDMap)
+{
+  contourToSliceInstanceUIDMap.clear();
+
+  DRTContourImageSequence* rtContourImageSequence = this->GetReferencedFrameOfReferenceContourImageSequence(rtStructureSet);
+  if (!rtContourImageSequence || !rtContourImageSequence->gotoFirstItem().good())
+  {
+    vtkErrorWithObjectMacro(this->External, "GetReferencedFrameOfReferenceContourToSliceInstanceUIDMap: No items in contour image sequence object item in referenced frame of reference sequence");
+    return;
+  }
+
+  int currentSliceNumber = -1; // Use negative keys to indicate that the slice instances cannot be directly mapped to the ROI planar contours
+  do
+  {
+    DRTContourImageSequence::Item &rtContourImageSequenceItem = rtContourImageSequence->getCurrentItem();
+    if (rtContourImageSequenceItem.isValid())
+    {
+      OFString referencedSOPInstanceUID("");
+      rtContourImageSequenceItem.getReferencedSOPInstanceUID(referencedSOPInstanceUID);
+      contourToSliceInstanceUIDMap[currentSliceNumber] = referencedSOPInstanceUID.c_str();
+    }
+    else
+    {
+      vtkErrorWithObjectMacro(this->External, "GetReferencedFrameOfReferenceContourToSliceInstanceUIDMap: Contour image sequence object item in referenced frame of reference sequence is invalid");
+    }
+    currentSliceNumber--;
+  }
+  while (rtContourImageSequence->gotoNextItem().good());
+}
+
 //----------------------------------------------------------------------------
 void vtkSlicerDicomRtReader::vtkInternal::LoadRTDose(DcmDataset* dataset)
 {
@@ -759,6 +936,12 @@ void vtkSlicerDicomRtReader::vtkInternal::LoadRTDose(DcmDataset* dataset)
   this->External->SetPixelSpacing(pixelSpacingOFVector[1], pixelSpacingOFVector[0]);
   vtkDebugWithObjectMacro(this->External, "Pixel Spacing: (" << pixelSpacingOFVector[1] << ", " << pixelSpacingOFVector[0] << ")");
 
+  // Decode dose voxels. If not possible, then the importer falls back to reading the volume with the generic reader
+  if (!this->LoadRTDoseVoxels(rtDose, dataset, vtkVariant(doseGridScaling.c_str()).ToDouble()))
+  {
+    vtkDebugWithObjectMacro(this->External, "LoadRTDose: Dose voxels are not decoded, generic volume reader needs to be used");
+  }
+
   // Get referenced RTPlan instance UID
   DRTReferencedRTPlanSequence &referencedRTPlanSequence = rtDose.getReferencedRTPlanSequence();
   if (referencedRTPlanSequence.gotoFirstItem().good())
@@ -789,6 +972,156 @@ void vtkSlicerDicomRtReader::vtkInternal::LoadRTDose(DcmDataset* dataset)
   this->External->LoadRTDoseSuccessful = true;
 }
 
+//----------------------------------------------------------------------------
+bool vtkSlicerDicomRtReader::vtkInternal::LoadRTDoseVoxels(DRTDoseIOD& rtDose, DcmDataset* dataset, double doseGridScaling)
+{
+  this->DoseImageData = nullptr;
+  this->DoseIJKToRASMatrix = nullptr;
+
+  // Only native pixel data can be read frame by frame
+  if (DcmXfer(dataset->getOriginalXfer()).isEncapsulated())
+  {
+    return false;
+  }
+
+  Uint16 rows = 0;
+  Uint16 columns = 0;
+  Uint16 samplesPerPixel = 0;
+  Uint16 bitsAllocated = 0;
+  Uint16 pixelRepresentation = 0;
+  if ( rtDose.getRows(rows).bad() || rtDose.getColumns(columns).bad() || rtDose.getSamplesPerPixel(samplesPerPixel).bad()
+    || rtDose.getBitsAllocated(bitsAllocated).bad() || rtDose.getPixelRepresentation(pixelRepresentation).bad() )
+  {
+    vtkErrorWithObjectMacro(this->External, "LoadRTDoseVoxels: Failed to get image pixel description for dose object");
+    return false;
+  }
+  if (rows == 0 || columns == 0 || samplesPerPixel != 1 || (bitsAllocated != 16 && bitsAllocated != 32))
+  {
+    vtkWarningWithObjectMacro(this->External, "LoadRTDoseVoxels: Unsupported dose pixel format (" << columns << "x" << rows
+      << ", " << samplesPerPixel << " samples per pixel, " << bitsAllocated << " bits allocated)");
+    return false;
+  }
+  Sint32 numberOfFrames = 1;
+  if (rtDose.getNumberOfFrames(numberOfFrames).bad() || numberOfFrames < 1)
+  {
+    numberOfFrames = 1;
+  }
+
+  // Geometry
+  OFVector<vtkTypeFloat64> imagePositionPatient;
+  OFVector<vtkTypeFloat64> imageOrientationPatient;
+  if ( rtDose.getImagePositionPatient(imagePositionPatient).bad() || imagePositionPatient.size() < 3
+    || rtDose.getImageOrientationPatient(imageOrientationPatient).bad() || imageOrientationPatient.size() < 6 )
+  {
+    vtkErrorWithObjectMacro(this->External, "LoadRTDoseVoxels: Failed to get image position and orientation for dose object");
+    return false;
+  }
+  // Grid frame offsets are along the slice normal, either relative to the first frame (starting with zero)
+  // or as absolute coordinates. Only the differences are used, which is the same in both cases.
+  double sliceSpacing = 1.0;
+  if (numberOfFrames > 1)
+  {
+    OFVector<vtkTypeFloat64> gridFrameOffsetVector;
+    if (rtDose.getGridFrameOffsetVector(gridFrameOffsetVector).bad() || gridFrameOffsetVector.size() < static_cast<size_t>(numberOfFrames))
+    {
+      vtkErrorWithObjectMacro(this->External, "LoadRTDoseVoxels: Failed to get grid frame offset vector for multi-frame dose object");
+      return false;
+    }
+    sliceSpacing = gridFrameOffsetVector[1] - gridFrameOffsetVector[0];
+    if (sliceSpacing == 0.0)
+    {
+      vtkErrorWithObjectMacro(this->External, "LoadRTDoseVoxels: Invalid grid frame offset vector for dose object");
+      return false;
+    }
+    for (Sint32 frame = 2; frame < numberOfFrames; ++frame)
+    {
+      double currentSpacing = gridFrameOffsetVector[frame] - gridFrameOffsetVector[frame-1];
+      if (!vtkSlicerRtCommon::AreEqualWithTolerance(currentSpacing, sliceSpacing))
+      {
+        vtkWarningWithObjectMacro(this->External, "LoadRTDoseVoxels: Non-uniform grid frame offsets in dose object, using the first frame spacing " << sliceSpacing);
+        break;
+      }
+    }
+  }
+
+  double rowDirection[3] = { imageOrientationPatient[0], imageOrientationPatient[1], imageOrientationPatient[2] };
+  double columnDirection[3] = { imageOrientationPatient[3], imageOrientationPatient[4], imageOrientationPatient[5] };
+  double sliceNormal[3] = { 0.0, 0.0, 0.0 };
+  vtkMath::Cross(rowDirection, columnDirection, sliceNormal);
+  double* pixelSpacing = this->External->GetPixelSpacing();
+
+  vtkSmartPointer<vtkMatrix4x4> ijkToRasMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+  for (int row = 0; row < 3; ++row)
+  {
+    // DICOM patient coordinate system is LPS, convert to RAS
+    double lpsToRas = (row < 2 ? -1.0 : 1.0);
+    ijkToRasMatrix->SetElement(row, 0, lpsToRas * rowDirection[row] * pixelSpacing[0]);
+    ijkToRasMatrix->SetElement(row, 1, lpsToRas * columnDirection[row] * pixelSpacing[1]);
+    ijkToRasMatrix->SetElement(row, 2, lpsToRas * sliceNormal[row] * sliceSpacing);
+    ijkToRasMatrix->SetElement(row, 3, lpsToRas * imagePositionPatient[row]);
+  }
+
+  // Voxels
+  DcmElement* pixelDataElement = nullptr;
+  if (dataset->findAndGetElement(DCM_PixelData, pixelDataElement).bad() || !pixelDataElement)
+  {
+    vtkErrorWithObjectMacro(this->External, "LoadRTDoseVoxels: Failed to get pixel data for dose object");
+    return false;
+  }
+  const vtkIdType numberOfVoxelsPerFrame = static_cast<vtkIdType>(rows) * columns;
+  const Uint32 bytesPerFrame = static_cast<Uint32>(numberOfVoxelsPerFrame * (bitsAllocated / 8));
+  if (static_cast<double>(pixelDataElement->getLength()) < static_cast<double>(bytesPerFrame) * numberOfFrames)
+  {
+    vtkErrorWithObjectMacro(this->External, "LoadRTDoseVoxels: Pixel data of dose object is shorter than expected");
+    return false;
+  }
+
+  vtkSmartPointer<vtkImageData> doseImageData = vtkSmartPointer<vtkImageData>::New();
+  doseImageData->SetDimensions(columns, rows, numberOfFrames);
+  doseImageData->AllocateScalars(VTK_FLOAT, 1);
+  float* doseVoxels = static_cast<float*>(doseImageData->GetScalarPointer());
+
+  // Pixel data that was not loaded when parsing the file is read from the file frame by frame.
+  // The file cache keeps the file open between frames. Values are returned in local byte order.
+  std::vector<Uint8> frameBuffer(bytesPerFrame);
+  DcmFileCache fileCache;
+  for (Sint32 frame = 0; frame < numberOfFrames; ++frame)
+  {
+    if (pixelDataElement->getPartialValue(frameBuffer.data(), static_cast<Uint32>(frame) * bytesPerFrame, bytesPerFrame, &fileCache).bad())
+    {
+      vtkErrorWithObjectMacro(this->External, "LoadRTDoseVoxels: Failed to read frame " << frame << " of dose object");
+      return false;
+    }
+    float* frameDoseVoxels = doseVoxels + frame * numberOfVoxelsPerFrame;
+    if (bitsAllocated == 16)
+    {
+      if (pixelRepresentation)
+      {
+        ScaleDoseFrame<Sint16>(frameBuffer.data(), numberOfVoxelsPerFrame, doseGridScaling, frameDoseVoxels);
+      }
+      else
+      {
+        ScaleDoseFrame<Uint16>(frameBuffer.data(), numberOfVoxelsPerFrame, doseGridScaling, frameDoseVoxels);
+      }
+    }
+    else
+    {
+      if (pixelRepresentation)
+      {
+        ScaleDoseFrame<Sint32>(frameBuffer.data(), numberOfVoxelsPerFrame, doseGridScaling, frameDoseVoxels);
+      }
+      else
+      {
+        ScaleDoseFrame<Uint32>(frameBuffer.data(), numberOfVoxelsPerFrame, doseGridScaling, frameDoseVoxels);
+      }
+    }
+  }
+
+  this->DoseImageData = doseImageData;
+  this->DoseIJKToRASMatrix = ijkToRasMatrix;
+  return true;
+}
+
 //----------------------------------------------------------------------------
 void vtkSlicerDicomRtReader::vtkInternal::LoadRTPlan(DcmDataset* dataset)
 {
@@ -1203,6 +1536,7 @@ void vtkSlicerDicomRtReader::vtkInternal::LoadRTPlan(DcmDataset* dataset)
         vtkErrorWithObjectMacro( this->External, "LoadRTPlan: Number of control points expected ("
           << beamNumberOfControlPoints << ") and found (" << controlPointCount << ") do not match. Invalid points remain among control points");
       }
+      this->BeamNumberToIndexMap.emplace(beamEntry.Number, this->BeamSequenceVector.size());
       this->BeamSequenceVector.push_back(beamEntry);
     }
     while (rtPlanBeamSequence.gotoNextItem().good());
@@ -1848,6 +2182,7 @@ void vtkSlicerDicomRtReader::vtkInternal::LoadRTIonPlan(DcmDataset* dataset)
         vtkErrorWithObjectMacro( this->External, "LoadRTIonPlan: Number of control points expected ("
           << beamNumberOfControlPoints << ") and found (" << controlPointCount << ") do not match. Invalid points remain among control points");
       }
+      this->BeamNumberToIndexMap.emplace(beamEntry.Number, this->BeamSequenceVector.size());
       this->BeamSequenceVector.push_back(beamEntry);
     }
     while (ionBeamSequence.gotoNextItem().good());
@@ -1944,19 +2279,145 @@ void vtkSlicerDicomRtReader::vtkInternal::LoadRTStructureSet(DcmDataset* dataset
     return;
   }
 
-  // Read ROIs, iterate over ROI contour sequence
-  do 
+  // Collect ROI contour items and the corresponding ROI entries.
+  // DCMTK sequences are traversed using a cursor, so this is done serially
+  std::vector<DRTROIContourSequence::Item*> roiContourItems;
+  std::vector<RoiEntry*> roiEntries;
+  do
   {
     DRTROIContourSequence::Item &currentRoi = rtROIContourSequence.getCurrentItem();
-    RoiEntry* currentRoiEntry = this->LoadContour(currentRoi, rtStructureSet);
-    if (currentRoiEntry)
+    if (!currentRoi.isValid())
+    {
+      continue;
+    }
+    Sint32 referencedRoiNumber = -1;
+    currentRoi.getReferencedROINumber(referencedRoiNumber);
+    RoiEntry* roiEntry = this->FindRoiByNumber(referencedRoiNumber);
+    if (roiEntry == nullptr)
     {
-      // Set referenced series UID
-      currentRoiEntry->ReferencedSeriesUID = (std::string)referencedSeriesInstanceUID.c_str();
+      vtkErrorWithObjectMacro(this->External, "LoadRTStructureSet: ROI with number " << referencedRoiNumber << " is not found");
+      continue;
     }
+    // If multiple contour items reference the same ROI then the last one is loaded
+    std::vector<RoiEntry*>::iterator existingEntryIt = std::find(roiEntries.begin(), roiEntries.end(), roiEntry);
+    if (existingEntryIt != roiEntries.end())
+    {
+      roiContourItems.erase(roiContourItems.begin() + (existingEntryIt - roiEntries.begin()));
+      roiEntries.erase(existingEntryIt);
+    }
+    roiContourItems.push_back(&currentRoi);
+    roiEntries.push_back(roiEntry);
   }
   while (rtROIContourSequence.gotoNextItem().good());
 
+  // If loading the contours is deferred, then only count the points. Point ROIs are loaded anyway,
+  // as they are loaded as fiducials, and the number of contours also needs to be known for that
+  vtkIdType numberOfRois = static_cast<vtkIdType>(roiContourItems.size());
+  std::vector<char> roiContoursDeferred(numberOfRois, 0);
+  bool roiContoursDeferredAny = false;
+  if (this->External->DeferRoiContourLoading)
+  {
+    for (vtkIdType roiIndex = 0; roiIndex < numberOfRois; ++roiIndex)
+    {
+      RoiEntry* roiEntry = roiEntries[roiIndex];
+      roiEntry->NumberOfPoints = GetNumberOfContourPoints(*roiContourItems[roiIndex]);
+      if (roiEntry->NumberOfPoints > 1)
+      {
+        LoadRoiDisplayColor(*roiContourItems[roiIndex], roiEntry);
+        roiEntry->DeferredContourItem = roiContourItems[roiIndex];
+        roiContoursDeferred[roiIndex] = 1;
+        roiContoursDeferredAny = true;
+      }
+    }
+  }
+
+  // Decode contours of the ROIs in parallel
+  std::vector<std::set<std::string> > roiReferencedSopInstanceUids(numberOfRois);
+  std::vector<char> roiContoursLoaded(numberOfRois, 0);
+  std::vector<RoiLoadMessages> roiLoadMessages(numberOfRois);
+  vtkSMPTools::For(0, numberOfRois, 1, [&](vtkIdType beginRoiIndex, vtkIdType endRoiIndex)
+  {
+    for (vtkIdType roiIndex = beginRoiIndex; roiIndex < endRoiIndex; ++roiIndex)
+    {
+      if (roiContoursDeferred[roiIndex])
+      {
+        continue;
+      }
+      roiContoursLoaded[roiIndex] = this->LoadContour(
+        *roiContourItems[roiIndex], roiEntries[roiIndex], roiReferencedSopInstanceUids[roiIndex], roiLoadMessages[roiIndex]);
+    }
+  });
+  for (const RoiLoadMessages& messages : roiLoadMessages)
+  {
+    this->LogRoiLoadMessages(messages);
+  }
+
+  // Set referenced series and slice instances in ROI order
+  std::map<int, std::string> frameOfReferenceContourToSliceInstanceUIDMap;
+  bool frameOfReferenceContourImagesRead = false;
+  vtkIdType lastLoadedRoiIndex = -1;
+  for (vtkIdType roiIndex = 0; roiIndex < numberOfRois; ++roiIndex)
+  {
+    RoiEntry* roiEntry = roiEntries[roiIndex];
+    roiEntry->ReferencedSeriesUID = (std::string)referencedSeriesInstanceUID.c_str();
+    if (!roiContoursLoaded[roiIndex])
+    {
+      continue;
+    }
+    lastLoadedRoiIndex = roiIndex;
+
+    // Read slice reference UIDs from referenced frame of reference sequence if it was not included in the ROIContourSequence
+    if (roiEntry->ContourIndexToSOPInstanceUIDMap.empty())
+    {
+      if (!frameOfReferenceContourImagesRead)
+      {
+        this->GetReferencedFrameOfReferenceContourToSliceInstanceUIDMap(rtStructureSet, frameOfReferenceContourToSliceInstanceUIDMap);
+        frameOfReferenceContourImagesRead = true;
+      }
+      roiEntry->ContourIndexToSOPInstanceUIDMap = frameOfReferenceContourToSliceInstanceUIDMap;
+      for (std::map<int, std::string>::iterator sliceIt = frameOfReferenceContourToSliceInstanceUIDMap.begin();
+        sliceIt != frameOfReferenceContourToSliceInstanceUIDMap.end(); ++sliceIt)
+      {
+        roiReferencedSopInstanceUids[roiIndex].insert(sliceIt->second);
+      }
+    }
+  }
+
+  // Get referenced SOP instance UIDs. If loading the contours is deferred, then the contour image references of the
+  // referenced frame of reference are used, as they are available without reading the contours of the ROIs
+  std::set<std::string> structureSetReferencedSopInstanceUids;
+  if (roiContoursDeferredAny)
+  {
+    if (!frameOfReferenceContourImagesRead)
+    {
+      this->GetReferencedFrameOfReferenceContourToSliceInstanceUIDMap(rtStructureSet, frameOfReferenceContourToSliceInstanceUIDMap);
+    }
+    for (std::map<int, std::string>::iterator sliceIt = frameOfReferenceContourToSliceInstanceUIDMap.begin();
+      sliceIt != frameOfReferenceContourToSliceInstanceUIDMap.end(); ++sliceIt)
+    {
+      structureSetReferencedSopInstanceUids.insert(sliceIt->second);
+    }
+  }
+  else if (lastLoadedRoiIndex >= 0)
+  {
+    structureSetReferencedSopInstanceUids = roiReferencedSopInstanceUids[lastLoadedRoiIndex];
+  }
+
+  // Serialize referenced SOP instance UID set
+  if (roiContoursDeferredAny || lastLoadedRoiIndex >= 0)
+  {
+    std::set<std::string>::iterator uidIt;
+    std::string serializedUidList("");
+    for (uidIt = structureSetReferencedSopInstanceUids.begin(); uidIt != structureSetReferencedSopInstanceUids.end(); ++uidIt)
+    {
+      serializedUidList.append(*uidIt);
+      serializedUidList.append(" ");
+    }
+    // Strip last space
+    serializedUidList = serializedUidList.substr(0, serializedUidList.size()-1);
+    this->External->SetRTStructureSetReferencedSOPInstanceUIDs(serializedUidList.c_str());
+  }
+
   // Get SOP instance UID
   OFString sopInstanceUid("");
   if (rtStructureSet->getSOPInstanceUID(sopInstanceUid).bad())
@@ -1967,11 +2428,26 @@ void vtkSlicerDicomRtReader::vtkInternal::LoadRTStructureSet(DcmDataset* dataset
   }
   this->External->SetSOPInstanceUID(sopInstanceUid.c_str());
 
+  // Get structure set label
+  OFString structureSetLabel("");
+  rtStructureSet->getStructureSetLabel(structureSetLabel);
+  this->External->SetRTStructureSetLabel(structureSetLabel.c_str());
+
   // Get and store patient, study and series information
   this->External->GetAndStoreRtHierarchyInformation(rtStructureSet);
 
   this->External->LoadRTStructureSetSuccessful = true;
-  delete rtStructureSet;
+
+  // Keep structure set if contours are to be loaded later
+  if (roiContoursDeferredAny)
+  {
+    delete this->DeferredStructureSet;
+    this->DeferredStructureSet = rtStructureSet;
+  }
+  else
+  {
+    delete rtStructureSet;
+  }
 }
 
 //----------------------------------------------------------------------------
@@ -2009,49 +2485,115 @@ void vtkSlicerDicomRtReader::vtkInternal::LoadContoursFromRoiSequence(DRTStructu
     roiEntry.Number=roiNumber;
 
     // Save to vector          
+    this->RoiNumberToIndexMap.emplace(roiEntry.Number, this->RoiSequenceVector.size());
     this->RoiSequenceVector.push_back(roiEntry);
   }
   while (rtStructureSetROISequence->gotoNextItem().good());
 }
 
 //----------------------------------------------------------------------------
-vtkSlicerDicomRtReader::vtkInternal::RoiEntry* vtkSlicerDicomRtReader::vtkInternal::LoadContour(
-  DRTROIContourSequence::Item &roi, DRTStructureSetIOD* rtStructureSet)
+vtkIdType vtkSlicerDicomRtReader::vtkInternal::GetNumberOfContourPoints(DRTROIContourSequence::Item &roi, vtkIdType* numberOfContours/*=nullptr*/)
 {
-  if (!roi.isValid())
+  vtkIdType totalNumberOfPoints = 0;
+  vtkIdType totalNumberOfContours = 0;
+  DRTContourSequence &rtContourSequence = roi.getContourSequence();
+  if (rtContourSequence.gotoFirstItem().good())
   {
-    return nullptr;
+    do
+    {
+      DRTContourSequence::Item &contourItem = rtContourSequence.getCurrentItem();
+      Sint32 numberOfPoints = 0;
+      if (contourItem.isValid() && contourItem.getNumberOfContourPoints(numberOfPoints).good() && numberOfPoints > 0)
+      {
+        totalNumberOfPoints += numberOfPoints;
+        totalNumberOfContours++;
+      }
+    }
+    while (rtContourSequence.gotoNextItem().good());
   }
 
-  // Used for connection from one planar contour ROI to the corresponding anatomical volume slice instance
-  std::map<int, std::string> contourToSliceInstanceUIDMap;
-  std::set<std::string> referencedSopInstanceUids;
+  if (numberOfContours)
+  {
+    *numberOfContours = totalNumberOfContours;
+  }
+  return totalNumberOfPoints;
+}
 
-  // Get ROI entry created for the referenced ROI
-  Sint32 referencedRoiNumber = -1;
-  roi.getReferencedROINumber(referencedRoiNumber);
-  RoiEntry* roiEntry = this->FindRoiByNumber(referencedRoiNumber);
-  if (roiEntry == nullptr)
+//----------------------------------------------------------------------------
+void vtkSlicerDicomRtReader::vtkInternal::LoadRoiDisplayColor(DRTROIContourSequence::Item &roi, RoiEntry* roiEntry)
+{
+  Sint32 roiDisplayColor = -1;
+  for (int j=0; j<3; j++)
   {
-    vtkErrorWithObjectMacro(this->External, "LoadContour: ROI with number " << referencedRoiNumber << " is not found");      
-    return nullptr;
-  } 
+    roi.getROIDisplayColor(roiDisplayColor,j);
+    roiEntry->DisplayColor[j] = roiDisplayColor/255.0;
+  }
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerDicomRtReader::vtkInternal::LogRoiLoadMessages(const RoiLoadMessages& messages)
+{
+  for (const std::string& error : messages.Errors)
+  {
+    vtkErrorWithObjectMacro(this->External, << error);
+  }
+  for (const std::string& warning : messages.Warnings)
+  {
+    vtkWarningWithObjectMacro(this->External, << warning);
+  }
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerDicomRtReader::vtkInternal::LoadContour(
+  DRTROIContourSequence::Item &roi, RoiEntry* roiEntry, std::set<std::string>& referencedSopInstanceUids,
+  RoiLoadMessages& messages)
+{
+  if (!roi.isValid() || roiEntry == nullptr)
+  {
+    return false;
+  }
+
+  // Used for connection from one planar contour ROI to the corresponding anatomical volume slice instance
+  std::map<int, std::string> contourToSliceInstanceUIDMap;
 
   // Get contour sequence
   DRTContourSequence &rtContourSequence = roi.getContourSequence();
   if (!rtContourSequence.gotoFirstItem().good())
   {
-    vtkErrorWithObjectMacro(this->External, "LoadContour: Contour sequence for ROI named '"
-      << roiEntry->Name << "' with number " << referencedRoiNumber << " is empty");
-    return roiEntry;
+    std::stringstream ss;
+    ss << "LoadContour: Contour sequence for ROI named '" << roiEntry->Name << "' with number " << roiEntry->Number << " is empty";
+    messages.Errors.push_back(ss.str());
+    return false;
   }
 
-  // Create containers for contour poly data
-  vtkSmartPointer<vtkPoints> currentRoiContourPoints = vtkSmartPointer<vtkPoints>::New();
-  vtkSmartPointer<vtkCellArray> currentRoiContourCells = vtkSmartPointer<vtkCellArray>::New();
+  // Count contours and points so that the poly data arrays can be allocated at once
+  vtkIdType totalNumberOfContours = 0;
+  vtkIdType totalNumberOfPoints = GetNumberOfContourPoints(roi, &totalNumberOfContours);
+  rtContourSequence.gotoFirstItem();
+
+  // Create containers for contour poly data. Each contour is a closed polyline, so its cell contains
+  // the first point again at the end
+  vtkSmartPointer<vtkFloatArray> currentRoiContourPointsArray = vtkSmartPointer<vtkFloatArray>::New();
+  currentRoiContourPointsArray->SetNumberOfComponents(3);
+  currentRoiContourPointsArray->SetNumberOfTuples(totalNumberOfPoints);
+  float* pointsPtr = currentRoiContourPointsArray->GetPointer(0);
+  vtkSmartPointer<vtkIdTypeArray> currentRoiContourOffsets = vtkSmartPointer<vtkIdTypeArray>::New();
+  currentRoiContourOffsets->SetNumberOfValues(totalNumberOfContours + 1);
+  vtkIdType* offsetsPtr = currentRoiContourOffsets->GetPointer(0);
+  vtkSmartPointer<vtkIdTypeArray> currentRoiContourConnectivity = vtkSmartPointer<vtkIdTypeArray>::New();
+  currentRoiContourConnectivity->SetNumberOfValues(totalNumberOfPoints + totalNumberOfContours);
+  vtkIdType* connectivityPtr = currentRoiContourConnectivity->GetPointer(0);
   vtkIdType pointId = 0;
+  vtkIdType contourIndex = 0;
+  vtkIdType connectivityIndex = 0;
+  offsetsPtr[0] = 0;
+
+  // Hash of the contours, computed from the values as they are read
+  uint64_t contourHash = CONTOUR_HASH_OFFSET_BASIS;
 
   // Read contour data, iterate over contour sequence
+  OFVector<vtkTypeFloat64> contourData_LPS;
+  OFString contourGeometricType;
   do
   {
     // Get contour
@@ -2062,35 +2604,49 @@ vtkSlicerDicomRtReader::vtkInternal::RoiEntry* vtkSlicerDicomRtReader::vtkIntern
     }
 
     // Get number of contour points
-    OFString numberOfPointsString("");
-    contourItem.getNumberOfContourPoints(numberOfPointsString);
-    std::stringstream ss;
-    ss << numberOfPointsString;
-    int numberOfPoints;
-    ss >> numberOfPoints;
+    Sint32 numberOfPoints = 0;
+    contourItem.getNumberOfContourPoints(numberOfPoints);
 
     // Get contour point data
-    OFVector<vtkTypeFloat64> contourData_LPS;
+    contourData_LPS.clear();
     contourItem.getContourData(contourData_LPS);
-    if (contourData_LPS.size() != size_t(numberOfPoints * 3))
+    if (numberOfPoints <= 0 || contourData_LPS.size() != size_t(numberOfPoints) * 3)
     {
-      vtkErrorWithObjectMacro(this->External, "LoadContour: Contour sequence object item is invalid: "
+      std::stringstream ss;
+      ss << "LoadContour: Contour sequence object item is invalid: "
         << " number of contour points is " << numberOfPoints << " therefore expected "
-        << numberOfPoints * 3 << " values in contour data but only found " << contourData_LPS.size());
+        << numberOfPoints * 3 << " values in contour data but only found " << contourData_LPS.size();
+      messages.Errors.push_back(ss.str());
       continue;
     }
 
-    unsigned int contourIndex = currentRoiContourCells->InsertNextCell(numberOfPoints+1);
-    for (int k=0; k<numberOfPoints; k++)
+    // Add contour to the hash
+    contourGeometricType.clear();
+    contourItem.getContourGeometricType(contourGeometricType);
+    AddToContourHash(contourHash, contourGeometricType.c_str(), contourGeometricType.length() + 1);
+    AddToContourHash(contourHash, &numberOfPoints, sizeof(numberOfPoints));
+    AddToContourHash(contourHash, &contourData_LPS[0], contourData_LPS.size() * sizeof(vtkTypeFloat64));
+
+    // Convert from DICOM LPS -> Slicer RAS
+    const vtkTypeFloat64* contourDataPtr = &contourData_LPS[0];
+    float* contourPointsPtr = pointsPtr + 3 * pointId;
+    for (Sint32 k=0; k<numberOfPoints; ++k)
     {
-      // Convert from DICOM LPS -> Slicer RAS
-      currentRoiContourPoints->InsertPoint(pointId, -contourData_LPS[3*k], -contourData_LPS[3*k+1], contourData_LPS[3*k+2]);
-      currentRoiContourCells->InsertCellPoint(pointId);
-      pointId++;
+      contourPointsPtr[3*k]   = static_cast<float>(-contourDataPtr[3*k]);
+      contourPointsPtr[3*k+1] = static_cast<float>(-contourDataPtr[3*k+1]);
+      contourPointsPtr[3*k+2] = static_cast<float>(contourDataPtr[3*k+2]);
     }
 
-    // Close the contour
-    currentRoiContourCells->InsertCellPoint(pointId-numberOfPoints);
+    // Add cell, and close the contour
+    vtkIdType* contourConnectivityPtr = connectivityPtr + connectivityIndex;
+    for (Sint32 k=0; k<numberOfPoints; ++k)
+    {
+      contourConnectivityPtr[k] = pointId + k;
+    }
+    contourConnectivityPtr[numberOfPoints] = pointId;
+    connectivityIndex += numberOfPoints + 1;
+    offsetsPtr[contourIndex + 1] = connectivityIndex;
+    pointId += numberOfPoints;
 
     // Add map to the referenced slice instance UID
     // This is not a mandatory field so no error logged if not found. The reason why
@@ -2109,47 +2665,41 @@ vtkSlicerDicomRtReader::vtkInternal::RoiEntry* vtkSlicerDicomRtReader::vtkIntern
         // Check if multiple SOP instance UIDs are referenced
         if (rtContourImageSequence.getNumberOfItems() > 1)
         {
-          vtkWarningWithObjectMacro(this->External, "LoadContour: Contour in ROI " << roiEntry->Number << ": " << roiEntry->Name << " contains multiple referenced instances. This is not yet supported");
+          std::stringstream ss;
+          ss << "LoadContour: Contour in ROI " << roiEntry->Number << ": " << roiEntry->Name << " contains multiple referenced instances. This is not yet supported";
+          messages.Warnings.push_back(ss.str());
         }
       }
       else
       {
-        vtkErrorWithObjectMacro(this->External, "LoadContour: Contour image sequence object item is invalid");
+        messages.Errors.push_back("LoadContour: Contour image sequence object item is invalid");
       }
     }
+
+    contourIndex++;
   }
   while (rtContourSequence.gotoNextItem().good());
 
-  // Read slice reference UIDs from referenced frame of reference sequence if it was not included in the ROIContourSequence above
-  if (contourToSliceInstanceUIDMap.empty())
+  // Shrink arrays if invalid contours were skipped
+  currentRoiContourPointsArray->SetNumberOfTuples(pointId);
+  currentRoiContourOffsets->SetNumberOfValues(contourIndex + 1);
+  currentRoiContourConnectivity->SetNumberOfValues(connectivityIndex);
+
+  vtkSmartPointer<vtkPoints> currentRoiContourPoints = vtkSmartPointer<vtkPoints>::New();
+  currentRoiContourPoints->SetData(currentRoiContourPointsArray);
+  vtkSmartPointer<vtkCellArray> currentRoiContourCells = vtkSmartPointer<vtkCellArray>::New();
+#if VTK_MAJOR_VERSION >= 9
+  currentRoiContourCells->SetData(currentRoiContourOffsets, currentRoiContourConnectivity);
+#else
+  // Legacy cell arrays store the cell sizes inline, so the cells are inserted one by one
+  currentRoiContourCells->Allocate(connectivityIndex + contourIndex);
+  offsetsPtr = currentRoiContourOffsets->GetPointer(0);
+  connectivityPtr = currentRoiContourConnectivity->GetPointer(0);
+  for (vtkIdType cellIndex = 0; cellIndex < contourIndex; ++cellIndex)
   {
-    DRTContourImageSequence* rtContourImageSequence = this->GetReferencedFrameOfReferenceContourImageSequence(rtStructureSet);
-    if (rtContourImageSequence && rtContourImageSequence->gotoFirstItem().good())
-    {
-      int currentSliceNumber = -1; // Use negative keys to indicate that the slice instances cannot be directly mapped to the ROI planar contours
-      do 
-      {
-        DRTContourImageSequence::Item &rtContourImageSequenceItem = rtContourImageSequence->getCurrentItem();
-        if (rtContourImageSequenceItem.isValid())
-        {
-          OFString referencedSOPInstanceUID("");
-          rtContourImageSequenceItem.getReferencedSOPInstanceUID(referencedSOPInstanceUID);
-          contourToSliceInstanceUIDMap[currentSliceNumber] = referencedSOPInstanceUID.c_str();
-          referencedSopInstanceUids.insert(referencedSOPInstanceUID.c_str());
-        }
-        else
-        {
-          vtkErrorWithObjectMacro(this->External, "LoadContour: Contour image sequence object item in referenced frame of reference sequence is invalid");
-        }
-        currentSliceNumber--;
-      }
-      while (rtContourImageSequence->gotoNextItem().good());
-    }
-    else
-    {
-      vtkErrorWithObjectMacro(this->External, "LoadContour: No items in contour image sequence object item in referenced frame of reference sequence");
-    }
+    currentRoiContourCells->InsertNextCell(offsetsPtr[cellIndex + 1] - offsetsPtr[cellIndex], connectivityPtr + offsetsPtr[cellIndex]);
   }
+#endif
 
   // Save just loaded contour data into ROI entry
   vtkSmartPointer<vtkPolyData> currentRoiPolyData = vtkSmartPointer<vtkPolyData>::New();
@@ -2166,30 +2716,19 @@ vtkSlicerDicomRtReader::vtkInternal::RoiEntry* vtkSlicerDicomRtReader::vtkIntern
   }
   roiEntry->SetPolyData(currentRoiPolyData);
 
+  roiEntry->NumberOfPoints = pointId;
+
+  std::stringstream contourHashStream;
+  contourHashStream << std::hex << std::setw(16) << std::setfill('0') << contourHash;
+  roiEntry->ContourHash = contourHashStream.str();
+
   // Get structure color
-  Sint32 roiDisplayColor = -1;
-  for (int j=0; j<3; j++)
-  {
-    roi.getROIDisplayColor(roiDisplayColor,j);
-    roiEntry->DisplayColor[j] = roiDisplayColor/255.0;
-  }
+  LoadRoiDisplayColor(roi, roiEntry);
 
   // Set referenced SOP instance UIDs
   roiEntry->ContourIndexToSOPInstanceUIDMap = contourToSliceInstanceUIDMap;
 
-  // Serialize referenced SOP instance UID set
-  std::set<std::string>::iterator uidIt;
-  std::string serializedUidList("");
-  for (uidIt = referencedSopInstanceUids.begin(); uidIt != referencedSopInstanceUids.end(); ++uidIt)
-  {
-    serializedUidList.append(*uidIt);
-    serializedUidList.append(" ");
-  }
-  // Strip last space
-  serializedUidList = serializedUidList.substr(0, serializedUidList.size()-1);
-  this->External->SetRTStructureSetReferencedSOPInstanceUIDs(serializedUidList.c_str());
-
-  return roiEntry;
+  return true;
 }
 
 //----------------------------------------------------------------------------
@@ -2312,7 +2851,8 @@ void vtkSlicerDicomRtReader::vtkInternal::LoadRTImage(DcmDataset* dataset)
   {
     if (imagePlanePixelSpacing.size() == 2)
     {
-      //this->SetImagePlanePixelSpacing(imagePlanePixelSpacing[0], imagePlanePixelSpacing[1]);
+      // Spacing is stored as row spacing (Y) then column spacing (X)
+      this->External->SetImagePlanePixelSpacing(imagePlanePixelSpacing[1], imagePlanePixelSpacing[0]);
     }
     else
     {
@@ -2320,6 +2860,29 @@ void vtkSlicerDicomRtReader::vtkInternal::LoadRTImage(DcmDataset* dataset)
     }
   }
 
+  // Rows and Columns
+  Uint16 rows = 0;
+  Uint16 columns = 0;
+  if (rtImage.getRows(rows).bad() || rtImage.getColumns(columns).bad())
+  {
+    vtkErrorWithObjectMacro(this->External, "LoadRTImage: Failed to get Rows and Columns for RT Image object");
+    return; // mandatory DICOM value
+  }
+  this->External->SetRTImageDimensions(columns, rows);
+
+  // NumberOfFrames
+  this->RTImageFramesImageData = nullptr;
+  Sint32 numberOfFrames = 1;
+  if (rtImage.getNumberOfFrames(numberOfFrames).bad() || numberOfFrames < 1)
+  {
+    numberOfFrames = 1;
+  }
+  this->External->SetRTImageNumberOfFrames(numberOfFrames);
+  if (numberOfFrames > 1 && !this->LoadRTImageFrames(rtImage, dataset, numberOfFrames))
+  {
+    vtkWarningWithObjectMacro(this->External, "LoadRTImage: Failed to decode frames of multi-frame RT image, it needs to be read as a volume");
+  }
+
   // RTImagePosition
   OFVector<vtkTypeFloat64> rtImagePosition;
   if (rtImage.getRTImagePosition(rtImagePosition).good())
@@ -2433,6 +2996,137 @@ void vtkSlicerDicomRtReader::vtkInternal::LoadRTImage(DcmDataset* dataset)
   this->External->LoadRTImageSuccessful = true;
 }
 
+//----------------------------------------------------------------------------
+bool vtkSlicerDicomRtReader::vtkInternal::LoadRTImageFrames(DRTImageIOD& rtImage, DcmDataset* dataset, Sint32 numberOfFrames)
+{
+  // Only native little endian pixel data can be read frame by frame. Other data is read by the generic reader
+  DcmXfer transferSyntax(dataset->getOriginalXfer());
+  if (transferSyntax.isEncapsulated() || transferSyntax.getByteOrder() != EBO_LittleEndian)
+  {
+    return false;
+  }
+
+  int* dimensions = this->External->GetRTImageDimensions();
+  Uint16 samplesPerPixel = 0;
+  Uint16 bitsAllocated = 0;
+  Uint16 bitsStored = 0;
+  Uint16 pixelRepresentation = 0;
+  if ( rtImage.getSamplesPerPixel(samplesPerPixel).bad() || rtImage.getBitsAllocated(bitsAllocated).bad()
+    || rtImage.getBitsStored(bitsStored).bad() || rtImage.getPixelRepresentation(pixelRepresentation).bad() )
+  {
+    vtkErrorWithObjectMacro(this->External, "LoadRTImageFrames: Failed to get image pixel description for RT image object");
+    return false;
+  }
+  // Stored values are used as they are, so unused high bits (that would need masking or sign extension) are not supported
+  if (dimensions[0] == 0 || dimensions[1] == 0 || samplesPerPixel != 1 || bitsStored != bitsAllocated
+    || (bitsAllocated != 8 && bitsAllocated != 16 && bitsAllocated != 32))
+  {
+    vtkWarningWithObjectMacro(this->External, "LoadRTImageFrames: Unsupported RT image pixel format (" << dimensions[0] << "x" << dimensions[1]
+      << ", " << samplesPerPixel << " samples per pixel, " << bitsAllocated << " bits allocated, " << bitsStored << " bits stored)");
+    return false;
+  }
+
+  // Stored values are kept unless they need to be rescaled
+  vtkTypeFloat64 rescaleSlope = 1.0;
+  vtkTypeFloat64 rescaleIntercept = 0.0;
+  if (rtImage.getRescaleSlope(rescaleSlope).bad())
+  {
+    rescaleSlope = 1.0;
+  }
+  if (rtImage.getRescaleIntercept(rescaleIntercept).bad())
+  {
+    rescaleIntercept = 0.0;
+  }
+  bool rescale = (rescaleSlope != 1.0 || rescaleIntercept != 0.0);
+  int scalarType = VTK_FLOAT;
+  if (!rescale)
+  {
+    switch (bitsAllocated)
+    {
+      case 8: scalarType = (pixelRepresentation ? VTK_SIGNED_CHAR : VTK_UNSIGNED_CHAR); break;
+      case 16: scalarType = (pixelRepresentation ? VTK_SHORT : VTK_UNSIGNED_SHORT); break;
+      default: scalarType = (pixelRepresentation ? VTK_INT : VTK_UNSIGNED_INT); break;
+    }
+  }
+
+  DcmElement* pixelDataElement = nullptr;
+  if (dataset->findAndGetElement(DCM_PixelData, pixelDataElement).bad() || !pixelDataElement)
+  {
+    vtkErrorWithObjectMacro(this->External, "LoadRTImageFrames: Failed to get pixel data for RT image object");
+    return false;
+  }
+  // Offsets are computed in 64 bits. As the whole pixel data fits in its 32-bit length, so do the frame offsets
+  const vtkIdType numberOfPixelsPerFrame = static_cast<vtkIdType>(dimensions[0]) * dimensions[1];
+  const Uint64 bytesPerFrame = static_cast<Uint64>(numberOfPixelsPerFrame) * (bitsAllocated / 8);
+  if (static_cast<Uint64>(pixelDataElement->getLength()) < bytesPerFrame * static_cast<Uint64>(numberOfFrames))
+  {
+    vtkErrorWithObjectMacro(this->External, "LoadRTImageFrames: Pixel data of RT image object is shorter than expected");
+    return false;
+  }
+
+  vtkSmartPointer<vtkImageData> framesImageData = vtkSmartPointer<vtkImageData>::New();
+  framesImageData->SetDimensions(dimensions[0], dimensions[1], numberOfFrames);
+  framesImageData->AllocateScalars(scalarType, 1);
+  const vtkIdType bytesPerFrameInImageData = numberOfPixelsPerFrame * framesImageData->GetScalarSize();
+  Uint8* framesBuffer = static_cast<Uint8*>(framesImageData->GetScalarPointer());
+
+  // Each frame is read directly into its place in the frames buffer. Pixel data that was not loaded
+  // when parsing the file is read from the file, the file cache keeps the file open between frames.
+  DcmFileCache fileCache;
+  for (Sint32 frame = 0; frame < numberOfFrames; ++frame)
+  {
+    Uint8* frameBuffer = framesBuffer + static_cast<vtkIdType>(frame) * bytesPerFrameInImageData;
+    const Uint64 frameOffset = static_cast<Uint64>(frame) * bytesPerFrame;
+    if ( pixelDataElement->getPartialValue(frameBuffer, static_cast<Uint32>(frameOffset),
+      static_cast<Uint32>(bytesPerFrame), &fileCache).bad() )
+    {
+      vtkErrorWithObjectMacro(this->External, "LoadRTImageFrames: Failed to read frame " << frame << " of RT image object");
+      return false;
+    }
+    if (!rescale)
+    {
+      continue;
+    }
+    float* framePixels = reinterpret_cast<float*>(frameBuffer);
+    switch (bitsAllocated)
+    {
+      case 8:
+        if (pixelRepresentation)
+        {
+          RescaleImageFrame<Sint8>(framePixels, numberOfPixelsPerFrame, rescaleSlope, rescaleIntercept);
+        }
+        else
+        {
+          RescaleImageFrame<Uint8>(framePixels, numberOfPixelsPerFrame, rescaleSlope, rescaleIntercept);
+        }
+        break;
+      case 16:
+        if (pixelRepresentation)
+        {
+          RescaleImageFrame<Sint16>(framePixels, numberOfPixelsPerFrame, rescaleSlope, rescaleIntercept);
+        }
+        else
+        {
+          RescaleImageFrame<Uint16>(framePixels, numberOfPixelsPerFrame, rescaleSlope, rescaleIntercept);
+        }
+        break;
+      default:
+        if (pixelRepresentation)
+        {
+          RescaleImageFrame<Sint32>(framePixels, numberOfPixelsPerFrame, rescaleSlope, rescaleIntercept);
+        }
+        else
+        {
+          RescaleImageFrame<Uint32>(framePixels, numberOfPixelsPerFrame, rescaleSlope, rescaleIntercept);
+        }
+        break;
+    }
+  }
+
+  this->RTImageFramesImageData = framesImageData;
+  return true;
+}
+
 
 //----------------------------------------------------------------------------
 // vtkSlicerDicomRtReader methods
@@ -2443,6 +3137,7 @@ vtkSlicerDicomRtReader::vtkSlicerDicomRtReader()
   this->Internal = new vtkInternal(this);
 
   this->RTStructureSetReferencedSOPInstanceUIDs = nullptr;
+  this->RTStructureSetLabel = nullptr;
 
   this->SetPixelSpacing(0.0,0.0);
   this->DoseUnits = nullptr;
@@ -2460,17 +3155,26 @@ vtkSlicerDicomRtReader::vtkSlicerDicomRtReader()
   this->RTImageSID = 0.0;
   this->WindowCenter = 0.0;
   this->WindowWidth = 0.0;
+  this->SetRTImageDimensions(0,0);
+  this->RTImageNumberOfFrames = 1;
+  this->SetImagePlanePixelSpacing(1.0,1.0);
 
   this->LoadRTStructureSetSuccessful = false;
   this->LoadRTDoseSuccessful = false;
   this->LoadRTPlanSuccessful = false;
   this->LoadRTIonPlanSuccessful = false;
   this->LoadRTImageSuccessful = false;
+
+  this->DatasetCache = nullptr;
+  this->DeferRoiContourLoading = false;
+  this->DeferRtImagePixelLoading = false;
 }
 
 //----------------------------------------------------------------------------
 vtkSlicerDicomRtReader::~vtkSlicerDicomRtReader()
 {
+  this->SetDatasetCache(nullptr);
+
   if (this->Internal)
   {
     delete this->Internal;
@@ -2496,14 +3200,31 @@ void vtkSlicerDicomRtReader::Update()
     QString databaseFile = databaseDirectory + DICOMREADER_DICOM_DATABASE_FILENAME.c_str();
     this->SetDatabaseFile(databaseFile.toUtf8().constData());
 
-    // Load DICOM file or dataset
-    DcmFileFormat fileformat;
-
+    // Load DICOM file or dataset. Use the already parsed file from the cache if available, in which case
+    // only the values that were skipped when parsing (such as long contour data) need to be read from the file.
+    // If RT image pixel loading is deferred, then long values of RT images are left in the file, and read only if accessed
+    std::shared_ptr<DcmFileFormat> fileformat;
     OFCondition result = EC_TagNotFound;
-    result = fileformat.loadFile(this->FileName, EXS_Unknown);
+    if (this->DatasetCache)
+    {
+      fileformat = this->DatasetCache->GetFileFormat(this->FileName);
+      if (fileformat)
+      {
+        bool deferPixels = (this->DeferRtImagePixelLoading && IsRtImageFile(fileformat.get()));
+        result = (deferPixels ? EC_Normal : fileformat->loadAllDataIntoMemory());
+      }
+    }
+    if (!fileformat || result.bad())
+    {
+      // The header is checked first, so that the values of other objects are read the same way as without deferring
+      bool deferPixels = (this->DeferRtImagePixelLoading && IsRtImageFile(this->FileName));
+      fileformat = std::make_shared<DcmFileFormat>();
+      result = fileformat->loadFile(this->FileName, EXS_Unknown, EGL_noChange,
+        deferPixels ? DEFERRED_PIXEL_MAX_READ_LENGTH : DCM_MaxReadLength);
+    }
     if (result.good())
     {
-      DcmDataset *dataset = fileformat.getDataset();
+      DcmDataset *dataset = fileformat->getDataset();
 
       // Check SOP Class UID for one of the supported RT objects
       //   TODO: One series can contain composite information, e.g, an RTPLAN series can contain structure sets and plans as well
@@ -2559,6 +3280,24 @@ void vtkSlicerDicomRtReader::Update()
   }
 }
 
+//----------------------------------------------------------------------------
+vtkImageData* vtkSlicerDicomRtReader::GetDoseImageData()
+{
+  return this->Internal->DoseImageData;
+}
+
+//----------------------------------------------------------------------------
+vtkMatrix4x4* vtkSlicerDicomRtReader::GetDoseIJKToRASMatrix()
+{
+  return this->Internal->DoseIJKToRASMatrix;
+}
+
+//----------------------------------------------------------------------------
+vtkImageData* vtkSlicerDicomRtReader::GetRTImageFramesImageData()
+{
+  return this->Internal->RTImageFramesImageData;
+}
+
 //----------------------------------------------------------------------------
 int vtkSlicerDicomRtReader::GetNumberOfRois()
 {
@@ -2620,6 +3359,79 @@ int vtkSlicerDicomRtReader::GetRoiNumber(unsigned int internalIndex)
   return this->Internal->RoiSequenceVector[internalIndex].Number;
 }
 
+//----------------------------------------------------------------------------
+int vtkSlicerDicomRtReader::GetRoiNumberOfPoints(unsigned int internalIndex)
+{
+  if (internalIndex >= this->Internal->RoiSequenceVector.size())
+  {
+    vtkErrorMacro("GetRoiNumberOfPoints: Cannot get ROI with internal index: " << internalIndex);
+    return 0;
+  }
+  return static_cast<int>(this->Internal->RoiSequenceVector[internalIndex].NumberOfPoints);
+}
+
+//----------------------------------------------------------------------------
+const char* vtkSlicerDicomRtReader::GetRoiContourHash(unsigned int internalIndex)
+{
+  if (internalIndex >= this->Internal->RoiSequenceVector.size())
+  {
+    vtkErrorMacro("GetRoiContourHash: Cannot get ROI with internal index: " << internalIndex);
+    return nullptr;
+  }
+  return this->Internal->RoiSequenceVector[internalIndex].ContourHash.c_str();
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerDicomRtReader::GetRoiContoursLoaded(unsigned int internalIndex)
+{
+  if (internalIndex >= this->Internal->RoiSequenceVector.size())
+  {
+    vtkErrorMacro("GetRoiContoursLoaded: Cannot get ROI with internal index: " << internalIndex);
+    return false;
+  }
+  return (this->Internal->RoiSequenceVector[internalIndex].DeferredContourItem == nullptr);
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerDicomRtReader::LoadRoiContours(unsigned int internalIndex)
+{
+  if (internalIndex >= this->Internal->RoiSequenceVector.size())
+  {
+    vtkErrorMacro("LoadRoiContours: Cannot get ROI with internal index: " << internalIndex);
+    return false;
+  }
+  vtkInternal::RoiEntry* roiEntry = &this->Internal->RoiSequenceVector[internalIndex];
+  if (!roiEntry->DeferredContourItem)
+  {
+    return true; // Already loaded
+  }
+  if (!this->Internal->DeferredStructureSet)
+  {
+    vtkErrorMacro("LoadRoiContours: Structure set is not available to load contours of ROI " << roiEntry->Name);
+    return false;
+  }
+
+  DRTROIContourSequence::Item* roiContourItem = roiEntry->DeferredContourItem;
+  roiEntry->DeferredContourItem = nullptr;
+  std::set<std::string> referencedSopInstanceUids;
+  vtkInternal::RoiLoadMessages messages;
+  bool contoursLoaded = this->Internal->LoadContour(*roiContourItem, roiEntry, referencedSopInstanceUids, messages);
+  this->Internal->LogRoiLoadMessages(messages);
+  if (!contoursLoaded)
+  {
+    return false;
+  }
+
+  // Read slice reference UIDs from referenced frame of reference sequence if it was not included in the ROIContourSequence
+  if (roiEntry->ContourIndexToSOPInstanceUIDMap.empty())
+  {
+    this->Internal->GetReferencedFrameOfReferenceContourToSliceInstanceUIDMap(
+      this->Internal->DeferredStructureSet, roiEntry->ContourIndexToSOPInstanceUIDMap);
+  }
+
+  return true;
+}
+
 //----------------------------------------------------------------------------
 int vtkSlicerDicomRtReader::GetNumberOfBeams()
 {
@@ -2760,6 +3572,19 @@ double vtkSlicerDicomRtReader::GetBeamControlPointGantryAngle( unsigned int beam
   return 0.0;
 }
 
+//----------------------------------------------------------------------------
+double vtkSlicerDicomRtReader::GetBeamControlPointCumulativeMetersetWeight( unsigned int beamNumber, 
+  unsigned int controlPointIndex)
+{
+  vtkInternal::BeamEntry* beam = this->Internal->FindBeamByNumber(beamNumber);
+  if (beam && (controlPointIndex < beam->ControlPointSequenceVector.size()))
+  {
+    vtkInternal::ControlPointEntry& controlPoint = beam->ControlPointSequenceVector.at(controlPointIndex);
+    return controlPoint.CumulativeMetersetWeight;
+  }
+  return -1.0;
+}
+
 //----------------------------------------------------------------------------
 double vtkSlicerDicomRtReader::GetBeamControlPointPatientSupportAngle( unsigned int beamNumber, 
   unsigned int controlPointIndex)
@@ -2883,6 +3708,61 @@ const char* vtkSlicerDicomRtReader::GetBeamControlPointMultiLeafCollimatorPositi
   return nullptr;
 }
 
+//----------------------------------------------------------------------------
+const char* vtkSlicerDicomRtReader::GetBeamMultiLeafCollimatorPositions( unsigned int beamNumber, 
+  std::vector<double>& pairBoundaries, std::vector<double>& leafPositions)
+{
+  pairBoundaries.clear();
+  leafPositions.clear();
+
+  vtkInternal::BeamEntry* beam = this->Internal->FindBeamByNumber(beamNumber);
+  if (!beam)
+  {
+    vtkErrorMacro("GetBeamMultiLeafCollimatorPositions: Unable to find beam of number" << beamNumber);
+    return nullptr;
+  }
+  const std::string& mlcType = beam->MultiLeafCollimatorType;
+  if (mlcType.empty())
+  {
+    vtkDebugMacro("GetBeamMultiLeafCollimatorPositions: MLC type undefined");
+    return nullptr;
+  }
+  const size_t numberOfPositions = 2 * beam->MultiLeafCollimator.NumberOfLeafJawPairs;
+  if ( numberOfPositions == 0 || beam->ControlPointSequenceVector.empty()
+    || beam->MultiLeafCollimator.LeafPositionBoundary.size() != beam->MultiLeafCollimator.NumberOfLeafJawPairs + 1 )
+  {
+    vtkErrorMacro("GetBeamMultiLeafCollimatorPositions: Invalid MLC or no control point sequence data for beam: " << beam->Name);
+    return nullptr;
+  }
+
+  leafPositions.reserve(beam->ControlPointSequenceVector.size() * numberOfPositions);
+  for (std::vector<vtkInternal::ControlPointEntry>::const_iterator controlPointIt = beam->ControlPointSequenceVector.begin();
+    controlPointIt != beam->ControlPointSequenceVector.end(); ++controlPointIt)
+  {
+    if (controlPointIt->MultiLeafCollimatorType == mlcType && controlPointIt->LeafPositions.size() == numberOfPositions)
+    {
+      leafPositions.insert(leafPositions.end(), controlPointIt->LeafPositions.begin(), controlPointIt->LeafPositions.end());
+    }
+    else if (!leafPositions.empty())
+    {
+      // Leaves do not move in this control point
+      size_t previousPositionsStart = leafPositions.size() - numberOfPositions;
+      for (size_t positionIndex = 0; positionIndex < numberOfPositions; ++positionIndex)
+      {
+        leafPositions.push_back(leafPositions[previousPositionsStart + positionIndex]);
+      }
+    }
+    else
+    {
+      vtkErrorMacro("GetBeamMultiLeafCollimatorPositions: No valid leaf positions in the first control point of beam: " << beam->Name);
+      return nullptr;
+    }
+  }
+
+  pairBoundaries = beam->MultiLeafCollimator.LeafPositionBoundary;
+  return mlcType.c_str();
+}
+
 //----------------------------------------------------------------------------
 bool vtkSlicerDicomRtReader::GetBeamControlPointScanSpotParameters( unsigned int beamNumber, 
   unsigned int controlPointIndex, std::vector<float>& positionMap, 
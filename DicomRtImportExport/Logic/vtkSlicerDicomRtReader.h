@@ -38,7 +38,10 @@
 // STD includes
 #include <vector>
 
+class vtkImageData;
+class vtkMatrix4x4;
 class vtkPolyData;
+class vtkSlicerDicomRtDatasetCache;
 
 /// \ingroup SlicerRt_QtModules_DicomRtImport
 class VTK_SLICER_DICOMRTIMPORTEXPORT_LOGIC_EXPORT vtkSlicerDicomRtReader : public vtkSlicerDicomReaderBase
@@ -51,6 +54,11 @@ public:
   /// Do reading
   void Update();
 
+  /// Set cache of parsed files. If the input file is found in the cache, then it is not parsed again
+  void SetDatasetCache(vtkSlicerDicomRtDatasetCache* cache);
+  /// Get cache of parsed files
+  vtkGetObjectMacro(DatasetCache, vtkSlicerDicomRtDatasetCache);
+
 public:
   /// Get number of created ROIs
   int GetNumberOfRois();
@@ -75,6 +83,26 @@ public:
   /// \param internalIndex Internal index of ROI to get
   int GetRoiNumber(unsigned int internalIndex);
 
+  /// Get number of contour points of a certain ROI by internal index.
+  /// Available before the contours are loaded (see \sa DeferRoiContourLoading)
+  /// \param internalIndex Internal index of ROI to get
+  int GetRoiNumberOfPoints(unsigned int internalIndex);
+
+  /// Get hash of the contour sequence of a certain ROI by internal index. It is computed from the geometric type
+  /// and the data of the contours when they are loaded, so it changes only if the contours change
+  /// \param internalIndex Internal index of ROI to get
+  /// \return Hash string, empty if the contours are not loaded (see \sa DeferRoiContourLoading)
+  const char* GetRoiContourHash(unsigned int internalIndex);
+
+  /// Get flag indicating whether the contours of a certain ROI are loaded (see \sa DeferRoiContourLoading)
+  /// \param internalIndex Internal index of ROI to get
+  bool GetRoiContoursLoaded(unsigned int internalIndex);
+
+  /// Load the contours of a certain ROI if loading was deferred (see \sa DeferRoiContourLoading)
+  /// \param internalIndex Internal index of ROI to load
+  /// \return Success flag. True if the contours were already loaded
+  bool LoadRoiContours(unsigned int internalIndex);
+
   /// Get number of beams
   int GetNumberOfBeams();
 
@@ -124,6 +152,10 @@ public:
   double GetBeamControlPointBeamLimitingDeviceAngle( unsigned int beamNumber, 
     unsigned int controlPoint);
 
+  /// Get cumulative meterset weight for a given control point of a beam
+  double GetBeamControlPointCumulativeMetersetWeight( unsigned int beamNumber, 
+    unsigned int controlPoint);
+
   /// Get jaw positions for a given control point of a beam
   /// \param jawPositions Array in which the jaw positions are copied
   /// \return true if jaw positions are valid, false otherwise 
@@ -174,6 +206,14 @@ public:
     unsigned int controlPoint, std::vector<double>& pairBoundaries, 
     std::vector<double>& leafPositions);
 
+  /// Get MLC leaves boundaries & leaves positions of all control points of a beam in one call
+  /// \param pairBoundaries Array in which the raw leaves boundaries are copied (number of leaf pairs + 1 values)
+  /// \param leafPositions Array in which the raw leaf positions are copied: number of control points x (2 x number of leaf pairs)
+  ///   values, contiguous for each control point. Control points without leaf positions repeat those of the previous one
+  /// \return "MLCX" or "MLCY" if data is valid, nullptr otherwise
+  const char* GetBeamMultiLeafCollimatorPositions( unsigned int beamNumber, 
+    std::vector<double>& pairBoundaries, std::vector<double>& leafPositions);
+
   /// Get number of channels
   int GetNumberOfChannels();
 
@@ -189,6 +229,11 @@ public:
   /// Set referenced SOP instance UID list for the loaded structure set
   vtkSetStringMacro(RTStructureSetReferencedSOPInstanceUIDs);
 
+  /// Get label of the loaded structure set
+  vtkGetStringMacro(RTStructureSetLabel);
+  /// Set label of the loaded structure set
+  vtkSetStringMacro(RTStructureSetLabel);
+
   /// Get pixel spacing for dose volume
   vtkGetVector2Macro(PixelSpacing, double);
 
@@ -202,6 +247,13 @@ public:
   /// Set dose grid scaling
   vtkSetStringMacro(DoseGridScaling);
 
+  /// Get dose volume voxels decoded from the RT dose file with the dose grid scaling applied (float scalars).
+  /// The image data has unit spacing and zero origin, the geometry is in \sa GetDoseIJKToRASMatrix
+  /// \return Dose image data, nullptr if the pixel data cannot be decoded directly (e.g. compressed transfer syntax)
+  vtkImageData* GetDoseImageData();
+  /// Get IJK to RAS matrix of the dose volume decoded from the RT dose file (\sa GetDoseImageData)
+  vtkMatrix4x4* GetDoseIJKToRASMatrix();
+
   /// Get RT Plan SOP instance UID referenced by RT Dose
   vtkGetStringMacro(RTDoseReferencedRTPlanSOPInstanceUID);
   /// Set RT Plan SOP instance UID referenced by RT Dose
@@ -267,6 +319,21 @@ public:
   /// Set RT Image SID
   vtkSetMacro(RTImageSID, double);
 
+  /// Get RT image dimensions (number of columns and rows)
+  vtkGetVector2Macro(RTImageDimensions, int);
+
+  /// Get number of frames of an RT image (more than one for cine images)
+  vtkGetMacro(RTImageNumberOfFrames, int);
+
+  /// Get frames of a multi-frame RT image decoded into one image data, the frame index being the third axis.
+  /// All frames share the geometry of the RT image (\sa GetImagePlanePixelSpacing). The image data has unit spacing
+  /// and zero origin. Scalars are the stored values, or float if rescale slope or intercept is specified.
+  /// \return Frames image data, nullptr if the RT image is single-frame or its pixel data cannot be decoded directly
+  vtkImageData* GetRTImageFramesImageData();
+
+  /// Get RT image pixel spacing in the image plane. First element for X spacing, second for Y spacing
+  vtkGetVector2Macro(ImagePlanePixelSpacing, double);
+
   /// Get window center
   vtkGetMacro(WindowCenter, double);
   /// Set window center
@@ -278,6 +345,22 @@ public:
   vtkSetMacro(WindowWidth, double);
 
 
+  /// Set flag determining whether loading the contours of structure set ROIs is deferred.
+  /// If enabled, only the ROI properties and number of points are read in \sa Update (point ROIs are loaded),
+  /// and the contours are decoded on request by \sa LoadRoiContours. The structure set is kept in memory until
+  /// the reader is deleted. Off by default
+  vtkSetMacro(DeferRoiContourLoading, bool);
+  /// Get flag determining whether loading the contours of structure set ROIs is deferred
+  vtkGetMacro(DeferRoiContourLoading, bool);
+  vtkBooleanMacro(DeferRoiContourLoading, bool);
+
+  /// Set flag determining whether the pixel data of RT images is skipped when reading the file.
+  /// Only the header is parsed in \sa Update, and the pixels are read later from the file by the caller. Off by default
+  vtkSetMacro(DeferRtImagePixelLoading, bool);
+  /// Get flag determining whether the pixel data of RT images is skipped when reading the file
+  vtkGetMacro(DeferRtImagePixelLoading, bool);
+  vtkBooleanMacro(DeferRtImagePixelLoading, bool);
+
   /// Get load structure set successful flag
   vtkGetMacro(LoadRTStructureSetSuccessful, bool);
   /// Get load dose successful flag
@@ -292,11 +375,20 @@ public:
 protected:
   /// Set pixel spacing for dose volume
   vtkSetVector2Macro(PixelSpacing, double);
+  /// Set RT image dimensions
+  vtkSetVector2Macro(RTImageDimensions, int);
+  /// Set number of frames of an RT image
+  vtkSetMacro(RTImageNumberOfFrames, int);
+  /// Set RT image pixel spacing
+  vtkSetVector2Macro(ImagePlanePixelSpacing, double);
 
 protected:
   /// Referenced SOP instance UID list for the loaded structure set (serialized, separated by spaces)
   char* RTStructureSetReferencedSOPInstanceUIDs;
 
+  /// User-defined label of the loaded structure set, which is kept by its revisions
+  char* RTStructureSetLabel;
+
   /// Pixel spacing - for RTDOSE. First element for X spacing, second for Y spacing.
   double PixelSpacing[2];
 
@@ -348,6 +440,15 @@ protected:
   /// RT Image SID (Distance from radiation machine source to image plane (in mm) along radiation beam axis)
   double RTImageSID;
 
+  /// Number of columns and rows of an RT Image
+  int RTImageDimensions[2];
+
+  /// Number of frames of an RT Image
+  int RTImageNumberOfFrames;
+
+  /// Pixel spacing of an RT Image in the image plane (X and Y spacing)
+  double ImagePlanePixelSpacing[2];
+
   /// Center of window for an RT Image
   double WindowCenter;
 
@@ -370,6 +471,15 @@ protected:
   /// Flag indicating if RT Image has been successfully read from the input dataset
   bool LoadRTImageSuccessful;
 
+  /// Cache of parsed files (optional)
+  vtkSlicerDicomRtDatasetCache* DatasetCache;
+
+  /// Flag determining whether loading the contours of structure set ROIs is deferred
+  bool DeferRoiContourLoading;
+
+  /// Flag determining whether the pixel data of RT images is skipped when reading the file
+  bool DeferRtImagePixelLoading;
+
 protected:
   vtkSlicerDicomRtReader();
   ~vtkSlicerDicomRtReader() override;
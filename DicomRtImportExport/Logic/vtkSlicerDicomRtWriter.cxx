@@ -20,6 +20,7 @@
 ==============================================================================*/
 
 #include <string>
+#include <thread>
 #include <vector>
 
 // DicomRtExport includes
@@ -30,8 +31,11 @@
 #include <vtkObjectFactory.h>
 #include <vtkSmartPointer.h>
 #include <vtkPolyData.h>
-#include <vtkCell.h>
+#include <vtkCellArray.h>
+#include <vtkDoubleArray.h>
+#include <vtkFloatArray.h>
 #include <vtkPoints.h>
+#include <vtkVersion.h>
 
 // ITK includes
 #include "itkImage.h"
@@ -53,6 +57,26 @@
 #include "rtss_roi.h"
 #include "rtss_contour.h"
 
+namespace
+{
+  /// Copy the points of a contour cell into the coordinate arrays of a Plastimatch contour, with RAS to LPS conversion.
+  /// Coordinates are accessed directly in the point array, which avoids the virtual accessor per point
+  template<typename CoordinateType>
+  void CopyContourPoints(const CoordinateType* coordinates, vtkIdType numberOfPoints, const vtkIdType* pointIds, Rtss_contour* contour)
+  {
+    float* x = contour->x;
+    float* y = contour->y;
+    float* z = contour->z;
+    for (vtkIdType pointIndex=0; pointIndex<numberOfPoints; ++pointIndex)
+    {
+      const CoordinateType* point = coordinates + 3 * pointIds[pointIndex];
+      x[pointIndex] = static_cast<float>(-point[0]);
+      y[pointIndex] = static_cast<float>(-point[1]);
+      z[pointIndex] = static_cast<float>(point[2]);
+    }
+  }
+}
+
 //----------------------------------------------------------------------------
 vtkStandardNewMacro(vtkSlicerDicomRtWriter);
 
@@ -79,6 +103,8 @@ vtkSlicerDicomRtWriter::vtkSlicerDicomRtWriter()
   this->RtssSeriesNumber = nullptr;
 
   this->FileName = nullptr;
+
+  this->WriteDoseConcurrently = false;
 }
 
 //----------------------------------------------------------------------------
@@ -88,6 +114,8 @@ vtkSlicerDicomRtWriter::~vtkSlicerDicomRtWriter() = default;
 void vtkSlicerDicomRtWriter::PrintSelf(ostream& os, vtkIndent indent)
 {
   this->Superclass::PrintSelf(os, indent);
+
+  os << indent << "WriteDoseConcurrently: " << (this->WriteDoseConcurrently ? "true" : "false") << "\n";
 }
 
 //----------------------------------------------------------------------------
@@ -99,7 +127,7 @@ void vtkSlicerDicomRtWriter::SetImage(const Plm_image::Pointer& img)
 //----------------------------------------------------------------------------
 void vtkSlicerDicomRtWriter::SetDose(const Plm_image::Pointer& img)
 {
-  this->RtStudy.set_dose(img);
+  this->Dose = img;
 }
   
 //----------------------------------------------------------------------------
@@ -160,21 +188,59 @@ void vtkSlicerDicomRtWriter::AddStructure(const char *name, double *color,
     int sliceNumber = sliceNumbers[contourIndex];
     std::string sliceUID = sliceUIDs[contourIndex];
     vtkPolyData* contourPolyData = sliceContours[contourIndex];
-    for (int cellIndex=0; cellIndex<contourPolyData->GetNumberOfCells(); ++cellIndex)
+    vtkPoints* points = contourPolyData->GetPoints();
+    if (!points || contourPolyData->GetNumberOfCells() == 0)
     {
-      vtkPoints* points = contourPolyData->GetCell(cellIndex)->GetPoints();
-      Rtss_contour* contour = roi->add_polyline(points->GetNumberOfPoints());
-      contour->slice_no = sliceNumber;
-      contour->ct_slice_uid = sliceUID;
+      continue;
+    }
+
+    // Access the coordinates directly if stored in a float or double array
+    vtkFloatArray* floatCoordinates = vtkFloatArray::FastDownCast(points->GetData());
+    vtkDoubleArray* doubleCoordinates = vtkDoubleArray::FastDownCast(points->GetData());
 
-      for (int pointIndex=0; pointIndex<points->GetNumberOfPoints(); ++pointIndex)
+    // Traverse the cell connectivity directly instead of creating a generic cell for each contour.
+    // Cell arrays are visited in the order of the cell IDs of the poly data
+    vtkCellArray* cellArrays[4] = { contourPolyData->GetVerts(), contourPolyData->GetLines(),
+      contourPolyData->GetPolys(), contourPolyData->GetStrips() };
+    for (vtkCellArray* cellArray : cellArrays)
+    {
+      if (!cellArray || cellArray->GetNumberOfCells() == 0)
+      {
+        continue;
+      }
+      vtkIdType numberOfPoints = 0;
+#if VTK_MAJOR_VERSION >= 9
+      const vtkIdType* pointIds = nullptr;
+#else
+      vtkIdType* pointIds = nullptr;
+#endif
+      cellArray->InitTraversal();
+      while (cellArray->GetNextCell(numberOfPoints, pointIds))
       {
-        double point[3] = {0.0,0.0,0.0};
-        points->GetPoint(pointIndex, point);
+        Rtss_contour* contour = roi->add_polyline(numberOfPoints);
+        contour->slice_no = sliceNumber;
+        contour->ct_slice_uid = sliceUID;
+
         // RAS to LPS conversion
-        contour->x[pointIndex] = point[0] * -1.0;
-        contour->y[pointIndex] = point[1] * -1.0;
-        contour->z[pointIndex] = point[2];
+        if (floatCoordinates)
+        {
+          CopyContourPoints(floatCoordinates->GetPointer(0), numberOfPoints, pointIds, contour);
+        }
+        else if (doubleCoordinates)
+        {
+          CopyContourPoints(doubleCoordinates->GetPointer(0), numberOfPoints, pointIds, contour);
+        }
+        else
+        {
+          for (vtkIdType pointIndex=0; pointIndex<numberOfPoints; ++pointIndex)
+          {
+            double point[3] = {0.0,0.0,0.0};
+            points->GetPoint(pointIds[pointIndex], point);
+            contour->x[pointIndex] = point[0] * -1.0;
+            contour->y[pointIndex] = point[1] * -1.0;
+            contour->z[pointIndex] = point[2];
+          }
+        }
       }
     }
   }
@@ -183,8 +249,45 @@ void vtkSlicerDicomRtWriter::AddStructure(const char *name, double *color,
 //----------------------------------------------------------------------------
 void vtkSlicerDicomRtWriter::Write()
 {
-  // Set study metadata
   Rt_study_metadata::Pointer& rt_metadata = this->RtStudy.get_rt_study_metadata ();
+  this->SetMetadata(rt_metadata);
+
+  bool writeDoseConcurrently = ( this->WriteDoseConcurrently && this->Dose
+    && (this->RtStudy.have_image() || this->RtStudy.have_segmentation()) );
+  if (!writeDoseConcurrently)
+  {
+    if (this->Dose)
+    {
+      this->RtStudy.set_dose(this->Dose);
+    }
+
+    // Write output to files
+    this->RtStudy.save_dicom(this->FileName);
+    return;
+  }
+
+  // Dose is written from a separate study that has the same study and frame of reference as the image.
+  // The two studies share no data: each has its own metadata, writer state and output files. The only process-wide
+  // state used by both writers is the DCMTK data dictionary and UID generator, which DCMTK guards by its own locks.
+  // The image slices cannot be written concurrently, as Plastimatch writes them in one call and generates the slice
+  // UIDs referenced by the structure set while writing them
+  Rt_study doseStudy;
+  Rt_study_metadata::Pointer& dose_metadata = doseStudy.get_rt_study_metadata ();
+  this->SetMetadata(dose_metadata);
+  dose_metadata->set_study_uid (rt_metadata->get_study_uid ());
+  dose_metadata->set_frame_of_reference_uid (rt_metadata->get_frame_of_reference_uid ());
+  doseStudy.set_dose(this->Dose);
+
+  // Write output to files
+  std::thread doseWriterThread([this, &doseStudy]() { doseStudy.save_dicom(this->FileName); });
+  this->RtStudy.save_dicom(this->FileName);
+  doseWriterThread.join();
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerDicomRtWriter::SetMetadata(Rt_study_metadata::Pointer& rt_metadata)
+{
+  // Set study metadata
   if (this->PatientName && this->PatientName[0] != 0)
   {
     rt_metadata->set_study_metadata (0x0010, 0x0010, this->PatientName);
@@ -247,7 +350,4 @@ void vtkSlicerDicomRtWriter::Write()
   {
     rt_metadata->set_rtstruct_metadata (0x0020, 0x0011, this->RtssSeriesNumber);
   }
-  
-  // Write output to files
-  this->RtStudy.save_dicom(this->FileName);
 }
@@ -65,6 +65,12 @@ public:
   /// TODO: Description, argument names and descriptions
   void Write();
 
+  /// Set flag determining whether the dose is written concurrently (see \sa WriteDoseConcurrently)
+  vtkSetMacro(WriteDoseConcurrently, bool);
+  /// Get flag determining whether the dose is written concurrently
+  vtkGetMacro(WriteDoseConcurrently, bool);
+  vtkBooleanMacro(WriteDoseConcurrently, bool);
+
 public:
   /// Get the DICOM Patient Name
   vtkGetStringMacro(PatientName);
@@ -133,6 +139,9 @@ public:
 
 protected:
   std::string formatColorString (const double *color);
+  /// Set study, image, dose and structure set metadata from the parameters of the writer
+  void SetMetadata (Rt_study_metadata::Pointer& rt_metadata);
+
   vtkSlicerDicomRtWriter();
   ~vtkSlicerDicomRtWriter() override;
 
@@ -160,6 +169,14 @@ protected:
   /// Plastimatch RT study structure
   Rt_study RtStudy;
 
+  /// Dose distribution image. Added to \sa RtStudy when writing, unless it is written concurrently
+  Plm_image::Pointer Dose;
+
+  /// Flag determining whether the dose is written on a separate thread, concurrently with the image series and the
+  /// structure set. The image slices are still written one by one, and the structure set that references them is
+  /// written after them. Off by default, in which case all objects are written on the calling thread
+  bool WriteDoseConcurrently;
+
 private:
   vtkSlicerDicomRtWriter(const vtkSlicerDicomRtWriter&) = delete;
   void operator=(const vtkSlicerDicomRtWriter&) = delete;
@@ -0,0 +1,204 @@
+import os
+import unittest
+import vtk, qt, ctk, slicer
+from slicer.ScriptedLoadableModule import *
+import logging
+
+class DicomRtExportTest(unittest.TestCase):
+  def setUp(self):
+    """ Do whatever is needed to reset the state - typically a scene clear will be enough.
+    """
+    slicer.mrmlScene.Clear(0)
+
+  #------------------------------------------------------------------------------
+  def runTest(self):
+    """Run as few or as many tests as needed here.
+    """
+    self.setUp()
+    self.test_DicomRtExportTest_FullTest1()
+
+  #------------------------------------------------------------------------------
+  def test_DicomRtExportTest_FullTest1(self):
+    # Check for modules
+    self.assertIsNotNone( slicer.modules.dicomrtimportexport )
+    self.assertIsNotNone( slicer.modules.segmentations )
+
+    self.TestSection_LoadInputData()
+    self.TestSection_CreateExportables()
+    self.TestSection_ExportConcurrently()
+    self.TestSection_VerifyStructureSetContours()
+
+    logging.info("Test finished")
+
+  #------------------------------------------------------------------------------
+  def TestSection_LoadInputData(self):
+    logging.info("Load input data")
+    import vtkSlicerRtCommonPython as vtkSlicerRtCommon
+
+    self.dataDir = os.path.dirname(os.path.realpath(__file__)) + '/../../../Testing/Data'
+    self.tempDir = slicer.app.temporaryPath + '/DicomRtExportTest'
+    if not os.access(self.tempDir, os.F_OK):
+      os.mkdir(self.tempDir)
+
+    self.ctNode = slicer.util.loadVolume(self.dataDir + '/TinyPatientCT.nrrd')
+    self.assertIsNotNone( self.ctNode )
+    self.doseNode = slicer.util.loadVolume(self.dataDir + '/TinyPatientDose.nrrd')
+    self.assertIsNotNone( self.doseNode )
+    self.doseNode.SetAttribute(vtkSlicerRtCommon.vtkSlicerRtCommon.DICOMRTIMPORT_DOSE_VOLUME_IDENTIFIER_ATTRIBUTE_NAME, '1')
+    self.segmentationNode = slicer.util.loadSegmentation(self.dataDir + '/TinyPatientStructureSet.seg.vtm')
+    self.assertIsNotNone( self.segmentationNode )
+
+  #------------------------------------------------------------------------------
+  def TestSection_CreateExportables(self):
+    logging.info("Create exportables")
+
+    # Put the nodes in a study so that they are exported as one RT study
+    shNode = slicer.vtkMRMLSubjectHierarchyNode.GetSubjectHierarchyNode(slicer.mrmlScene)
+    patientItemID = shNode.CreateSubjectHierarchyItem(shNode.GetSceneItemID(), 'TinyPatient',
+      slicer.vtkMRMLSubjectHierarchyConstants.GetDICOMLevelPatient())
+    studyItemID = shNode.CreateSubjectHierarchyItem(patientItemID, 'TinyStudy',
+      slicer.vtkMRMLSubjectHierarchyConstants.GetDICOMLevelStudy())
+    shNode.SetItemUID(studyItemID, slicer.vtkMRMLSubjectHierarchyConstants.GetDICOMUIDName(), '1.2.3.4.5.6.7.8.9')
+
+    from DicomRtImportExportPlugin import DicomRtImportExportPluginClass
+    exporter = DicomRtImportExportPluginClass()
+    self.exportables = []
+    for node in [self.ctNode, self.doseNode, self.segmentationNode]:
+      itemID = shNode.GetItemByDataNode(node)
+      shNode.SetItemParent(itemID, studyItemID)
+      exportables = exporter.examineForExport(itemID)
+      self.assertEqual( len(exportables), 1 )
+      exportable = exportables[0]
+      exportable.setTag('PatientName', 'TinyPatient')
+      exportable.setTag('PatientID', 'TinyPatientID')
+      exportable.setTag('PatientSex', 'O')
+      exportable.setTag('StudyDate', '20000101')
+      exportable.setTag('StudyTime', '120000')
+      self.exportables.append(exportable)
+
+  #------------------------------------------------------------------------------
+  def TestSection_ExportConcurrently(self):
+    logging.info("Export concurrently")
+
+    logic = slicer.modules.dicomrtimportexport.logic()
+
+    # Export the study serially
+    serialOutputDir = self.tempDir + '/Serial'
+    self.exportStudy(serialOutputDir)
+    serialDatasets = self.readDatasets(serialOutputDir)
+    self.assertGreater( len(serialDatasets), 2 )
+
+    # Export the study concurrently several times, so that races between the two writers (such as in UID generation)
+    # show up as differing output or as colliding UIDs
+    numberOfConcurrentExports = 5
+    concurrentInstanceUids = set()
+    logic.SetExportDoseConcurrently(True)
+    try:
+      for exportIndex in range(numberOfConcurrentExports):
+        concurrentOutputDir = self.tempDir + '/Concurrent%d' % exportIndex
+        self.exportStudy(concurrentOutputDir)
+        concurrentDatasets = self.readDatasets(concurrentOutputDir)
+
+        # Output must be identical apart from timestamps and generated UIDs
+        self.assertEqual( len(serialDatasets), len(concurrentDatasets) )
+        self.uidMap = {}
+        for serialDataset, concurrentDataset in zip(serialDatasets, concurrentDatasets):
+          self.compareDatasets(serialDataset.file_meta, concurrentDataset.file_meta)
+          self.compareDatasets(serialDataset, concurrentDataset)
+        # Distinct UIDs of the serial export must not have been generated as the same UID
+        self.assertEqual( len(set(self.uidMap.values())), len(self.uidMap) )
+
+        # Instance UIDs are unique across all exports
+        for concurrentDataset in concurrentDatasets:
+          self.assertNotIn( concurrentDataset.SOPInstanceUID, concurrentInstanceUids )
+          concurrentInstanceUids.add(concurrentDataset.SOPInstanceUID)
+    finally:
+      logic.SetExportDoseConcurrently(False)
+
+  #------------------------------------------------------------------------------
+  def TestSection_VerifyStructureSetContours(self):
+    logging.info("Verify structure set contours")
+
+    logic = slicer.modules.dicomrtimportexport.logic()
+    segmentation = self.segmentationNode.GetSegmentation()
+    closedSurfaceName = slicer.vtkSegmentationConverter.GetSegmentationClosedSurfaceRepresentationName()
+    binaryLabelmapName = slicer.vtkSegmentationConverter.GetSegmentationBinaryLabelmapRepresentationName()
+
+    # Use labelmap master so that the flag selects between the labelmap and the closed surface export
+    self.assertTrue( segmentation.CreateRepresentation(binaryLabelmapName) )
+    segmentation.SetMasterRepresentationName(binaryLabelmapName)
+
+    for closedSurfaceContours in [True, False]:
+      outputDir = self.tempDir + ('/ClosedSurfaceContours' if closedSurfaceContours else '/LabelmapContours')
+      logic.SetExportClosedSurfaceContours(closedSurfaceContours)
+      self.exportStudy(outputDir)
+      self.verifyStructureSetContours(outputDir)
+    logic.SetExportClosedSurfaceContours(False)
+
+    segmentation.SetMasterRepresentationName(closedSurfaceName)
+
+  #------------------------------------------------------------------------------
+  def exportStudy(self, outputDir):
+    import shutil
+    if os.access(outputDir, os.F_OK):
+      shutil.rmtree(outputDir)
+    os.mkdir(outputDir)
+
+    exportablesCollection = vtk.vtkCollection()
+    for exportable in self.exportables:
+      exportable.directory = outputDir
+      vtkExportable = slicer.vtkSlicerDICOMExportable()
+      exportable.copyToVtkExportable(vtkExportable)
+      exportablesCollection.AddItem(vtkExportable)
+
+    message = slicer.modules.dicomrtimportexport.logic().ExportDicomRTStudy(exportablesCollection)
+    self.assertEqual( message, '' )
+
+  #------------------------------------------------------------------------------
+  def verifyStructureSetContours(self, outputDir):
+    # Contours are created at the CT slice positions, whether cut from closed surfaces or from labelmaps
+    ctDatasets = [dataset for dataset in self.readDatasets(outputDir) if dataset.Modality == 'CT']
+    rtssDatasets = [dataset for dataset in self.readDatasets(outputDir) if dataset.Modality == 'RTSTRUCT']
+    self.assertEqual( len(rtssDatasets), 1 )
+    slicePositions = [float(dataset.ImagePositionPatient[2]) for dataset in ctDatasets]
+
+    roiContours = rtssDatasets[0].ROIContourSequence
+    self.assertEqual( len(roiContours), self.segmentationNode.GetSegmentation().GetNumberOfSegments() )
+    for roiContour in roiContours:
+      self.assertGreater( len(roiContour.ContourSequence), 0 )
+      for contour in roiContour.ContourSequence:
+        self.assertEqual( contour.ContourGeometricType, 'CLOSED_PLANAR' )
+        self.assertGreater( int(contour.NumberOfContourPoints), 2 )
+        contourPosition = float(contour.ContourData[2])
+        self.assertAlmostEqual( min([abs(contourPosition - slicePosition) for slicePosition in slicePositions]), 0.0, places=2 )
+
+  #------------------------------------------------------------------------------
+  def readDatasets(self, directory):
+    import pydicom
+    datasets = [pydicom.dcmread(os.path.join(directory, fileName)) for fileName in os.listdir(directory)]
+    return sorted(datasets, key=lambda dataset: (dataset.Modality, int(dataset.get('InstanceNumber', 0))))
+
+  #------------------------------------------------------------------------------
+  def compareDatasets(self, serialDataset, concurrentDataset):
+    ignoredKeywords = ['InstanceCreationDate', 'InstanceCreationTime', 'StudyDate', 'StudyTime',
+      'SeriesDate', 'SeriesTime', 'ContentDate', 'ContentTime', 'AcquisitionDate', 'AcquisitionTime',
+      'StructureSetDate', 'StructureSetTime']
+    serialElements = [element for element in serialDataset if element.keyword not in ignoredKeywords]
+    concurrentElements = [element for element in concurrentDataset if element.keyword not in ignoredKeywords]
+    self.assertEqual( [element.tag for element in serialElements], [element.tag for element in concurrentElements] )
+
+    for serialElement, concurrentElement in zip(serialElements, concurrentElements):
+      if serialElement.VR == 'SQ':
+        self.assertEqual( len(serialElement.value), len(concurrentElement.value) )
+        for serialItem, concurrentItem in zip(serialElement.value, concurrentElement.value):
+          self.compareDatasets(serialItem, concurrentItem)
+      elif serialElement.VR == 'UI':
+        # Generated UIDs differ between exports, but must map to each other consistently
+        serialUid = str(serialElement.value)
+        concurrentUid = str(concurrentElement.value)
+        if serialUid in self.uidMap:
+          self.assertEqual( self.uidMap[serialUid], concurrentUid, serialElement.keyword )
+        else:
+          self.uidMap[serialUid] = concurrentUid
+      else:
+        self.assertEqual( serialElement.value, concurrentElement.value, serialElement.keyword )
@@ -39,6 +39,13 @@ class DicomRtImportTest(unittest.TestCase):
     self.TestSection_SelectLoadables()
     self.TestSection_LoadIntoSlicer()
     self.TestSection_SaveScene()
+    self.TestSection_LoadStudyIntoSlicer()
+    self.TestSection_LoadStructureSetLazily()
+    self.TestSection_LoadRtImageLazily()
+    self.TestSection_LoadMultiFrameRtImage()
+    self.TestSection_LoadRtDoseVoxels()
+    self.TestSection_LoadDynamicBeam()
+    self.TestSection_MergeStructureSet()
     self.TestSection_ClearDatabase()
 
     logging.info("Test finished")
@@ -174,6 +181,499 @@ class DicomRtImportTest(unittest.TestCase):
     readable = os.access(sceneFileName, os.R_OK)
     self.assertTrue( readable )
 
+  #------------------------------------------------------------------------------
+  def TestSection_LoadStudyIntoSlicer(self):
+    # slicer.util.delayDisplay("Load study into Slicer",self.delayMs)
+    logging.info("Load study into Slicer")
+    import time
+
+    loadablesCollection = self.getRtLoadables()
+    vtkLoadables = [loadablesCollection.GetItemAsObject(index) for index in range(loadablesCollection.GetNumberOfItems())]
+    self.assertEqual( len(vtkLoadables), 4 )
+
+    logic = slicer.modules.dicomrtimportexport.logic()
+
+    # Load each loadable separately
+    slicer.mrmlScene.Clear(0)
+    startTime = time.time()
+    for vtkLoadable in vtkLoadables:
+      self.assertTrue( logic.LoadDicomRT(vtkLoadable) )
+    perLoadableTime = time.time() - startTime
+    perLoadableNumberOfNodes = slicer.mrmlScene.GetNumberOfNodes()
+    perLoadableNumberOfItems = slicer.vtkMRMLSubjectHierarchyNode.GetSubjectHierarchyNode(slicer.mrmlScene).GetNumberOfItems()
+
+    # Load the whole study at once. The loadables are given in reverse order, so the logic needs to load
+    # the referenced objects first for the references to be resolved
+    slicer.mrmlScene.Clear(0)
+    reversedLoadablesCollection = vtk.vtkCollection()
+    for vtkLoadable in reversed(vtkLoadables):
+      reversedLoadablesCollection.AddItem(vtkLoadable)
+    startTime = time.time()
+    self.assertTrue( logic.LoadDicomRTStudy(reversedLoadablesCollection) )
+    studyTime = time.time() - startTime
+
+    logging.info("Loading time per loadable: %.3fs, as a study: %.3fs" % (perLoadableTime, studyTime))
+
+    # Same objects are loaded
+    self.assertEqual( slicer.mrmlScene.GetNumberOfNodes(), perLoadableNumberOfNodes )
+    shNode = slicer.vtkMRMLSubjectHierarchyNode.GetSubjectHierarchyNode(slicer.mrmlScene)
+    self.assertEqual( shNode.GetNumberOfItems(), perLoadableNumberOfItems )
+    self.assertEqual( len( slicer.util.getNodes('vtkMRMLScalarVolumeNode*') ), 2 )
+    self.assertEqual( len( slicer.util.getNodes('vtkMRMLRTBeamNode*') ), 5 )
+    self.assertEqual( len( slicer.util.getNodes('vtkMRMLSegmentationNode*') ), 1 )
+
+    # References are resolved: the RT image is placed at its beam as a planar image
+    import vtkSlicerRtCommonPython as vtkSlicerRtCommon
+    rtImageFound = False
+    for volumeNode in slicer.util.getNodesByClass('vtkMRMLScalarVolumeNode'):
+      itemID = shNode.GetItemByDataNode(volumeNode)
+      if shNode.GetItemAttribute(itemID, vtkSlicerRtCommon.vtkSlicerRtCommon.DICOMRTIMPORT_RTIMAGE_IDENTIFIER_ATTRIBUTE_NAME):
+        rtImageFound = True
+        self.assertIsNotNone( volumeNode.GetNodeReference('planarImageDisplayedModelRef') )
+    self.assertTrue( rtImageFound )
+
+  #------------------------------------------------------------------------------
+  def TestSection_LoadStructureSetLazily(self):
+    # slicer.util.delayDisplay("Load structure set lazily",self.delayMs)
+    logging.info("Load structure set lazily")
+    import vtkSlicerRtCommonPython as vtkSlicerRtCommon
+    planarContourName = slicer.vtkSegmentationConverter.GetSegmentationPlanarContourRepresentationName()
+
+    vtkLoadables = self.getRtLoadables()
+
+    logic = slicer.modules.dicomrtimportexport.logic()
+    isodoseLogic = slicer.modules.isodose.logic()
+
+    def getNumberOfContourPoints(segment):
+      contours = segment.GetRepresentation(planarContourName)
+      return contours.GetNumberOfPoints() if contours else 0
+
+    def computeIsodoseVolumeStatistics(segmentationNode, segmentIDs=None):
+      # Segment labelmaps are created on the dose lattice, which requests the deferred segment data
+      doseVolumeNode = None
+      for volumeNode in slicer.util.getNodesByClass('vtkMRMLScalarVolumeNode'):
+        if volumeNode.GetAttribute(vtkSlicerRtCommon.vtkSlicerRtCommon.DICOMRTIMPORT_DOSE_VOLUME_IDENTIFIER_ATTRIBUTE_NAME):
+          doseVolumeNode = volumeNode
+      self.assertIsNotNone( doseVolumeNode )
+      parameterNode = slicer.mrmlScene.AddNewNodeByClass('vtkMRMLIsodoseNode')
+      parameterNode.SetAndObserveDoseVolumeNode(doseVolumeNode)
+      parameterNode.SetAndObserveColorTableNode(slicer.vtkSlicerIsodoseModuleLogic.GetDefaultIsodoseColorTable(slicer.mrmlScene))
+      tableNode = slicer.mrmlScene.AddNewNodeByClass('vtkMRMLTableNode')
+      self.assertEqual( isodoseLogic.ComputeIsodoseVolumeStatistics(parameterNode, segmentationNode, segmentIDs, tableNode), '' )
+      table = tableNode.GetTable()
+      return [[table.GetValue(row, column).ToString() for column in range(table.GetNumberOfColumns())] for row in range(table.GetNumberOfRows())]
+
+    # Load the study with the contours of all segments
+    slicer.mrmlScene.Clear(0)
+    self.assertTrue( logic.LoadDicomRTStudy(vtkLoadables) )
+    segmentationNode = slicer.util.getNode('vtkMRMLSegmentationNode*')
+    segmentation = segmentationNode.GetSegmentation()
+    self.assertGreater( segmentation.GetNumberOfSegments(), 1 )
+    expectedNumberOfContourPoints = [getNumberOfContourPoints(segmentation.GetNthSegment(index)) for index in range(segmentation.GetNumberOfSegments())]
+    self.assertGreater( min(expectedNumberOfContourPoints), 0 )
+    firstSegmentIDs = vtk.vtkStringArray()
+    firstSegmentIDs.InsertNextValue(segmentation.GetNthSegmentID(0))
+    expectedFirstSegmentStatistics = computeIsodoseVolumeStatistics(segmentationNode, firstSegmentIDs)
+    expectedStatistics = computeIsodoseVolumeStatistics(segmentationNode)
+    self.assertGreater( len(expectedStatistics), 0 )
+
+    # Load the study with deferred contours
+    slicer.mrmlScene.Clear(0)
+    logic.SetLazyStructureSetLoading(True)
+    try:
+      self.assertTrue( logic.LoadDicomRTStudy(vtkLoadables) )
+    finally:
+      logic.SetLazyStructureSetLoading(False)
+    segmentationNode = slicer.util.getNode('vtkMRMLSegmentationNode*')
+    segmentation = segmentationNode.GetSegmentation()
+    self.assertEqual( segmentation.GetNumberOfSegments(), len(expectedNumberOfContourPoints) )
+    for index in range(segmentation.GetNumberOfSegments()):
+      self.assertEqual( getNumberOfContourPoints(segmentation.GetNthSegment(index)), 0 )
+
+    # Consumers of segment data request the contours of the segments they use only
+    self.assertEqual( computeIsodoseVolumeStatistics(segmentationNode, firstSegmentIDs), expectedFirstSegmentStatistics )
+    self.assertEqual( getNumberOfContourPoints(segmentation.GetNthSegment(0)), expectedNumberOfContourPoints[0] )
+    self.assertEqual( getNumberOfContourPoints(segmentation.GetNthSegment(1)), 0 )
+
+    # Requesting without segment ID loads the remaining contours, which give the same result as the eager load
+    segmentationNode.InvokeEvent(vtkSlicerRtCommon.vtkSlicerRtCommon.SegmentDataRequested)
+    for index in range(segmentation.GetNumberOfSegments()):
+      self.assertEqual( getNumberOfContourPoints(segmentation.GetNthSegment(index)), expectedNumberOfContourPoints[index] )
+    self.assertEqual( computeIsodoseVolumeStatistics(segmentationNode), expectedStatistics )
+
+  #------------------------------------------------------------------------------
+  def TestSection_LoadRtImageLazily(self):
+    # slicer.util.delayDisplay("Load RT image lazily",self.delayMs)
+    logging.info("Load RT image lazily")
+    import vtkSlicerRtCommonPython as vtkSlicerRtCommon
+
+    vtkLoadables = self.getRtLoadables()
+
+    logic = slicer.modules.dicomrtimportexport.logic()
+
+    def getRtImageVolumeNode():
+      shNode = slicer.vtkMRMLSubjectHierarchyNode.GetSubjectHierarchyNode(slicer.mrmlScene)
+      for volumeNode in slicer.util.getNodesByClass('vtkMRMLScalarVolumeNode'):
+        itemID = shNode.GetItemByDataNode(volumeNode)
+        if shNode.GetItemAttribute(itemID, vtkSlicerRtCommon.vtkSlicerRtCommon.DICOMRTIMPORT_RTIMAGE_IDENTIFIER_ATTRIBUTE_NAME):
+          return volumeNode
+      return None
+
+    # Load the study with the pixels of the RT image
+    slicer.mrmlScene.Clear(0)
+    self.assertTrue( logic.LoadDicomRTStudy(vtkLoadables) )
+    rtImageVolumeNode = getRtImageVolumeNode()
+    self.assertIsNotNone( rtImageVolumeNode )
+    expectedIjkToRas = vtk.vtkMatrix4x4()
+    rtImageVolumeNode.GetIJKToRASMatrix(expectedIjkToRas)
+    expectedScalarRange = rtImageVolumeNode.GetImageData().GetScalarRange()
+    expectedDimensions = rtImageVolumeNode.GetImageData().GetDimensions()
+
+    # Load the study with deferred RT image pixels
+    slicer.mrmlScene.Clear(0)
+    logic.SetLazyRtImageLoading(True)
+    try:
+      self.assertTrue( logic.LoadDicomRTStudy(vtkLoadables) )
+    finally:
+      logic.SetLazyRtImageLoading(False)
+    rtImageVolumeNode = getRtImageVolumeNode()
+    self.assertIsNotNone( rtImageVolumeNode )
+
+    # Geometry is set up from the header, but the pixels are not loaded
+    ijkToRas = vtk.vtkMatrix4x4()
+    rtImageVolumeNode.GetIJKToRASMatrix(ijkToRas)
+    for row in range(4):
+      for column in range(4):
+        self.assertAlmostEqual( ijkToRas.GetElement(row, column), expectedIjkToRas.GetElement(row, column), places=3 )
+    self.assertEqual( rtImageVolumeNode.GetImageData().GetDimensions(), expectedDimensions )
+    self.assertEqual( rtImageVolumeNode.GetImageData().GetScalarRange(), (0.0, 0.0) )
+
+    # Pixels are loaded on request
+    rtImageVolumeNode.InvokeEvent(vtkSlicerRtCommon.vtkSlicerRtCommon.RtImageDataRequested)
+    self.assertEqual( rtImageVolumeNode.GetImageData().GetScalarRange(), expectedScalarRange )
+
+    # Pixels are loaded when the RT image is shown in a slice view
+    slicer.mrmlScene.Clear(0)
+    logic.SetLazyRtImageLoading(True)
+    try:
+      self.assertTrue( logic.LoadDicomRTStudy(vtkLoadables) )
+    finally:
+      logic.SetLazyRtImageLoading(False)
+    rtImageVolumeNode = getRtImageVolumeNode()
+    self.assertEqual( rtImageVolumeNode.GetImageData().GetScalarRange(), (0.0, 0.0) )
+    sliceCompositeNode = slicer.mrmlScene.GetFirstNodeByClass('vtkMRMLSliceCompositeNode')
+    self.assertIsNotNone( sliceCompositeNode )
+    sliceCompositeNode.SetBackgroundVolumeID(rtImageVolumeNode.GetID())
+    self.assertEqual( rtImageVolumeNode.GetImageData().GetScalarRange(), expectedScalarRange )
+
+  #------------------------------------------------------------------------------
+  def TestSection_LoadMultiFrameRtImage(self):
+    # slicer.util.delayDisplay("Load multi-frame RT image",self.delayMs)
+    logging.info("Load multi-frame RT image")
+    import numpy
+    import pydicom
+
+    # Create multi-frame RT image from the frames of the test RT image, shifted so that each frame is different
+    multiFrameDir = self.tempDir + '/MultiFrameRtImage'
+    if not os.access(multiFrameDir, os.F_OK):
+      os.makedirs(multiFrameDir)
+    dataset = pydicom.dcmread(self.dataDir + '/RI.1.2.246.352.71.3.2088656855.2381134.20110921150951.dcm')
+    singleFrame = dataset.pixel_array
+    numberOfFrames = 3
+    frames = [numpy.roll(singleFrame, frameIndex * 7, axis=1) for frameIndex in range(numberOfFrames)]
+    # Frames are read directly only if all allocated bits are stored and the pixel data is little endian
+    dataset.BitsStored = dataset.BitsAllocated
+    dataset.HighBit = dataset.BitsAllocated - 1
+    dataset.NumberOfFrames = numberOfFrames
+    dataset.PixelData = numpy.stack(frames).astype(singleFrame.dtype.newbyteorder('<')).tobytes()
+    dataset.SOPInstanceUID = pydicom.uid.generate_uid()
+    dataset.file_meta.MediaStorageSOPInstanceUID = dataset.SOPInstanceUID
+    dataset.file_meta.TransferSyntaxUID = pydicom.uid.ExplicitVRLittleEndian
+    dataset.is_little_endian = True
+    dataset.is_implicit_VR = False
+    multiFrameFilePath = multiFrameDir + '/RI.MultiFrame.dcm'
+    dataset.save_as(multiFrameFilePath)
+    rescaleSlope = float(dataset.get('RescaleSlope', 1.0))
+    rescaleIntercept = float(dataset.get('RescaleIntercept', 0.0))
+
+    # Load the multi-frame RT image with the plan, so that the RT image geometry is set up using the referenced beam
+    logic = slicer.modules.dicomrtimportexport.logic()
+    fileList = vtk.vtkStringArray()
+    fileList.InsertNextValue(self.dataDir + '/RP.1.2.246.352.71.5.2088656855.377401.20110920153647.dcm')
+    fileList.InsertNextValue(multiFrameFilePath)
+    vtkLoadables = vtk.vtkCollection()
+    logic.ExamineForLoad(fileList, vtkLoadables)
+    self.assertEqual( vtkLoadables.GetNumberOfItems(), 2 )
+    slicer.mrmlScene.Clear(0)
+    self.assertTrue( logic.LoadDicomRTStudy(vtkLoadables) )
+
+    browserNode = slicer.util.getNode('*_SequenceBrowser')
+    rtImageVolumeNode = browserNode.GetNodeReference('frameSequenceRtImageRef')
+    self.assertIsNotNone( rtImageVolumeNode )
+    framesVolumeNode = rtImageVolumeNode.GetNodeReference('rtImageFramesVolumeRef')
+    self.assertIsNotNone( framesVolumeNode )
+    self.assertEqual( browserNode.GetMasterSequenceNode().GetNumberOfDataNodes(), numberOfFrames )
+
+    # Frames are in the geometry of the RT image, which is set up after the frames are loaded
+    self.assertGreater( len( slicer.util.getNodes('vtkMRMLPlanarImageNode*') ), 0 )
+    ijkToRas = vtk.vtkMatrix4x4()
+    rtImageVolumeNode.GetIJKToRASMatrix(ijkToRas)
+    framesIjkToRas = vtk.vtkMatrix4x4()
+    framesVolumeNode.GetIJKToRASMatrix(framesIjkToRas)
+    for row in range(4):
+      for column in range(4):
+        self.assertAlmostEqual( framesIjkToRas.GetElement(row, column), ijkToRas.GetElement(row, column), places=6 )
+
+    # Selecting a frame in the browser shows its pixels in the RT image
+    for frameIndex in [0, 2, 1, 0]:
+      browserNode.SetSelectedItemNumber(frameIndex)
+      self.assertEqual( rtImageVolumeNode.GetAttribute('DicomRtImport.RtImageFrameIndex'), str(frameIndex) )
+      expectedPixels = frames[frameIndex] * rescaleSlope + rescaleIntercept
+      pixels = slicer.util.arrayFromVolume(rtImageVolumeNode)
+      self.assertEqual( pixels.shape, (1,) + expectedPixels.shape )
+      self.assertTrue( numpy.allclose(pixels[0], expectedPixels) )
+
+  #------------------------------------------------------------------------------
+  def TestSection_LoadRtDoseVoxels(self):
+    # slicer.util.delayDisplay("Load RT dose voxels",self.delayMs)
+    logging.info("Load RT dose voxels")
+    import numpy
+    import pydicom
+    import vtkSlicerRtCommonPython as vtkSlicerRtCommon
+
+    doseFilePath = self.dataDir + '/RD.1.2.246.352.71.7.2088656855.452083.20110920153746.dcm'
+
+    # Load the dose with the RT importer, which decodes and scales the voxels itself
+    logic = slicer.modules.dicomrtimportexport.logic()
+    fileList = vtk.vtkStringArray()
+    fileList.InsertNextValue(doseFilePath)
+    vtkLoadables = vtk.vtkCollection()
+    logic.ExamineForLoad(fileList, vtkLoadables)
+    self.assertEqual( vtkLoadables.GetNumberOfItems(), 1 )
+    slicer.mrmlScene.Clear(0)
+    self.assertTrue( logic.LoadDicomRTStudy(vtkLoadables) )
+    doseVolumeNodes = [volumeNode for volumeNode in slicer.util.getNodesByClass('vtkMRMLScalarVolumeNode')
+      if volumeNode.GetAttribute(vtkSlicerRtCommon.vtkSlicerRtCommon.DICOMRTIMPORT_DOSE_VOLUME_IDENTIFIER_ATTRIBUTE_NAME)]
+    self.assertEqual( len(doseVolumeNodes), 1 )
+    doseVolumeNode = doseVolumeNodes[0]
+
+    # Reference: generic volume reader with the pixel spacing and the dose grid scaling applied, as the dose was loaded before
+    dataset = pydicom.dcmread(doseFilePath, stop_before_pixels=True)
+    referenceVolumeNode = slicer.mrmlScene.AddNewNodeByClass('vtkMRMLScalarVolumeNode', 'GenericReaderDose')
+    storageNode = slicer.vtkMRMLVolumeArchetypeStorageNode()
+    storageNode.SetFileName(doseFilePath)
+    storageNode.ResetFileNameList()
+    storageNode.SetSingleFile(1)
+    self.assertTrue( storageNode.ReadData(referenceVolumeNode) )
+    referenceSpacing = referenceVolumeNode.GetSpacing()
+    referenceVolumeNode.SetSpacing(float(dataset.PixelSpacing[1]), float(dataset.PixelSpacing[0]), referenceSpacing[2])
+
+    ijkToRas = vtk.vtkMatrix4x4()
+    doseVolumeNode.GetIJKToRASMatrix(ijkToRas)
+    referenceIjkToRas = vtk.vtkMatrix4x4()
+    referenceVolumeNode.GetIJKToRASMatrix(referenceIjkToRas)
+    for row in range(4):
+      for column in range(4):
+        self.assertAlmostEqual( ijkToRas.GetElement(row, column), referenceIjkToRas.GetElement(row, column), places=4 )
+
+    doseVoxels = slicer.util.arrayFromVolume(doseVolumeNode)
+    expectedDoseVoxels = slicer.util.arrayFromVolume(referenceVolumeNode).astype(numpy.float64) * float(dataset.DoseGridScaling)
+    self.assertEqual( doseVoxels.dtype, numpy.float32 )
+    self.assertEqual( doseVoxels.shape, expectedDoseVoxels.shape )
+    self.assertGreater( expectedDoseVoxels.max(), 0.0 )
+    self.assertTrue( numpy.allclose(doseVoxels, expectedDoseVoxels, rtol=1e-6, atol=1e-6 * expectedDoseVoxels.max()) )
+
+    slicer.mrmlScene.RemoveNode(referenceVolumeNode)
+
+  #------------------------------------------------------------------------------
+  def TestSection_LoadDynamicBeam(self):
+    # slicer.util.delayDisplay("Load dynamic beam",self.delayMs)
+    logging.info("Load dynamic beam")
+    import copy
+    import glob
+    import pydicom
+
+    # Create plan with a dynamic first beam from the test plan. Each control point has different angles, jaws and MLC positions
+    dynamicPlanDir = self.tempDir + '/DynamicBeamPlan'
+    if not os.access(dynamicPlanDir, os.F_OK):
+      os.makedirs(dynamicPlanDir)
+    dataset = pydicom.dcmread(self.dataDir + '/RP.1.2.246.352.71.5.2088656855.377401.20110920153647.dcm')
+    beam = dataset.BeamSequence[0]
+    beam.BeamType = 'DYNAMIC'
+    leafPositionBoundaries = [-20.0, -10.0, 0.0, 10.0, 20.0]
+    numberOfLeafPairs = len(leafPositionBoundaries) - 1
+    beamLimitingDevices = []
+    for deviceType, numberOfPairs in [('ASYMX', 1), ('ASYMY', 1), ('MLCX', numberOfLeafPairs)]:
+      device = pydicom.Dataset()
+      device.RTBeamLimitingDeviceType = deviceType
+      device.NumberOfLeafJawPairs = numberOfPairs
+      if deviceType == 'MLCX':
+        device.LeafPositionBoundaries = leafPositionBoundaries
+      beamLimitingDevices.append(device)
+    beam.BeamLimitingDeviceSequence = pydicom.Sequence(beamLimitingDevices)
+
+    numberOfControlPoints = 5
+    firstControlPoint = beam.ControlPointSequence[0]
+    finalMetersetWeight = float(beam.get('FinalCumulativeMetersetWeight', 1.0))
+    expectedControlPoints = []
+    controlPoints = []
+    for index in range(numberOfControlPoints):
+      gantryAngle = (float(firstControlPoint.GantryAngle) + 10.0 * index) % 360.0
+      collimatorAngle = 5.0 * index
+      couchAngle = float(firstControlPoint.get('PatientSupportAngle', 0.0))
+      jawPositions = [-50.0 - index, 50.0 + index, -40.0 + index, 40.0 - index]
+      leafPositions = [-10.0 - index - leaf for leaf in range(numberOfLeafPairs)] + [10.0 + index + leaf for leaf in range(numberOfLeafPairs)]
+      controlPoint = copy.deepcopy(firstControlPoint)
+      controlPoint.ControlPointIndex = index
+      controlPoint.GantryAngle = gantryAngle
+      controlPoint.BeamLimitingDeviceAngle = collimatorAngle
+      controlPoint.PatientSupportAngle = couchAngle
+      controlPoint.CumulativeMetersetWeight = finalMetersetWeight * index / (numberOfControlPoints - 1)
+      devicePositions = []
+      for deviceType, positions in [('ASYMX', jawPositions[0:2]), ('ASYMY', jawPositions[2:4]), ('MLCX', leafPositions)]:
+        devicePosition = pydicom.Dataset()
+        devicePosition.RTBeamLimitingDeviceType = deviceType
+        devicePosition.LeafJawPositions = positions
+        devicePositions.append(devicePosition)
+      controlPoint.BeamLimitingDevicePositionSequence = pydicom.Sequence(devicePositions)
+      controlPoints.append(controlPoint)
+      expectedControlPoints.append((gantryAngle, collimatorAngle, couchAngle, jawPositions, leafPositions))
+    beam.ControlPointSequence = pydicom.Sequence(controlPoints)
+    beam.NumberOfControlPoints = numberOfControlPoints
+    dataset.SOPInstanceUID = pydicom.uid.generate_uid()
+    dataset.file_meta.MediaStorageSOPInstanceUID = dataset.SOPInstanceUID
+    dynamicPlanFilePath = dynamicPlanDir + '/RP.Dynamic.dcm'
+    dataset.save_as(dynamicPlanFilePath)
+
+    def getControlPointBrowserAndBeam():
+      for browserNode in slicer.util.getNodesByClass('vtkMRMLSequenceBrowserNode'):
+        beamNode = browserNode.GetNodeReference('controlPointBeamRef')
+        if beamNode:
+          return browserNode, beamNode
+      return None, None
+
+    def verifyControlPointBrowsing(browserNode, beamNode):
+      self.assertEqual( beamNode.GetNumberOfControlPoints(), numberOfControlPoints )
+      for index in [3, 1, 4, 0, 2]:
+        browserNode.SetSelectedItemNumber(index)
+        self.assertEqual( beamNode.GetCurrentControlPointIndex(), index )
+        gantryAngle, collimatorAngle, couchAngle, jawPositions, leafPositions = expectedControlPoints[index]
+        self.assertAlmostEqual( beamNode.GetGantryAngle(), gantryAngle, places=3 )
+        self.assertAlmostEqual( beamNode.GetCollimatorAngle(), collimatorAngle, places=3 )
+        self.assertAlmostEqual( beamNode.GetCouchAngle(), couchAngle, places=3 )
+        self.assertAlmostEqual( beamNode.GetX1Jaw(), jawPositions[0], places=3 )
+        self.assertAlmostEqual( beamNode.GetX2Jaw(), jawPositions[1], places=3 )
+        self.assertAlmostEqual( beamNode.GetY1Jaw(), jawPositions[2], places=3 )
+        self.assertAlmostEqual( beamNode.GetY2Jaw(), jawPositions[3], places=3 )
+        mlcTable = beamNode.GetMultiLeafCollimatorTableNode().GetTable()
+        for leafPair in range(numberOfLeafPairs):
+          self.assertAlmostEqual( mlcTable.GetValue(leafPair, 1).ToDouble(), leafPositions[leafPair], places=3 )
+          self.assertAlmostEqual( mlcTable.GetValue(leafPair, 2).ToDouble(), leafPositions[numberOfLeafPairs + leafPair], places=3 )
+
+    # Load the plan. The dynamic beam is one beam node, and its control points are applied when browsed
+    logic = slicer.modules.dicomrtimportexport.logic()
+    fileList = vtk.vtkStringArray()
+    fileList.InsertNextValue(dynamicPlanFilePath)
+    vtkLoadables = vtk.vtkCollection()
+    logic.ExamineForLoad(fileList, vtkLoadables)
+    self.assertEqual( vtkLoadables.GetNumberOfItems(), 1 )
+    slicer.mrmlScene.Clear(0)
+    self.assertTrue( logic.LoadDicomRTStudy(vtkLoadables) )
+    self.assertEqual( len( slicer.util.getNodes('vtkMRMLRTBeamNode*') ), len(dataset.BeamSequence) )
+    browserNode, beamNode = getControlPointBrowserAndBeam()
+    self.assertIsNotNone( browserNode )
+    verifyControlPointBrowsing(browserNode, beamNode)
+
+    # Save the scene and load it again. The control point arrays are restored from the scene file,
+    # and the browser loaded with the scene applies them to the beam
+    sceneDir = self.tempDir + '/DynamicBeamScene'
+    if not os.access(sceneDir, os.F_OK):
+      os.makedirs(sceneDir)
+    for fileName in glob.glob(sceneDir + '/*.mrml'):
+      os.remove(fileName)
+    self.assertTrue( slicer.app.applicationLogic().SaveSceneToSlicerDataBundleDirectory(sceneDir, None) )
+    sceneFiles = glob.glob(sceneDir + '/*.mrml')
+    self.assertEqual( len(sceneFiles), 1 )
+    slicer.mrmlScene.Clear(0)
+    slicer.util.loadScene(sceneFiles[0])
+    browserNode, beamNode = getControlPointBrowserAndBeam()
+    self.assertIsNotNone( browserNode )
+    for index in range(numberOfControlPoints):
+      gantryAngle, collimatorAngle, couchAngle = vtk.mutable(0.0), vtk.mutable(0.0), vtk.mutable(0.0)
+      jawPositions = [0.0, 0.0, 0.0, 0.0]
+      cumulativeMetersetWeight = vtk.mutable(0.0)
+      self.assertTrue( beamNode.GetControlPoint(index, gantryAngle, collimatorAngle, couchAngle, jawPositions, cumulativeMetersetWeight) )
+      self.assertAlmostEqual( float(gantryAngle), expectedControlPoints[index][0], places=3 )
+      self.assertAlmostEqual( float(collimatorAngle), expectedControlPoints[index][1], places=3 )
+      for jawIndex in range(4):
+        self.assertAlmostEqual( jawPositions[jawIndex], expectedControlPoints[index][3][jawIndex], places=3 )
+      self.assertAlmostEqual( float(cumulativeMetersetWeight), finalMetersetWeight * index / (numberOfControlPoints - 1), places=3 )
+    verifyControlPointBrowsing(browserNode, beamNode)
+
+  #------------------------------------------------------------------------------
+  def TestSection_MergeStructureSet(self):
+    # slicer.util.delayDisplay("Merge structure set",self.delayMs)
+    logging.info("Merge structure set")
+    import vtkSlicerRtCommonPython as vtkSlicerRtCommon
+    contourHashTagName = vtkSlicerRtCommon.vtkSlicerRtCommon.DICOMRTIMPORT_ROI_CONTOUR_HASH_SEGMENT_TAG_NAME
+
+    vtkLoadables = self.getRtLoadables()
+
+    logic = slicer.modules.dicomrtimportexport.logic()
+
+    def getContourHash(segment):
+      contourHash = vtk.mutable('')
+      segment.GetTag(contourHashTagName, contourHash)
+      return str(contourHash)
+
+    # Load the study, and simulate a change in the contours of the first segment
+    slicer.mrmlScene.Clear(0)
+    self.assertTrue( logic.LoadDicomRTStudy(vtkLoadables) )
+    segmentationNode = slicer.util.getNode('vtkMRMLSegmentationNode*')
+    segmentation = segmentationNode.GetSegmentation()
+    segmentIDs = vtk.vtkStringArray()
+    segmentation.GetSegmentIDs(segmentIDs)
+    self.assertGreater( segmentIDs.GetNumberOfValues(), 1 )
+    segmentIDList = [segmentIDs.GetValue(index) for index in range(segmentIDs.GetNumberOfValues())]
+    for segmentID in segmentIDList:
+      self.assertNotEqual( getContourHash(segmentation.GetSegment(segmentID)), '' )
+    changedSegmentID = segmentIDList[0]
+    contourHash = getContourHash(segmentation.GetSegment(changedSegmentID))
+    segmentation.GetSegment(changedSegmentID).SetTag(contourHashTagName, 'changed')
+    segments = [segmentation.GetSegment(segmentID) for segmentID in segmentIDList]
+
+    # Add a segment that was not loaded from the structure set
+    userSegmentID = segmentation.AddEmptySegment('UserSegment')
+
+    # Load the study again merging the structure set into the segmentation
+    logic.SetMergeStructureSetSegments(True)
+    try:
+      self.assertTrue( logic.LoadDicomRTStudy(vtkLoadables) )
+    finally:
+      logic.SetMergeStructureSetSegments(False)
+    self.assertEqual( len( slicer.util.getNodes('vtkMRMLSegmentationNode*') ), 1 )
+    self.assertEqual( segmentation.GetNumberOfSegments(), len(segmentIDList) + 1 )
+    self.assertIsNotNone( segmentation.GetSegment(userSegmentID) )
+
+    # Only the changed segment is rebuilt, in place
+    self.assertEqual( segmentation.GetNthSegmentID(0), changedSegmentID )
+    self.assertNotEqual( segmentation.GetSegment(changedSegmentID), segments[0] )
+    self.assertEqual( getContourHash(segmentation.GetSegment(changedSegmentID)), contourHash )
+    for segmentID, segment in zip(segmentIDList[1:], segments[1:]):
+      self.assertEqual( segmentation.GetSegment(segmentID), segment )
+
+    # A structure set with a different label is not a revision of the loaded one, so it is not merged
+    shNode = slicer.vtkMRMLSubjectHierarchyNode.GetSubjectHierarchyNode(slicer.mrmlScene)
+    shNode.SetItemAttribute(shNode.GetItemByDataNode(segmentationNode),
+      vtkSlicerRtCommon.vtkSlicerRtCommon.DICOMRTIMPORT_STRUCTURE_SET_LABEL_ATTRIBUTE_NAME, 'OtherStructureSet')
+    logic.SetMergeStructureSetSegments(True)
+    try:
+      self.assertTrue( logic.LoadDicomRTStudy(vtkLoadables) )
+    finally:
+      logic.SetMergeStructureSetSegments(False)
+    self.assertEqual( len( slicer.util.getNodes('vtkMRMLSegmentationNode*') ), 2 )
+    self.assertEqual( segmentation.GetNumberOfSegments(), len(segmentIDList) + 1 )
+
   #------------------------------------------------------------------------------
   def TestSection_ClearDatabase(self):
     # slicer.util.delayDisplay("Clear database",self.delayMs)
@@ -189,3 +689,18 @@ class DicomRtImportTest(unittest.TestCase):
     logging.info("Restoring original database directory")
     if self.originalDatabaseDirectory:
       slicer.dicomDatabase.openDatabase(self.originalDatabaseDirectory)
+
+  #------------------------------------------------------------------------------
+  def getRtLoadables(self):
+    """Get the RT loadables examined by the DICOM browser as a collection of VTK loadables
+    """
+    vtkLoadables = vtk.vtkCollection()
+    loadablesByPlugin = self.dicomWidget.browserWidget.loadablesByPlugin
+    for plugin in loadablesByPlugin:
+      if plugin.loadType != 'RT':
+        continue
+      for loadable in loadablesByPlugin[plugin]:
+        vtkLoadable = slicer.vtkSlicerDICOMLoadable()
+        loadable.copyToVtkLoadable(vtkLoadable)
+        vtkLoadables.AddItem(vtkLoadable)
+    return vtkLoadables
@@ -29,6 +29,7 @@
 // VTK includes
 #include <vtkObjectFactory.h>
 #include <vtkSmartPointer.h>
+#include <vtkStringArray.h>
 
 // STD includes
 #include <sstream>
@@ -46,6 +47,7 @@ vtkMRMLNodeNewMacro(vtkMRMLDoseComparisonNode);
 vtkMRMLDoseComparisonNode::vtkMRMLDoseComparisonNode()
 {
   this->MaskSegmentID = nullptr;
+  this->SelectedSegmentIDs.clear();
   this->DtaDistanceToleranceMm = 3.0;
   this->DoseDifferenceTolerancePercent = 3.0;
   this->ReferenceDoseGy = 50.0;
@@ -58,6 +60,8 @@ vtkMRMLDoseComparisonNode::vtkMRMLDoseComparisonNode()
   this->ResultsValid = false;
   this->ReportString = nullptr;
   this->LocalDoseDifference = false;
+  this->ComputePerSegmentPassRates = false;
+  this->SegmentPassFractionsPercent.clear();
 
   this->HideFromEditors = false;
 }
@@ -66,6 +70,8 @@ vtkMRMLDoseComparisonNode::vtkMRMLDoseComparisonNode()
 vtkMRMLDoseComparisonNode::~vtkMRMLDoseComparisonNode()
 {
   this->SetMaskSegmentID(nullptr);
+  this->SelectedSegmentIDs.clear();
+  this->SegmentPassFractionsPercent.clear();
 }
 
 //----------------------------------------------------------------------------
@@ -75,6 +81,12 @@ void vtkMRMLDoseComparisonNode::WriteXML(ostream& of, int nIndent)
 
   // Write all MRML node attributes into output stream
   of << " MaskSegmentID=\"" << (this->MaskSegmentID ? this->MaskSegmentID : "nullptr") << "\"";
+  of << " SelectedSegmentIDs=\"";
+  for (std::vector<std::string>::iterator it = this->SelectedSegmentIDs.begin(); it != this->SelectedSegmentIDs.end(); ++it)
+    {
+    of << (*it) << "|";
+    }
+  of << "\"";
   of << " DtaDistanceToleranceMm=\"" << this->DtaDistanceToleranceMm << "\"";
   of << " DoseDifferenceTolerancePercent=\"" << this->DoseDifferenceTolerancePercent << "\"";
   of << " ReferenceDoseGy=\"" << this->ReferenceDoseGy << "\"";
@@ -84,6 +96,7 @@ void vtkMRMLDoseComparisonNode::WriteXML(ostream& of, int nIndent)
   of << " UseGeometricGammaCalculation=\"" << (this->UseGeometricGammaCalculation ? "true" : "false") << "\"";
   of << " LocalDoseDifference=\"" << (this->LocalDoseDifference ? "true" : "false") << "\"";
   of << " DoseThresholdOnReferenceOnly=\"" << (this->DoseThresholdOnReferenceOnly ? "true" : "false") << "\"";
+  of << " ComputePerSegmentPassRates=\"" << (this->ComputePerSegmentPassRates ? "true" : "false") << "\"";
   of << " PassFractionPercent=\"" << this->PassFractionPercent << "\"";
   of << " ResultsValid=\"" << (this->ResultsValid ? "true" : "false") << "\"";
   of << " ReportString=\"" << (this->ReportString ? this->ReportString : "") << "\"";
@@ -107,6 +120,24 @@ void vtkMRMLDoseComparisonNode::ReadXMLAttributes(const char** atts)
       {
       this->SetMaskSegmentID(vtkVariant(attValue).ToString());
       }
+    else if (!strcmp(attName, "SelectedSegmentIDs"))
+      {
+      std::string valueStr(attValue);
+      std::string separatorCharacter("|");
+
+      this->SelectedSegmentIDs.clear();
+      size_t separatorPosition = valueStr.find( separatorCharacter );
+      while (separatorPosition != std::string::npos)
+        {
+        this->SelectedSegmentIDs.push_back(valueStr.substr(0, separatorPosition));
+        valueStr = valueStr.substr( separatorPosition+1 );
+        separatorPosition = valueStr.find( separatorCharacter );
+        }
+      if (!valueStr.empty())
+        {
+        this->SelectedSegmentIDs.push_back(valueStr);
+        }
+      }
     else if (!strcmp(attName, "DtaDistanceToleranceMm"))
       {
       this->DtaDistanceToleranceMm = vtkVariant(attValue).ToDouble();
@@ -143,6 +174,10 @@ void vtkMRMLDoseComparisonNode::ReadXMLAttributes(const char** atts)
       {
       this->DoseThresholdOnReferenceOnly = (strcmp(attValue,"true") ? false : true);
       }
+    else if (!strcmp(attName, "ComputePerSegmentPassRates"))
+      {
+      this->ComputePerSegmentPassRates = (strcmp(attValue,"true") ? false : true);
+      }
     else if (!strcmp(attName, "PassFractionPercent"))
       {
       this->PassFractionPercent = vtkVariant(attValue).ToDouble();
@@ -153,7 +188,7 @@ void vtkMRMLDoseComparisonNode::ReadXMLAttributes(const char** atts)
       }
     }
 
-  // Note: ReportString is not read from XML, it is a strictly temporary value
+  // Note: ReportString and per-segment pass fractions are not read from XML, they are strictly temporary values
 }
 
 //----------------------------------------------------------------------------
@@ -167,6 +202,7 @@ void vtkMRMLDoseComparisonNode::Copy(vtkMRMLNode *anode)
   vtkMRMLDoseComparisonNode *node = (vtkMRMLDoseComparisonNode *) anode;
 
   this->SetMaskSegmentID(node->MaskSegmentID);
+  this->SelectedSegmentIDs = node->SelectedSegmentIDs;
   this->DtaDistanceToleranceMm = node->DtaDistanceToleranceMm;
   this->DoseDifferenceTolerancePercent = node->DoseDifferenceTolerancePercent;
   this->ReferenceDoseGy = node->ReferenceDoseGy;
@@ -177,6 +213,8 @@ void vtkMRMLDoseComparisonNode::Copy(vtkMRMLNode *anode)
   this->UseGeometricGammaCalculation = node->UseGeometricGammaCalculation;
   this->LocalDoseDifference = node->LocalDoseDifference;
   this->DoseThresholdOnReferenceOnly = node->DoseThresholdOnReferenceOnly;
+  this->ComputePerSegmentPassRates = node->ComputePerSegmentPassRates;
+  this->SegmentPassFractionsPercent = node->SegmentPassFractionsPercent;
   this->ResultsValid = node->ResultsValid;
   this->ReportString = node->ReportString;
 
@@ -190,6 +228,12 @@ void vtkMRMLDoseComparisonNode::PrintSelf(ostream& os, vtkIndent indent)
   Superclass::PrintSelf(os,indent);
 
   os << indent << "MaskSegmentID:   " << (this->MaskSegmentID ? this->MaskSegmentID : "nullptr") << "\n";
+  os << indent << "SelectedSegmentIDs:   ";
+  for (std::vector<std::string>::iterator it = this->SelectedSegmentIDs.begin(); it != this->SelectedSegmentIDs.end(); ++it)
+    {
+    os << (*it) << "|";
+    }
+  os << "\n";
   os << indent << "DtaDistanceToleranceMm:   " << this->DtaDistanceToleranceMm << "\n";
   os << indent << "DoseDifferenceTolerancePercent:   " << this->DoseDifferenceTolerancePercent << "\n";
   os << indent << "ReferenceDoseGy:   " << this->ReferenceDoseGy << "\n";
@@ -199,7 +243,14 @@ void vtkMRMLDoseComparisonNode::PrintSelf(ostream& os, vtkIndent indent)
   os << indent << "UseGeometricGammaCalculation:   " << (this->UseGeometricGammaCalculation ? "true" : "false") << "\n";
   os << indent << "LocalDoseDifference:   " << (this->LocalDoseDifference ? "true" : "false") << "\n";
   os << indent << "DoseThresholdOnReferenceOnly:   " << (this->DoseThresholdOnReferenceOnly ? "true" : "false") << "\n";
+  os << indent << "ComputePerSegmentPassRates:   " << (this->ComputePerSegmentPassRates ? "true" : "false") << "\n";
   os << indent << "PassFractionPercent:   " << this->PassFractionPercent << "\n";
+  os << indent << "SegmentPassFractionsPercent:   ";
+  for (std::map<std::string, double>::iterator it = this->SegmentPassFractionsPercent.begin(); it != this->SegmentPassFractionsPercent.end(); ++it)
+    {
+    os << it->first << "=" << it->second << " ";
+    }
+  os << "\n";
   os << indent << "ResultsValid:   " << (this->ResultsValid ? "true" : "false") << "\n";
   os << indent << "ReportString:   " << (this->ReportString ? this->ReportString : "") << "\n";
 }
@@ -275,3 +326,59 @@ void vtkMRMLDoseComparisonNode::SetAndObserveGammaVolumeNode(vtkMRMLScalarVolume
 
   this->SetNodeReferenceID(GAMMA_VOLUME_REFERENCE_ROLE, (node ? node->GetID() : nullptr));
 }
+
+//----------------------------------------------------------------------------
+void vtkMRMLDoseComparisonNode::GetSelectedSegmentIDs(std::vector<std::string> &selectedSegmentIDs)
+{
+  selectedSegmentIDs = this->SelectedSegmentIDs;
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLDoseComparisonNode::SetSelectedSegmentIDs(std::vector<std::string> selectedSegmentIDs)
+{
+  this->SelectedSegmentIDs = selectedSegmentIDs;
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLDoseComparisonNode::ClearSegmentPassFractions()
+{
+  this->SegmentPassFractionsPercent.clear();
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLDoseComparisonNode::SetSegmentPassFractionPercent(std::string segmentID, double passFractionPercent)
+{
+  this->SegmentPassFractionsPercent[segmentID] = passFractionPercent;
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLDoseComparisonNode::GetSegmentPassFractionsPercent(std::map<std::string, double> &passFractions)
+{
+  passFractions = this->SegmentPassFractionsPercent;
+}
+
+//----------------------------------------------------------------------------
+double vtkMRMLDoseComparisonNode::GetSegmentPassFractionPercent(std::string segmentID)
+{
+  std::map<std::string, double>::iterator passFractionIt = this->SegmentPassFractionsPercent.find(segmentID);
+  if (passFractionIt == this->SegmentPassFractionsPercent.end())
+    {
+    return -1.0;
+    }
+  return passFractionIt->second;
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLDoseComparisonNode::GetSegmentPassFractionSegmentIDs(vtkStringArray* segmentIDs)
+{
+  if (!segmentIDs)
+    {
+    return;
+    }
+  segmentIDs->Initialize();
+  std::map<std::string, double>::iterator passFractionIt;
+  for (passFractionIt = this->SegmentPassFractionsPercent.begin(); passFractionIt != this->SegmentPassFractionsPercent.end(); ++passFractionIt)
+    {
+    segmentIDs->InsertNextValue(passFractionIt->first.c_str());
+    }
+}
@@ -28,11 +28,13 @@
 // STD includes
 #include <vector>
 #include <set>
+#include <map>
 
 #include "vtkSlicerDoseComparisonModuleLogicExport.h"
 
 class vtkMRMLScalarVolumeNode;
 class vtkMRMLSegmentationNode;
+class vtkStringArray;
 
 /// \ingroup SlicerRt_QtModules_DoseComparison
 class VTK_SLICER_DOSECOMPARISON_LOGIC_EXPORT vtkMRMLDoseComparisonNode : public vtkMRMLNode
@@ -83,6 +85,23 @@ public:
   /// Set mask segment ID
   vtkSetStringMacro(MaskSegmentID);
 
+  /// Get selected segment IDs for per-segment pass rate computation
+  void GetSelectedSegmentIDs(std::vector<std::string> &selectedSegmentIDs);
+  /// Set selected segment IDs for per-segment pass rate computation
+  void SetSelectedSegmentIDs(std::vector<std::string> selectedSegmentIDs);
+
+  /// Clear per-segment pass fractions map
+  void ClearSegmentPassFractions();
+  /// Set pass fraction for a segment in percent
+  void SetSegmentPassFractionPercent(std::string segmentID, double passFractionPercent);
+  /// Get per-segment pass fractions map
+  void GetSegmentPassFractionsPercent(std::map<std::string, double> &passFractions);
+  /// Get pass fraction for a given segment in percent
+  /// \return Pass fraction, -1 if not computed for the segment or no voxels were analyzed in it
+  double GetSegmentPassFractionPercent(std::string segmentID);
+  /// Get IDs of segments for which pass fraction has been computed (python accessor)
+  void GetSegmentPassFractionSegmentIDs(vtkStringArray* segmentIDs);
+
   /// Get distance to agreement (DTA) tolerance, in mm
   vtkGetMacro(DtaDistanceToleranceMm, double);
   /// Set distance to agreement (DTA) tolerance, in mm
@@ -136,6 +155,13 @@ public:
   /// Set local dose difference flag
   vtkBooleanMacro(LocalDoseDifference, bool);
 
+  /// Get per-segment pass rates flag
+  vtkGetMacro(ComputePerSegmentPassRates, bool);
+  /// Set per-segment pass rates flag
+  vtkSetMacro(ComputePerSegmentPassRates, bool);
+  /// Set per-segment pass rates flag
+  vtkBooleanMacro(ComputePerSegmentPassRates, bool);
+
   /// Get valid flag
   vtkGetMacro(ResultsValid, bool);
   /// Set valid flag
@@ -163,6 +189,10 @@ protected:
   /// Mask segment ID in mask segmentation node
   char* MaskSegmentID;
 
+  /// Segments for which pass rates are computed in per-segment mode.
+  /// Gamma is computed once over the union of these segments. All segments are used if empty.
+  std::vector<std::string> SelectedSegmentIDs;
+
   /// Distance to agreement (DTA) tolerance, in mm
   double DtaDistanceToleranceMm;
 
@@ -200,9 +230,17 @@ protected:
   /// Default value is false, meaning that both images will be used
   bool DoseThresholdOnReferenceOnly;
 
+  /// Flag determining whether gamma is computed over the union of the selected segments of the
+  /// mask segmentation, and pass rates are reported for each segment. Off by default, in which case
+  /// the single mask segment is used
+  bool ComputePerSegmentPassRates;
+
   /// Percentage of voxels that passed (output)
   double PassFractionPercent;
 
+  /// Percentage of analyzed voxels that passed within each selected segment (output)
+  std::map<std::string, double> SegmentPassFractionsPercent;
+
   /// Flag indicating if the results are valid
   bool ResultsValid;
 
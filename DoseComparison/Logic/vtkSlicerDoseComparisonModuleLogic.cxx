@@ -52,12 +52,20 @@
 
 // VTK includes
 #include <vtkNew.h>
+#include <vtkGeneralTransform.h>
 #include <vtkTimerLog.h>
 #include <vtkLookupTable.h>
 #include <vtkImageConstantPad.h>
+#include <vtkImageData.h>
+#include <vtkImageAccumulate.h>
+#include <vtkImageToImageStencil.h>
+#include <vtkImageStencilData.h>
 #include <vtkObjectFactory.h>
 #include "vtksys/SystemTools.hxx"
 
+// STD includes
+#include <algorithm>
+
 // SlicerBase includes
 #include "vtkSlicerApplicationLogic.h"
 
@@ -207,7 +215,29 @@ std::string vtkSlicerDoseComparisonModuleLogic::ComputeGammaDoseDifference(vtkMR
   Plm_image::Pointer maskVolume;
   vtkMRMLSegmentationNode* maskSegmentationNode = parameterNode->GetMaskSegmentationNode();
   const char* maskSegmentID = parameterNode->GetMaskSegmentID();
-  if (maskSegmentationNode && maskSegmentID)
+  bool computePerSegmentPassRates = (maskSegmentationNode && parameterNode->GetComputePerSegmentPassRates());
+  std::map<std::string, vtkSmartPointer<vtkOrientedImageData> > segmentLabelmaps;
+  parameterNode->ClearSegmentPassFractions();
+  if (computePerSegmentPassRates)
+  {
+    // Use the union of the selected segments as mask, so that gamma only needs to be computed once
+    vtkSmartPointer<vtkOrientedImageData> unionLabelmap = vtkSmartPointer<vtkOrientedImageData>::New();
+    std::string errorMessage = this->CreateSegmentLabelmapsInReferenceGeometry(parameterNode, segmentLabelmaps, unionLabelmap);
+    if (!errorMessage.empty())
+    {
+      vtkErrorMacro("ComputeGammaDoseDifference: " << errorMessage);
+      return errorMessage;
+    }
+
+    maskVolume = PlmCommon::ConvertVtkOrientedImageDataToPlmImage(unionLabelmap);
+    if (!maskVolume)
+    {
+      errorMessage = "Failed to convert union of mask segment labelmaps into Plm_image";
+      vtkErrorMacro("ComputeGammaDoseDifference: " << errorMessage);
+      return errorMessage;
+    }
+  }
+  else if (maskSegmentationNode && maskSegmentID)
   {
     // Extract a labelmap for the dose comparison to use it as a mask
     vtkSegmentation* maskSegmentation = maskSegmentationNode->GetSegmentation();
@@ -263,7 +293,7 @@ std::string vtkSlicerDoseComparisonModuleLogic::ComputeGammaDoseDifference(vtkMR
   Gamma_dose_comparison gamma;
   gamma.set_reference_image(referenceDose->itk_float());
   gamma.set_compare_image(compareDose->itk_float());
-  if (maskSegmentationNode && maskSegmentID)
+  if (maskVolume)
   {
     gamma.set_mask_image(maskVolume->itk_uchar());
   }
@@ -287,6 +317,28 @@ std::string vtkSlicerDoseComparisonModuleLogic::ComputeGammaDoseDifference(vtkMR
   parameterNode->SetPassFractionPercent( gamma.get_pass_fraction() * 100.0 );
   parameterNode->SetReportString(gamma.get_report_string().c_str());
 
+  // Bin pass/fail voxels of the single gamma run per segment
+  double checkpointSegmentPassRatesStart = timer->GetUniversalTime();
+  if (computePerSegmentPassRates)
+  {
+    vtkSmartPointer<vtkImageData> passImage = vtkSmartPointer<vtkImageData>::New();
+    vtkSmartPointer<vtkImageData> failImage = vtkSmartPointer<vtkImageData>::New();
+    if ( !vtkSlicerRtCommon::ConvertItkImageToVtkImageData<unsigned char>(gamma.get_pass_image_itk(), passImage, VTK_UNSIGNED_CHAR)
+      || !vtkSlicerRtCommon::ConvertItkImageToVtkImageData<unsigned char>(gamma.get_fail_image_itk(), failImage, VTK_UNSIGNED_CHAR) )
+    {
+      std::string errorMessage("Failed to convert gamma pass and fail images");
+      vtkErrorMacro("ComputeGammaDoseDifference: " << errorMessage);
+      return errorMessage;
+    }
+
+    std::string errorMessage = this->ComputeSegmentPassFractions(parameterNode, segmentLabelmaps, passImage, failImage);
+    if (!errorMessage.empty())
+    {
+      vtkErrorMacro("ComputeGammaDoseDifference: " << errorMessage);
+      return errorMessage;
+    }
+  }
+
   // Convert output to VTK
   double checkpointVtkConvertStart = timer->GetUniversalTime();
 
@@ -373,13 +425,155 @@ std::string vtkSlicerDoseComparisonModuleLogic::ComputeGammaDoseDifference(vtkMR
     std::cout << "Total gamma computation time: " << checkpointEnd-checkpointStart << " s" << std::endl
               << "\tApplying transforms: " << checkpointConvertStart-checkpointStart << " s" << std::endl
               << "\tConverting from VTK to ITK: " << checkpointGammaStart-checkpointConvertStart << " s" << std::endl
-              << "\tGamma computation: " << checkpointVtkConvertStart-checkpointGammaStart << " s" << std::endl
+              << "\tGamma computation: " << checkpointSegmentPassRatesStart-checkpointGammaStart << " s" << std::endl
+              << "\tPer-segment pass rates: " << checkpointVtkConvertStart-checkpointSegmentPassRatesStart << " s" << std::endl
               << "\tConverting back from ITK to VTK: " << checkpointEnd-checkpointVtkConvertStart << " s" << std::endl;
   }
 
   return "";
 }
 
+//---------------------------------------------------------------------------
+std::string vtkSlicerDoseComparisonModuleLogic::CreateSegmentLabelmapsInReferenceGeometry(vtkMRMLDoseComparisonNode* parameterNode,
+  std::map<std::string, vtkSmartPointer<vtkOrientedImageData> >& segmentLabelmaps, vtkOrientedImageData* unionLabelmap)
+{
+  segmentLabelmaps.clear();
+  if (!parameterNode || !unionLabelmap)
+  {
+    return "Invalid parameter set node or output labelmap";
+  }
+  vtkMRMLSegmentationNode* maskSegmentationNode = parameterNode->GetMaskSegmentationNode();
+  vtkMRMLScalarVolumeNode* referenceDoseVolumeNode = parameterNode->GetReferenceDoseVolumeNode();
+  if (!maskSegmentationNode || !referenceDoseVolumeNode)
+  {
+    return "Both mask segmentation node and reference dose volume node need to be set";
+  }
+
+  // If segment IDs list is empty then include all segments
+  std::vector<std::string> segmentIDs;
+  parameterNode->GetSelectedSegmentIDs(segmentIDs);
+  if (segmentIDs.empty())
+  {
+    maskSegmentationNode->GetSegmentation()->GetSegmentIDs(segmentIDs);
+  }
+  if (segmentIDs.empty())
+  {
+    return "No segments in mask segmentation";
+  }
+
+  // Make sure segment data is loaded if it was deferred on import
+  for (const std::string& segmentID : segmentIDs)
+  {
+    maskSegmentationNode->InvokeEvent(vtkSlicerRtCommon::SegmentDataRequested, (void*)segmentID.c_str());
+  }
+
+  // Gamma is computed on the lattice of the reference dose, so all labelmaps need to match that
+  vtkSmartPointer<vtkGeneralTransform> segmentationToWorldTransform;
+  if (maskSegmentationNode->GetParentTransformNode())
+  {
+    segmentationToWorldTransform = vtkSmartPointer<vtkGeneralTransform>::New();
+    maskSegmentationNode->GetParentTransformNode()->GetTransformToWorld(segmentationToWorldTransform);
+  }
+  std::vector<vtkSmartPointer<vtkOrientedImageData> > segmentLabelmapsVector;
+  std::string errorMessage = vtkSlicerRtCommon::CreateSegmentLabelmapsInVolumeGeometry(referenceDoseVolumeNode,
+    maskSegmentationNode->GetSegmentation(), segmentationToWorldTransform, segmentIDs, segmentLabelmapsVector);
+  if (!errorMessage.empty())
+  {
+    return errorMessage;
+  }
+
+  int referenceExtent[6] = {0,-1,0,-1,0,-1};
+  referenceDoseVolumeNode->GetImageData()->GetExtent(referenceExtent);
+  unionLabelmap->SetExtent(referenceExtent);
+  unionLabelmap->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+  unionLabelmap->CopyDirections(segmentLabelmapsVector[0]);
+  unionLabelmap->SetOrigin(segmentLabelmapsVector[0]->GetOrigin());
+  unionLabelmap->SetSpacing(segmentLabelmapsVector[0]->GetSpacing());
+  vtkIdType numberOfVoxels = unionLabelmap->GetNumberOfPoints();
+  unsigned char* unionLabelmapPtr = static_cast<unsigned char*>(unionLabelmap->GetScalarPointer());
+  std::fill(unionLabelmapPtr, unionLabelmapPtr + numberOfVoxels, 0);
+
+  for (size_t segmentIndex = 0; segmentIndex < segmentIDs.size(); ++segmentIndex)
+  {
+    // Add segment to union mask
+    vtkOrientedImageData* segmentLabelmap = segmentLabelmapsVector[segmentIndex];
+    unsigned char* segmentLabelmapPtr = static_cast<unsigned char*>(segmentLabelmap->GetScalarPointer());
+    for (vtkIdType voxelIndex = 0; voxelIndex < numberOfVoxels; ++voxelIndex)
+    {
+      if (segmentLabelmapPtr[voxelIndex])
+      {
+        unionLabelmapPtr[voxelIndex] = 1;
+      }
+    }
+
+    segmentLabelmaps[segmentIDs[segmentIndex]] = segmentLabelmap;
+  }
+
+  return "";
+}
+
+//---------------------------------------------------------------------------
+std::string vtkSlicerDoseComparisonModuleLogic::ComputeSegmentPassFractions(vtkMRMLDoseComparisonNode* parameterNode,
+  std::map<std::string, vtkSmartPointer<vtkOrientedImageData> >& segmentLabelmaps, vtkImageData* passImage, vtkImageData* failImage)
+{
+  if (!parameterNode || !passImage || !failImage)
+  {
+    return "Invalid parameter set node or gamma pass/fail images";
+  }
+
+  for (std::map<std::string, vtkSmartPointer<vtkOrientedImageData> >::iterator labelmapIt = segmentLabelmaps.begin();
+    labelmapIt != segmentLabelmaps.end(); ++labelmapIt)
+  {
+    vtkOrientedImageData* segmentLabelmap = labelmapIt->second;
+    int segmentDimensions[3] = {0,0,0};
+    segmentLabelmap->GetDimensions(segmentDimensions);
+    int passDimensions[3] = {0,0,0};
+    passImage->GetDimensions(passDimensions);
+    if ( segmentDimensions[0] != passDimensions[0] || segmentDimensions[1] != passDimensions[1]
+      || segmentDimensions[2] != passDimensions[2] )
+    {
+      return "Gamma pass image and segment labelmap lattices do not match";
+    }
+    // ITK to VTK conversion starts the extent at zero, align it with the segment labelmap so that the stencil applies.
+    // The geometry is changed on shallow copies, so that the images of the caller are left untouched.
+    vtkNew<vtkImageData> segmentPassImage;
+    segmentPassImage->ShallowCopy(passImage);
+    segmentPassImage->SetExtent(segmentLabelmap->GetExtent());
+    segmentPassImage->SetOrigin(segmentLabelmap->GetOrigin());
+    segmentPassImage->SetSpacing(segmentLabelmap->GetSpacing());
+    vtkNew<vtkImageData> segmentFailImage;
+    segmentFailImage->ShallowCopy(failImage);
+    segmentFailImage->SetExtent(segmentLabelmap->GetExtent());
+    segmentFailImage->SetOrigin(segmentLabelmap->GetOrigin());
+    segmentFailImage->SetSpacing(segmentLabelmap->GetSpacing());
+
+    vtkNew<vtkImageToImageStencil> stencil;
+    stencil->SetInputData(segmentLabelmap);
+    stencil->ThresholdByUpper(1);
+    stencil->Update();
+
+    // Number of flagged voxels within the segment is the mean of the 0/1 image times the stenciled voxel count
+    vtkNew<vtkImageAccumulate> passStat;
+    passStat->SetInputData(segmentPassImage);
+    passStat->SetStencilData(stencil->GetOutput());
+    passStat->Update();
+    double passCount = passStat->GetMean()[0] * passStat->GetVoxelCount();
+
+    vtkNew<vtkImageAccumulate> failStat;
+    failStat->SetInputData(segmentFailImage);
+    failStat->SetStencilData(stencil->GetOutput());
+    failStat->Update();
+    double failCount = failStat->GetMean()[0] * failStat->GetVoxelCount();
+
+    // Segments without analyzed voxels (e.g. entirely below the analysis threshold) get an invalid pass fraction
+    double analyzedCount = passCount + failCount;
+    parameterNode->SetSegmentPassFractionPercent( labelmapIt->first,
+      (analyzedCount > 0.0 ? passCount / analyzedCount * 100.0 : -1.0) );
+  }
+
+  return "";
+}
+
 //---------------------------------------------------------------------------
 void vtkSlicerDoseComparisonModuleLogic::CreateDefaultGammaColorTable()
 {
@@ -30,9 +30,18 @@
 // Slicer includes
 #include "vtkSlicerModuleLogic.h"
 
+// VTK includes
+#include <vtkSmartPointer.h>
+
+// STD includes
+#include <map>
+
 #include "vtkSlicerDoseComparisonModuleLogicExport.h"
 
 class vtkMRMLDoseComparisonNode;
+class vtkMRMLScalarVolumeNode;
+class vtkOrientedImageData;
+class vtkImageData;
 
 /// \ingroup SlicerRt_QtModules_DoseComparison
 class VTK_SLICER_DOSECOMPARISON_LOGIC_EXPORT vtkSlicerDoseComparisonModuleLogic :
@@ -52,6 +61,8 @@ public:
 
 public:
   /// Compute gamma metric according to the selected input volumes and parameters (DoseComparison parameter set node content)
+  /// If per-segment pass rates are requested in the parameter node, then gamma is computed once over the union of the
+  /// selected segments, and the pass rates are binned per segment afterwards (\sa ComputeSegmentPassFractions)
   /// \return Error message, empty string if no error
   std::string ComputeGammaDoseDifference(vtkMRMLDoseComparisonNode* parameterNode);
 
@@ -66,6 +77,22 @@ protected:
   /// Loads default gamma color table from the supplied color table file
   void LoadDefaultGammaColorTable();
 
+  /// Create binary labelmaps in the geometry of the reference dose volume for the selected segments of the
+  /// mask segmentation, and their union that is used as the gamma mask
+  /// \param segmentLabelmaps Output map of segment IDs to labelmaps (0/1 values) matching the reference dose lattice
+  /// \param unionLabelmap Output labelmap containing the union of all segment labelmaps
+  /// \return Error message, empty string if no error
+  std::string CreateSegmentLabelmapsInReferenceGeometry(vtkMRMLDoseComparisonNode* parameterNode,
+    std::map<std::string, vtkSmartPointer<vtkOrientedImageData> >& segmentLabelmaps, vtkOrientedImageData* unionLabelmap);
+
+  /// Count passing and failing voxels of a single gamma run within each segment using stencils,
+  /// and store the pass fractions in the parameter node.
+  /// \param passImage Image containing 1 for analyzed voxels with gamma not greater than one, matching the reference dose lattice
+  /// \param failImage Image containing 1 for analyzed voxels with gamma greater than one, matching the reference dose lattice
+  /// \return Error message, empty string if no error
+  std::string ComputeSegmentPassFractions(vtkMRMLDoseComparisonNode* parameterNode,
+    std::map<std::string, vtkSmartPointer<vtkOrientedImageData> >& segmentLabelmaps, vtkImageData* passImage, vtkImageData* failImage);
+
 public:
   vtkGetMacro(LogSpeedMeasurements, bool);
   vtkSetMacro(LogSpeedMeasurements, bool);
@@ -0,0 +1,209 @@
+/*==============================================================================
+
+  Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+  Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// DoseComparison includes
+#include "vtkSlicerDoseComparisonModuleLogic.h"
+#include "vtkMRMLDoseComparisonNode.h"
+
+// Segmentations includes
+#include "vtkMRMLSegmentationNode.h"
+
+// SegmentationCore includes
+#include "vtkOrientedImageData.h"
+#include "vtkSegment.h"
+#include "vtkSegmentation.h"
+#include "vtkSegmentationConverter.h"
+
+// MRML includes
+#include <vtkMRMLScalarVolumeNode.h>
+#include <vtkMRMLScene.h>
+#include <vtkMRMLSubjectHierarchyNode.h>
+
+// VTK includes
+#include <vtkImageData.h>
+#include <vtkMatrix4x4.h>
+#include <vtkNew.h>
+
+// STD includes
+#include <cmath>
+#include <map>
+#include <string>
+#include <vector>
+
+//----------------------------------------------------------------------------
+/// Create a dose volume node with a Gaussian dose distribution on a 2.5 mm grid
+vtkMRMLScalarVolumeNode* CreateGaussianDoseVolumeNode(vtkMRMLScene* scene, const char* name, const double centerIJK[3], double maximumDose);
+/// Add a segment with a binary labelmap on the lattice of the dose volume. Voxels within the extent are included if
+/// they are within the given radius from the center (IJK coordinates), or all of them if the radius is negative
+void AddDoseLatticeSegment(vtkMRMLSegmentationNode* segmentationNode, vtkMRMLScalarVolumeNode* doseVolumeNode,
+  const char* segmentName, const int extent[6], const double centerIJK[3], double radius);
+
+//----------------------------------------------------------------------------
+int vtkSlicerDoseComparisonModuleLogicTest2(int vtkNotUsed(argc), char* vtkNotUsed(argv)[])
+{
+  vtkNew<vtkMRMLScene> mrmlScene;
+  vtkMRMLSubjectHierarchyNode::GetSubjectHierarchyNode(mrmlScene);
+  vtkNew<vtkSlicerDoseComparisonModuleLogic> doseComparisonLogic;
+  doseComparisonLogic->SetMRMLScene(mrmlScene);
+
+  // Compare dose is shifted by about a DTA and scaled by more than the dose difference criterion, so that
+  // both passing and failing voxels are present in the segments
+  const double referenceCenter[3] = { 15.5, 16.2, 15.8 };
+  const double compareCenter[3] = { 16.7, 16.2, 15.3 };
+  vtkMRMLScalarVolumeNode* referenceDoseVolumeNode = CreateGaussianDoseVolumeNode(mrmlScene, "ReferenceDose", referenceCenter, 10.0);
+  vtkMRMLScalarVolumeNode* compareDoseVolumeNode = CreateGaussianDoseVolumeNode(mrmlScene, "CompareDose", compareCenter, 10.4);
+
+  // Overlapping segments with extents smaller than the dose
+  vtkNew<vtkMRMLSegmentationNode> maskSegmentationNode;
+  mrmlScene->AddNode(maskSegmentationNode);
+  maskSegmentationNode->GetSegmentation()->SetMasterRepresentationName(vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName());
+  const int coreExtent[6] = { 6, 25, 6, 25, 6, 25 };
+  const double coreCenter[3] = { 15.0, 16.0, 16.0 };
+  AddDoseLatticeSegment(maskSegmentationNode, referenceDoseVolumeNode, "Core", coreExtent, coreCenter, 6.5);
+  const int slabExtent[6] = { 14, 28, 3, 29, 10, 20 };
+  const double slabCenter[3] = { 0.0, 0.0, 0.0 };
+  AddDoseLatticeSegment(maskSegmentationNode, referenceDoseVolumeNode, "Slab", slabExtent, slabCenter, -1.0);
+  const int shellExtent[6] = { 0, 31, 0, 31, 0, 31 };
+  const double shellCenter[3] = { 20.0, 12.0, 17.0 };
+  AddDoseLatticeSegment(maskSegmentationNode, referenceDoseVolumeNode, "Offset", shellExtent, shellCenter, 8.0);
+  std::vector<std::string> segmentIDs;
+  maskSegmentationNode->GetSegmentation()->GetSegmentIDs(segmentIDs);
+
+  // Gamma computed once over the union of all segments, with the pass rates binned per segment
+  vtkNew<vtkMRMLScalarVolumeNode> perSegmentGammaVolumeNode;
+  mrmlScene->AddNode(perSegmentGammaVolumeNode);
+  vtkNew<vtkMRMLDoseComparisonNode> perSegmentParameterNode;
+  mrmlScene->AddNode(perSegmentParameterNode);
+  perSegmentParameterNode->SetAndObserveReferenceDoseVolumeNode(referenceDoseVolumeNode);
+  perSegmentParameterNode->SetAndObserveCompareDoseVolumeNode(compareDoseVolumeNode);
+  perSegmentParameterNode->SetAndObserveMaskSegmentationNode(maskSegmentationNode);
+  perSegmentParameterNode->SetAndObserveGammaVolumeNode(perSegmentGammaVolumeNode);
+  perSegmentParameterNode->SetUseGeometricGammaCalculation(false);
+  // Use an explicit reference dose, so that the dose criterion and the analysis threshold are the same for all masks
+  perSegmentParameterNode->UseMaximumDoseOff();
+  perSegmentParameterNode->SetReferenceDoseGy(10.0);
+  perSegmentParameterNode->ComputePerSegmentPassRatesOn();
+  std::string errorMessage = doseComparisonLogic->ComputeGammaDoseDifference(perSegmentParameterNode);
+  if (!errorMessage.empty() || !perSegmentParameterNode->GetResultsValid())
+  {
+    std::cerr << __LINE__ << ": Failed to compute gamma with per-segment pass rates: " << errorMessage << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // Reference: gamma computed separately with each segment as mask
+  bool anySegmentFailing = false;
+  for (const std::string& segmentID : segmentIDs)
+  {
+    vtkNew<vtkMRMLScalarVolumeNode> segmentGammaVolumeNode;
+    mrmlScene->AddNode(segmentGammaVolumeNode);
+    vtkNew<vtkMRMLDoseComparisonNode> segmentParameterNode;
+    mrmlScene->AddNode(segmentParameterNode);
+    segmentParameterNode->SetAndObserveReferenceDoseVolumeNode(referenceDoseVolumeNode);
+    segmentParameterNode->SetAndObserveCompareDoseVolumeNode(compareDoseVolumeNode);
+    segmentParameterNode->SetAndObserveMaskSegmentationNode(maskSegmentationNode);
+    segmentParameterNode->SetMaskSegmentID(segmentID.c_str());
+    segmentParameterNode->SetAndObserveGammaVolumeNode(segmentGammaVolumeNode);
+    segmentParameterNode->SetUseGeometricGammaCalculation(false);
+    segmentParameterNode->UseMaximumDoseOff();
+    segmentParameterNode->SetReferenceDoseGy(10.0);
+    errorMessage = doseComparisonLogic->ComputeGammaDoseDifference(segmentParameterNode);
+    if (!errorMessage.empty() || !segmentParameterNode->GetResultsValid())
+    {
+      std::cerr << __LINE__ << ": Failed to compute gamma with mask segment " << segmentID << ": " << errorMessage << std::endl;
+      return EXIT_FAILURE;
+    }
+
+    double passFractionPercent = perSegmentParameterNode->GetSegmentPassFractionPercent(segmentID);
+    double expectedPassFractionPercent = segmentParameterNode->GetPassFractionPercent();
+    std::cout << "Segment " << segmentID << " pass fraction: " << passFractionPercent << "% (separate gamma: "
+      << expectedPassFractionPercent << "%)" << std::endl;
+    if (passFractionPercent < 0.0 || fabs(passFractionPercent - expectedPassFractionPercent) > 1.0e-6)
+    {
+      std::cerr << __LINE__ << ": Pass fraction of segment " << segmentID << " (" << passFractionPercent
+        << "%) does not match gamma computed with the segment as mask (" << expectedPassFractionPercent << "%)" << std::endl;
+      return EXIT_FAILURE;
+    }
+    anySegmentFailing = anySegmentFailing || (expectedPassFractionPercent < 100.0);
+  }
+  if (!anySegmentFailing)
+  {
+    std::cerr << __LINE__ << ": Test doses are expected to produce failing voxels" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+vtkMRMLScalarVolumeNode* CreateGaussianDoseVolumeNode(vtkMRMLScene* scene, const char* name, const double centerIJK[3], double maximumDose)
+{
+  const int dimensions[3] = { 32, 32, 32 };
+  const double sigma = 6.0;
+  vtkNew<vtkImageData> doseImageData;
+  doseImageData->SetDimensions(dimensions[0], dimensions[1], dimensions[2]);
+  doseImageData->AllocateScalars(VTK_FLOAT, 1);
+  float* dosePtr = static_cast<float*>(doseImageData->GetScalarPointer());
+  for (int k = 0; k < dimensions[2]; ++k)
+  {
+    for (int j = 0; j < dimensions[1]; ++j)
+    {
+      for (int i = 0; i < dimensions[0]; ++i)
+      {
+        double squaredDistance = (i - centerIJK[0]) * (i - centerIJK[0])
+          + (j - centerIJK[1]) * (j - centerIJK[1]) + (k - centerIJK[2]) * (k - centerIJK[2]);
+        *(dosePtr++) = static_cast<float>(maximumDose * exp(-squaredDistance / (2.0 * sigma * sigma)));
+      }
+    }
+  }
+
+  vtkNew<vtkMRMLScalarVolumeNode> doseVolumeNode;
+  doseVolumeNode->SetName(name);
+  doseVolumeNode->SetAndObserveImageData(doseImageData);
+  doseVolumeNode->SetSpacing(2.5, 2.5, 2.5);
+  doseVolumeNode->SetOrigin(-40.0, 25.0, -38.75);
+  scene->AddNode(doseVolumeNode);
+  return doseVolumeNode;
+}
+
+//----------------------------------------------------------------------------
+void AddDoseLatticeSegment(vtkMRMLSegmentationNode* segmentationNode, vtkMRMLScalarVolumeNode* doseVolumeNode,
+  const char* segmentName, const int extent[6], const double centerIJK[3], double radius)
+{
+  vtkNew<vtkMatrix4x4> ijkToRasMatrix;
+  doseVolumeNode->GetIJKToRASMatrix(ijkToRasMatrix);
+  vtkNew<vtkOrientedImageData> segmentLabelmap;
+  segmentLabelmap->SetExtent(extent[0], extent[1], extent[2], extent[3], extent[4], extent[5]);
+  segmentLabelmap->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+  segmentLabelmap->SetGeometryFromImageToWorldMatrix(ijkToRasMatrix);
+  for (int k = extent[4]; k <= extent[5]; ++k)
+  {
+    for (int j = extent[2]; j <= extent[3]; ++j)
+    {
+      for (int i = extent[0]; i <= extent[1]; ++i)
+      {
+        double squaredDistance = (i - centerIJK[0]) * (i - centerIJK[0])
+          + (j - centerIJK[1]) * (j - centerIJK[1]) + (k - centerIJK[2]) * (k - centerIJK[2]);
+        bool inside = (radius < 0.0 || squaredDistance <= radius * radius);
+        segmentLabelmap->SetScalarComponentFromDouble(i, j, k, 0, inside ? 1.0 : 0.0);
+      }
+    }
+  }
+
+  vtkNew<vtkSegment> segment;
+  segment->SetName(segmentName);
+  segment->AddRepresentation(vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName(), segmentLabelmap);
+  segmentationNode->GetSegmentation()->AddSegment(segment);
+}
@@ -227,6 +227,8 @@ std::string vtkSlicerDoseVolumeHistogramModuleLogic::ComputeDvh(vtkMRMLDoseVolum
   segmentationCopy->CopyConversionParameters(selectedSegmentation);
   for (std::vector<std::string>::iterator segmentIt = segmentIDs.begin(); segmentIt != segmentIDs.end(); ++segmentIt)
   {
+    // Make sure segment data is loaded if it was deferred on import
+    segmentationNode->InvokeEvent(vtkSlicerRtCommon::SegmentDataRequested, (void*)segmentIt->c_str());
     segmentationCopy->CopySegmentFromSegmentation(selectedSegmentation, (*segmentIt));
   }
 
@@ -25,12 +25,14 @@
 // MRML includes
 #include <vtkMRMLColorTableNode.h>
 #include <vtkMRMLModelHierarchyNode.h>
+#include <vtkMRMLModelNode.h>
 #include <vtkMRMLScalarVolumeNode.h>
 #include <vtkMRMLScene.h>
 
 // VTK includes
 #include <vtkObjectFactory.h>
 #include <vtkSmartPointer.h>
+#include <vtkVariant.h>
 
 // STD includes
 #include <sstream>
@@ -38,6 +40,8 @@
 //------------------------------------------------------------------------------
 static const char* DOSE_VOLUME_REFERENCE_ROLE = "doseVolumeRef";
 const char* vtkMRMLIsodoseNode::COLOR_TABLE_REFERENCE_ROLE = "colorTableRef";
+const char* vtkMRMLIsodoseNode::ISODOSE_MODEL_REFERENCE_ROLE = "isodoseModelRef";
+const char* vtkMRMLIsodoseNode::ISODOSE_LEVEL_ATTRIBUTE_NAME = "IsodoseLevel";
 
 //------------------------------------------------------------------------------
 vtkMRMLNodeNewMacro(vtkMRMLIsodoseNode);
@@ -46,6 +50,7 @@ vtkMRMLNodeNewMacro(vtkMRMLIsodoseNode);
 vtkMRMLIsodoseNode::vtkMRMLIsodoseNode()
 {
   this->ShowIsodoseLines = true;
+  this->SliceIsodoseLines = false;
   this->ShowIsodoseSurfaces = true;
   this->ShowScalarBar = false;
   this->ShowScalarBar2D = false;
@@ -53,12 +58,16 @@ vtkMRMLIsodoseNode::vtkMRMLIsodoseNode()
   this->DoseUnits = DoseUnitsType::Unknown;
   this->ReferenceDoseValue = -1.;
   this->RelativeRepresentationFlag = false;
+  this->IsodoseModelsDoseVolumeState = nullptr;
 
   this->HideFromEditors = false;
 }
 
 //----------------------------------------------------------------------------
-vtkMRMLIsodoseNode::~vtkMRMLIsodoseNode() = default;
+vtkMRMLIsodoseNode::~vtkMRMLIsodoseNode()
+{
+  this->SetIsodoseModelsDoseVolumeState(nullptr);
+}
 
 //----------------------------------------------------------------------------
 void vtkMRMLIsodoseNode::WriteXML(ostream& of, int nIndent)
@@ -68,6 +77,7 @@ void vtkMRMLIsodoseNode::WriteXML(ostream& of, int nIndent)
   // Write all MRML node attributes into output stream
   vtkMRMLWriteXMLBeginMacro(of);
   vtkMRMLWriteXMLBooleanMacro(ShowIsodoseLines, ShowIsodoseLines);
+  vtkMRMLWriteXMLBooleanMacro(SliceIsodoseLines, SliceIsodoseLines);
   vtkMRMLWriteXMLBooleanMacro(ShowIsodoseSurfaces, ShowIsodoseSurfaces);
   vtkMRMLWriteXMLBooleanMacro(ShowScalarBar, ShowScalarBar);
   vtkMRMLWriteXMLBooleanMacro(ShowScalarBar2D, ShowScalarBar2D);
@@ -87,6 +97,7 @@ void vtkMRMLIsodoseNode::ReadXMLAttributes(const char** atts)
 
   vtkMRMLReadXMLBeginMacro(atts);
   vtkMRMLReadXMLBooleanMacro(ShowIsodoseLines, ShowIsodoseLines);
+  vtkMRMLReadXMLBooleanMacro(SliceIsodoseLines, SliceIsodoseLines);
   vtkMRMLReadXMLBooleanMacro(ShowIsodoseSurfaces, ShowIsodoseSurfaces);
   vtkMRMLReadXMLBooleanMacro(ShowScalarBar, ShowScalarBar);
   vtkMRMLReadXMLBooleanMacro(ShowScalarBar2D, ShowScalarBar2D);
@@ -110,6 +121,7 @@ void vtkMRMLIsodoseNode::Copy(vtkMRMLNode *anode)
 
   vtkMRMLCopyBeginMacro(anode);
   vtkMRMLCopyBooleanMacro(ShowIsodoseLines);
+  vtkMRMLCopyBooleanMacro(SliceIsodoseLines);
   vtkMRMLCopyBooleanMacro(ShowIsodoseSurfaces);
   vtkMRMLCopyBooleanMacro(ShowScalarBar);
   vtkMRMLCopyBooleanMacro(ShowScalarBar2D);
@@ -129,6 +141,7 @@ void vtkMRMLIsodoseNode::PrintSelf(ostream& os, vtkIndent indent)
 
   vtkMRMLPrintBeginMacro(os, indent);
   vtkMRMLPrintBooleanMacro(ShowIsodoseLines);
+  vtkMRMLPrintBooleanMacro(SliceIsodoseLines);
   vtkMRMLPrintBooleanMacro(ShowIsodoseSurfaces);
   vtkMRMLPrintBooleanMacro(ShowScalarBar);
   vtkMRMLPrintBooleanMacro(ShowScalarBar2D);
@@ -136,6 +149,7 @@ void vtkMRMLIsodoseNode::PrintSelf(ostream& os, vtkIndent indent)
   vtkMRMLPrintIntMacro(DoseUnits);
   vtkMRMLPrintFloatMacro(ReferenceDoseValue);
   vtkMRMLPrintBooleanMacro(RelativeRepresentationFlag);
+  vtkMRMLPrintStringMacro(IsodoseModelsDoseVolumeState);
   vtkMRMLPrintEndMacro();
 }
 
@@ -189,6 +203,55 @@ void vtkMRMLIsodoseNode::SetAndObserveColorTableNode(vtkMRMLColorTableNode* node
   doseVolumeNode->SetNodeReferenceID(COLOR_TABLE_REFERENCE_ROLE, (node ? node->GetID() : nullptr));
 }
 
+//----------------------------------------------------------------------------
+int vtkMRMLIsodoseNode::GetNumberOfIsodoseModelNodes()
+{
+  return this->GetNumberOfNodeReferences(ISODOSE_MODEL_REFERENCE_ROLE);
+}
+
+//----------------------------------------------------------------------------
+vtkMRMLModelNode* vtkMRMLIsodoseNode::GetNthIsodoseModelNode(int n)
+{
+  return vtkMRMLModelNode::SafeDownCast( this->GetNthNodeReference(ISODOSE_MODEL_REFERENCE_ROLE, n) );
+}
+
+//----------------------------------------------------------------------------
+double vtkMRMLIsodoseNode::GetNthIsodoseModelLevelValue(int n)
+{
+  vtkMRMLModelNode* modelNode = this->GetNthIsodoseModelNode(n);
+  if (!modelNode || !modelNode->GetAttribute(ISODOSE_LEVEL_ATTRIBUTE_NAME))
+  {
+    vtkErrorMacro("GetNthIsodoseModelLevelValue: No isodose level found for isodose model " << n);
+    return 0.0;
+  }
+
+  return vtkVariant(modelNode->GetAttribute(ISODOSE_LEVEL_ATTRIBUTE_NAME)).ToDouble();
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLIsodoseNode::AddIsodoseModelNode(vtkMRMLModelNode* modelNode, double levelValue)
+{
+  if (!modelNode || this->Scene != modelNode->GetScene())
+    {
+    vtkErrorMacro("AddIsodoseModelNode: Cannot set reference: the referenced and referencing node are not in the same scene");
+    return;
+    }
+
+  // Store the exact level value on the model, so that it can be matched against the requested levels later
+  std::stringstream levelValueStream;
+  levelValueStream.precision(17);
+  levelValueStream << levelValue;
+  modelNode->SetAttribute(ISODOSE_LEVEL_ATTRIBUTE_NAME, levelValueStream.str().c_str());
+
+  this->AddNodeReferenceID(ISODOSE_MODEL_REFERENCE_ROLE, modelNode->GetID());
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLIsodoseNode::RemoveAllIsodoseModelNodes()
+{
+  this->RemoveNodeReferenceIDs(ISODOSE_MODEL_REFERENCE_ROLE);
+}
+
 //----------------------------------------------------------------------------
 void vtkMRMLIsodoseNode::SetDoseUnits(int doseUnits)
 {
@@ -31,6 +31,7 @@
 
 class vtkMRMLScalarVolumeNode;
 class vtkMRMLModelHierarchyNode;
+class vtkMRMLModelNode;
 class vtkMRMLColorTableNode;
 
 /// \ingroup SlicerRt_QtModules_Isodose
@@ -39,6 +40,8 @@ class VTK_SLICER_ISODOSE_LOGIC_EXPORT vtkMRMLIsodoseNode : public vtkMRMLNode
 public:
   enum DoseUnitsType { Unknown = -1, Gy = 0, Relative = 1 };
   static const char* COLOR_TABLE_REFERENCE_ROLE;
+  static const char* ISODOSE_MODEL_REFERENCE_ROLE;
+  static const char* ISODOSE_LEVEL_ATTRIBUTE_NAME;
 
   static vtkMRMLIsodoseNode *New();
   vtkTypeMacro(vtkMRMLIsodoseNode, vtkMRMLNode);
@@ -70,11 +73,33 @@ public:
   /// Set and observe color table node (associated to dose volume node)
   void SetAndObserveColorTableNode(vtkMRMLColorTableNode* node);
 
+  /// Get number of isodose model nodes generated from the current dose volume
+  int GetNumberOfIsodoseModelNodes();
+  /// Get n-th isodose model node. The models are ordered by the isodose levels of the color table
+  vtkMRMLModelNode* GetNthIsodoseModelNode(int n);
+  /// Get isodose level value (in dose units) the n-th isodose model node was extracted at
+  double GetNthIsodoseModelLevelValue(int n);
+  /// Add isodose model node extracted at a given isodose level value
+  void AddIsodoseModelNode(vtkMRMLModelNode* modelNode, double levelValue);
+  /// Remove references to all isodose model nodes. The model nodes themselves are not removed from the scene
+  void RemoveAllIsodoseModelNodes();
+
+  /// Get/Set state of the dose volume the referenced isodose models were extracted from.
+  /// Not saved to file, so surfaces are regenerated after loading the scene
+  vtkGetStringMacro(IsodoseModelsDoseVolumeState);
+  vtkSetStringMacro(IsodoseModelsDoseVolumeState);
+
   /// Get/Set show isodose lines checkbox state
   vtkGetMacro(ShowIsodoseLines, bool);
   vtkSetMacro(ShowIsodoseLines, bool);
   vtkBooleanMacro(ShowIsodoseLines, bool);
 
+  /// Get/Set per-slice isodose lines mode. If on, then isodose lines are computed on demand for the slice
+  /// displayed in each slice view instead of showing the intersections of the isodose surfaces
+  vtkGetMacro(SliceIsodoseLines, bool);
+  vtkSetMacro(SliceIsodoseLines, bool);
+  vtkBooleanMacro(SliceIsodoseLines, bool);
+
   /// Get/Set show isodose surfaces checkbox state
   vtkGetMacro(ShowIsodoseSurfaces, bool);
   vtkSetMacro(ShowIsodoseSurfaces, bool);
@@ -120,6 +145,9 @@ protected:
   /// State of Show isodose lines checkbox
   bool ShowIsodoseLines;
 
+  /// Flag whether isodose lines are computed per displayed slice
+  bool SliceIsodoseLines;
+
   /// State of Show isodose surfaces checkbox
   bool ShowIsodoseSurfaces;
 
@@ -141,6 +169,9 @@ protected:
   /// Whether use relative isolevels representation
   /// for absolute dose (Gy) and unknown units or not
   bool RelativeRepresentationFlag;
+
+  /// State of the dose volume when the referenced isodose models were extracted
+  char* IsodoseModelsDoseVolumeState;
 };
 
 #endif
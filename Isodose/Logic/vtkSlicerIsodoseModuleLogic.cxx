@@ -31,12 +31,19 @@
 // SlicerRT includes
 #include "vtkSlicerRtCommon.h"
 
+// Segmentations includes
+#include "vtkMRMLSegmentationNode.h"
+#include "vtkOrientedImageData.h"
+
 // MRML includes
 #include <vtkMRMLColorTableNode.h>
+#include <vtkMRMLDisplayNode.h>
 #include <vtkMRMLModelDisplayNode.h>
 #include <vtkMRMLModelNode.h>
 #include <vtkMRMLScalarVolumeNode.h>
 #include <vtkMRMLScene.h>
+#include <vtkMRMLSliceNode.h>
+#include <vtkMRMLTableNode.h>
 #include <vtkMRMLTransformNode.h>
 #include <vtkMRMLScalarVolumeDisplayNode.h>
 
@@ -44,23 +51,50 @@
 #include <vtkMRMLColorLogic.h>
 
 // VTK includes
+#include <vtkAssignAttribute.h>
+#include <vtkCellArray.h>
+#include <vtkCellData.h>
 #include <vtkColorTransferFunction.h>
+#include <vtkCommand.h>
+#include <vtkDataArray.h>
 #include <vtkDecimatePro.h>
+#include <vtkDoubleArray.h>
+#include <vtkExtractVOI.h>
+#include <vtkFlyingEdges3D.h>
 #include <vtkGeneralTransform.h>
+#include <vtkIdList.h>
+#include <vtkImageCast.h>
 #include <vtkImageChangeInformation.h>
 #include <vtkImageData.h>
-#include <vtkImageMarchingCubes.h>
 #include <vtkImageReslice.h>
+#include <vtkIntArray.h>
 #include <vtkLookupTable.h>
+#include <vtkMarchingSquares.h>
+#include <vtkMath.h>
+#include <vtkMatrix4x4.h>
 #include <vtkNew.h>
 #include <vtkObjectFactory.h>
+#include <vtkPointData.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
 #include <vtkPolyDataNormals.h>
+#include <vtkSMPThreadLocal.h>
+#include <vtkSMPTools.h>
 #include <vtkSmartPointer.h>
+#include <vtkStringArray.h>
+#include <vtkTable.h>
+#include <vtkTransform.h>
 #include <vtkTransformPolyDataFilter.h>
 #include <vtkTriangleFilter.h>
+#include <vtkVersion.h>
 #include <vtkWindowedSincPolyDataFilter.h>
 #include "vtksys/SystemTools.hxx"
 
+// STD includes
+#include <algorithm>
+#include <deque>
+#include <sstream>
+
 //----------------------------------------------------------------------------
 const char* DEFAULT_ISODOSE_COLOR_TABLE_FILE_NAME = "Isodose_ColorTable.ctbl";
 const char* DEFAULT_ISODOSE_COLOR_TABLE_NODE_NAME = "Isodose_ColorTable_Default";
@@ -70,6 +104,173 @@ const std::string vtkSlicerIsodoseModuleLogic::ISODOSE_PARAMETER_SET_BASE_NAME_P
 const std::string vtkSlicerIsodoseModuleLogic::ISODOSE_ROOT_HIERARCHY_NAME_POSTFIX = "_IsodoseSurfaces";
 const std::string vtkSlicerIsodoseModuleLogic::ISODOSE_RELATIVE_ROOT_HIERARCHY_NAME_POSTFIX = "_RelativeIsodoseSurfaces";
 const std::string vtkSlicerIsodoseModuleLogic::ISODOSE_COLOR_TABLE_NODE_NAME_POSTFIX = "_IsodoseColorTable";
+const char* SLICE_ISODOSE_LINES_MODEL_REFERENCE_ROLE = "sliceIsodoseLinesModelRef";
+const char* ISODOSE_LEVEL_INDEX_ARRAY_NAME = "IsodoseLevelIndex";
+const size_t SLICE_ISODOSE_LINES_OBLIQUE_CACHE_MAXIMUM_SIZE = 256;
+
+//----------------------------------------------------------------------------
+namespace
+{
+  /// Decimate, smooth and compute normals for isodose surfaces. Each level is processed independently,
+  /// so that vtkSMPTools can distribute the levels over the available threads.
+  class IsosurfacePostProcessingFunctor
+  {
+  public:
+    IsosurfacePostProcessingFunctor(std::vector<vtkSmartPointer<vtkPolyData> >& isoPolyDatas)
+      : IsoPolyDatas(isoPolyDatas)
+    {
+    }
+
+    void operator()(vtkIdType begin, vtkIdType end)
+    {
+      for (vtkIdType levelIndex = begin; levelIndex < end; ++levelIndex)
+      {
+        vtkPolyData* isoPolyData = this->IsoPolyDatas[levelIndex];
+        if (!isoPolyData || isoPolyData->GetNumberOfPoints() < 1)
+        {
+          continue;
+        }
+
+        vtkSmartPointer<vtkTriangleFilter> triangleFilter = vtkSmartPointer<vtkTriangleFilter>::New();
+        triangleFilter->SetInputData(isoPolyData);
+        triangleFilter->Update();
+
+        vtkSmartPointer<vtkDecimatePro> decimate = vtkSmartPointer<vtkDecimatePro>::New();
+        decimate->SetInputData(triangleFilter->GetOutput());
+        decimate->SetTargetReduction(0.6);
+        decimate->SetFeatureAngle(60);
+        decimate->SplittingOff();
+        decimate->PreserveTopologyOn();
+        decimate->SetMaximumError(1);
+        decimate->Update();
+
+        vtkSmartPointer<vtkWindowedSincPolyDataFilter> smootherSinc = vtkSmartPointer<vtkWindowedSincPolyDataFilter>::New();
+        smootherSinc->SetPassBand(0.1);
+        smootherSinc->SetInputData(decimate->GetOutput() );
+        smootherSinc->SetNumberOfIterations(2);
+        smootherSinc->FeatureEdgeSmoothingOff();
+        smootherSinc->BoundarySmoothingOff();
+        smootherSinc->Update();
+
+        vtkSmartPointer<vtkPolyDataNormals> normals = vtkSmartPointer<vtkPolyDataNormals>::New();
+        normals->SetInputData(smootherSinc->GetOutput());
+        normals->ComputePointNormalsOn();
+        normals->SetFeatureAngle(60);
+        normals->Update();
+
+        this->IsoPolyDatas[levelIndex] = normals->GetOutput();
+      }
+    }
+
+  private:
+    std::vector<vtkSmartPointer<vtkPolyData> >& IsoPolyDatas;
+  };
+
+  /// Get the values that the contouring filters store in the output scalars for each level. The output scalars have
+  /// the type of the input, so for integer dose the level is stored truncated to the integer type.
+  /// \param scalarType Type of the contour output scalars
+  /// \return False if two different levels are stored as the same value, i.e. they cannot be told apart in the output
+  bool GetContourScalarValues(int scalarType, const std::vector<double>& isoLevels, std::vector<double>& contourScalarValues)
+  {
+    contourScalarValues = isoLevels;
+    if (scalarType == VTK_FLOAT || scalarType == VTK_DOUBLE)
+    {
+      return true;
+    }
+    double scalarTypeMin = vtkDataArray::GetDataTypeMin(scalarType);
+    double scalarTypeMax = vtkDataArray::GetDataTypeMax(scalarType);
+    std::vector<std::pair<double, double> > storedLevels;
+    for (size_t levelIndex = 0; levelIndex < isoLevels.size(); ++levelIndex)
+    {
+      double isoLevel = std::min(std::max(isoLevels[levelIndex], scalarTypeMin), scalarTypeMax);
+      contourScalarValues[levelIndex] = (isoLevel < 0.0 ? ceil(isoLevel) : floor(isoLevel));
+      storedLevels.push_back(std::make_pair(contourScalarValues[levelIndex], isoLevels[levelIndex]));
+    }
+    std::sort(storedLevels.begin(), storedLevels.end());
+    for (size_t levelIndex = 1; levelIndex < storedLevels.size(); ++levelIndex)
+    {
+      if ( storedLevels[levelIndex].first == storedLevels[levelIndex-1].first
+        && storedLevels[levelIndex].second != storedLevels[levelIndex-1].second )
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  /// Count dose voxels of each segment per isodose level bin. The bin of a voxel is the number of (ascending)
+  /// levels its dose reaches, so that the volume covered by a level is the sum of the bins from that level up.
+  /// Each thread counts into its own bins, which are summed at the end.
+  template <class T>
+  class IsodoseVolumeCountingFunctor
+  {
+  public:
+    IsodoseVolumeCountingFunctor(const T* dose, const std::vector<unsigned char*>& segmentMasks,
+      const std::vector<double>& sortedLevels)
+      : Dose(dose)
+      , SegmentMasks(segmentMasks)
+      , SortedLevels(sortedLevels)
+      , NumberOfBins(sortedLevels.size() + 1)
+    {
+    }
+
+    void Initialize()
+    {
+      this->LocalCounts.Local().assign(this->SegmentMasks.size() * this->NumberOfBins, 0);
+    }
+
+    void operator()(vtkIdType begin, vtkIdType end)
+    {
+      std::vector<vtkIdType>& counts = this->LocalCounts.Local();
+      size_t numberOfSegments = this->SegmentMasks.size();
+      for (vtkIdType voxelIndex = begin; voxelIndex < end; ++voxelIndex)
+      {
+        size_t bin = std::upper_bound(this->SortedLevels.begin(), this->SortedLevels.end(),
+          static_cast<double>(this->Dose[voxelIndex])) - this->SortedLevels.begin();
+        for (size_t segmentIndex = 0; segmentIndex < numberOfSegments; ++segmentIndex)
+        {
+          if (this->SegmentMasks[segmentIndex][voxelIndex])
+          {
+            ++counts[segmentIndex * this->NumberOfBins + bin];
+          }
+        }
+      }
+    }
+
+    void Reduce()
+    {
+      this->Counts.assign(this->SegmentMasks.size() * this->NumberOfBins, 0);
+      for (vtkSMPThreadLocal<std::vector<vtkIdType> >::iterator countsIt = this->LocalCounts.begin();
+        countsIt != this->LocalCounts.end(); ++countsIt)
+      {
+        for (size_t index = 0; index < this->Counts.size(); ++index)
+        {
+          this->Counts[index] += (*countsIt)[index];
+        }
+      }
+    }
+
+    /// Voxel counts indexed by segment index * number of bins + bin
+    std::vector<vtkIdType> Counts;
+
+  private:
+    const T* Dose;
+    const std::vector<unsigned char*>& SegmentMasks;
+    const std::vector<double>& SortedLevels;
+    size_t NumberOfBins;
+    vtkSMPThreadLocal<std::vector<vtkIdType> > LocalCounts;
+  };
+
+  /// Count dose voxels per segment and isodose level bin on the native scalar type of the dose
+  template <class T>
+  void CountIsodoseVolumes(const T* dose, vtkIdType numberOfVoxels, const std::vector<unsigned char*>& segmentMasks,
+    const std::vector<double>& sortedLevels, std::vector<vtkIdType>& counts)
+  {
+    IsodoseVolumeCountingFunctor<T> counting(dose, segmentMasks, sortedLevels);
+    vtkSMPTools::For(0, numberOfVoxels, counting);
+    counts = counting.Counts;
+  }
+}
 
 //----------------------------------------------------------------------------
 vtkStandardNewMacro(vtkSlicerIsodoseModuleLogic);
@@ -138,6 +339,14 @@ void vtkSlicerIsodoseModuleLogic::UpdateFromMRMLScene()
     return;
   }
 
+  // Observe slice nodes that were added before this logic
+  std::vector<vtkMRMLNode*> sliceNodes;
+  this->GetMRMLScene()->GetNodesByClass("vtkMRMLSliceNode", sliceNodes);
+  for (vtkMRMLNode* sliceNode : sliceNodes)
+  {
+    this->ObserveSliceNode(sliceNode);
+  }
+
   this->Modified();
 }
 
@@ -150,6 +359,8 @@ void vtkSlicerIsodoseModuleLogic::OnMRMLSceneEndClose()
     return;
   }
 
+  this->SliceIsodoseLinesCache.clear();
+
   this->Modified();
 }
 
@@ -162,6 +373,11 @@ void vtkSlicerIsodoseModuleLogic::OnMRMLSceneNodeAdded(vtkMRMLNode* node)
     return;
   }
 
+  if (node->IsA("vtkMRMLSliceNode"))
+  {
+    this->ObserveSliceNode(node);
+  }
+
   // if the scene is still updating, jump out
   if (this->GetMRMLScene()->IsBatchProcessing())
   {
@@ -174,6 +390,47 @@ void vtkSlicerIsodoseModuleLogic::OnMRMLSceneNodeAdded(vtkMRMLNode* node)
   }
 }
 
+//---------------------------------------------------------------------------
+void vtkSlicerIsodoseModuleLogic::ObserveSliceNode(vtkMRMLNode* node)
+{
+  // Slice changes trigger the update of the per-slice isodose lines
+  vtkSmartPointer<vtkIntArray> events = vtkSmartPointer<vtkIntArray>::New();
+  events->InsertNextValue(vtkCommand::ModifiedEvent);
+  vtkObserveMRMLNodeEventsMacro(node, events);
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerIsodoseModuleLogic::ProcessMRMLNodesEvents(vtkObject* caller, unsigned long event, void* callData)
+{
+  Superclass::ProcessMRMLNodesEvents(caller, event, callData);
+
+  vtkMRMLScene* scene = this->GetMRMLScene();
+  if (!scene)
+  {
+    vtkErrorMacro("ProcessMRMLNodesEvents: Invalid MRML scene");
+    return;
+  }
+  if (scene->IsBatchProcessing())
+  {
+    return;
+  }
+
+  vtkMRMLSliceNode* sliceNode = vtkMRMLSliceNode::SafeDownCast(caller);
+  if (sliceNode && event == vtkCommand::ModifiedEvent)
+  {
+    std::vector<vtkMRMLNode*> parameterNodes;
+    scene->GetNodesByClass("vtkMRMLIsodoseNode", parameterNodes);
+    for (vtkMRMLNode* node : parameterNodes)
+    {
+      vtkMRMLIsodoseNode* parameterNode = vtkMRMLIsodoseNode::SafeDownCast(node);
+      if (parameterNode->GetSliceIsodoseLines() && parameterNode->GetShowIsodoseLines())
+      {
+        this->UpdateSliceIsodoseLines(parameterNode, sliceNode);
+      }
+    }
+  }
+}
+
 //---------------------------------------------------------------------------
 void vtkSlicerIsodoseModuleLogic::OnMRMLSceneNodeRemoved(vtkMRMLNode* node)
 {
@@ -243,9 +500,10 @@ vtkIdType vtkSlicerIsodoseModuleLogic::GetIsodoseFolderItemID(vtkMRMLNode* node)
   shNode->GetItemChildren(doseShItemID, doseChildItemIDs, false);
   for (vtkIdType childItemID : doseChildItemIDs)
   {
+    // Absolute and relative isodose folders are both considered
     std::string childItemName = shNode->GetItemName(childItemID);
-    std::string childItemNamePostfix = childItemName.substr(childItemName.size() - ISODOSE_ROOT_HIERARCHY_NAME_POSTFIX.size());
-    if (!childItemNamePostfix.compare(ISODOSE_ROOT_HIERARCHY_NAME_POSTFIX))
+    if ( vtksys::SystemTools::StringEndsWith(childItemName, ISODOSE_ROOT_HIERARCHY_NAME_POSTFIX.c_str())
+      || vtksys::SystemTools::StringEndsWith(childItemName, ISODOSE_RELATIVE_ROOT_HIERARCHY_NAME_POSTFIX.c_str()) )
     {
       return childItemID;
     }
@@ -626,6 +884,77 @@ void vtkSlicerIsodoseModuleLogic::SetNumberOfIsodoseLevels(vtkMRMLIsodoseNode* p
   //colorTableNode->SetAttribute("Category", vtkSlicerRtCommon::SLICERRT_EXTENSION_NAME);
 }
 
+//---------------------------------------------------------------------------
+bool vtkSlicerIsodoseModuleLogic::IsRelativeIsodoseRepresentation(vtkMRMLIsodoseNode* parameterNode)
+{
+  if (!parameterNode)
+  {
+    return false;
+  }
+
+  vtkMRMLIsodoseNode::DoseUnitsType doseUnits = parameterNode->GetDoseUnits();
+  if (parameterNode->GetRelativeRepresentationFlag() 
+    && (doseUnits == vtkMRMLIsodoseNode::Gy
+    || doseUnits == vtkMRMLIsodoseNode::Unknown))
+  {
+    return true;
+  }
+  return (doseUnits == vtkMRMLIsodoseNode::Relative);
+}
+
+//---------------------------------------------------------------------------
+std::string vtkSlicerIsodoseModuleLogic::GetIsodoseUnitName(vtkMRMLIsodoseNode* parameterNode)
+{
+  if (!parameterNode)
+  {
+    return "";
+  }
+
+  // force percentage dose units for relative isodose representation
+  if (vtkSlicerIsodoseModuleLogic::IsRelativeIsodoseRepresentation(parameterNode))
+  {
+    return "%";
+  }
+
+  switch (parameterNode->GetDoseUnits())
+  {
+  case vtkMRMLIsodoseNode::Gy:
+    return "Gy";
+  case vtkMRMLIsodoseNode::Relative:
+    return "%";
+  case vtkMRMLIsodoseNode::Unknown:
+  default:
+    return "MU";
+  }
+}
+
+//---------------------------------------------------------------------------
+bool vtkSlicerIsodoseModuleLogic::GetIsodoseLevelValues(vtkMRMLIsodoseNode* parameterNode, std::vector<double>& isoLevels)
+{
+  isoLevels.clear();
+  vtkMRMLColorTableNode* colorTableNode = (parameterNode ? parameterNode->GetColorTableNode() : nullptr);
+  if (!colorTableNode)
+  {
+    return false;
+  }
+
+  bool relativeFlag = vtkSlicerIsodoseModuleLogic::IsRelativeIsodoseRepresentation(parameterNode);
+  double referenceValue = parameterNode->GetReferenceDoseValue();
+  int numberOfLevels = colorTableNode->GetNumberOfColors();
+  isoLevels.resize(numberOfLevels, 0.0);
+  for (int i = 0; i < numberOfLevels; i++)
+  {
+    double isoLevel = vtkVariant(colorTableNode->GetColorName(i)).ToDouble();
+    // change isoLevel value for relative representation
+    if (relativeFlag && parameterNode->GetDoseUnits() != vtkMRMLIsodoseNode::Relative)
+    {
+      isoLevel = isoLevel * referenceValue / 100.;
+    }
+    isoLevels[i] = isoLevel;
+  }
+  return true;
+}
+
 //---------------------------------------------------------------------------
 void vtkSlicerIsodoseModuleLogic::CreateIsodoseSurfaces(vtkMRMLIsodoseNode* parameterNode)
 {
@@ -649,8 +978,6 @@ void vtkSlicerIsodoseModuleLogic::CreateIsodoseSurfaces(vtkMRMLIsodoseNode* para
     return;
   }
 
-  scene->StartState(vtkMRMLScene::BatchProcessState); 
-
   // Get subject hierarchy item for the dose volume
   vtkIdType doseShItemID = shNode->GetItemByDataNode(doseVolumeNode);
   if (!doseShItemID)
@@ -659,211 +986,973 @@ void vtkSlicerIsodoseModuleLogic::CreateIsodoseSurfaces(vtkMRMLIsodoseNode* para
     return;
   }
 
-  // Check existing isodose set and remove if exists
-  vtkIdType isodoseFolderItemID = this->GetIsodoseFolderItemID(doseVolumeNode);
-  if (isodoseFolderItemID)
+  // Get color table
+  vtkMRMLColorTableNode* colorTableNode = parameterNode->GetColorTableNode();
+  if (!colorTableNode)
   {
-    shNode->RemoveItem(isodoseFolderItemID, true, true);
+    vtkErrorMacro("CreateIsodoseSurfaces: Failed to get isodose color table node for dose volume " << doseVolumeNode->GetName());
+    return;
   }
 
   // Check if that absolute of relative values
-  bool relativeFlag = false;
-  vtkMRMLIsodoseNode::DoseUnitsType doseUnits = parameterNode->GetDoseUnits();
-  if (parameterNode->GetRelativeRepresentationFlag() 
-    && (doseUnits == vtkMRMLIsodoseNode::Gy
-    || doseUnits == vtkMRMLIsodoseNode::Unknown))
-  {
-    relativeFlag = true;
-  }
-  else if (doseUnits == vtkMRMLIsodoseNode::Relative)
-  {
-    relativeFlag = true;
-  }
+  bool relativeFlag = vtkSlicerIsodoseModuleLogic::IsRelativeIsodoseRepresentation(parameterNode);
   std::string isodoseName = relativeFlag ? 
     vtkSlicerIsodoseModuleLogic::ISODOSE_RELATIVE_ROOT_HIERARCHY_NAME_POSTFIX :
     vtkSlicerIsodoseModuleLogic::ISODOSE_ROOT_HIERARCHY_NAME_POSTFIX;
-
-  // Setup isodose subject hierarchy folder
   std::string isodoseFolderName = std::string(doseVolumeNode->GetName()) + isodoseName;
-  isodoseFolderItemID = shNode->CreateFolderItem(doseShItemID, isodoseFolderName);
 
-  // Get color table
-  vtkMRMLColorTableNode* colorTableNode = parameterNode->GetColorTableNode();
-  if (!colorTableNode)
+  // Set dose unit name
+  std::string doseUnitName = vtkSlicerIsodoseModuleLogic::GetIsodoseUnitName(parameterNode);
+
+  // Collect isodose level values
+  std::vector<double> isoLevels;
+  vtkSlicerIsodoseModuleLogic::GetIsodoseLevelValues(parameterNode, isoLevels);
+  int numberOfLevels = static_cast<int>(isoLevels.size());
+
+  scene->StartState(vtkMRMLScene::BatchProcessState); 
+
+  // Cached isodose surfaces can only be reused if the dose volume content and geometry did not change since they were
+  // extracted. Otherwise remove existing isodose set if exists and regenerate all levels.
+  std::string doseVolumeStateKey = vtkSlicerIsodoseModuleLogic::GetDoseVolumeStateKey(doseVolumeNode);
+  vtkIdType isodoseFolderItemID = this->GetIsodoseFolderItemID(doseVolumeNode);
+  if ( isodoseFolderItemID
+    && (parameterNode->GetIsodoseModelsDoseVolumeState() == nullptr
+      || doseVolumeStateKey.compare(parameterNode->GetIsodoseModelsDoseVolumeState())) )
   {
-    vtkErrorMacro("CreateIsodoseSurfaces: Failed to get isodose color table node for dose volume " << doseVolumeNode->GetName());
-    return;
+    shNode->RemoveItem(isodoseFolderItemID, true, true);
+    isodoseFolderItemID = 0;
   }
-
-  // Check that range is valid for dose and relative dose
-  // Set dose unit name
-  std::string doseUnitName = "Gy";
-  switch (doseUnits)
+  if (!isodoseFolderItemID)
   {
-  case vtkMRMLIsodoseNode::Gy:
-    break;
-  case vtkMRMLIsodoseNode::Relative:
-    doseUnitName = "%";
-    break;
-  case vtkMRMLIsodoseNode::Unknown:
-  default:
-    doseUnitName = "MU";
-    break;
+    parameterNode->RemoveAllIsodoseModelNodes();
+    isodoseFolderItemID = shNode->CreateFolderItem(doseShItemID, isodoseFolderName);
   }
-
-  // force percentage dose units for relative isodose representation
-  if (relativeFlag)
+  else
   {
-    doseUnitName = "%";
+    // Relative representation may have been toggled
+    shNode->SetItemName(isodoseFolderItemID, isodoseFolderName);
+  }
+  parameterNode->SetIsodoseModelsDoseVolumeState(doseVolumeStateKey.c_str());
+
+  // Match requested levels to the cached surfaces. Only the levels without a cached surface need to be extracted.
+  std::vector<vtkMRMLModelNode*> levelModelNodes(numberOfLevels, nullptr);
+  std::vector<bool> cachedModelUsed(parameterNode->GetNumberOfIsodoseModelNodes(), false);
+  std::vector<double> levelsToExtract;
+  std::vector<int> levelIndicesToExtract;
+  for (int i = 0; i < numberOfLevels; i++)
+  {
+    for (int cachedIndex = 0; cachedIndex < parameterNode->GetNumberOfIsodoseModelNodes(); ++cachedIndex)
+    {
+      vtkMRMLModelNode* cachedModelNode = parameterNode->GetNthIsodoseModelNode(cachedIndex);
+      if ( !cachedModelUsed[cachedIndex] && cachedModelNode
+        && vtkSlicerRtCommon::AreEqualWithTolerance(parameterNode->GetNthIsodoseModelLevelValue(cachedIndex), isoLevels[i]) )
+      {
+        levelModelNodes[i] = cachedModelNode;
+        cachedModelUsed[cachedIndex] = true;
+        break;
+      }
+    }
+    if (!levelModelNodes[i])
+    {
+      levelsToExtract.push_back(isoLevels[i]);
+      levelIndicesToExtract.push_back(i);
+    }
   }
-  
-  // Progress
-  int progressStepCount = colorTableNode->GetNumberOfColors() + 1 /* reslice step */;
-  int currentProgressStep = 0;
-
-  // Reslice dose volume
-  vtkSmartPointer<vtkMatrix4x4> inputIJK2RASMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
-  doseVolumeNode->GetIJKToRASMatrix(inputIJK2RASMatrix);
-  vtkSmartPointer<vtkMatrix4x4> inputRAS2IJKMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
-  doseVolumeNode->GetRASToIJKMatrix(inputRAS2IJKMatrix); 
-
-  vtkSmartPointer<vtkTransform> outputIJK2IJKResliceTransform = vtkSmartPointer<vtkTransform>::New(); 
-  outputIJK2IJKResliceTransform->Identity();
-  outputIJK2IJKResliceTransform->PostMultiply();
-  outputIJK2IJKResliceTransform->SetMatrix(inputIJK2RASMatrix);
 
-  vtkSmartPointer<vtkMRMLTransformNode> inputVolumeNodeTransformNode = doseVolumeNode->GetParentTransformNode();
-  vtkSmartPointer<vtkMatrix4x4> inputRAS2RASMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
-  if (inputVolumeNodeTransformNode!=nullptr)
+  // Cached models that are not used for any requested level anymore can be recycled for the new levels
+  std::deque<vtkMRMLModelNode*> unusedModelNodes;
+  for (int cachedIndex = 0; cachedIndex < parameterNode->GetNumberOfIsodoseModelNodes(); ++cachedIndex)
   {
-    inputVolumeNodeTransformNode->GetMatrixTransformToWorld(inputRAS2RASMatrix);  
-    outputIJK2IJKResliceTransform->Concatenate(inputRAS2RASMatrix);
+    vtkMRMLModelNode* cachedModelNode = parameterNode->GetNthIsodoseModelNode(cachedIndex);
+    if (!cachedModelUsed[cachedIndex] && cachedModelNode)
+    {
+      unusedModelNodes.push_back(cachedModelNode);
+    }
   }
-  
-  outputIJK2IJKResliceTransform->Concatenate(inputRAS2IJKMatrix);
-  outputIJK2IJKResliceTransform->Inverse();
-
-  int dimensions[3] = {0, 0, 0};
-  doseVolumeNode->GetImageData()->GetDimensions(dimensions);
-  vtkSmartPointer<vtkImageReslice> reslice = vtkSmartPointer<vtkImageReslice>::New();
-  reslice->SetInputData(doseVolumeNode->GetImageData());
-  reslice->SetOutputOrigin(0, 0, 0);
-  reslice->SetOutputSpacing(1, 1, 1);
-  reslice->SetOutputExtent(0, dimensions[0]-1, 0, dimensions[1]-1, 0, dimensions[2]-1);
-  reslice->SetResliceTransform(outputIJK2IJKResliceTransform);
-  reslice->Update();
-  vtkSmartPointer<vtkImageData> reslicedDoseVolumeImage = reslice->GetOutput(); 
+
+  // Progress: one step for matching the cached levels, one for each extracted level, and one for updating the models
+  int progressStepCount = static_cast<int>(levelsToExtract.size()) + 2;
+  int currentProgressStep = 0;
 
   // Report progress
   ++currentProgressStep;
   double progress = (double)(currentProgressStep) / (double)progressStepCount;
   this->InvokeEvent(vtkSlicerRtCommon::ProgressUpdated, (void*)&progress);
 
-  // reference value for relative representation
-  double referenceValue = parameterNode->GetReferenceDoseValue();
+  // The same level may appear multiple times in the color table. Surfaces of duplicate levels share their points and
+  // cells, so each unique level is extracted and post-processed once, and the duplicates get a copy of the result.
+  std::vector<double> uniqueLevelsToExtract(levelsToExtract);
+  std::sort(uniqueLevelsToExtract.begin(), uniqueLevelsToExtract.end());
+  uniqueLevelsToExtract.erase(std::unique(uniqueLevelsToExtract.begin(), uniqueLevelsToExtract.end()), uniqueLevelsToExtract.end());
 
-  // Create isodose surfaces
-  for (int i = 0; i < colorTableNode->GetNumberOfColors(); i++)
+  std::vector<vtkSmartPointer<vtkPolyData> > extractedPolyDatas(levelsToExtract.size());
+  if (!uniqueLevelsToExtract.empty())
   {
-    double val[6] = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
-    const char* strIsoLevel = colorTableNode->GetColorName(i);
-    double isoLevel = vtkVariant(strIsoLevel).ToDouble();
-    // change isoLevel value for relative representation
-    if (relativeFlag)
+    // Contour the dose voxels directly in their IJK frame. The volume geometry and the parent transform (if any)
+    // are applied to the vertices of the extracted surfaces, so the voxel grid never needs to be resampled.
+    vtkImageData* doseImageData = doseVolumeNode->GetImageData();
+    vtkSmartPointer<vtkImageData> ijkDoseImage = doseImageData;
+    double* doseImageOrigin = doseImageData->GetOrigin();
+    double* doseImageSpacing = doseImageData->GetSpacing();
+    if ( doseImageOrigin[0] != 0.0 || doseImageOrigin[1] != 0.0 || doseImageOrigin[2] != 0.0
+      || doseImageSpacing[0] != 1.0 || doseImageSpacing[1] != 1.0 || doseImageSpacing[2] != 1.0 )
     {
-      if (doseUnits != vtkMRMLIsodoseNode::Relative)
-      {
-        isoLevel = isoLevel * referenceValue / 100.;
-      }
+      // Geometry is normally stored in the volume node, but make sure the image is in IJK (no copy of the voxels)
+      vtkNew<vtkImageChangeInformation> ijkImageInformation;
+      ijkImageInformation->SetInputData(doseImageData);
+      ijkImageInformation->SetOutputOrigin(0, 0, 0);
+      ijkImageInformation->SetOutputSpacing(1, 1, 1);
+      ijkImageInformation->Update();
+      ijkDoseImage = ijkImageInformation->GetOutput();
+    }
+
+    // IJK to world transform for the surfaces. Non-linear parent transforms are supported as well.
+    vtkSmartPointer<vtkMatrix4x4> inputIJK2RASMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+    doseVolumeNode->GetIJKToRASMatrix(inputIJK2RASMatrix);
+    vtkSmartPointer<vtkGeneralTransform> inputIJKToWorldTransform = vtkSmartPointer<vtkGeneralTransform>::New();
+    inputIJKToWorldTransform->PostMultiply();
+    inputIJKToWorldTransform->Concatenate(inputIJK2RASMatrix);
+    vtkMRMLTransformNode* inputVolumeNodeTransformNode = doseVolumeNode->GetParentTransformNode();
+    if (inputVolumeNodeTransformNode)
+    {
+      vtkSmartPointer<vtkGeneralTransform> inputRASToWorldTransform = vtkSmartPointer<vtkGeneralTransform>::New();
+      inputVolumeNodeTransformNode->GetTransformToWorld(inputRASToWorldTransform);
+      inputIJKToWorldTransform->Concatenate(inputRASToWorldTransform);
     }
-    colorTableNode->GetColor(i, val);
 
-    vtkSmartPointer<vtkImageMarchingCubes> marchingCubes = vtkSmartPointer<vtkImageMarchingCubes>::New();
-    marchingCubes->SetInputData(reslicedDoseVolumeImage);
-    marchingCubes->SetNumberOfContours(1); 
-    marchingCubes->SetValue(0, isoLevel);
-    marchingCubes->ComputeScalarsOff();
-    marchingCubes->ComputeGradientsOff();
-    marchingCubes->ComputeNormalsOff();
-    marchingCubes->Update();
-
-    vtkSmartPointer<vtkPolyData> isoPolyData= marchingCubes->GetOutput();
-    if (isoPolyData->GetNumberOfPoints() >= 1)
-    {
-      vtkSmartPointer<vtkTriangleFilter> triangleFilter = vtkSmartPointer<vtkTriangleFilter>::New();
-      triangleFilter->SetInputData(marchingCubes->GetOutput());
-      triangleFilter->Update();
-
-      vtkSmartPointer<vtkDecimatePro> decimate = vtkSmartPointer<vtkDecimatePro>::New();
-      decimate->SetInputData(triangleFilter->GetOutput());
-      decimate->SetTargetReduction(0.6);
-      decimate->SetFeatureAngle(60);
-      decimate->SplittingOff();
-      decimate->PreserveTopologyOn();
-      decimate->SetMaximumError(1);
-      decimate->Update();
-
-      vtkSmartPointer<vtkWindowedSincPolyDataFilter> smootherSinc = vtkSmartPointer<vtkWindowedSincPolyDataFilter>::New();
-      smootherSinc->SetPassBand(0.1);
-      smootherSinc->SetInputData(decimate->GetOutput() );
-      smootherSinc->SetNumberOfIterations(2);
-      smootherSinc->FeatureEdgeSmoothingOff();
-      smootherSinc->BoundarySmoothingOff();
-      smootherSinc->Update();
-
-      vtkSmartPointer<vtkPolyDataNormals> normals = vtkSmartPointer<vtkPolyDataNormals>::New();
-      normals->SetInputData(smootherSinc->GetOutput());
-      normals->ComputePointNormalsOn();
-      normals->SetFeatureAngle(60);
-      normals->Update();
-
-      vtkSmartPointer<vtkTransform> inputIJKToRASTransform = vtkSmartPointer<vtkTransform>::New();
-      inputIJKToRASTransform->Identity();
-      inputIJKToRASTransform->SetMatrix(inputIJK2RASMatrix);
+    // Extract all missing isodose levels in one multi-threaded pass, then split the output into one surface per level
+    std::vector<vtkSmartPointer<vtkPolyData> > uniqueLevelPolyDatas;
+    vtkSlicerIsodoseModuleLogic::ExtractIsosurfaces(ijkDoseImage, uniqueLevelsToExtract, uniqueLevelPolyDatas);
 
+    // Post-process the level surfaces in parallel (grain of one level, as the levels are few but heavy)
+    IsosurfacePostProcessingFunctor postProcessing(uniqueLevelPolyDatas);
+    vtkSMPTools::For(0, static_cast<vtkIdType>(uniqueLevelPolyDatas.size()), 1, postProcessing);
+
+    for (size_t uniqueLevelIndex = 0; uniqueLevelIndex < uniqueLevelPolyDatas.size(); ++uniqueLevelIndex)
+    {
+      vtkPolyData* isoPolyData = uniqueLevelPolyDatas[uniqueLevelIndex];
+      if (!isoPolyData || isoPolyData->GetNumberOfPoints() < 1)
+      {
+        // Levels without surface are cached as empty surface too, so that they are not extracted again on the next update
+        uniqueLevelPolyDatas[uniqueLevelIndex] = vtkSmartPointer<vtkPolyData>::New();
+        continue;
+      }
       vtkSmartPointer<vtkTransformPolyDataFilter> transformPolyData = vtkSmartPointer<vtkTransformPolyDataFilter>::New();
-      transformPolyData->SetInputData(normals->GetOutput());
-      transformPolyData->SetTransform(inputIJKToRASTransform);
+      transformPolyData->SetInputData(isoPolyData);
+      transformPolyData->SetTransform(inputIJKToWorldTransform);
       transformPolyData->Update();
-  
+      uniqueLevelPolyDatas[uniqueLevelIndex] = transformPolyData->GetOutput();
+    }
+
+    // Hand the final surfaces out to the requested levels. Duplicate levels get a shallow copy of the same surface.
+    std::vector<bool> uniqueLevelAssigned(uniqueLevelsToExtract.size(), false);
+    for (size_t extractedIndex = 0; extractedIndex < levelsToExtract.size(); ++extractedIndex)
+    {
+      size_t uniqueLevelIndex = std::lower_bound(uniqueLevelsToExtract.begin(), uniqueLevelsToExtract.end(),
+        levelsToExtract[extractedIndex]) - uniqueLevelsToExtract.begin();
+      vtkPolyData* uniqueLevelPolyData = uniqueLevelPolyDatas[uniqueLevelIndex];
+      if (!uniqueLevelAssigned[uniqueLevelIndex])
+      {
+        extractedPolyDatas[extractedIndex] = uniqueLevelPolyData;
+        uniqueLevelAssigned[uniqueLevelIndex] = true;
+      }
+      else
+      {
+        vtkSmartPointer<vtkPolyData> duplicateLevelPolyData = vtkSmartPointer<vtkPolyData>::New();
+        duplicateLevelPolyData->ShallowCopy(uniqueLevelPolyData);
+        extractedPolyDatas[extractedIndex] = duplicateLevelPolyData;
+      }
+    }
+  }
+
+  // Report progress
+  currentProgressStep += static_cast<int>(levelsToExtract.size());
+  progress = (double)(currentProgressStep) / (double)progressStepCount;
+  this->InvokeEvent(vtkSlicerRtCommon::ProgressUpdated, (void*)&progress);
+
+  // Assign newly extracted surfaces to recycled or new isodose model nodes
+  for (size_t extractedIndex = 0; extractedIndex < levelIndicesToExtract.size(); ++extractedIndex)
+  {
+    vtkPolyData* isoPolyData = extractedPolyDatas[extractedIndex];
+    if (!isoPolyData)
+    {
+      continue;
+    }
+    int i = levelIndicesToExtract[extractedIndex];
+    vtkMRMLModelNode* isodoseModelNode = nullptr;
+    if (!unusedModelNodes.empty())
+    {
+      isodoseModelNode = unusedModelNodes.front();
+      unusedModelNodes.pop_front();
+    }
+    else
+    {
       vtkSmartPointer<vtkMRMLModelDisplayNode> displayNode = vtkSmartPointer<vtkMRMLModelDisplayNode>::New();
       displayNode = vtkMRMLModelDisplayNode::SafeDownCast(scene->AddNode(displayNode));
-      displayNode->Visibility2DOn();  
+      // Slice views show the per-slice isodose lines instead of the surface intersections if enabled
+      displayNode->SetVisibility2D(!parameterNode->GetSliceIsodoseLines());
       displayNode->VisibilityOn(); 
-      displayNode->SetColor(val[0], val[1], val[2]);
-      displayNode->SetOpacity(val[3]);
-    
       // Disable backface culling to make the back side of the model visible as well
       displayNode->SetBackfaceCulling(0);
 
-      vtkSmartPointer<vtkMRMLModelNode> isodoseModelNode = vtkSmartPointer<vtkMRMLModelNode>::New();
-      std::string isodoseModelNodeName = vtkSlicerIsodoseModuleLogic::ISODOSE_MODEL_NODE_NAME_PREFIX + strIsoLevel + doseUnitName;
-      isodoseModelNode->SetName(isodoseModelNodeName.c_str());
-      isodoseModelNode->SetSelectable(1);
-      isodoseModelNode->SetAttribute(vtkSlicerRtCommon::DICOMRTIMPORT_ISODOSE_MODEL_IDENTIFIER_ATTRIBUTE_NAME.c_str(), "1"); // The attribute above distinguishes isodoses from regular models
-      scene->AddNode(isodoseModelNode);
-      isodoseModelNode->SetAndObserveDisplayNodeID(displayNode->GetID());
-      isodoseModelNode->SetAndObservePolyData(transformPolyData->GetOutput());
-      shNode->RequestOwnerPluginSearch(isodoseModelNode); //TODO: Why is this needed?
+      vtkSmartPointer<vtkMRMLModelNode> newIsodoseModelNode = vtkSmartPointer<vtkMRMLModelNode>::New();
+      newIsodoseModelNode->SetSelectable(1);
+      newIsodoseModelNode->SetAttribute(vtkSlicerRtCommon::DICOMRTIMPORT_ISODOSE_MODEL_IDENTIFIER_ATTRIBUTE_NAME.c_str(), "1"); // The attribute above distinguishes isodoses from regular models
+      scene->AddNode(newIsodoseModelNode);
+      newIsodoseModelNode->SetAndObserveDisplayNodeID(displayNode->GetID());
+      shNode->RequestOwnerPluginSearch(newIsodoseModelNode); //TODO: Why is this needed?
 
       // Put the new node in the isodose folder
-      vtkIdType isodoseModelItemID = shNode->GetItemByDataNode(isodoseModelNode);
+      vtkIdType isodoseModelItemID = shNode->GetItemByDataNode(newIsodoseModelNode);
       if (isodoseModelItemID) // There is no automatic SH creation in automatic tests 
       {
         shNode->SetItemParent(isodoseModelItemID, isodoseFolderItemID);
       }
+      isodoseModelNode = newIsodoseModelNode;
+    }
+    isodoseModelNode->SetAndObservePolyData(isoPolyData);
+    levelModelNodes[i] = isodoseModelNode;
+  }
+
+  // Remove cached models that are not needed anymore
+  for (vtkMRMLModelNode* unusedModelNode : unusedModelNodes)
+  {
+    vtkMRMLDisplayNode* unusedDisplayNode = unusedModelNode->GetDisplayNode();
+    scene->RemoveNode(unusedModelNode);
+    if (unusedDisplayNode)
+    {
+      scene->RemoveNode(unusedDisplayNode);
+    }
+  }
+
+  // Update name and color of all isodose models in place, and store them as the new cache in level order
+  parameterNode->RemoveAllIsodoseModelNodes();
+  for (int i = 0; i < numberOfLevels; i++)
+  {
+    vtkMRMLModelNode* isodoseModelNode = levelModelNodes[i];
+    if (!isodoseModelNode)
+    {
+      continue;
+    }
+    double val[6] = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
+    const char* strIsoLevel = colorTableNode->GetColorName(i);
+    colorTableNode->GetColor(i, val);
+
+    std::string isodoseModelNodeName = vtkSlicerIsodoseModuleLogic::ISODOSE_MODEL_NODE_NAME_PREFIX + strIsoLevel + doseUnitName;
+    isodoseModelNode->SetName(isodoseModelNodeName.c_str());
+    vtkMRMLDisplayNode* displayNode = isodoseModelNode->GetDisplayNode();
+    if (displayNode)
+    {
+      displayNode->SetColor(val[0], val[1], val[2]);
+      displayNode->SetOpacity(val[3]);
     }
 
-    // Report progress
-    ++currentProgressStep;
-    progress = (double)(currentProgressStep) / (double)progressStepCount;
-    this->InvokeEvent(vtkSlicerRtCommon::ProgressUpdated, (void*)&progress);
+    parameterNode->AddIsodoseModelNode(isodoseModelNode, isoLevels[i]);
   } // For all isodose levels
 
+  // Report progress
+  currentProgressStep = progressStepCount;
+  progress = 1.0;
+  this->InvokeEvent(vtkSlicerRtCommon::ProgressUpdated, (void*)&progress);
+
   // Update dose color table based on isodose
   this->UpdateDoseColorTableFromIsodose(parameterNode);
 
   scene->EndState(vtkMRMLScene::BatchProcessState);
+
+  // Levels may have changed, so update the per-slice isodose lines as well
+  if (parameterNode->GetSliceIsodoseLines())
+  {
+    this->UpdateSliceIsodoseLinesInAllViews(parameterNode);
+  }
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerIsodoseModuleLogic::ExtractIsolines(vtkImageData* doseSliceImageData, const std::vector<double>& isoLevels,
+  vtkPolyData* isolinePolyData)
+{
+  if (!isolinePolyData)
+  {
+    return;
+  }
+  isolinePolyData->Initialize();
+  if (!doseSliceImageData || isoLevels.empty())
+  {
+    return;
+  }
+
+  // The contour value is stored in the output point scalars, which identifies the level of each line. Integer dose is only
+  // cast to float if two levels would be stored as the same integer value.
+  std::vector<double> contourScalarValues;
+  vtkSmartPointer<vtkImageData> contourInputImage = doseSliceImageData;
+  if (!GetContourScalarValues(doseSliceImageData->GetScalarType(), isoLevels, contourScalarValues))
+  {
+    vtkNew<vtkImageCast> cast;
+    cast->SetInputData(doseSliceImageData);
+    cast->SetOutputScalarTypeToFloat();
+    cast->Update();
+    contourInputImage = cast->GetOutput();
+  }
+
+  // Contour all levels of the slice in one marching squares pass
+  vtkNew<vtkMarchingSquares> marchingSquares;
+  marchingSquares->SetInputData(contourInputImage);
+  marchingSquares->SetNumberOfContours(static_cast<int>(isoLevels.size()));
+  for (size_t levelIndex = 0; levelIndex < isoLevels.size(); ++levelIndex)
+  {
+    marchingSquares->SetValue(static_cast<int>(levelIndex), isoLevels[levelIndex]);
+  }
+  marchingSquares->Update();
+  vtkPolyData* contourPolyData = marchingSquares->GetOutput();
+  vtkDataArray* contourValues = contourPolyData->GetPointData()->GetScalars();
+  if (!contourValues || contourPolyData->GetNumberOfLines() < 1)
+  {
+    return;
+  }
+  GetContourScalarValues(contourValues->GetDataType(), isoLevels, contourScalarValues);
+
+  // Store the index of the level (i.e. the isodose color table entry) for each line segment for coloring
+  vtkNew<vtkIntArray> levelIndexArray;
+  levelIndexArray->SetName(ISODOSE_LEVEL_INDEX_ARRAY_NAME);
+  levelIndexArray->SetNumberOfValues(contourPolyData->GetNumberOfLines());
+  vtkCellArray* lines = contourPolyData->GetLines();
+  vtkNew<vtkIdList> linePointIds;
+  lines->InitTraversal();
+  for (vtkIdType lineIndex = 0; lines->GetNextCell(linePointIds); ++lineIndex)
+  {
+    double contourValue = contourValues->GetTuple1(linePointIds->GetId(0));
+    int nearestLevelIndex = 0;
+    for (size_t levelIndex = 1; levelIndex < isoLevels.size(); ++levelIndex)
+    {
+      if (fabs(contourScalarValues[levelIndex] - contourValue) < fabs(contourScalarValues[nearestLevelIndex] - contourValue))
+      {
+        nearestLevelIndex = static_cast<int>(levelIndex);
+      }
+    }
+    levelIndexArray->SetValue(lineIndex, nearestLevelIndex);
+  }
+
+  isolinePolyData->SetPoints(contourPolyData->GetPoints());
+  isolinePolyData->SetLines(lines);
+  isolinePolyData->GetCellData()->AddArray(levelIndexArray);
+  isolinePolyData->GetCellData()->SetActiveScalars(ISODOSE_LEVEL_INDEX_ARRAY_NAME);
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerIsodoseModuleLogic::UpdateSliceIsodoseLines(vtkMRMLIsodoseNode* parameterNode, vtkMRMLSliceNode* sliceNode)
+{
+  vtkMRMLScene* scene = this->GetMRMLScene();
+  if (!scene || !parameterNode || !sliceNode)
+  {
+    vtkErrorMacro("UpdateSliceIsodoseLines: Invalid scene, parameter set node, or slice node");
+    return;
+  }
+  if (!parameterNode->GetSliceIsodoseLines() || !parameterNode->GetShowIsodoseLines())
+  {
+    return;
+  }
+  vtkMRMLScalarVolumeNode* doseVolumeNode = parameterNode->GetDoseVolumeNode();
+  vtkMRMLColorTableNode* colorTableNode = parameterNode->GetColorTableNode();
+  if (!doseVolumeNode || !doseVolumeNode->GetImageData() || !colorTableNode)
+  {
+    return;
+  }
+  vtkMRMLTransformNode* doseTransformNode = doseVolumeNode->GetParentTransformNode();
+  if (doseTransformNode && !doseTransformNode->IsTransformToWorldLinear())
+  {
+    vtkErrorMacro("UpdateSliceIsodoseLines: Per-slice isodose lines are not supported for dose volumes under non-linear transform");
+    return;
+  }
+
+  std::vector<double> isoLevels;
+  vtkSlicerIsodoseModuleLogic::GetIsodoseLevelValues(parameterNode, isoLevels);
+
+  // Cached lines are valid as long as the dose volume and the levels do not change
+  std::stringstream cacheStateStream;
+  cacheStateStream << vtkSlicerIsodoseModuleLogic::GetDoseVolumeStateKey(doseVolumeNode);
+  for (double isoLevel : isoLevels)
+  {
+    cacheStateStream << "|" << isoLevel;
+  }
+  std::string parameterNodeID(parameterNode->GetID());
+  SliceIsodoseLinesCacheType& sliceLinesCache = this->SliceIsodoseLinesCache[parameterNodeID];
+  if (sliceLinesCache.State != cacheStateStream.str())
+  {
+    sliceLinesCache.State = cacheStateStream.str();
+    sliceLinesCache.Lines.clear();
+    sliceLinesCache.ObliqueSliceKeys.clear();
+  }
+
+  // Dose IJK to world transform
+  vtkNew<vtkMatrix4x4> ijkToWorldMatrix;
+  doseVolumeNode->GetIJKToRASMatrix(ijkToWorldMatrix);
+  if (doseTransformNode)
+  {
+    vtkNew<vtkMatrix4x4> rasToWorldMatrix;
+    doseTransformNode->GetMatrixTransformToWorld(rasToWorldMatrix);
+    vtkMatrix4x4::Multiply4x4(rasToWorldMatrix, ijkToWorldMatrix, ijkToWorldMatrix);
+  }
+  vtkNew<vtkMatrix4x4> worldToIJKMatrix;
+  vtkMatrix4x4::Invert(ijkToWorldMatrix, worldToIJKMatrix);
+
+  // Slice plane in the dose IJK frame
+  vtkNew<vtkMatrix4x4> sliceToIJKMatrix;
+  vtkMatrix4x4::Multiply4x4(worldToIJKMatrix, sliceNode->GetSliceToRAS(), sliceToIJKMatrix);
+
+  vtkImageData* doseImageData = doseVolumeNode->GetImageData();
+  int doseExtent[6] = {0, -1, 0, -1, 0, -1};
+  doseImageData->GetExtent(doseExtent);
+
+  // If the slice plane is a voxel plane of the dose (the common case of the slice views aligned to the dose grid),
+  // then the lines are extracted from the voxels of that plane, and the slice is identified by its index
+  double sliceNormalIJK[3] = {0.0, 0.0, 0.0};
+  for (int i = 0; i < 3; ++i)
+  {
+    sliceNormalIJK[i] = sliceToIJKMatrix->GetElement(i, 2);
+  }
+  vtkMath::Normalize(sliceNormalIJK);
+  int alignedAxis = -1;
+  for (int i = 0; i < 3; ++i)
+  {
+    if (fabs(fabs(sliceNormalIJK[i]) - 1.0) < 1e-4)
+    {
+      alignedAxis = i;
+    }
+  }
+  int sliceIndex = 0;
+  if (alignedAxis >= 0)
+  {
+    double slicePositionIJK = sliceToIJKMatrix->GetElement(alignedAxis, 3);
+    sliceIndex = static_cast<int>(floor(slicePositionIJK + 0.5));
+    if ( fabs(slicePositionIJK - sliceIndex) > 0.01
+      || sliceIndex < doseExtent[alignedAxis * 2] || sliceIndex > doseExtent[alignedAxis * 2 + 1] )
+    {
+      alignedAxis = -1;
+    }
+  }
+
+  std::stringstream sliceKeyStream;
+  if (alignedAxis >= 0)
+  {
+    sliceKeyStream << "IJK" << alignedAxis << ":" << sliceIndex;
+  }
+  else
+  {
+    // Oblique or in-between slices are identified by the exact plane
+    sliceKeyStream << "Plane";
+    for (int row = 0; row < 3; ++row)
+    {
+      for (int column = 0; column < 4; ++column)
+      {
+        sliceKeyStream << ":" << sliceToIJKMatrix->GetElement(row, column);
+      }
+    }
+  }
+  std::string sliceKey = sliceKeyStream.str();
+
+  vtkSmartPointer<vtkPolyData> sliceLines;
+  std::map<std::string, vtkSmartPointer<vtkPolyData> >::iterator cachedLinesIt = sliceLinesCache.Lines.find(sliceKey);
+  if (cachedLinesIt != sliceLinesCache.Lines.end())
+  {
+    sliceLines = cachedLinesIt->second;
+  }
+  else
+  {
+    vtkNew<vtkPolyData> sliceLinesIJK;
+    vtkNew<vtkTransform> sliceLinesToWorldTransform;
+    if (alignedAxis >= 0)
+    {
+      // Dose voxels of the displayed slice, in IJK coordinates
+      int sliceExtent[6] = {doseExtent[0], doseExtent[1], doseExtent[2], doseExtent[3], doseExtent[4], doseExtent[5]};
+      sliceExtent[alignedAxis * 2] = sliceIndex;
+      sliceExtent[alignedAxis * 2 + 1] = sliceIndex;
+      vtkNew<vtkExtractVOI> extractSlice;
+      extractSlice->SetInputData(doseImageData);
+      extractSlice->SetVOI(sliceExtent);
+      extractSlice->Update();
+      vtkNew<vtkImageChangeInformation> ijkSliceInformation;
+      ijkSliceInformation->SetInputData(extractSlice->GetOutput());
+      ijkSliceInformation->SetOutputOrigin(0, 0, 0);
+      ijkSliceInformation->SetOutputSpacing(1, 1, 1);
+      ijkSliceInformation->Update();
+      vtkSlicerIsodoseModuleLogic::ExtractIsolines(ijkSliceInformation->GetOutput(), isoLevels, sliceLinesIJK);
+      sliceLinesToWorldTransform->SetMatrix(ijkToWorldMatrix);
+    }
+    else
+    {
+      // Reslice the dose on the displayed plane with the finest dose spacing, covering the whole dose volume
+      double doseSpacing[3] = {1.0, 1.0, 1.0};
+      doseVolumeNode->GetSpacing(doseSpacing);
+      double resliceSpacing = std::min(doseSpacing[0], std::min(doseSpacing[1], doseSpacing[2]));
+      vtkNew<vtkMatrix4x4> ijkToSliceMatrix;
+      vtkMatrix4x4::Invert(sliceToIJKMatrix, ijkToSliceMatrix);
+      double sliceBounds[4] = {VTK_DOUBLE_MAX, VTK_DOUBLE_MIN, VTK_DOUBLE_MAX, VTK_DOUBLE_MIN};
+      for (int corner = 0; corner < 8; ++corner)
+      {
+        double cornerIJK[4] = { static_cast<double>(doseExtent[(corner & 1) ? 1 : 0]),
+          static_cast<double>(doseExtent[(corner & 2) ? 3 : 2]), static_cast<double>(doseExtent[(corner & 4) ? 5 : 4]), 1.0 };
+        double cornerSlice[4] = {0.0, 0.0, 0.0, 1.0};
+        ijkToSliceMatrix->MultiplyPoint(cornerIJK, cornerSlice);
+        sliceBounds[0] = std::min(sliceBounds[0], cornerSlice[0]);
+        sliceBounds[1] = std::max(sliceBounds[1], cornerSlice[0]);
+        sliceBounds[2] = std::min(sliceBounds[2], cornerSlice[1]);
+        sliceBounds[3] = std::max(sliceBounds[3], cornerSlice[1]);
+      }
+
+      vtkNew<vtkImageChangeInformation> ijkImageInformation;
+      ijkImageInformation->SetInputData(doseImageData);
+      ijkImageInformation->SetOutputOrigin(0, 0, 0);
+      ijkImageInformation->SetOutputSpacing(1, 1, 1);
+      ijkImageInformation->Update();
+      vtkNew<vtkImageReslice> reslice;
+      reslice->SetInputData(ijkImageInformation->GetOutput());
+      reslice->SetResliceAxes(sliceToIJKMatrix);
+      reslice->SetOutputOrigin(0, 0, 0);
+      reslice->SetOutputSpacing(resliceSpacing, resliceSpacing, 1.0);
+      reslice->SetOutputExtent(
+        static_cast<int>(floor(sliceBounds[0] / resliceSpacing)), static_cast<int>(ceil(sliceBounds[1] / resliceSpacing)),
+        static_cast<int>(floor(sliceBounds[2] / resliceSpacing)), static_cast<int>(ceil(sliceBounds[3] / resliceSpacing)),
+        0, 0 );
+      reslice->SetOutputScalarType(VTK_FLOAT);
+      reslice->SetBackgroundLevel(*std::min_element(isoLevels.begin(), isoLevels.end()) - 1.0);
+      reslice->SetInterpolationModeToLinear();
+      reslice->Update();
+      vtkSlicerIsodoseModuleLogic::ExtractIsolines(reslice->GetOutput(), isoLevels, sliceLinesIJK);
+      sliceLinesToWorldTransform->SetMatrix(sliceNode->GetSliceToRAS());
+    }
+
+    vtkNew<vtkTransformPolyDataFilter> transformSliceLines;
+    transformSliceLines->SetInputData(sliceLinesIJK);
+    transformSliceLines->SetTransform(sliceLinesToWorldTransform);
+    transformSliceLines->Update();
+    sliceLines = transformSliceLines->GetOutput();
+
+    if (alignedAxis < 0)
+    {
+      if (sliceLinesCache.ObliqueSliceKeys.size() >= SLICE_ISODOSE_LINES_OBLIQUE_CACHE_MAXIMUM_SIZE)
+      {
+        sliceLinesCache.Lines.erase(sliceLinesCache.ObliqueSliceKeys.front());
+        sliceLinesCache.ObliqueSliceKeys.pop_front();
+      }
+      sliceLinesCache.ObliqueSliceKeys.push_back(sliceKey);
+    }
+    sliceLinesCache.Lines[sliceKey] = sliceLines;
+  }
+
+  vtkMRMLModelNode* sliceLinesModelNode = this->GetSliceIsodoseLinesModelNode(parameterNode, sliceNode);
+  if (sliceLinesModelNode->GetPolyData() != sliceLines)
+  {
+    sliceLinesModelNode->SetAndObservePolyData(sliceLines);
+  }
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerIsodoseModuleLogic::UpdateSliceIsodoseLinesInAllViews(vtkMRMLIsodoseNode* parameterNode)
+{
+  vtkMRMLScene* scene = this->GetMRMLScene();
+  if (!scene || !parameterNode)
+  {
+    vtkErrorMacro("UpdateSliceIsodoseLinesInAllViews: Invalid scene or parameter set node");
+    return;
+  }
+
+  if (!parameterNode->GetSliceIsodoseLines() || !parameterNode->GetShowIsodoseLines())
+  {
+    this->RemoveSliceIsodoseLines(parameterNode);
+    return;
+  }
+
+  std::vector<vtkMRMLNode*> sliceNodes;
+  scene->GetNodesByClass("vtkMRMLSliceNode", sliceNodes);
+  for (vtkMRMLNode* sliceNode : sliceNodes)
+  {
+    this->UpdateSliceIsodoseLines(parameterNode, vtkMRMLSliceNode::SafeDownCast(sliceNode));
+  }
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerIsodoseModuleLogic::RemoveSliceIsodoseLines(vtkMRMLIsodoseNode* parameterNode)
+{
+  vtkMRMLScene* scene = this->GetMRMLScene();
+  if (!scene || !parameterNode)
+  {
+    vtkErrorMacro("RemoveSliceIsodoseLines: Invalid scene or parameter set node");
+    return;
+  }
+
+  std::vector<vtkMRMLModelNode*> sliceLinesModelNodes;
+  for (int i = 0; i < parameterNode->GetNumberOfNodeReferences(SLICE_ISODOSE_LINES_MODEL_REFERENCE_ROLE); ++i)
+  {
+    vtkMRMLModelNode* sliceLinesModelNode = vtkMRMLModelNode::SafeDownCast(
+      parameterNode->GetNthNodeReference(SLICE_ISODOSE_LINES_MODEL_REFERENCE_ROLE, i) );
+    if (sliceLinesModelNode)
+    {
+      sliceLinesModelNodes.push_back(sliceLinesModelNode);
+    }
+  }
+  parameterNode->RemoveNodeReferenceIDs(SLICE_ISODOSE_LINES_MODEL_REFERENCE_ROLE);
+  for (vtkMRMLModelNode* sliceLinesModelNode : sliceLinesModelNodes)
+  {
+    vtkMRMLDisplayNode* sliceLinesDisplayNode = sliceLinesModelNode->GetDisplayNode();
+    scene->RemoveNode(sliceLinesModelNode);
+    if (sliceLinesDisplayNode)
+    {
+      scene->RemoveNode(sliceLinesDisplayNode);
+    }
+  }
+
+  if (parameterNode->GetID())
+  {
+    this->SliceIsodoseLinesCache.erase(parameterNode->GetID());
+  }
+}
+
+//---------------------------------------------------------------------------
+vtkMRMLModelNode* vtkSlicerIsodoseModuleLogic::GetSliceIsodoseLinesModelNode(vtkMRMLIsodoseNode* parameterNode, vtkMRMLSliceNode* sliceNode)
+{
+  // Each slice view has its own lines model, displayed only in that view
+  for (int i = 0; i < parameterNode->GetNumberOfNodeReferences(SLICE_ISODOSE_LINES_MODEL_REFERENCE_ROLE); ++i)
+  {
+    vtkMRMLModelNode* sliceLinesModelNode = vtkMRMLModelNode::SafeDownCast(
+      parameterNode->GetNthNodeReference(SLICE_ISODOSE_LINES_MODEL_REFERENCE_ROLE, i) );
+    if ( sliceLinesModelNode && sliceLinesModelNode->GetDisplayNode()
+      && sliceLinesModelNode->GetDisplayNode()->IsDisplayableInView(sliceNode->GetID()) )
+    {
+      return sliceLinesModelNode;
+    }
+  }
+
+  vtkMRMLScene* scene = this->GetMRMLScene();
+  vtkMRMLColorTableNode* colorTableNode = parameterNode->GetColorTableNode();
+
+  vtkSmartPointer<vtkMRMLModelDisplayNode> displayNode = vtkSmartPointer<vtkMRMLModelDisplayNode>::New();
+  displayNode->SetHideFromEditors(1);
+  displayNode->SetSaveWithScene(false);
+  scene->AddNode(displayNode);
+  displayNode->SetViewNodeIDs(std::vector<std::string>(1, sliceNode->GetID()));
+  displayNode->Visibility3DOff();
+  displayNode->Visibility2DOn();
+  displayNode->SetSliceIntersectionThickness(2);
+  displayNode->SetAndObserveColorNodeID(colorTableNode ? colorTableNode->GetID() : nullptr);
+#if Slicer_VERSION_MAJOR >= 5 || (Slicer_VERSION_MAJOR >= 4 && Slicer_VERSION_MINOR >= 11)
+  // The lines lie in the slice plane, so they are projected instead of intersected with the slice
+  displayNode->SetSliceDisplayModeToProjection();
+  displayNode->SetActiveScalar(ISODOSE_LEVEL_INDEX_ARRAY_NAME, vtkAssignAttribute::CELL_DATA);
+  displayNode->SetScalarRangeFlag(vtkMRMLDisplayNode::UseColorNodeScalarRange);
+#else
+  // Slice projection display mode is not available, the lines are shown where the slice intersects them
+  displayNode->SetActiveScalarName(ISODOSE_LEVEL_INDEX_ARRAY_NAME);
+  displayNode->SetActiveAttributeLocation(vtkAssignAttribute::CELL_DATA);
+  if (colorTableNode)
+  {
+    displayNode->SetScalarRange(0, colorTableNode->GetNumberOfColors() - 1);
+  }
+#endif
+  displayNode->ScalarVisibilityOn();
+
+  vtkSmartPointer<vtkMRMLModelNode> sliceLinesModelNode = vtkSmartPointer<vtkMRMLModelNode>::New();
+  std::string sliceLinesModelNodeName = std::string(parameterNode->GetDoseVolumeNode()->GetName()) + "_IsodoseLines_" + sliceNode->GetName();
+  sliceLinesModelNode->SetName(sliceLinesModelNodeName.c_str());
+  sliceLinesModelNode->SetHideFromEditors(1);
+  sliceLinesModelNode->SetSelectable(0);
+  sliceLinesModelNode->SetSaveWithScene(false);
+  sliceLinesModelNode->SetAttribute(vtkMRMLSubjectHierarchyConstants::GetSubjectHierarchyExcludeFromTreeAttributeName().c_str(), "1");
+  scene->AddNode(sliceLinesModelNode);
+  sliceLinesModelNode->SetAndObserveDisplayNodeID(displayNode->GetID());
+
+  parameterNode->AddNodeReferenceID(SLICE_ISODOSE_LINES_MODEL_REFERENCE_ROLE, sliceLinesModelNode->GetID());
+  return sliceLinesModelNode;
+}
+
+//---------------------------------------------------------------------------
+std::string vtkSlicerIsodoseModuleLogic::GetDoseVolumeStateKey(vtkMRMLScalarVolumeNode* doseVolumeNode)
+{
+  if (!doseVolumeNode || !doseVolumeNode->GetImageData())
+  {
+    return "";
+  }
+
+  // Voxel content, lattice geometry, and transform to world all affect the isodose surfaces
+  std::stringstream stateStream;
+  stateStream << doseVolumeNode->GetImageData()->GetMTime();
+  vtkNew<vtkMatrix4x4> ijkToRasMatrix;
+  doseVolumeNode->GetIJKToRASMatrix(ijkToRasMatrix);
+  for (int row = 0; row < 3; ++row)
+  {
+    for (int column = 0; column < 4; ++column)
+    {
+      stateStream << "|" << ijkToRasMatrix->GetElement(row, column);
+    }
+  }
+  for ( vtkMRMLTransformNode* parentTransformNode = doseVolumeNode->GetParentTransformNode();
+    parentTransformNode; parentTransformNode = parentTransformNode->GetParentTransformNode() )
+  {
+    stateStream << "|" << parentTransformNode->GetID() << ":" << parentTransformNode->GetMTime();
+  }
+  return stateStream.str();
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerIsodoseModuleLogic::ExtractIsosurfaces(vtkImageData* doseImageData, const std::vector<double>& isoLevels,
+  std::vector<vtkSmartPointer<vtkPolyData> >& isoPolyDatas)
+{
+  isoPolyDatas.clear();
+  isoPolyDatas.resize(isoLevels.size());
+  if (!doseImageData || isoLevels.empty())
+  {
+    return;
+  }
+
+  // Unique level values, as the same level may appear multiple times in the color table
+  std::vector<double> uniqueLevels(isoLevels);
+  std::sort(uniqueLevels.begin(), uniqueLevels.end());
+  uniqueLevels.erase(std::unique(uniqueLevels.begin(), uniqueLevels.end()), uniqueLevels.end());
+
+  // The contour value is stored in the output point scalars, which have the type of the input. Integer dose is contoured
+  // on its native type, and the levels are identified by their truncated stored value. Only if two levels are stored as
+  // the same integer value is the dose cast to float, which costs a float copy of the whole dose grid.
+  std::vector<double> contourScalarValues;
+  vtkSmartPointer<vtkImageData> contourInputImage = doseImageData;
+  if (!GetContourScalarValues(doseImageData->GetScalarType(), uniqueLevels, contourScalarValues))
+  {
+    vtkNew<vtkImageCast> cast;
+    cast->SetInputData(doseImageData);
+    cast->SetOutputScalarTypeToFloat();
+    cast->Update();
+    contourInputImage = cast->GetOutput();
+  }
+
+  // Flying edges is multi-threaded through vtkSMPTools and processes all contour values in one call
+  vtkNew<vtkFlyingEdges3D> flyingEdges;
+  flyingEdges->SetInputData(contourInputImage);
+  flyingEdges->SetNumberOfContours(static_cast<int>(uniqueLevels.size()));
+  for (size_t levelIndex = 0; levelIndex < uniqueLevels.size(); ++levelIndex)
+  {
+    flyingEdges->SetValue(static_cast<int>(levelIndex), uniqueLevels[levelIndex]);
+  }
+  flyingEdges->ComputeScalarsOn();
+  flyingEdges->ComputeGradientsOff();
+  flyingEdges->ComputeNormalsOff();
+  flyingEdges->Update();
+
+  vtkPolyData* allLevelsPolyData = flyingEdges->GetOutput();
+  vtkDataArray* levelScalars = allLevelsPolyData->GetPointData()->GetScalars();
+  vtkPoints* allLevelsPoints = allLevelsPolyData->GetPoints();
+  if (!levelScalars || !allLevelsPoints || allLevelsPolyData->GetNumberOfPolys() == 0)
+  {
+    return;
+  }
+  GetContourScalarValues(levelScalars->GetDataType(), uniqueLevels, contourScalarValues);
+
+  // Split triangles by level. Each output point belongs to exactly one level, so a single map is enough.
+  size_t numberOfUniqueLevels = uniqueLevels.size();
+  std::vector<vtkSmartPointer<vtkPoints> > levelPoints(numberOfUniqueLevels);
+  std::vector<vtkSmartPointer<vtkCellArray> > levelPolys(numberOfUniqueLevels);
+  for (size_t levelIndex = 0; levelIndex < numberOfUniqueLevels; ++levelIndex)
+  {
+    levelPoints[levelIndex] = vtkSmartPointer<vtkPoints>::New();
+    levelPoints[levelIndex]->SetDataType(allLevelsPoints->GetDataType());
+    levelPolys[levelIndex] = vtkSmartPointer<vtkCellArray>::New();
+  }
+  std::vector<vtkIdType> pointIdMap(allLevelsPolyData->GetNumberOfPoints(), -1);
+  vtkCellArray* allLevelsPolys = allLevelsPolyData->GetPolys();
+  vtkIdType numberOfCellPoints = 0;
+#if VTK_MAJOR_VERSION >= 9
+  const vtkIdType* cellPointIds = nullptr;
+#else
+  vtkIdType* cellPointIds = nullptr;
+#endif
+  vtkIdType levelCellPointIds[3] = {0, 0, 0};
+  for (allLevelsPolys->InitTraversal(); allLevelsPolys->GetNextCell(numberOfCellPoints, cellPointIds); )
+  {
+    if (numberOfCellPoints != 3)
+    {
+      continue;
+    }
+    // Find the level the triangle belongs to (nearest stored unique level value)
+    double cellLevelValue = levelScalars->GetTuple1(cellPointIds[0]);
+    size_t levelIndex = std::lower_bound(contourScalarValues.begin(), contourScalarValues.end(), cellLevelValue) - contourScalarValues.begin();
+    if ( levelIndex == numberOfUniqueLevels
+      || (levelIndex > 0 && cellLevelValue - contourScalarValues[levelIndex-1] < contourScalarValues[levelIndex] - cellLevelValue) )
+    {
+      --levelIndex;
+    }
+    for (int cellPointIndex = 0; cellPointIndex < 3; ++cellPointIndex)
+    {
+      vtkIdType pointId = cellPointIds[cellPointIndex];
+      if (pointIdMap[pointId] < 0)
+      {
+        pointIdMap[pointId] = levelPoints[levelIndex]->InsertNextPoint(allLevelsPoints->GetPoint(pointId));
+      }
+      levelCellPointIds[cellPointIndex] = pointIdMap[pointId];
+    }
+    levelPolys[levelIndex]->InsertNextCell(3, levelCellPointIds);
+  }
+
+  // Assign level surfaces to the requested levels. Duplicate levels get their own shallow copy.
+  for (size_t levelIndex = 0; levelIndex < isoLevels.size(); ++levelIndex)
+  {
+    size_t uniqueLevelIndex = std::lower_bound(uniqueLevels.begin(), uniqueLevels.end(), isoLevels[levelIndex]) - uniqueLevels.begin();
+    vtkSmartPointer<vtkPolyData> levelPolyData = vtkSmartPointer<vtkPolyData>::New();
+    levelPolyData->SetPoints(levelPoints[uniqueLevelIndex]);
+    levelPolyData->SetPolys(levelPolys[uniqueLevelIndex]);
+    isoPolyDatas[levelIndex] = levelPolyData;
+  }
+}
+
+//---------------------------------------------------------------------------
+std::string vtkSlicerIsodoseModuleLogic::ComputeIsodoseVolumeStatistics(vtkMRMLIsodoseNode* parameterNode,
+  vtkMRMLSegmentationNode* segmentationNode, vtkStringArray* segmentIDs, vtkMRMLTableNode* statisticsTableNode)
+{
+  if (!this->GetMRMLScene() || !parameterNode || !segmentationNode || !statisticsTableNode)
+  {
+    std::string errorMessage("Invalid scene, parameter set node, segmentation node, or output table node");
+    vtkErrorMacro("ComputeIsodoseVolumeStatistics: " << errorMessage);
+    return errorMessage;
+  }
+  vtkMRMLScalarVolumeNode* doseVolumeNode = parameterNode->GetDoseVolumeNode();
+  if (!doseVolumeNode || !doseVolumeNode->GetImageData())
+  {
+    std::string errorMessage("Invalid dose volume");
+    vtkErrorMacro("ComputeIsodoseVolumeStatistics: " << errorMessage);
+    return errorMessage;
+  }
+  vtkMRMLColorTableNode* colorTableNode = parameterNode->GetColorTableNode();
+  std::vector<double> isoLevels;
+  if (!colorTableNode || !vtkSlicerIsodoseModuleLogic::GetIsodoseLevelValues(parameterNode, isoLevels) || isoLevels.empty())
+  {
+    std::string errorMessage("Failed to get isodose levels for dose volume");
+    vtkErrorMacro("ComputeIsodoseVolumeStatistics: " << errorMessage);
+    return errorMessage;
+  }
+
+  // If segment IDs list is empty then include all segments
+  std::vector<std::string> segmentIDsVector;
+  if (segmentIDs)
+  {
+    for (vtkIdType index = 0; index < segmentIDs->GetNumberOfValues(); ++index)
+    {
+      segmentIDsVector.push_back(segmentIDs->GetValue(index));
+    }
+  }
+  if (segmentIDsVector.empty())
+  {
+    segmentationNode->GetSegmentation()->GetSegmentIDs(segmentIDsVector);
+  }
+  if (segmentIDsVector.empty())
+  {
+    std::string errorMessage("No segments in segmentation");
+    vtkErrorMacro("ComputeIsodoseVolumeStatistics: " << errorMessage);
+    return errorMessage;
+  }
+
+  // Make sure segment data is loaded if it was deferred on import
+  for (const std::string& segmentID : segmentIDsVector)
+  {
+    segmentationNode->InvokeEvent(vtkSlicerRtCommon::SegmentDataRequested, (void*)segmentID.c_str());
+  }
+
+  // Segment masks on the dose lattice, so that a voxel index addresses the same voxel in the dose and all masks
+  vtkSmartPointer<vtkGeneralTransform> segmentationToWorldTransform;
+  if (segmentationNode->GetParentTransformNode())
+  {
+    segmentationToWorldTransform = vtkSmartPointer<vtkGeneralTransform>::New();
+    segmentationNode->GetParentTransformNode()->GetTransformToWorld(segmentationToWorldTransform);
+  }
+  std::vector<vtkSmartPointer<vtkOrientedImageData> > segmentLabelmaps;
+  std::string errorMessage = vtkSlicerRtCommon::CreateSegmentLabelmapsInVolumeGeometry(doseVolumeNode,
+    segmentationNode->GetSegmentation(), segmentationToWorldTransform, segmentIDsVector, segmentLabelmaps);
+  if (!errorMessage.empty())
+  {
+    vtkErrorMacro("ComputeIsodoseVolumeStatistics: " << errorMessage);
+    return errorMessage;
+  }
+  std::vector<unsigned char*> segmentMasks;
+  for (vtkOrientedImageData* segmentLabelmap : segmentLabelmaps)
+  {
+    segmentMasks.push_back(static_cast<unsigned char*>(segmentLabelmap->GetScalarPointer()));
+  }
+
+  // Threshold the dose at all levels and count the covered voxels per segment in one multi-threaded pass.
+  // Dose values are accessed directly in their native scalar type, so no copy of the dose is needed.
+  vtkImageData* doseImageData = doseVolumeNode->GetImageData();
+  std::vector<double> sortedLevels(isoLevels);
+  std::sort(sortedLevels.begin(), sortedLevels.end());
+  std::vector<vtkIdType> binCounts;
+  switch (doseImageData->GetScalarType())
+  {
+    vtkTemplateMacro(CountIsodoseVolumes(static_cast<VTK_TT*>(doseImageData->GetScalarPointer()),
+      doseImageData->GetNumberOfPoints(), segmentMasks, sortedLevels, binCounts));
+    default:
+    {
+      std::string errorMessage("Unsupported dose volume scalar type");
+      vtkErrorMacro("ComputeIsodoseVolumeStatistics: " << errorMessage);
+      return errorMessage;
+    }
+  }
+
+  // Covered voxel count of a level is the number of voxels in the bins of the same and higher levels
+  int numberOfBins = static_cast<int>(sortedLevels.size()) + 1;
+  std::vector<std::vector<vtkIdType> > coveredVoxelCounts(segmentMasks.size(), std::vector<vtkIdType>(numberOfBins, 0));
+  for (size_t segmentIndex = 0; segmentIndex < segmentMasks.size(); ++segmentIndex)
+  {
+    vtkIdType sum = 0;
+    for (int bin = numberOfBins - 1; bin >= 0; --bin)
+    {
+      sum += binCounts[segmentIndex * numberOfBins + bin];
+      coveredVoxelCounts[segmentIndex][bin] = sum;
+    }
+  }
+
+  // Fill statistics table: one row per isodose level, and volume (cc) and percentage columns for each segment
+  double doseSpacing[3] = {1.0, 1.0, 1.0};
+  doseVolumeNode->GetSpacing(doseSpacing);
+  double voxelVolumeCc = doseSpacing[0] * doseSpacing[1] * doseSpacing[2] / 1000.0;
+  std::string doseUnitName = vtkSlicerIsodoseModuleLogic::GetIsodoseUnitName(parameterNode);
+  int numberOfLevels = static_cast<int>(isoLevels.size());
+
+  vtkTable* statisticsTable = statisticsTableNode->GetTable();
+  statisticsTable->Initialize();
+  vtkNew<vtkStringArray> columnLevel;
+  columnLevel->SetName("Isodose level");
+  columnLevel->SetNumberOfValues(numberOfLevels);
+  statisticsTable->AddColumn(columnLevel);
+  vtkNew<vtkDoubleArray> columnDose;
+  columnDose->SetName("Dose");
+  columnDose->SetNumberOfValues(numberOfLevels);
+  statisticsTable->AddColumn(columnDose);
+  for (int i = 0; i < numberOfLevels; ++i)
+  {
+    columnLevel->SetValue(i, std::string(colorTableNode->GetColorName(i)) + doseUnitName);
+    columnDose->SetValue(i, isoLevels[i]);
+  }
+
+  for (size_t segmentIndex = 0; segmentIndex < segmentMasks.size(); ++segmentIndex)
+  {
+    vtkSegment* segment = segmentationNode->GetSegmentation()->GetSegment(segmentIDsVector[segmentIndex]);
+    std::string segmentName = (segment && segment->GetName() ? segment->GetName() : segmentIDsVector[segmentIndex]);
+    vtkIdType segmentVoxelCount = coveredVoxelCounts[segmentIndex][0];
+
+    vtkNew<vtkDoubleArray> columnVolume;
+    columnVolume->SetName((segmentName + " volume (cc)").c_str());
+    columnVolume->SetNumberOfValues(numberOfLevels);
+    vtkNew<vtkDoubleArray> columnPercent;
+    columnPercent->SetName((segmentName + " volume (%)").c_str());
+    columnPercent->SetNumberOfValues(numberOfLevels);
+    for (int i = 0; i < numberOfLevels; ++i)
+    {
+      int bin = static_cast<int>(std::lower_bound(sortedLevels.begin(), sortedLevels.end(), isoLevels[i]) - sortedLevels.begin()) + 1;
+      vtkIdType coveredVoxelCount = coveredVoxelCounts[segmentIndex][bin];
+      columnVolume->SetValue(i, coveredVoxelCount * voxelVolumeCc);
+      columnPercent->SetValue(i, segmentVoxelCount > 0 ? 100.0 * coveredVoxelCount / segmentVoxelCount : 0.0);
+    }
+    statisticsTable->AddColumn(columnVolume);
+    statisticsTable->AddColumn(columnPercent);
+  }
+  statisticsTable->SetNumberOfRows(numberOfLevels);
+  statisticsTableNode->Modified();
+
+  return "";
 }
 
 //---------------------------------------------------------------------------
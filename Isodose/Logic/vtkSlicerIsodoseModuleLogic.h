@@ -33,11 +33,32 @@
 
 #include "vtkSlicerIsodoseModuleLogicExport.h"
 
+// VTK includes
+#include <vtkSmartPointer.h>
+
+// STD includes
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
+
 // MRML includes
 class vtkMRMLColorTableNode;
 class vtkMRMLIsodoseNode;
 class vtkMRMLModelHierarchyNode;
+class vtkMRMLModelNode;
 class vtkMRMLScalarVolumeNode;
+class vtkMRMLSegmentationNode;
+class vtkMRMLSliceNode;
+class vtkMRMLTableNode;
+
+// VTK includes
+class vtkImageData;
+class vtkPolyData;
+class vtkStringArray;
+
+// Segmentations includes
+class vtkOrientedImageData;
 
 /// \ingroup SlicerRt_QtModules_Isodose
 class VTK_SLICER_ISODOSE_LOGIC_EXPORT vtkSlicerIsodoseModuleLogic : public vtkSlicerModuleLogic
@@ -58,9 +79,65 @@ public:
   /// Set number of isodose levels
   void SetNumberOfIsodoseLevels(vtkMRMLIsodoseNode* parameterNode, int newNumberOfColors);
 
-  /// Accumulates dose volumes with the given IDs and corresponding weights
+  /// Create isodose surface models for all levels of the isodose color table.
+  /// All levels are extracted in a single multi-threaded contouring pass, then split into one model node per level.
+  /// If the dose volume is unchanged since the last call, then only the new or modified levels are extracted,
+  /// and the existing isodose model nodes are updated in place. Levels that the dose does not reach get an empty model,
+  /// so that they are not extracted again either.
   void CreateIsodoseSurfaces(vtkMRMLIsodoseNode* parameterNode);
 
+  /// Extract isosurfaces for multiple levels with one multi-threaded flying edges pass,
+  /// and split the result into one surface per level. The surfaces are in the IJK coordinate frame of the image.
+  /// \param doseImageData Dose image to contour
+  /// \param isoLevels Isodose level values
+  /// \param isoPolyDatas Output surfaces, one for each entry in isoLevels. Surfaces may be empty.
+  ///   Surfaces of duplicate levels share their points and cells, so they must not be processed concurrently.
+  static void ExtractIsosurfaces(vtkImageData* doseImageData, const std::vector<double>& isoLevels,
+    std::vector<vtkSmartPointer<vtkPolyData> >& isoPolyDatas);
+
+  /// Compute isodose lines for the slice displayed in a slice view, and show them in that view only.
+  /// Only the displayed plane of the dose is contoured (all levels in one marching squares pass), and the lines
+  /// are cached per slice index, so that browsing the slices does not need any surface generation.
+  /// Called automatically on slice changes if per-slice isodose lines are enabled in the parameter node
+  void UpdateSliceIsodoseLines(vtkMRMLIsodoseNode* parameterNode, vtkMRMLSliceNode* sliceNode);
+
+  /// Update per-slice isodose lines in all slice views, or remove them if disabled in the parameter node
+  void UpdateSliceIsodoseLinesInAllViews(vtkMRMLIsodoseNode* parameterNode);
+
+  /// Remove per-slice isodose line models and cached lines of a parameter node
+  void RemoveSliceIsodoseLines(vtkMRMLIsodoseNode* parameterNode);
+
+  /// Extract isodose lines for multiple levels from a single dose slice with one marching squares pass.
+  /// The lines are in the coordinate frame of the image, and the cell scalars contain the index of the level
+  static void ExtractIsolines(vtkImageData* doseSliceImageData, const std::vector<double>& isoLevels, vtkPolyData* isolinePolyData);
+
+  /// Get isodose level values (in dose units) for the isodose color table entries.
+  /// Relative levels are converted to dose using the reference dose value
+  /// \return False if the color table is not available
+  static bool GetIsodoseLevelValues(vtkMRMLIsodoseNode* parameterNode, std::vector<double>& isoLevels);
+
+  /// Determine whether the isodose levels are in relative (%) representation
+  static bool IsRelativeIsodoseRepresentation(vtkMRMLIsodoseNode* parameterNode);
+
+  /// Get unit name of the isodose levels (Gy, %, or MU)
+  static std::string GetIsodoseUnitName(vtkMRMLIsodoseNode* parameterNode);
+
+  /// Compute the volume of each segment covered by each isodose level (i.e. receiving at least the level dose).
+  /// The dose grid is thresholded at all levels and the covered voxels are counted per segment in one
+  /// multi-threaded pass, without generating any isodose surfaces.
+  /// \param parameterNode Isodose parameter node defining the dose volume and the isodose levels
+  /// \param segmentationNode Segmentation containing the structures
+  /// \param segmentIDs Segments to compute the statistics for. All segments are used if empty or nullptr
+  /// \param statisticsTableNode Output table with one row per isodose level. Columns are the level, its dose value,
+  ///   and the covered volume (cc) and volume percentage of each segment
+  /// \return Error message, empty string if successful
+  std::string ComputeIsodoseVolumeStatistics(vtkMRMLIsodoseNode* parameterNode, vtkMRMLSegmentationNode* segmentationNode,
+    vtkStringArray* segmentIDs, vtkMRMLTableNode* statisticsTableNode);
+
+  /// Get string describing the state of a dose volume that affects its isodose surfaces (voxels, geometry, transform).
+  /// Used to decide whether the isodose surfaces cached in the parameter node can be reused
+  static std::string GetDoseVolumeStateKey(vtkMRMLScalarVolumeNode* doseVolumeNode);
+
   /// Get isodose folder for a dose volume
   /// \param node Dose volume node or isodose parameter node referencing the dose volume
   /// \return Subject hierarchy item ID of the folder containing the isodose surfaces. 0 if not found
@@ -100,6 +177,28 @@ protected:
   void OnMRMLSceneNodeAdded(vtkMRMLNode* node) override;
   void OnMRMLSceneNodeRemoved(vtkMRMLNode* node) override;
   void OnMRMLSceneEndClose() override;
+  void ProcessMRMLNodesEvents(vtkObject* caller, unsigned long event, void* callData) override;
+
+  /// Observe modifications of a slice node for updating the per-slice isodose lines
+  void ObserveSliceNode(vtkMRMLNode* node);
+
+  /// Get lines model displayed in a slice view. Created if missing
+  vtkMRMLModelNode* GetSliceIsodoseLinesModelNode(vtkMRMLIsodoseNode* parameterNode, vtkMRMLSliceNode* sliceNode);
+
+protected:
+  /// Cached per-slice isodose lines of a parameter node
+  struct SliceIsodoseLinesCacheType
+  {
+    /// Dose volume state and isodose levels the cached lines were computed for
+    std::string State;
+    /// Isodose lines in world coordinates keyed by the slice (slice index for planes aligned to the dose grid)
+    std::map<std::string, vtkSmartPointer<vtkPolyData> > Lines;
+    /// Keys of the cached oblique slices, oldest first. The number of aligned slices is limited by the dose dimensions,
+    /// but oblique planes are not, so the oldest oblique slices are evicted when their number reaches the limit.
+    std::deque<std::string> ObliqueSliceKeys;
+  };
+  /// Per-slice isodose lines cache keyed by parameter node ID
+  std::map<std::string, SliceIsodoseLinesCacheType> SliceIsodoseLinesCache;
 
 protected:
   vtkSlicerIsodoseModuleLogic();
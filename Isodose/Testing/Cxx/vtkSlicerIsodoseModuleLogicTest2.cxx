@@ -0,0 +1,936 @@
+/*==============================================================================
+
+  Copyright (c) Radiation Medicine Program, University Health Network,
+  Princess Margaret Hospital, Toronto, ON, Canada. All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// Isodose includes
+#include "vtkSlicerIsodoseModuleLogic.h"
+#include "vtkMRMLIsodoseNode.h"
+
+// Segmentations includes
+#include "vtkMRMLSegmentationNode.h"
+
+// SegmentationCore includes
+#include "vtkOrientedImageData.h"
+#include "vtkSegment.h"
+#include "vtkSegmentation.h"
+#include "vtkSegmentationConverter.h"
+
+// MRML includes
+#include <vtkMRMLColorTableNode.h>
+#include <vtkMRMLLinearTransformNode.h>
+#include <vtkMRMLModelNode.h>
+#include <vtkMRMLScalarVolumeNode.h>
+#include <vtkMRMLScene.h>
+#include <vtkMRMLSliceNode.h>
+#include <vtkMRMLSubjectHierarchyNode.h>
+#include <vtkMRMLTableNode.h>
+
+// VTK includes
+#include <vtkAbstractArray.h>
+#include <vtkCellArray.h>
+#include <vtkCellData.h>
+#include <vtkDataArray.h>
+#include <vtkDecimatePro.h>
+#include <vtkExtractVOI.h>
+#include <vtkIdList.h>
+#include <vtkImageCast.h>
+#include <vtkImageData.h>
+#include <vtkImageMarchingCubes.h>
+#include <vtkImageReslice.h>
+#include <vtkMassProperties.h>
+#include <vtkMarchingSquares.h>
+#include <vtkMath.h>
+#include <vtkMatrix4x4.h>
+#include <vtkNew.h>
+#include <vtkPolyData.h>
+#include <vtkPolyDataNormals.h>
+#include <vtkSmartPointer.h>
+#include <vtkTable.h>
+#include <vtkTransform.h>
+#include <vtkTransformPolyDataFilter.h>
+#include <vtkTriangleFilter.h>
+#include <vtkVariant.h>
+#include <vtkWindowedSincPolyDataFilter.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+//----------------------------------------------------------------------------
+/// Create a dose image with a Gaussian dose distribution. The image is in IJK (unit spacing, zero origin).
+void CreateGaussianDoseImage(vtkImageData* doseImageData, int scalarType);
+/// Create a dose volume node with the Gaussian dose, an oblique IJK to RAS matrix, and a subject hierarchy item
+vtkMRMLScalarVolumeNode* CreateGaussianDoseVolumeNode(vtkMRMLScene* scene);
+/// Create an isodose parameter node with its own color table for the given dose levels
+vtkMRMLIsodoseNode* CreateIsodoseParameterNode(vtkMRMLScene* scene, vtkMRMLScalarVolumeNode* doseVolumeNode, const std::vector<double>& isoLevels);
+/// Set the dose levels as the color names of an isodose color table
+void SetIsodoseLevels(vtkMRMLColorTableNode* colorTableNode, const std::vector<double>& isoLevels);
+/// Create an isodose surface the way it was done before contouring on the dose voxels directly: the dose is
+/// resampled to apply the parent transform, contoured, post-processed, and then transformed with the IJK to RAS matrix.
+vtkSmartPointer<vtkPolyData> CreateReslicedIsodoseSurface(vtkMRMLScalarVolumeNode* doseVolumeNode, double isoLevel);
+/// Compare the surfaces extracted in one pass for all levels with surfaces extracted one level at a time
+/// \param closeLevelDifference Difference of two close levels (before scaling the levels for integer images)
+int TestSinglePassIsosurfaces(int scalarType, double closeLevelDifference);
+/// Compare the isodose models with surfaces extracted from the resampled dose, without and with parent transform
+int TestIsodoseSurfacesWithoutResampling();
+/// Add, change, and remove isodose levels and check that only the models of the affected levels are rebuilt
+int TestIncrementalIsodoseUpdate();
+/// Compare the per-slice isodose lines of a slice view aligned with the dose grid with a direct contour of the dose slice
+int TestSliceIsodoseLines();
+/// Compare the isodose volume statistics with voxel counts of the thresholded dose within segment labelmaps on the dose lattice
+int TestIsodoseVolumeStatistics();
+/// Add a segment with a binary labelmap on the lattice of the dose volume. Voxels within the extent are included if
+/// they are within the given radius from the center (IJK coordinates), or all of them if the radius is negative
+void AddDoseLatticeSegment(vtkMRMLSegmentationNode* segmentationNode, vtkMRMLScalarVolumeNode* doseVolumeNode,
+  const char* segmentName, const int extent[6], const double centerIJK[3], double radius);
+/// Get the number of line segments, their total length and their bounds.
+/// Only the lines of the given level are considered if a level index array is specified
+void GetIsolineProperties(vtkPolyData* linesPolyData, vtkDataArray* levelIndexArray, int levelIndex,
+  vtkIdType& numberOfSegments, double& totalLength, double bounds[6]);
+/// Get the isodose models of the parameter node and their poly data in level order
+void GetIsodoseModels(vtkMRMLIsodoseNode* parameterNode, std::vector<vtkSmartPointer<vtkMRMLModelNode> >& modelNodes,
+  std::vector<vtkSmartPointer<vtkPolyData> >& polyDatas);
+/// Compare surface volumes and bounds
+bool AreSurfacesEqual(vtkPolyData* actualPolyData, vtkPolyData* expectedPolyData, double volumeTolerance, double boundsTolerance);
+
+//----------------------------------------------------------------------------
+int vtkSlicerIsodoseModuleLogicTest2(int vtkNotUsed(argc), char* vtkNotUsed(argv)[])
+{
+  if (TestSinglePassIsosurfaces(VTK_FLOAT, 0.05) != EXIT_SUCCESS)
+  {
+    return EXIT_FAILURE;
+  }
+  // Integer dose grids are contoured on their native type if the levels are stored as different integer values
+  if (TestSinglePassIsosurfaces(VTK_SHORT, 0.05) != EXIT_SUCCESS)
+  {
+    return EXIT_FAILURE;
+  }
+  // Levels that are stored as the same integer value are contoured on a float copy, and must still be separated
+  if (TestSinglePassIsosurfaces(VTK_SHORT, 0.002) != EXIT_SUCCESS)
+  {
+    return EXIT_FAILURE;
+  }
+  if (TestIsodoseSurfacesWithoutResampling() != EXIT_SUCCESS)
+  {
+    return EXIT_FAILURE;
+  }
+  if (TestIncrementalIsodoseUpdate() != EXIT_SUCCESS)
+  {
+    return EXIT_FAILURE;
+  }
+  if (TestSliceIsodoseLines() != EXIT_SUCCESS)
+  {
+    return EXIT_FAILURE;
+  }
+  if (TestIsodoseVolumeStatistics() != EXIT_SUCCESS)
+  {
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+void CreateGaussianDoseImage(vtkImageData* doseImageData, int scalarType)
+{
+  const int dimensions[3] = { 40, 36, 44 };
+  const double center[3] = { 19.3, 17.6, 22.4 };
+  const double sigma = 7.5;
+  // Integer images store the dose in cGy-like units, so that the levels are not on voxel values
+  const double maximumDose = (scalarType == VTK_FLOAT ? 10.0 : 1000.0);
+
+  doseImageData->SetDimensions(dimensions[0], dimensions[1], dimensions[2]);
+  doseImageData->AllocateScalars(scalarType, 1);
+  for (int k = 0; k < dimensions[2]; ++k)
+  {
+    for (int j = 0; j < dimensions[1]; ++j)
+    {
+      for (int i = 0; i < dimensions[0]; ++i)
+      {
+        double squaredDistance = (i - center[0]) * (i - center[0])
+          + (j - center[1]) * (j - center[1]) + (k - center[2]) * (k - center[2]);
+        double dose = maximumDose * exp(-squaredDistance / (2.0 * sigma * sigma));
+        doseImageData->SetScalarComponentFromDouble(i, j, k, 0, (scalarType == VTK_FLOAT ? dose : floor(dose)));
+      }
+    }
+  }
+}
+
+//----------------------------------------------------------------------------
+vtkMRMLScalarVolumeNode* CreateGaussianDoseVolumeNode(vtkMRMLScene* scene)
+{
+  vtkNew<vtkImageData> doseImageData;
+  CreateGaussianDoseImage(doseImageData, VTK_FLOAT);
+
+  vtkNew<vtkMRMLScalarVolumeNode> doseVolumeNode;
+  doseVolumeNode->SetName("Dose");
+  doseVolumeNode->SetAndObserveImageData(doseImageData);
+  vtkNew<vtkTransform> ijkToRasTransform;
+  ijkToRasTransform->Translate(-42.0, 31.5, -66.0);
+  ijkToRasTransform->RotateZ(30.0);
+  ijkToRasTransform->RotateX(-90.0);
+  ijkToRasTransform->Scale(2.0, 2.5, 3.0);
+  doseVolumeNode->SetIJKToRASMatrix(ijkToRasTransform->GetMatrix());
+  scene->AddNode(doseVolumeNode);
+  doseVolumeNode->CreateDefaultDisplayNodes();
+
+  // There is no automatic subject hierarchy item creation without the plugin logic
+  vtkMRMLSubjectHierarchyNode* shNode = vtkMRMLSubjectHierarchyNode::GetSubjectHierarchyNode(scene);
+  if (shNode && !shNode->GetItemByDataNode(doseVolumeNode))
+  {
+    shNode->CreateItem(shNode->GetSceneItemID(), doseVolumeNode);
+  }
+  return doseVolumeNode;
+}
+
+//----------------------------------------------------------------------------
+vtkMRMLIsodoseNode* CreateIsodoseParameterNode(vtkMRMLScene* scene, vtkMRMLScalarVolumeNode* doseVolumeNode, const std::vector<double>& isoLevels)
+{
+  vtkNew<vtkMRMLColorTableNode> colorTableNode;
+  colorTableNode->SetName("IsodoseTestColorTable");
+  colorTableNode->SetTypeToUser();
+  SetIsodoseLevels(colorTableNode, isoLevels);
+  scene->AddNode(colorTableNode);
+
+  vtkNew<vtkMRMLIsodoseNode> parameterNode;
+  scene->AddNode(parameterNode);
+  parameterNode->SetAndObserveDoseVolumeNode(doseVolumeNode);
+  parameterNode->SetAndObserveColorTableNode(colorTableNode);
+  return parameterNode;
+}
+
+//----------------------------------------------------------------------------
+void SetIsodoseLevels(vtkMRMLColorTableNode* colorTableNode, const std::vector<double>& isoLevels)
+{
+  int numberOfLevels = static_cast<int>(isoLevels.size());
+  colorTableNode->SetNumberOfColors(numberOfLevels);
+  for (int levelIndex = 0; levelIndex < numberOfLevels; ++levelIndex)
+  {
+    double colorValue = (numberOfLevels > 1 ? levelIndex / (numberOfLevels - 1.0) : 1.0);
+    colorTableNode->SetColor(levelIndex, vtkVariant(isoLevels[levelIndex]).ToString().c_str(), colorValue, 1.0 - colorValue, 0.0, 0.2);
+  }
+}
+
+//----------------------------------------------------------------------------
+vtkSmartPointer<vtkPolyData> CreateReslicedIsodoseSurface(vtkMRMLScalarVolumeNode* doseVolumeNode, double isoLevel)
+{
+  vtkNew<vtkMatrix4x4> inputIJK2RASMatrix;
+  doseVolumeNode->GetIJKToRASMatrix(inputIJK2RASMatrix);
+  vtkNew<vtkMatrix4x4> inputRAS2IJKMatrix;
+  doseVolumeNode->GetRASToIJKMatrix(inputRAS2IJKMatrix);
+
+  vtkNew<vtkTransform> outputIJK2IJKResliceTransform;
+  outputIJK2IJKResliceTransform->Identity();
+  outputIJK2IJKResliceTransform->PostMultiply();
+  outputIJK2IJKResliceTransform->SetMatrix(inputIJK2RASMatrix);
+  vtkMRMLTransformNode* inputVolumeNodeTransformNode = doseVolumeNode->GetParentTransformNode();
+  if (inputVolumeNodeTransformNode)
+  {
+    vtkNew<vtkMatrix4x4> inputRAS2RASMatrix;
+    inputVolumeNodeTransformNode->GetMatrixTransformToWorld(inputRAS2RASMatrix);
+    outputIJK2IJKResliceTransform->Concatenate(inputRAS2RASMatrix);
+  }
+  outputIJK2IJKResliceTransform->Concatenate(inputRAS2IJKMatrix);
+  outputIJK2IJKResliceTransform->Inverse();
+
+  int dimensions[3] = { 0, 0, 0 };
+  doseVolumeNode->GetImageData()->GetDimensions(dimensions);
+  vtkNew<vtkImageReslice> reslice;
+  reslice->SetInputData(doseVolumeNode->GetImageData());
+  reslice->SetOutputOrigin(0, 0, 0);
+  reslice->SetOutputSpacing(1, 1, 1);
+  reslice->SetOutputExtent(0, dimensions[0]-1, 0, dimensions[1]-1, 0, dimensions[2]-1);
+  reslice->SetResliceTransform(outputIJK2IJKResliceTransform);
+  reslice->Update();
+
+  vtkNew<vtkImageMarchingCubes> marchingCubes;
+  marchingCubes->SetInputData(reslice->GetOutput());
+  marchingCubes->SetNumberOfContours(1);
+  marchingCubes->SetValue(0, isoLevel);
+  marchingCubes->ComputeScalarsOff();
+  marchingCubes->ComputeGradientsOff();
+  marchingCubes->ComputeNormalsOff();
+  marchingCubes->Update();
+
+  vtkNew<vtkTriangleFilter> triangleFilter;
+  triangleFilter->SetInputData(marchingCubes->GetOutput());
+  triangleFilter->Update();
+
+  vtkNew<vtkDecimatePro> decimate;
+  decimate->SetInputData(triangleFilter->GetOutput());
+  decimate->SetTargetReduction(0.6);
+  decimate->SetFeatureAngle(60);
+  decimate->SplittingOff();
+  decimate->PreserveTopologyOn();
+  decimate->SetMaximumError(1);
+  decimate->Update();
+
+  vtkNew<vtkWindowedSincPolyDataFilter> smootherSinc;
+  smootherSinc->SetPassBand(0.1);
+  smootherSinc->SetInputData(decimate->GetOutput());
+  smootherSinc->SetNumberOfIterations(2);
+  smootherSinc->FeatureEdgeSmoothingOff();
+  smootherSinc->BoundarySmoothingOff();
+  smootherSinc->Update();
+
+  vtkNew<vtkPolyDataNormals> normals;
+  normals->SetInputData(smootherSinc->GetOutput());
+  normals->ComputePointNormalsOn();
+  normals->SetFeatureAngle(60);
+  normals->Update();
+
+  vtkNew<vtkTransform> inputIJKToRASTransform;
+  inputIJKToRASTransform->SetMatrix(inputIJK2RASMatrix);
+  vtkNew<vtkTransformPolyDataFilter> transformPolyData;
+  transformPolyData->SetInputData(normals->GetOutput());
+  transformPolyData->SetTransform(inputIJKToRASTransform);
+  transformPolyData->Update();
+
+  vtkSmartPointer<vtkPolyData> isodoseSurface = transformPolyData->GetOutput();
+  return isodoseSurface;
+}
+
+//----------------------------------------------------------------------------
+int TestSinglePassIsosurfaces(int scalarType, double closeLevelDifference)
+{
+  vtkNew<vtkImageData> doseImageData;
+  CreateGaussianDoseImage(doseImageData, scalarType);
+
+  // Unsorted levels with a duplicate, all of them closed surfaces inside the image.
+  // Levels of integer images are between voxel values to avoid surface points falling on the voxels.
+  const double levelScale = (scalarType == VTK_FLOAT ? 1.0 : 100.0);
+  const double levelOffset = (scalarType == VTK_FLOAT ? 0.0 : 0.5);
+  std::vector<double> isoLevels;
+  isoLevels.push_back(5.0 * levelScale + levelOffset);
+  isoLevels.push_back(2.05 * levelScale + levelOffset);
+  isoLevels.push_back(8.0 * levelScale + levelOffset);
+  isoLevels.push_back(5.0 * levelScale + levelOffset);
+  isoLevels.push_back((2.05 + closeLevelDifference) * levelScale + levelOffset);
+
+  std::vector<vtkSmartPointer<vtkPolyData> > isoPolyDatas;
+  vtkSlicerIsodoseModuleLogic::ExtractIsosurfaces(doseImageData, isoLevels, isoPolyDatas);
+  if (isoPolyDatas.size() != isoLevels.size())
+  {
+    std::cerr << __LINE__ << ": Number of extracted surfaces (" << isoPolyDatas.size()
+      << ") does not match number of levels (" << isoLevels.size() << ")" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // Reference: one marching cubes run per level on the float dose, as isodose surfaces were extracted before
+  vtkNew<vtkImageCast> cast;
+  cast->SetInputData(doseImageData);
+  cast->SetOutputScalarTypeToFloat();
+  cast->Update();
+  for (size_t levelIndex = 0; levelIndex < isoLevels.size(); ++levelIndex)
+  {
+    vtkNew<vtkImageMarchingCubes> marchingCubes;
+    marchingCubes->SetInputData(cast->GetOutput());
+    marchingCubes->SetNumberOfContours(1);
+    marchingCubes->SetValue(0, isoLevels[levelIndex]);
+    marchingCubes->ComputeScalarsOff();
+    marchingCubes->ComputeGradientsOff();
+    marchingCubes->ComputeNormalsOff();
+    marchingCubes->Update();
+
+    vtkPolyData* isoPolyData = isoPolyDatas[levelIndex];
+    if (!isoPolyData || isoPolyData->GetNumberOfPolys() == 0)
+    {
+      std::cerr << __LINE__ << ": No surface extracted for level " << isoLevels[levelIndex] << std::endl;
+      return EXIT_FAILURE;
+    }
+    // Both algorithms interpolate the same voxel edges, only the triangulation of the cells may differ
+    if (isoPolyData->GetNumberOfPoints() != marchingCubes->GetOutput()->GetNumberOfPoints())
+    {
+      std::cerr << __LINE__ << ": Number of surface points for level " << isoLevels[levelIndex] << " (" << isoPolyData->GetNumberOfPoints()
+        << ") does not match the single level extraction (" << marchingCubes->GetOutput()->GetNumberOfPoints() << ")" << std::endl;
+      return EXIT_FAILURE;
+    }
+    if (!AreSurfacesEqual(isoPolyData, marchingCubes->GetOutput(), 5.0e-3, 1.0e-4))
+    {
+      std::cerr << __LINE__ << ": Surface of level " << isoLevels[levelIndex] << " does not match the single level extraction" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  // Duplicate levels share the surface geometry, but not the poly data object
+  if (isoPolyDatas[0] == isoPolyDatas[3] || isoPolyDatas[0]->GetPoints() != isoPolyDatas[3]->GetPoints())
+  {
+    std::cerr << __LINE__ << ": Duplicate levels are expected to get separate poly data with shared points" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int TestIsodoseSurfacesWithoutResampling()
+{
+  vtkNew<vtkMRMLScene> mrmlScene;
+  vtkNew<vtkSlicerIsodoseModuleLogic> isodoseLogic;
+  isodoseLogic->SetMRMLScene(mrmlScene);
+
+  vtkMRMLScalarVolumeNode* doseVolumeNode = CreateGaussianDoseVolumeNode(mrmlScene);
+  std::vector<double> isoLevels;
+  isoLevels.push_back(2.05);
+  isoLevels.push_back(5.0);
+  isoLevels.push_back(8.0);
+  isoLevels.push_back(5.0); // Duplicate level is post-processed once and shared
+  vtkMRMLIsodoseNode* parameterNode = CreateIsodoseParameterNode(mrmlScene, doseVolumeNode, isoLevels);
+
+  // Parent transform that moves the dose by whole voxels, so that resampling the dose does not change the voxel values
+  const double voxelShift[4] = { 2.0, -1.0, 3.0, 0.0 };
+  double worldShift[4] = { 0.0, 0.0, 0.0, 0.0 };
+  vtkNew<vtkMatrix4x4> ijkToRasMatrix;
+  doseVolumeNode->GetIJKToRASMatrix(ijkToRasMatrix);
+  ijkToRasMatrix->MultiplyPoint(voxelShift, worldShift);
+  vtkNew<vtkMatrix4x4> shiftMatrix;
+  shiftMatrix->SetElement(0, 3, worldShift[0]);
+  shiftMatrix->SetElement(1, 3, worldShift[1]);
+  shiftMatrix->SetElement(2, 3, worldShift[2]);
+  vtkNew<vtkMRMLLinearTransformNode> shiftTransformNode;
+  mrmlScene->AddNode(shiftTransformNode);
+  shiftTransformNode->SetMatrixTransformToParent(shiftMatrix);
+
+  for (int transformed = 0; transformed < 2; ++transformed)
+  {
+    doseVolumeNode->SetAndObserveTransformNodeID(transformed ? shiftTransformNode->GetID() : nullptr);
+    isodoseLogic->CreateIsodoseSurfaces(parameterNode);
+
+    if (parameterNode->GetNumberOfIsodoseModelNodes() != static_cast<int>(isoLevels.size()))
+    {
+      std::cerr << __LINE__ << ": Number of isodose models (" << parameterNode->GetNumberOfIsodoseModelNodes()
+        << ") does not match number of levels (" << isoLevels.size() << ")" << std::endl;
+      return EXIT_FAILURE;
+    }
+    for (int levelIndex = 0; levelIndex < static_cast<int>(isoLevels.size()); ++levelIndex)
+    {
+      vtkMRMLModelNode* isodoseModelNode = parameterNode->GetNthIsodoseModelNode(levelIndex);
+      vtkSmartPointer<vtkPolyData> reslicedIsodoseSurface = CreateReslicedIsodoseSurface(doseVolumeNode, isoLevels[levelIndex]);
+      // The decimation depends on the order of the points, so only the shape is compared (bounds within a voxel)
+      if (!isodoseModelNode || !AreSurfacesEqual(isodoseModelNode->GetPolyData(), reslicedIsodoseSurface, 0.02, 3.0))
+      {
+        std::cerr << __LINE__ << ": Isodose surface of level " << isoLevels[levelIndex] << (transformed ? " with" : " without")
+          << " parent transform does not match the surface extracted from the resampled dose" << std::endl;
+        return EXIT_FAILURE;
+      }
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int TestIncrementalIsodoseUpdate()
+{
+  vtkNew<vtkMRMLScene> mrmlScene;
+  vtkNew<vtkSlicerIsodoseModuleLogic> isodoseLogic;
+  isodoseLogic->SetMRMLScene(mrmlScene);
+
+  vtkMRMLScalarVolumeNode* doseVolumeNode = CreateGaussianDoseVolumeNode(mrmlScene);
+  std::vector<double> isoLevels;
+  isoLevels.push_back(2.05);
+  isoLevels.push_back(5.0);
+  isoLevels.push_back(8.0);
+  vtkMRMLIsodoseNode* parameterNode = CreateIsodoseParameterNode(mrmlScene, doseVolumeNode, isoLevels);
+  vtkMRMLColorTableNode* colorTableNode = parameterNode->GetColorTableNode();
+  isodoseLogic->CreateIsodoseSurfaces(parameterNode);
+
+  std::vector<vtkSmartPointer<vtkMRMLModelNode> > initialModelNodes;
+  std::vector<vtkSmartPointer<vtkPolyData> > initialPolyDatas;
+  GetIsodoseModels(parameterNode, initialModelNodes, initialPolyDatas);
+  if (initialModelNodes.size() != 3 || mrmlScene->GetNumberOfNodesByClass("vtkMRMLModelNode") != 3)
+  {
+    std::cerr << __LINE__ << ": Expected 3 isodose models, got " << initialModelNodes.size() << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // Add a level: only the new level is extracted, into a new model
+  isoLevels.insert(isoLevels.begin() + 2, 6.5);
+  SetIsodoseLevels(colorTableNode, isoLevels);
+  isodoseLogic->CreateIsodoseSurfaces(parameterNode);
+  std::vector<vtkSmartPointer<vtkMRMLModelNode> > modelNodes;
+  std::vector<vtkSmartPointer<vtkPolyData> > polyDatas;
+  GetIsodoseModels(parameterNode, modelNodes, polyDatas);
+  if (modelNodes.size() != 4 || mrmlScene->GetNumberOfNodesByClass("vtkMRMLModelNode") != 4)
+  {
+    std::cerr << __LINE__ << ": Expected 4 isodose models after adding a level, got " << modelNodes.size() << std::endl;
+    return EXIT_FAILURE;
+  }
+  const int keptAfterAdd[3][2] = { { 0, 0 }, { 1, 1 }, { 3, 2 } }; // { current index, initial index }
+  for (int keptIndex = 0; keptIndex < 3; ++keptIndex)
+  {
+    int index = keptAfterAdd[keptIndex][0];
+    int initialIndex = keptAfterAdd[keptIndex][1];
+    if (modelNodes[index] != initialModelNodes[initialIndex] || polyDatas[index] != initialPolyDatas[initialIndex])
+    {
+      std::cerr << __LINE__ << ": Model of unchanged level " << isoLevels[index] << " was rebuilt after adding a level" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  if ( std::find(initialModelNodes.begin(), initialModelNodes.end(), modelNodes[2]) != initialModelNodes.end()
+    || !polyDatas[2] || polyDatas[2]->GetNumberOfPoints() == 0 )
+  {
+    std::cerr << __LINE__ << ": Added level " << isoLevels[2] << " is expected to get a new, non-empty model" << std::endl;
+    return EXIT_FAILURE;
+  }
+  vtkSmartPointer<vtkMRMLModelNode> addedModelNode = modelNodes[2];
+  vtkSmartPointer<vtkPolyData> addedPolyData = polyDatas[2];
+
+  // Change a level: the model of the old level is reused for the new level with a newly extracted surface
+  isoLevels[1] = 5.5;
+  SetIsodoseLevels(colorTableNode, isoLevels);
+  isodoseLogic->CreateIsodoseSurfaces(parameterNode);
+  GetIsodoseModels(parameterNode, modelNodes, polyDatas);
+  if (modelNodes.size() != 4 || mrmlScene->GetNumberOfNodesByClass("vtkMRMLModelNode") != 4)
+  {
+    std::cerr << __LINE__ << ": Expected 4 isodose models after changing a level, got " << modelNodes.size() << std::endl;
+    return EXIT_FAILURE;
+  }
+  if ( polyDatas[0] != initialPolyDatas[0] || polyDatas[2] != addedPolyData || polyDatas[3] != initialPolyDatas[2]
+    || modelNodes[2] != addedModelNode )
+  {
+    std::cerr << __LINE__ << ": Model of an unchanged level was rebuilt after changing a level" << std::endl;
+    return EXIT_FAILURE;
+  }
+  if (modelNodes[1] != initialModelNodes[1] || polyDatas[1] == initialPolyDatas[1])
+  {
+    std::cerr << __LINE__ << ": Model of the changed level is expected to be reused with a new surface" << std::endl;
+    return EXIT_FAILURE;
+  }
+  std::string changedModelNamePrefix = vtkSlicerIsodoseModuleLogic::ISODOSE_MODEL_NODE_NAME_PREFIX + "5.5";
+  if (!modelNodes[1]->GetName() || std::string(modelNodes[1]->GetName()).compare(0, changedModelNamePrefix.size(), changedModelNamePrefix))
+  {
+    std::cerr << __LINE__ << ": Model of the changed level is not renamed: " << (modelNodes[1]->GetName() ? modelNodes[1]->GetName() : "(none)") << std::endl;
+    return EXIT_FAILURE;
+  }
+  // The new surface must be the one of the new level, which is smaller than the old one
+  vtkNew<vtkMassProperties> oldLevelProperties;
+  oldLevelProperties->SetInputData(initialPolyDatas[1]);
+  oldLevelProperties->Update();
+  vtkNew<vtkMassProperties> newLevelProperties;
+  newLevelProperties->SetInputData(polyDatas[1]);
+  newLevelProperties->Update();
+  if (newLevelProperties->GetVolume() >= oldLevelProperties->GetVolume())
+  {
+    std::cerr << __LINE__ << ": Surface of the changed level (" << newLevelProperties->GetVolume()
+      << ") is expected to be smaller than the one of the old level (" << oldLevelProperties->GetVolume() << ")" << std::endl;
+    return EXIT_FAILURE;
+  }
+  vtkSmartPointer<vtkMRMLModelNode> changedModelNode = modelNodes[1];
+
+  // Remove a level: the model of the removed level is removed from the scene, the others are kept
+  isoLevels.erase(isoLevels.begin() + 1);
+  SetIsodoseLevels(colorTableNode, isoLevels);
+  isodoseLogic->CreateIsodoseSurfaces(parameterNode);
+  GetIsodoseModels(parameterNode, modelNodes, polyDatas);
+  if (modelNodes.size() != 3 || mrmlScene->GetNumberOfNodesByClass("vtkMRMLModelNode") != 3)
+  {
+    std::cerr << __LINE__ << ": Expected 3 isodose models after removing a level, got " << modelNodes.size() << std::endl;
+    return EXIT_FAILURE;
+  }
+  if (polyDatas[0] != initialPolyDatas[0] || polyDatas[1] != addedPolyData || polyDatas[2] != initialPolyDatas[2])
+  {
+    std::cerr << __LINE__ << ": Model of an unchanged level was rebuilt after removing a level" << std::endl;
+    return EXIT_FAILURE;
+  }
+  if (changedModelNode->GetScene() != nullptr)
+  {
+    std::cerr << __LINE__ << ": Model of the removed level is still in the scene" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // Level above the maximum dose gets an empty model, which is not extracted again on the next update
+  isoLevels.push_back(1000.0);
+  SetIsodoseLevels(colorTableNode, isoLevels);
+  isodoseLogic->CreateIsodoseSurfaces(parameterNode);
+  GetIsodoseModels(parameterNode, modelNodes, polyDatas);
+  if (modelNodes.size() != 4 || !polyDatas[3] || polyDatas[3]->GetNumberOfPoints() != 0)
+  {
+    std::cerr << __LINE__ << ": Level " << isoLevels[3] << " above the maximum dose is expected to get an empty model" << std::endl;
+    return EXIT_FAILURE;
+  }
+  vtkSmartPointer<vtkPolyData> emptyPolyData = polyDatas[3];
+  isodoseLogic->CreateIsodoseSurfaces(parameterNode);
+  GetIsodoseModels(parameterNode, modelNodes, polyDatas);
+  if (modelNodes.size() != 4 || polyDatas[3] != emptyPolyData)
+  {
+    std::cerr << __LINE__ << ": Empty surface of level " << isoLevels[3] << " was extracted again without any change" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // Changing the dose invalidates all surfaces
+  doseVolumeNode->GetImageData()->Modified();
+  isodoseLogic->CreateIsodoseSurfaces(parameterNode);
+  std::vector<vtkSmartPointer<vtkPolyData> > previousPolyDatas(polyDatas);
+  GetIsodoseModels(parameterNode, modelNodes, polyDatas);
+  for (size_t index = 0; index < polyDatas.size(); ++index)
+  {
+    if (polyDatas[index] == previousPolyDatas[index])
+    {
+      std::cerr << __LINE__ << ": Model of level " << isoLevels[index] << " was not rebuilt after the dose changed" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int TestSliceIsodoseLines()
+{
+  vtkNew<vtkMRMLScene> mrmlScene;
+  vtkNew<vtkSlicerIsodoseModuleLogic> isodoseLogic;
+  isodoseLogic->SetMRMLScene(mrmlScene);
+
+  vtkMRMLScalarVolumeNode* doseVolumeNode = CreateGaussianDoseVolumeNode(mrmlScene);
+  std::vector<double> isoLevels;
+  isoLevels.push_back(8.0);
+  isoLevels.push_back(2.05);
+  isoLevels.push_back(5.0);
+  vtkMRMLIsodoseNode* parameterNode = CreateIsodoseParameterNode(mrmlScene, doseVolumeNode, isoLevels);
+  parameterNode->SliceIsodoseLinesOn();
+
+  // Slice view showing the K = 20 voxel plane of the oblique dose volume
+  const int sliceIndex = 20;
+  vtkNew<vtkMatrix4x4> ijkToRasMatrix;
+  doseVolumeNode->GetIJKToRASMatrix(ijkToRasMatrix);
+  vtkNew<vtkMatrix4x4> sliceToRasMatrix;
+  for (int column = 0; column < 3; ++column)
+  {
+    double axisDirection[3] = { ijkToRasMatrix->GetElement(0, column), ijkToRasMatrix->GetElement(1, column), ijkToRasMatrix->GetElement(2, column) };
+    vtkMath::Normalize(axisDirection);
+    for (int row = 0; row < 3; ++row)
+    {
+      sliceToRasMatrix->SetElement(row, column, axisDirection[row]);
+    }
+  }
+  const double slicePlaneOriginIJK[4] = { 0.0, 0.0, static_cast<double>(sliceIndex), 1.0 };
+  double slicePlaneOriginRAS[4] = { 0.0, 0.0, 0.0, 1.0 };
+  ijkToRasMatrix->MultiplyPoint(slicePlaneOriginIJK, slicePlaneOriginRAS);
+  for (int row = 0; row < 3; ++row)
+  {
+    sliceToRasMatrix->SetElement(row, 3, slicePlaneOriginRAS[row]);
+  }
+  vtkNew<vtkMRMLSliceNode> sliceNode;
+  sliceNode->SetName("Red");
+  sliceNode->SetLayoutName("Red");
+  mrmlScene->AddNode(sliceNode);
+  sliceNode->SetSliceToRAS(sliceToRasMatrix);
+  sliceNode->UpdateMatrices();
+
+  isodoseLogic->UpdateSliceIsodoseLines(parameterNode, sliceNode);
+  std::string sliceLinesModelNodeName = std::string(doseVolumeNode->GetName()) + "_IsodoseLines_" + sliceNode->GetName();
+  vtkMRMLModelNode* sliceLinesModelNode = vtkMRMLModelNode::SafeDownCast(mrmlScene->GetFirstNodeByName(sliceLinesModelNodeName.c_str()));
+  if (!sliceLinesModelNode || !sliceLinesModelNode->GetPolyData())
+  {
+    std::cerr << __LINE__ << ": No isodose lines model created for slice view " << sliceNode->GetName() << std::endl;
+    return EXIT_FAILURE;
+  }
+  vtkPolyData* sliceLines = sliceLinesModelNode->GetPolyData();
+  vtkDataArray* levelIndexArray = sliceLines->GetCellData()->GetArray("IsodoseLevelIndex");
+  if (!levelIndexArray)
+  {
+    std::cerr << __LINE__ << ": Isodose lines have no level index array" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // Reference: contour each level separately on the voxels of the slice, then transform to RAS
+  int doseExtent[6] = { 0, -1, 0, -1, 0, -1 };
+  doseVolumeNode->GetImageData()->GetExtent(doseExtent);
+  vtkNew<vtkExtractVOI> extractSlice;
+  extractSlice->SetInputData(doseVolumeNode->GetImageData());
+  extractSlice->SetVOI(doseExtent[0], doseExtent[1], doseExtent[2], doseExtent[3], sliceIndex, sliceIndex);
+  extractSlice->Update();
+  vtkNew<vtkTransform> ijkToRasTransform;
+  ijkToRasTransform->SetMatrix(ijkToRasMatrix);
+  for (int levelIndex = 0; levelIndex < static_cast<int>(isoLevels.size()); ++levelIndex)
+  {
+    vtkNew<vtkMarchingSquares> marchingSquares;
+    marchingSquares->SetInputData(extractSlice->GetOutput());
+    marchingSquares->SetValue(0, isoLevels[levelIndex]);
+    marchingSquares->Update();
+    vtkNew<vtkTransformPolyDataFilter> transformReferenceLines;
+    transformReferenceLines->SetInputData(marchingSquares->GetOutput());
+    transformReferenceLines->SetTransform(ijkToRasTransform);
+    transformReferenceLines->Update();
+
+    vtkIdType numberOfSegments = 0;
+    double totalLength = 0.0;
+    double bounds[6] = { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+    GetIsolineProperties(sliceLines, levelIndexArray, levelIndex, numberOfSegments, totalLength, bounds);
+    vtkIdType referenceNumberOfSegments = 0;
+    double referenceTotalLength = 0.0;
+    double referenceBounds[6] = { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+    GetIsolineProperties(transformReferenceLines->GetOutput(), nullptr, -1, referenceNumberOfSegments, referenceTotalLength, referenceBounds);
+
+    if (referenceNumberOfSegments == 0)
+    {
+      std::cerr << __LINE__ << ": Level " << isoLevels[levelIndex] << " is expected to intersect the test slice" << std::endl;
+      return EXIT_FAILURE;
+    }
+    if (numberOfSegments != referenceNumberOfSegments || fabs(totalLength - referenceTotalLength) > 1.0e-6 * referenceTotalLength)
+    {
+      std::cerr << __LINE__ << ": Isodose lines of level " << isoLevels[levelIndex] << " (" << numberOfSegments << " segments, "
+        << totalLength << " mm) do not match the contour of the slice (" << referenceNumberOfSegments << " segments, "
+        << referenceTotalLength << " mm)" << std::endl;
+      return EXIT_FAILURE;
+    }
+    for (int i = 0; i < 6; ++i)
+    {
+      if (fabs(bounds[i] - referenceBounds[i]) > 1.0e-4)
+      {
+        std::cerr << __LINE__ << ": Bounds of the isodose lines of level " << isoLevels[levelIndex]
+          << " do not match the contour of the slice" << std::endl;
+        return EXIT_FAILURE;
+      }
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int TestIsodoseVolumeStatistics()
+{
+  vtkNew<vtkMRMLScene> mrmlScene;
+  vtkNew<vtkSlicerIsodoseModuleLogic> isodoseLogic;
+  isodoseLogic->SetMRMLScene(mrmlScene);
+
+  vtkMRMLScalarVolumeNode* doseVolumeNode = CreateGaussianDoseVolumeNode(mrmlScene);
+  std::vector<double> isoLevels;
+  isoLevels.push_back(8.0);
+  isoLevels.push_back(2.05);
+  isoLevels.push_back(5.0);
+  isoLevels.push_back(0.5);
+  vtkMRMLIsodoseNode* parameterNode = CreateIsodoseParameterNode(mrmlScene, doseVolumeNode, isoLevels);
+
+  // Segments with labelmaps on the dose lattice, with extents smaller than the dose
+  vtkNew<vtkMRMLSegmentationNode> segmentationNode;
+  mrmlScene->AddNode(segmentationNode);
+  segmentationNode->GetSegmentation()->SetMasterRepresentationName(vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName());
+  const int sphereExtent[6] = { 2, 37, 2, 33, 4, 39 };
+  const double sphereCenter[3] = { 16.0, 21.0, 25.0 };
+  AddDoseLatticeSegment(segmentationNode, doseVolumeNode, "Sphere", sphereExtent, sphereCenter, 9.5);
+  const int boxExtent[6] = { 5, 30, 8, 25, 10, 35 };
+  const double boxCenter[3] = { 0.0, 0.0, 0.0 };
+  AddDoseLatticeSegment(segmentationNode, doseVolumeNode, "Box", boxExtent, boxCenter, -1.0);
+
+  vtkNew<vtkMRMLTableNode> statisticsTableNode;
+  mrmlScene->AddNode(statisticsTableNode);
+  std::string errorMessage = isodoseLogic->ComputeIsodoseVolumeStatistics(parameterNode, segmentationNode, nullptr, statisticsTableNode);
+  if (!errorMessage.empty())
+  {
+    std::cerr << __LINE__ << ": Failed to compute isodose volume statistics: " << errorMessage << std::endl;
+    return EXIT_FAILURE;
+  }
+  vtkTable* statisticsTable = statisticsTableNode->GetTable();
+  if (statisticsTable->GetNumberOfRows() != static_cast<vtkIdType>(isoLevels.size()))
+  {
+    std::cerr << __LINE__ << ": Number of statistics rows (" << statisticsTable->GetNumberOfRows()
+      << ") does not match number of levels (" << isoLevels.size() << ")" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // Reference: count the voxels of each labelmap where the dose reaches the level
+  double doseSpacing[3] = { 1.0, 1.0, 1.0 };
+  doseVolumeNode->GetSpacing(doseSpacing);
+  double voxelVolumeCc = doseSpacing[0] * doseSpacing[1] * doseSpacing[2] / 1000.0;
+  vtkImageData* doseImageData = doseVolumeNode->GetImageData();
+  std::vector<std::string> segmentIDs;
+  segmentationNode->GetSegmentation()->GetSegmentIDs(segmentIDs);
+  for (const std::string& segmentID : segmentIDs)
+  {
+    vtkSegment* segment = segmentationNode->GetSegmentation()->GetSegment(segmentID);
+    vtkOrientedImageData* segmentLabelmap = vtkOrientedImageData::SafeDownCast(
+      segment->GetRepresentation(vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName()) );
+    int segmentExtent[6] = { 0, -1, 0, -1, 0, -1 };
+    segmentLabelmap->GetExtent(segmentExtent);
+
+    vtkIdType segmentVoxelCount = 0;
+    std::vector<vtkIdType> coveredVoxelCounts(isoLevels.size(), 0);
+    for (int k = segmentExtent[4]; k <= segmentExtent[5]; ++k)
+    {
+      for (int j = segmentExtent[2]; j <= segmentExtent[3]; ++j)
+      {
+        for (int i = segmentExtent[0]; i <= segmentExtent[1]; ++i)
+        {
+          if (segmentLabelmap->GetScalarComponentAsDouble(i, j, k, 0) == 0.0)
+          {
+            continue;
+          }
+          ++segmentVoxelCount;
+          double dose = doseImageData->GetScalarComponentAsDouble(i, j, k, 0);
+          for (size_t levelIndex = 0; levelIndex < isoLevels.size(); ++levelIndex)
+          {
+            if (dose >= isoLevels[levelIndex])
+            {
+              ++coveredVoxelCounts[levelIndex];
+            }
+          }
+        }
+      }
+    }
+
+    std::string volumeColumnName = std::string(segment->GetName()) + " volume (cc)";
+    std::string percentColumnName = std::string(segment->GetName()) + " volume (%)";
+    vtkAbstractArray* volumeColumn = statisticsTable->GetColumnByName(volumeColumnName.c_str());
+    vtkAbstractArray* percentColumn = statisticsTable->GetColumnByName(percentColumnName.c_str());
+    if (!volumeColumn || !percentColumn)
+    {
+      std::cerr << __LINE__ << ": Missing statistics columns for segment " << segment->GetName() << std::endl;
+      return EXIT_FAILURE;
+    }
+    for (size_t levelIndex = 0; levelIndex < isoLevels.size(); ++levelIndex)
+    {
+      double expectedVolumeCc = coveredVoxelCounts[levelIndex] * voxelVolumeCc;
+      double expectedPercent = 100.0 * coveredVoxelCounts[levelIndex] / segmentVoxelCount;
+      double volumeCc = volumeColumn->GetVariantValue(levelIndex).ToDouble();
+      double percent = percentColumn->GetVariantValue(levelIndex).ToDouble();
+      if (fabs(volumeCc - expectedVolumeCc) > 1.0e-9 || fabs(percent - expectedPercent) > 1.0e-9)
+      {
+        std::cerr << __LINE__ << ": Volume of segment " << segment->GetName() << " covered by level " << isoLevels[levelIndex]
+          << " is " << volumeCc << " cc (" << percent << "%), expected " << expectedVolumeCc << " cc (" << expectedPercent << "%)" << std::endl;
+        return EXIT_FAILURE;
+      }
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+void AddDoseLatticeSegment(vtkMRMLSegmentationNode* segmentationNode, vtkMRMLScalarVolumeNode* doseVolumeNode,
+  const char* segmentName, const int extent[6], const double centerIJK[3], double radius)
+{
+  vtkNew<vtkMatrix4x4> ijkToRasMatrix;
+  doseVolumeNode->GetIJKToRASMatrix(ijkToRasMatrix);
+  vtkNew<vtkOrientedImageData> segmentLabelmap;
+  segmentLabelmap->SetExtent(extent[0], extent[1], extent[2], extent[3], extent[4], extent[5]);
+  segmentLabelmap->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+  segmentLabelmap->SetGeometryFromImageToWorldMatrix(ijkToRasMatrix);
+  for (int k = extent[4]; k <= extent[5]; ++k)
+  {
+    for (int j = extent[2]; j <= extent[3]; ++j)
+    {
+      for (int i = extent[0]; i <= extent[1]; ++i)
+      {
+        double squaredDistance = (i - centerIJK[0]) * (i - centerIJK[0])
+          + (j - centerIJK[1]) * (j - centerIJK[1]) + (k - centerIJK[2]) * (k - centerIJK[2]);
+        bool inside = (radius < 0.0 || squaredDistance <= radius * radius);
+        segmentLabelmap->SetScalarComponentFromDouble(i, j, k, 0, inside ? 1.0 : 0.0);
+      }
+    }
+  }
+
+  vtkNew<vtkSegment> segment;
+  segment->SetName(segmentName);
+  segment->AddRepresentation(vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName(), segmentLabelmap);
+  segmentationNode->GetSegmentation()->AddSegment(segment);
+}
+
+//----------------------------------------------------------------------------
+void GetIsolineProperties(vtkPolyData* linesPolyData, vtkDataArray* levelIndexArray, int levelIndex,
+  vtkIdType& numberOfSegments, double& totalLength, double bounds[6])
+{
+  numberOfSegments = 0;
+  totalLength = 0.0;
+  vtkMath::UninitializeBounds(bounds);
+  bool boundsInitialized = false;
+
+  vtkCellArray* lines = linesPolyData->GetLines();
+  vtkNew<vtkIdList> linePointIds;
+  lines->InitTraversal();
+  for (vtkIdType lineIndex = 0; lines->GetNextCell(linePointIds); ++lineIndex)
+  {
+    if (levelIndexArray && static_cast<int>(levelIndexArray->GetTuple1(lineIndex)) != levelIndex)
+    {
+      continue;
+    }
+    for (vtkIdType pointIndex = 0; pointIndex < linePointIds->GetNumberOfIds(); ++pointIndex)
+    {
+      double point[3] = { 0.0, 0.0, 0.0 };
+      linesPolyData->GetPoint(linePointIds->GetId(pointIndex), point);
+      for (int i = 0; i < 3; ++i)
+      {
+        bounds[2*i] = (boundsInitialized ? std::min(bounds[2*i], point[i]) : point[i]);
+        bounds[2*i+1] = (boundsInitialized ? std::max(bounds[2*i+1], point[i]) : point[i]);
+      }
+      boundsInitialized = true;
+      if (pointIndex > 0)
+      {
+        double previousPoint[3] = { 0.0, 0.0, 0.0 };
+        linesPolyData->GetPoint(linePointIds->GetId(pointIndex - 1), previousPoint);
+        totalLength += sqrt(vtkMath::Distance2BetweenPoints(previousPoint, point));
+        ++numberOfSegments;
+      }
+    }
+  }
+}
+
+//----------------------------------------------------------------------------
+void GetIsodoseModels(vtkMRMLIsodoseNode* parameterNode, std::vector<vtkSmartPointer<vtkMRMLModelNode> >& modelNodes,
+  std::vector<vtkSmartPointer<vtkPolyData> >& polyDatas)
+{
+  modelNodes.clear();
+  polyDatas.clear();
+  for (int index = 0; index < parameterNode->GetNumberOfIsodoseModelNodes(); ++index)
+  {
+    vtkMRMLModelNode* modelNode = parameterNode->GetNthIsodoseModelNode(index);
+    modelNodes.push_back(modelNode);
+    polyDatas.push_back(modelNode ? modelNode->GetPolyData() : nullptr);
+  }
+}
+
+//----------------------------------------------------------------------------
+bool AreSurfacesEqual(vtkPolyData* actualPolyData, vtkPolyData* expectedPolyData, double volumeTolerance, double boundsTolerance)
+{
+  if (!actualPolyData || !expectedPolyData)
+  {
+    return false;
+  }
+
+  vtkNew<vtkMassProperties> actualProperties;
+  actualProperties->SetInputData(actualPolyData);
+  actualProperties->Update();
+  vtkNew<vtkMassProperties> expectedProperties;
+  expectedProperties->SetInputData(expectedPolyData);
+  expectedProperties->Update();
+  double actualVolume = actualProperties->GetVolume();
+  double expectedVolume = expectedProperties->GetVolume();
+  if (fabs(actualVolume - expectedVolume) > volumeTolerance * expectedVolume)
+  {
+    std::cerr << "Surface volume " << actualVolume << " differs from expected volume " << expectedVolume << std::endl;
+    return false;
+  }
+
+  double actualBounds[6] = { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+  double expectedBounds[6] = { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+  actualPolyData->GetBounds(actualBounds);
+  expectedPolyData->GetBounds(expectedBounds);
+  for (int i = 0; i < 6; ++i)
+  {
+    if (fabs(actualBounds[i] - expectedBounds[i]) > boundsTolerance)
+    {
+      std::cerr << "Surface bounds (" << actualBounds[0] << ", " << actualBounds[1] << ", " << actualBounds[2] << ", " << actualBounds[3]
+        << ", " << actualBounds[4] << ", " << actualBounds[5] << ") differ from expected bounds (" << expectedBounds[0] << ", "
+        << expectedBounds[1] << ", " << expectedBounds[2] << ", " << expectedBounds[3] << ", " << expectedBounds[4] << ", "
+        << expectedBounds[5] << ")" << std::endl;
+      return false;
+    }
+  }
+
+  return true;
+}
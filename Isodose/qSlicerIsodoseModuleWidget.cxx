@@ -307,6 +307,7 @@ void qSlicerIsodoseModuleWidget::updateWidgetFromMRML()
 //    this->updateScalarBarsFromSelectedColorTable();
 
     d->checkBox_Isoline->setChecked(paramNode->GetShowIsodoseLines());
+    d->checkBox_SliceIsolines->setChecked(paramNode->GetSliceIsodoseLines());
     d->checkBox_Isosurface->setChecked(paramNode->GetShowIsodoseSurfaces());
 
     d->checkBox_ScalarBar->setChecked(paramNode->GetShowScalarBar());
@@ -339,6 +340,7 @@ void qSlicerIsodoseModuleWidget::setup()
 
   connect( d->checkBox_ShowDoseVolumesOnly, SIGNAL( stateChanged(int) ), this, SLOT( showDoseVolumesOnlyCheckboxChanged(int) ) );
   connect( d->checkBox_Isoline, SIGNAL(toggled(bool)), this, SLOT( setIsolineVisibility(bool) ) );
+  connect( d->checkBox_SliceIsolines, SIGNAL(toggled(bool)), this, SLOT( setSliceIsolines(bool) ) );
   connect( d->checkBox_Isosurface, SIGNAL(toggled(bool)), this, SLOT( setIsosurfaceVisibility(bool) ) );
   connect( d->checkBox_ScalarBar, SIGNAL(toggled(bool)), this, SLOT( setScalarBarVisibility(bool) ) );
   connect( d->checkBox_ScalarBar2D, SIGNAL(toggled(bool)), this, SLOT( setScalarBar2DVisibility(bool) ) );
@@ -735,6 +737,9 @@ void qSlicerIsodoseModuleWidget::setIsolineVisibility(bool visible)
   paramNode->SetShowIsodoseLines(visible);
   paramNode->DisableModifiedEventOff();
 
+  // Per-slice isodose lines are shown instead of the surface intersections if enabled
+  d->logic()->UpdateSliceIsodoseLinesInAllViews(paramNode);
+
   vtkIdType isdoseFolderItemID = d->logic()->GetIsodoseFolderItemID(paramNode);
   if (!isdoseFolderItemID)
   {
@@ -747,8 +752,27 @@ void qSlicerIsodoseModuleWidget::setIsolineVisibility(bool visible)
   for (vtkIdType childItemID : childItemIDs)
   {
     vtkMRMLModelNode* modelNode = vtkMRMLModelNode::SafeDownCast(shNode->GetItemDataNode(childItemID));
-    modelNode->GetDisplayNode()->SetVisibility2D(visible);
+    modelNode->GetDisplayNode()->SetVisibility2D(visible && !paramNode->GetSliceIsodoseLines());
+  }
+}
+
+//------------------------------------------------------------------------------
+void qSlicerIsodoseModuleWidget::setSliceIsolines(bool sliceIsolines)
+{
+  Q_D(qSlicerIsodoseModuleWidget);
+
+  vtkMRMLIsodoseNode* paramNode = vtkMRMLIsodoseNode::SafeDownCast(d->MRMLNodeComboBox_ParameterSet->currentNode());
+  if (!this->mrmlScene() || !paramNode)
+  {
+    return;
   }
+
+  paramNode->DisableModifiedEventOn();
+  paramNode->SetSliceIsodoseLines(sliceIsolines);
+  paramNode->DisableModifiedEventOff();
+
+  // Update both the per-slice lines and the slice visibility of the isodose surfaces
+  this->setIsolineVisibility(paramNode->GetShowIsodoseLines());
 }
 
 //------------------------------------------------------------------------------
@@ -81,6 +81,9 @@ protected slots:
   /// Slot for changing isoline visibility
   void setIsolineVisibility(bool);
 
+  /// Slot for switching between per-slice isodose lines and isosurface intersections
+  void setSliceIsolines(bool);
+
   /// Slot for changing isosurface visibility
   void setIsosurfaceVisibility(bool);
 
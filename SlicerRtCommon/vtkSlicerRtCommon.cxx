@@ -33,13 +33,23 @@
 #include <vtkDiscretizableColorTransferFunction.h>
 #include <vtkLookupTable.h>
 #include <vtkGeneralTransform.h>
+#include <vtkImageConstantPad.h>
 #include <vtkImageData.h>
+#include <vtkImageThreshold.h>
 #include <vtkMatrix4x4.h>
+#include <vtkNew.h>
 #include <vtkSmartPointer.h>
 
 // SegmentationCore includes
+#include "vtkClosedSurfaceToBinaryLabelmapConversionRule.h"
 #include "vtkOrientedImageData.h"
 #include "vtkOrientedImageDataResample.h"
+#include "vtkSegment.h"
+#include "vtkSegmentation.h"
+#include "vtkSegmentationConverter.h"
+
+// Slicer includes
+#include <vtkSlicerVersionConfigure.h>
 
 // VTK sys tools
 #include <vtksys/SystemTools.hxx>
@@ -72,7 +82,10 @@ const std::string vtkSlicerRtCommon::DICOMRTIMPORT_COLLIMATOR_ANGLE_ATTRIBUTE_NA
 const std::string vtkSlicerRtCommon::DICOMRTIMPORT_BEAM_JAW_POSITIONS_ATTRIBUTE_NAME = vtkSlicerRtCommon::DICOMRTIMPORT_ATTRIBUTE_PREFIX + "JawPositions";
 const std::string vtkSlicerRtCommon::DICOMRTIMPORT_BEAM_NUMBER_ATTRIBUTE_NAME = vtkSlicerRtCommon::DICOMRTIMPORT_ATTRIBUTE_PREFIX + "BeamNumber";
 const std::string vtkSlicerRtCommon::DICOMRTIMPORT_ROI_REFERENCED_SERIES_UID_ATTRIBUTE_NAME = vtkSlicerRtCommon::DICOMRTIMPORT_ATTRIBUTE_PREFIX + "RoiReferencedSeriesUid"; // DICOM connection
+const std::string vtkSlicerRtCommon::DICOMRTIMPORT_STRUCTURE_SET_LABEL_ATTRIBUTE_NAME = vtkSlicerRtCommon::DICOMRTIMPORT_ATTRIBUTE_PREFIX + "StructureSetLabel";
 const std::string vtkSlicerRtCommon::DICOMRTIMPORT_ROI_NUMBER_SEGMENT_TAG_NAME = vtkSlicerRtCommon::DICOMRTIMPORT_ATTRIBUTE_PREFIX + "RoiNumber";
+const std::string vtkSlicerRtCommon::DICOMRTIMPORT_ROI_CONTOUR_HASH_SEGMENT_TAG_NAME = vtkSlicerRtCommon::DICOMRTIMPORT_ATTRIBUTE_PREFIX + "RoiContourHash";
+const std::string vtkSlicerRtCommon::DICOMRTIMPORT_ROI_CONTOURS_DEFERRED_SEGMENT_TAG_NAME = vtkSlicerRtCommon::DICOMRTIMPORT_ATTRIBUTE_PREFIX + "RoiContoursDeferred";
 const std::string vtkSlicerRtCommon::DICOMRTIMPORT_RTIMAGE_IDENTIFIER_ATTRIBUTE_NAME = vtkSlicerRtCommon::DICOMRTIMPORT_ATTRIBUTE_PREFIX + "RtImage"; // Identifier
 const std::string vtkSlicerRtCommon::DICOMRTIMPORT_RTIMAGE_SID_ATTRIBUTE_NAME = vtkSlicerRtCommon::DICOMRTIMPORT_ATTRIBUTE_PREFIX + "RtImageSid";
 const std::string vtkSlicerRtCommon::DICOMRTIMPORT_RTIMAGE_POSITION_ATTRIBUTE_NAME = vtkSlicerRtCommon::DICOMRTIMPORT_ATTRIBUTE_PREFIX + "RtImagePosition";
@@ -398,3 +411,105 @@ bool vtkSlicerRtCommon::ConvertVolumeNodeToVtkOrientedImageData(vtkMRMLScalarVol
 
   return true;
 }
+
+//---------------------------------------------------------------------------
+std::string vtkSlicerRtCommon::CreateSegmentLabelmapsInVolumeGeometry(vtkMRMLScalarVolumeNode* referenceVolumeNode,
+  vtkSegmentation* segmentation, vtkGeneralTransform* segmentationToWorldTransform, const std::vector<std::string>& segmentIDs,
+  std::vector<vtkSmartPointer<vtkOrientedImageData> >& segmentLabelmaps)
+{
+  segmentLabelmaps.clear();
+  if (!referenceVolumeNode || !referenceVolumeNode->GetImageData() || !segmentation)
+  {
+    return "Invalid reference volume or segmentation";
+  }
+
+  // Only the geometry of the reference volume is needed, so its voxels are not copied
+  vtkSmartPointer<vtkMatrix4x4> referenceIjkToWorldMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+  referenceVolumeNode->GetIJKToRASMatrix(referenceIjkToWorldMatrix);
+  vtkMRMLTransformNode* referenceParentTransformNode = referenceVolumeNode->GetParentTransformNode();
+  if (referenceParentTransformNode)
+  {
+    if (!referenceParentTransformNode->IsTransformToWorldLinear())
+    {
+      return "Non-linear parent transform of the reference volume is not supported";
+    }
+    vtkSmartPointer<vtkMatrix4x4> referenceToWorldMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+    referenceParentTransformNode->GetMatrixTransformToWorld(referenceToWorldMatrix);
+    vtkMatrix4x4::Multiply4x4(referenceToWorldMatrix, referenceIjkToWorldMatrix, referenceIjkToWorldMatrix);
+  }
+  vtkSmartPointer<vtkOrientedImageData> referenceGeometryImage = vtkSmartPointer<vtkOrientedImageData>::New();
+  referenceGeometryImage->SetGeometryFromImageToWorldMatrix(referenceIjkToWorldMatrix);
+  int referenceExtent[6] = {0,-1,0,-1,0,-1};
+  referenceVolumeNode->GetImageData()->GetExtent(referenceExtent);
+  referenceGeometryImage->SetExtent(referenceExtent);
+
+  // Temporarily duplicate selected segments to contain binary labelmap of a different geometry (tied to the reference volume)
+  vtkSmartPointer<vtkSegmentation> segmentationCopy = vtkSmartPointer<vtkSegmentation>::New();
+  segmentationCopy->SetMasterRepresentationName(segmentation->GetMasterRepresentationName());
+  segmentationCopy->CopyConversionParameters(segmentation);
+  for (const std::string& segmentID : segmentIDs)
+  {
+    if (!segmentationCopy->CopySegmentFromSegmentation(segmentation, segmentID))
+    {
+      return std::string("Failed to get segment ") + segmentID;
+    }
+  }
+  segmentationCopy->SetConversionParameter( vtkSegmentationConverter::GetReferenceImageGeometryParameterName(),
+    vtkSegmentationConverter::SerializeImageGeometry(referenceGeometryImage) );
+  segmentationCopy->SetConversionParameter( vtkClosedSurfaceToBinaryLabelmapConversionRule::GetOversamplingFactorParameterName(), "1" );
+  // If conversion is not possible (labelmap is the master representation), then the existing labelmaps are resampled below
+  segmentationCopy->CreateRepresentation(vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName(), true);
+  if (!segmentationCopy->ContainsRepresentation(vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName()))
+  {
+    return "Failed to create binary labelmap representation for segments";
+  }
+
+  for (const std::string& segmentID : segmentIDs)
+  {
+    vtkSegment* segment = segmentationCopy->GetSegment(segmentID);
+    vtkOrientedImageData* segmentRepresentation = vtkOrientedImageData::SafeDownCast(
+      segment->GetRepresentation(vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName()) );
+    if (!segmentRepresentation)
+    {
+      return std::string("Failed to get binary labelmap for segment ") + segmentID;
+    }
+
+    // Extract the segment from the possibly shared labelmap as a 0/1 image
+    vtkNew<vtkImageThreshold> threshold;
+    threshold->SetInputData(segmentRepresentation);
+#if Slicer_VERSION_MAJOR >= 5 || (Slicer_VERSION_MAJOR >= 4 && Slicer_VERSION_MINOR >= 11)
+    threshold->ThresholdBetween(segment->GetLabelValue(), segment->GetLabelValue());
+#else
+    threshold->ThresholdByUpper(1);
+#endif
+    threshold->SetInValue(1);
+    threshold->SetOutValue(0);
+    threshold->SetOutputScalarTypeToUnsignedChar();
+    threshold->Update();
+    vtkSmartPointer<vtkOrientedImageData> segmentLabelmap = vtkSmartPointer<vtkOrientedImageData>::New();
+    segmentLabelmap->ShallowCopy(threshold->GetOutput());
+    segmentLabelmap->CopyDirections(segmentRepresentation);
+
+    // Apply the transform from the segmentation to world if necessary
+    if (segmentationToWorldTransform)
+    {
+      vtkOrientedImageDataResample::TransformOrientedImage(segmentLabelmap, segmentationToWorldTransform);
+    }
+
+    // Resample to the reference lattice (no-op if already matching) and pad to its full extent
+    if (!vtkOrientedImageDataResample::ResampleOrientedImageToReferenceOrientedImage(segmentLabelmap, referenceGeometryImage, segmentLabelmap))
+    {
+      return std::string("Failed to resample labelmap of segment ") + segmentID;
+    }
+    vtkNew<vtkImageConstantPad> padder;
+    padder->SetInputData(segmentLabelmap);
+    padder->SetConstant(0);
+    padder->SetOutputWholeExtent(referenceExtent);
+    padder->Update();
+    segmentLabelmap->vtkImageData::DeepCopy(padder->GetOutput());
+
+    segmentLabelmaps.push_back(segmentLabelmap);
+  }
+
+  return "";
+}
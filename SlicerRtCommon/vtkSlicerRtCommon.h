@@ -24,6 +24,7 @@
 // STD includes
 #include <cstdlib>
 #include <string>
+#include <vector>
 
 // ITK includes
 #include "itkImage.h"
@@ -39,6 +40,7 @@ class vtkMRMLTransformableNode;
 
 class vtkImageData;
 class vtkOrientedImageData;
+class vtkSegmentation;
 class vtkGeneralTransform;
 class vtkMatrix4x4;
 
@@ -71,7 +73,13 @@ public:
   enum
   {
     /// Progress bar indicator event
-    ProgressUpdated = 62200
+    ProgressUpdated = 62200,
+    /// Event invoked on a segmentation node by consumers of segment data (e.g. DVH) to request loading segment data that was
+    /// deferred when importing the segmentation. Call data is the segment ID (const char*), or nullptr for all segments
+    SegmentDataRequested,
+    /// Event invoked on an RT image volume node by consumers of the pixel data to request loading the pixels that were
+    /// deferred when importing the RT image. Call data is not used
+    RtImageDataRequested
   };
 
 public:
@@ -101,7 +109,10 @@ public:
   static const std::string DICOMRTIMPORT_BEAM_JAW_POSITIONS_ATTRIBUTE_NAME;
   static const std::string DICOMRTIMPORT_BEAM_NUMBER_ATTRIBUTE_NAME;
   static const std::string DICOMRTIMPORT_ROI_REFERENCED_SERIES_UID_ATTRIBUTE_NAME;
+  static const std::string DICOMRTIMPORT_STRUCTURE_SET_LABEL_ATTRIBUTE_NAME;
   static const std::string DICOMRTIMPORT_ROI_NUMBER_SEGMENT_TAG_NAME;
+  static const std::string DICOMRTIMPORT_ROI_CONTOUR_HASH_SEGMENT_TAG_NAME;
+  static const std::string DICOMRTIMPORT_ROI_CONTOURS_DEFERRED_SEGMENT_TAG_NAME;
   static const std::string DICOMRTIMPORT_RTIMAGE_IDENTIFIER_ATTRIBUTE_NAME;
   static const std::string DICOMRTIMPORT_RTIMAGE_SID_ATTRIBUTE_NAME;
   static const std::string DICOMRTIMPORT_RTIMAGE_POSITION_ATTRIBUTE_NAME;
@@ -169,6 +180,20 @@ public:
   */
   static bool ConvertVolumeNodeToVtkOrientedImageData(vtkMRMLScalarVolumeNode* inVolumeNode, vtkOrientedImageData* outImageData, bool applyRasToWorldConversion=true);
 
+  /*!
+    Create labelmaps of segments on the lattice of a volume, so that a voxel index addresses the same voxel
+    in the volume and in all the labelmaps. Parent transforms of both nodes are applied.
+    \param referenceVolumeNode Volume defining the geometry and the extent of the labelmaps
+    \param segmentation Segmentation containing the segments. Deferred segment data needs to be requested by the caller
+    \param segmentationToWorldTransform Parent transform of the segmentation node to world. Optional
+    \param segmentIDs IDs of the segments to create labelmaps for
+    \param segmentLabelmaps Output unsigned char labelmaps with 0/1 values, in the order of the segment IDs
+    \return Error message, empty string if successful
+  */
+  static std::string CreateSegmentLabelmapsInVolumeGeometry(vtkMRMLScalarVolumeNode* referenceVolumeNode, vtkSegmentation* segmentation,
+    vtkGeneralTransform* segmentationToWorldTransform, const std::vector<std::string>& segmentIDs,
+    std::vector<vtkSmartPointer<vtkOrientedImageData> >& segmentLabelmaps);
+
   /*!
     Convert volume MRML node to ITK image
     \param inVolumeNode Input volume node